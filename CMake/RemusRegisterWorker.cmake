@@ -21,6 +21,8 @@
 #   [ NO_INSTALL ]
 #   [ FILE_TYPE  <type of requirements file> FILE_PATH  <path to requirements file> ]
 #   [ TAG <JSON data> ]
+#   [ QUEUE_TIMEOUT <milliseconds> ]
+#   [ RUN_TIMEOUT <milliseconds> ]
 #   [ ARGUMENTS <arg1> ... ]
 #   [ ENVIRONMENT <varName1> <varValue1> ... ]
 #   )
@@ -89,6 +91,10 @@
 #structure; client submissions and worker advertisements must match for
 #a job to be passed to a worker.
 #
+#QUEUE_TIMEOUT and RUN_TIMEOUT set how long in milliseconds a job for this
+#worker can wait in the server queue, and can run, before the server fails
+#it. Jobs that set their own timeouts ignore these
+#
 #If WORKER_FILE_EXT is set we use the user specified file extension
 #instead of using the default "rw" extension. The passed in extension
 #should not start with "."
@@ -103,7 +109,7 @@ function(remus_register_mesh_worker workerTarget )
   endif()
 
   set(options NO_INSTALL)
-  set(oneValueArgs INPUT_TYPE OUTPUT_TYPE EXECUTABLE_NAME WORKER_NAME INSTALL_PATH WORKER_FILE_EXT FILE_TYPE FILE_PATH TAG)
+  set(oneValueArgs INPUT_TYPE OUTPUT_TYPE EXECUTABLE_NAME WORKER_NAME INSTALL_PATH WORKER_FILE_EXT FILE_TYPE FILE_PATH TAG QUEUE_TIMEOUT RUN_TIMEOUT)
   set(multiValueArgs ARGUMENTS ENVIRONMENT)
   cmake_parse_arguments(R "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
 
@@ -160,6 +166,16 @@ function(remus_register_mesh_worker workerTarget )
     \"Tag\":  ${R_TAG},")
   endif()
 
+  if(R_QUEUE_TIMEOUT)
+    set(extra_json "${extra_json}
+    \"QueueTimeout\":  ${R_QUEUE_TIMEOUT},")
+  endif()
+
+  if(R_RUN_TIMEOUT)
+    set(extra_json "${extra_json}
+    \"RunTimeout\":  ${R_RUN_TIMEOUT},")
+  endif()
+
   if(R_ARGUMENTS)
     # Since "@SELF@" should be replaced at run-time, not
     # configure-time, we set SELF here so that @SELF@ -> @SELF@:
@@ -86,6 +86,8 @@ endfunction()
 #   IS_FILE_BASED
 #   [ WORKER_NAME <name> ]
 #   [ TAG <JSON data> ]
+#   [ QUEUE_TIMEOUT <milliseconds> ]
+#   [ RUN_TIMEOUT <milliseconds> ]
 #   [ ARGUMENTS <arg1> ... ]
 #   [ ENVIRONMENT <varName1> <varValue1> ... ]
 #   )
@@ -106,7 +108,7 @@ function(remus_register_unit_test_worker)
   endif()
 
   set(options IS_FILE_BASED)
-  set(oneValueArgs EXEC_NAME INPUT_TYPE OUTPUT_TYPE CONFIG_DIR FILE_EXT TAG WORKER_NAME)
+  set(oneValueArgs EXEC_NAME INPUT_TYPE OUTPUT_TYPE CONFIG_DIR FILE_EXT TAG WORKER_NAME QUEUE_TIMEOUT RUN_TIMEOUT)
   set(multiValueArgs ARGUMENTS ENVIRONMENT)
   cmake_parse_arguments(R
     "${options}" "${oneValueArgs}" "${multiValueArgs}"
@@ -125,6 +127,16 @@ function(remus_register_unit_test_worker)
     \"Tag\":  ${R_TAG},")
   endif()
 
+  if(R_QUEUE_TIMEOUT)
+    set(extra_json "${extra_json}
+    \"QueueTimeout\":  ${R_QUEUE_TIMEOUT},")
+  endif()
+
+  if(R_RUN_TIMEOUT)
+    set(extra_json "${extra_json}
+    \"RunTimeout\":  ${R_RUN_TIMEOUT},")
+  endif()
+
   if(R_ARGUMENTS)
     # Since "@SELF@" should be replaced at run-time, not
     # configure-time, we set SELF here so that @SELF@ -> @SELF@:
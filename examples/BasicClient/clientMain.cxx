@@ -139,14 +139,18 @@ int main(int argc, char* argv[])
       }
 
     //While we have jobs still running on the server report back
-    //each time the status of the job changes
+    //each time the status of the job changes. Instead of polling each job
+    //we ask the server to hold our request until a job has finished or
+    //a second has passed.
     while(jobs.size() > 0)
       {
-      for(std::size_t i=0; i < jobs.size(); ++i, ++queries)
+      std::vector<remus::proto::JobStatus> latest = c.waitForJobs(jobs,1000);
+      ++queries;
+      for(std::size_t i=0; i < jobs.size(); ++i)
         {
         //update the status with the latest status and compare it too
         //the previously held status
-        remus::proto::JobStatus newStatus = c.jobStatus(jobs.at(i));
+        remus::proto::JobStatus newStatus = latest.at(i);
         remus::proto::JobStatus oldStatus = js.at(i);
         js[i]=newStatus;
 
@@ -181,6 +185,8 @@ int main(int argc, char* argv[])
             }
           jobs.erase(jobs.begin()+i);
           js.erase(js.begin()+i);
+          latest.erase(latest.begin()+i);
+          --i;
 
           std::cout << "outstanding jobs are: " << std::endl;
           for(std::size_t j=0; j < jobs.size(); ++j)
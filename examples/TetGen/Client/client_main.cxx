@@ -7,6 +7,7 @@
 #include "TetGenResult.h"
 
 #include <iostream>
+#include <vector>
 
 int main (int argc, char* argv[])
 {
@@ -38,10 +39,12 @@ int main (int argc, char* argv[])
     remus::proto::Job job = c.submitJob(sub);
     remus::proto::JobStatus jobState = c.jobStatus(job);
 
-    //wait while the job is running
+    //wait while the job is running, the server holds onto each wait
+    //request until the job finishes or a second has passed
+    std::vector<remus::proto::Job> jobs(1,job);
     while(jobState.good())
       {
-      jobState = c.jobStatus(job);
+      jobState = c.waitForJobs(jobs,1000).at(0);
       };
 
     if(jobState.finished())
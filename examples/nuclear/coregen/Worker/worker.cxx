@@ -35,6 +35,9 @@ worker::worker( remus::worker::ServerConnection const& conn )
     conn),
    Process(NULL)
 {
+  //we report progress for every line the mesher outputs, so only
+  //send the newest progress every quarter second
+  this->limitStatusUpdates(250);
 }
 
 worker::~worker()
@@ -12,12 +12,70 @@
 
 #include <remus/client/Client.h>
 
+#include <remus/common/MappedFile.h>
+#include <remus/common/MD5Hash.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 
 #include <remus/proto/zmqHelper.h>
+
+#include <algorithm>
+#include <map>
 #include <sstream>
 
+namespace {
+//returns an empty JobContent with the format and tag of the given content,
+//which is sent with the submission in place of content that is streamed.
+//Content from a file keeps its path, so the worker knows to spool it to
+//a file
+remus::proto::JobContent make_StreamedPlaceholder(
+                                  const remus::proto::JobContent& content)
+{
+  if(content.sourceType() == remus::common::ContentSource::File)
+    {
+    return content;
+    }
+  remus::proto::JobContent placeholder(content.formatType(), std::string());
+  placeholder.tag(content.tag());
+  return placeholder;
+}
+
+//copy the submission, replacing all in memory content that is too large
+//to send as a single message with a placeholder. When the server isn't
+//local it can't read our files, so file content is replaced as well.
+//The keys of the replaced content are added to streamedKeys. Content the
+//server already holds is replaced by a placeholder, but isn't streamed
+remus::proto::JobSubmission make_SkeletonSubmission(
+                                  const remus::proto::JobSubmission& submission,
+                                  bool isLocalEndpoint,
+                                  const remus::proto::ContentDigests& stored,
+                                  remus::proto::StreamedKeys& streamedKeys)
+{
+  remus::proto::JobSubmission skeleton(submission.requirements());
+  typedef remus::proto::JobSubmission::const_iterator it;
+  for(it i = submission.begin(); i != submission.end(); ++i)
+    {
+    const bool isFile =
+          i->second.sourceType() == remus::common::ContentSource::File;
+    if(stored.count(i->first) != 0)
+      {
+      skeleton[i->first] = make_StreamedPlaceholder(i->second);
+      }
+    else if( (isFile && !isLocalEndpoint) ||
+        (!isFile && i->second.dataSize() > remus::STREAM_CHUNK_SIZE) )
+      {
+      streamedKeys.insert(i->first);
+      skeleton[i->first] = make_StreamedPlaceholder(i->second);
+      }
+    else
+      {
+      skeleton[i->first] = i->second;
+      }
+    }
+  return skeleton;
+}
+}
+
 namespace remus{
 namespace client{
 
@@ -32,12 +90,25 @@ struct ZmqManagement
     Server(*(conn.context()), ZMQ_REQ)
   {}
 };
+
+//the requirements of each MeshIOType from the last CACHED_MESH_REQUIREMENTS
+//answer of the server, keyed by their digest, and the tag of that answer
+struct RequirementsCache
+{
+  struct Entry
+  {
+    std::string Tag;
+    std::map<std::string, remus::proto::JobRequirements> Requirements;
+  };
+  std::map<remus::common::MeshIOType, Entry> Types;
+};
 }
 
 //------------------------------------------------------------------------------
 Client::Client(const remus::client::ServerConnection &conn):
   ConnectionInfo(conn),
-  Zmq( new detail::ZmqManagement(conn) )
+  Zmq( new detail::ZmqManagement(conn) ),
+  Requirements( new detail::RequirementsCache() )
 {
   zmq::connectToAddress(this->Zmq->Server,conn.endpoint());
 }
@@ -107,6 +178,84 @@ bool Client::canMesh(const remus::proto::JobRequirements& reqs)
 //------------------------------------------------------------------------------
 remus::proto::JobRequirementsSet
 Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
+{
+  //tell the server the tag of our answer and the digests of the
+  //requirements we hold, so it only has to send what changed
+  detail::RequirementsCache::Entry& cached =
+                                    this->Requirements->Types[meshtypes];
+  typedef std::map<std::string,
+                   remus::proto::JobRequirements>::const_iterator CachedIt;
+
+  remus::proto::CachedRequirements held;
+  held.Tag = cached.Tag;
+  for(CachedIt i = cached.Requirements.begin();
+      i != cached.Requirements.end(); ++i)
+    {
+    held.Requirements[i->first] = std::string();
+    }
+
+  std::ostringstream input_buffer;
+  remus::proto::writeCachedRequirements(input_buffer, held);
+  remus::proto::send_Message(meshtypes,
+                             remus::CACHED_MESH_REQUIREMENTS,
+                             input_buffer.str(),
+                             &this->Zmq->Server);
+
+  remus::proto::Response response =
+      remus::proto::receive_Response(&this->Zmq->Server);
+  if(!response.isValid())
+    {
+    return remus::proto::JobRequirementsSet();
+    }
+  if(response.serviceType() != remus::CACHED_MESH_REQUIREMENTS)
+    {
+    //the server doesn't cache requirements, so we have to ask for all of them
+    this->Requirements->Types.erase(meshtypes);
+    return this->downloadRequirements(meshtypes);
+    }
+
+  const std::string data(response.data(), response.dataSize());
+  std::istringstream output_buffer(data);
+  const remus::proto::CachedRequirements answer =
+                          remus::proto::readCachedRequirements(output_buffer);
+  if(answer.Modified)
+    {
+    std::map<std::string, remus::proto::JobRequirements> current;
+    typedef std::map<std::string, std::string>::const_iterator AnswerIt;
+    for(AnswerIt i = answer.Requirements.begin();
+        i != answer.Requirements.end(); ++i)
+      {
+      CachedIt c = cached.Requirements.find(i->first);
+      if(!i->second.empty())
+        {
+        current[i->first] = remus::proto::to_JobRequirements(i->second);
+        }
+      else if(c != cached.Requirements.end())
+        {
+        current[i->first] = c->second;
+        }
+      else
+        { //the server thinks we hold requirements we don't
+        this->Requirements->Types.erase(meshtypes);
+        return this->downloadRequirements(meshtypes);
+        }
+      }
+    cached.Tag = answer.Tag;
+    cached.Requirements.swap(current);
+    }
+
+  remus::proto::JobRequirementsSet set;
+  for(CachedIt i = cached.Requirements.begin();
+      i != cached.Requirements.end(); ++i)
+    {
+    set.insert(i->second);
+    }
+  return set;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet
+Client::downloadRequirements( const remus::common::MeshIOType& meshtypes)
 {
   remus::proto::send_Message(meshtypes,
                              remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
@@ -125,18 +274,103 @@ Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
 remus::proto::Job
 Client::submitJob(const remus::proto::JobSubmission& submission)
 {
-  std::ostringstream buffer;
-  buffer << submission;
+  //large content that the server still holds from an earlier submission
+  //is only referenced by its digest. If the server drops that content
+  //before the submission reaches it, we send all of the content
+  const remus::proto::ContentDigests stored = this->storedContent(submission);
+  if(!stored.empty())
+    {
+    remus::proto::Job job = this->uploadSubmission(submission, stored);
+    if(job.valid())
+      {
+      return job;
+      }
+    }
+  return this->uploadSubmission(submission, remus::proto::ContentDigests());
+}
 
-  remus::proto::send_Message(submission.type(),
-                             remus::MAKE_MESH,
-                            buffer.str(),
-                            &this->Zmq->Server);
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::uploadSubmission(const remus::proto::JobSubmission& submission,
+                         const remus::proto::ContentDigests& stored)
+{
+  remus::proto::StreamedKeys streamedKeys;
+  const remus::proto::JobSubmission skeleton =
+                      make_SkeletonSubmission(submission,
+                                              this->ConnectionInfo.isLocalEndpoint(),
+                                              stored,
+                                              streamedKeys);
+  if(streamedKeys.empty())
+    {
+    return this->sendSubmission(skeleton, streamedKeys,
+                                remus::common::SharedMemoryHandles(), stored);
+    }
 
-  remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
-  const std::string job(response.data(), response.dataSize());
-  return remus::proto::to_Job(job);
+  if(this->ConnectionInfo.isLocalEndpoint())
+    {
+    //the server is on the same machine, so we hand it the large content
+    //through shared memory. If that fails we fall back to streaming
+    remus::proto::Job job = this->sendSharedSubmission(skeleton, submission,
+                                                       streamedKeys, stored);
+    if(job.valid())
+      {
+      return job;
+      }
+    }
+
+  remus::proto::Job job = this->sendSubmission(skeleton, streamedKeys,
+                                        remus::common::SharedMemoryHandles(),
+                                        stored);
+  typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+  for(KeyIt i = streamedKeys.begin(); i != streamedKeys.end() && job.valid(); ++i)
+    {
+    const remus::proto::JobContent& content = submission.find(*i)->second;
+    if(!this->streamContent(job, *i, content))
+      {
+      //make sure the server doesn't hold onto a job it can't run
+      this->terminate(job);
+      job = remus::proto::make_invalidJob();
+      }
+    }
+  return job;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::submitJob(const remus::proto::JobSubmission& submission,
+                  const std::string& key,
+                  std::istream& content)
+{
+  remus::proto::StreamedKeys streamedKeys;
+  remus::proto::JobSubmission skeleton =
+                      make_SkeletonSubmission(submission,
+                                              this->ConnectionInfo.isLocalEndpoint(),
+                                              remus::proto::ContentDigests(),
+                                              streamedKeys);
+
+  //the content of the key comes from the stream, so we only keep the format
+  //and tag of any content the submission has for it
+  remus::proto::JobContent& placeholder = skeleton[key];
+  placeholder = make_StreamedPlaceholder(placeholder);
+  streamedKeys.insert(key);
+
+  remus::proto::Job job = this->sendSubmission(skeleton, streamedKeys,
+                                        remus::common::SharedMemoryHandles(),
+                                        remus::proto::ContentDigests());
+  typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+  for(KeyIt i = streamedKeys.begin(); i != streamedKeys.end() && job.valid(); ++i)
+    {
+    const bool sent = (*i == key) ?
+      this->streamContent(job, key, placeholder.formatType(), content) :
+      this->streamContent(job, *i, submission.find(*i)->second);
+    if(!sent)
+      {
+      //make sure the server doesn't hold onto a job it can't run
+      this->terminate(job);
+      job = remus::proto::make_invalidJob();
+      }
+    }
+  return job;
 }
 
 //------------------------------------------------------------------------------
@@ -152,6 +386,46 @@ remus::proto::JobStatus Client::jobStatus(const remus::proto::Job& job)
   return remus::proto::to_JobStatus(status);
 }
 
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus>
+Client::waitForJobs(const std::vector<remus::proto::Job>& jobs,
+                    boost::int64_t timeoutInMilliseconds)
+{
+  std::vector<remus::proto::JobStatus> statuses;
+  if(jobs.empty())
+    {
+    return statuses;
+    }
+
+  std::ostringstream input_buffer;
+  input_buffer << timeoutInMilliseconds << std::endl;
+  input_buffer << jobs.size() << std::endl;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    input_buffer << jobs[i];
+    }
+
+  remus::proto::send_Message(remus::common::MeshIOType(),
+                             remus::WAIT_FOR_JOBS,
+                             input_buffer.str(),
+                             &this->Zmq->Server);
+
+  remus::proto::Response response =
+      remus::proto::receive_Response(&this->Zmq->Server);
+  const std::string data(response.data(), response.dataSize());
+  std::istringstream output_buffer(data);
+
+  std::size_t numberOfStatuses = 0;
+  output_buffer >> numberOfStatuses;
+  for(std::size_t i=0; i < numberOfStatuses && output_buffer.good(); ++i)
+    {
+    remus::proto::JobStatus status(boost::uuids::uuid(), remus::INVALID_STATUS);
+    output_buffer >> status;
+    statuses.push_back(status);
+    }
+  return statuses;
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
 {
@@ -166,6 +440,271 @@ remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
   return remus::proto::to_JobResult(result);
 }
 
+//------------------------------------------------------------------------------
+bool Client::retrieveResults(const remus::proto::Job& job, std::ostream& output)
+{
+  //we request one chunk at a time, so the server never has more than a
+  //single chunk of the result in flight to us
+  remus::common::MD5Hasher hasher;
+  boost::uint64_t offset = 0;
+  while(true)
+    {
+    std::ostringstream input_buffer;
+    input_buffer << offset << std::endl;
+    input_buffer << job;
+
+    remus::proto::send_Message(job.type(),
+                               remus::RESULT_CHUNK,
+                               input_buffer.str(),
+                               &this->Zmq->Server);
+
+    remus::proto::Response response =
+        remus::proto::receive_Response(&this->Zmq->Server);
+    const remus::proto::DataChunk chunk =
+        remus::proto::to_DataChunk(response.data(), response.dataSize());
+
+    //an empty chunk that isn't the last one means there is no result
+    if(chunk.offset() != offset ||
+       (chunk.dataSize() == 0 && !chunk.isFinal()))
+      {
+      return false;
+      }
+
+    output.write(chunk.data(), static_cast<std::streamsize>(chunk.dataSize()));
+    hasher.append(chunk.data(), chunk.dataSize());
+    offset += chunk.dataSize();
+
+    if(chunk.isFinal())
+      {
+      return offset == chunk.totalSize() &&
+             hasher.hash() == chunk.checksum() &&
+             output.good();
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ContentDigests
+Client::storedContent(const remus::proto::JobSubmission& submission)
+{
+  //only content that is large enough to be streamed is worth asking about
+  remus::proto::ContentDigests digests;
+  typedef remus::proto::JobSubmission::const_iterator it;
+  for(it i = submission.begin(); i != submission.end(); ++i)
+    {
+    if(i->second.sourceType() == remus::common::ContentSource::Memory &&
+       i->second.dataSize() > remus::STREAM_CHUNK_SIZE)
+      {
+      digests[i->first] = i->second.hash();
+      }
+    }
+  if(digests.empty())
+    {
+    return digests;
+    }
+
+  std::ostringstream input_buffer;
+  remus::proto::writeContentDigests(input_buffer, digests);
+  remus::proto::send_Message(submission.type(),
+                             remus::MISSING_CONTENT,
+                             input_buffer.str(),
+                             &this->Zmq->Server);
+
+  remus::proto::Response response =
+      remus::proto::receive_Response(&this->Zmq->Server);
+  if(response.serviceType() != remus::MISSING_CONTENT)
+    {
+    //the server doesn't keep content, so we have to send all of it
+    return remus::proto::ContentDigests();
+    }
+
+  const std::string data(response.data(), response.dataSize());
+  std::istringstream output_buffer(data);
+  const remus::proto::ContentDigests missing =
+                              remus::proto::readContentDigests(output_buffer);
+  typedef remus::proto::ContentDigests::const_iterator DigestIt;
+  for(DigestIt i = missing.begin(); i != missing.end(); ++i)
+    {
+    digests.erase(i->first);
+    }
+  return digests;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::sendSubmission(const remus::proto::JobSubmission& submission,
+                       const remus::proto::StreamedKeys& keys,
+                       const remus::common::SharedMemoryHandles& handles,
+                       const remus::proto::ContentDigests& stored)
+{
+  std::ostringstream buffer;
+  buffer << submission;
+  if(!keys.empty() || !handles.empty() || !stored.empty())
+    {
+    remus::proto::writeStreamedKeys(buffer, keys);
+    }
+  if(!handles.empty() || !stored.empty())
+    {
+    remus::common::writeSharedMemoryHandles(buffer, handles);
+    }
+  if(!stored.empty())
+    {
+    remus::proto::writeContentDigests(buffer, stored);
+    }
+
+  remus::proto::send_Message(submission.type(),
+                             remus::MAKE_MESH,
+                            buffer.str(),
+                            &this->Zmq->Server);
+
+  remus::proto::Response response =
+      remus::proto::receive_Response(&this->Zmq->Server);
+  const std::string job(response.data(), response.dataSize());
+  return remus::proto::to_Job(job);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::sendSharedSubmission(const remus::proto::JobSubmission& skeleton,
+                             const remus::proto::JobSubmission& submission,
+                             const remus::proto::StreamedKeys& keys,
+                             const remus::proto::ContentDigests& stored)
+{
+  remus::common::SharedMemoryHandles handles;
+  bool created = true;
+  typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+  for(KeyIt i = keys.begin(); i != keys.end() && created; ++i)
+    {
+    const remus::proto::JobContent& content = submission.find(*i)->second;
+    handles[*i] = remus::common::make_SharedMemory(content.data(),
+                                                   content.dataSize());
+    created = handles[*i].valid();
+    }
+
+  remus::proto::Job job = remus::proto::make_invalidJob();
+  if(created)
+    {
+    job = this->sendSubmission(skeleton, remus::proto::StreamedKeys(), handles,
+                               stored);
+    }
+
+  //the server has mapped the segments by now, or never will
+  typedef remus::common::SharedMemoryHandles::const_iterator HandleIt;
+  for(HandleIt i = handles.begin(); i != handles.end(); ++i)
+    {
+    remus::common::remove_SharedMemory(i->second);
+    }
+  return job;
+}
+
+//------------------------------------------------------------------------------
+bool Client::streamContent(const remus::proto::Job& job,
+                           const std::string& key,
+                           const remus::proto::JobContent& content)
+{
+  if(content.sourceType() == remus::common::ContentSource::File)
+    {
+    //send the file straight from a mapping of it, so it is never
+    //read into memory as a whole
+    const remus::common::FileHandle handle(
+                          std::string(content.data(), content.dataSize()));
+    remus::common::MappedFile file(handle);
+    return file.valid() &&
+           this->streamContent(job, key, content.formatType(),
+                               file.data(), file.size());
+    }
+  return this->streamContent(job, key, content.formatType(),
+                             content.data(), content.dataSize());
+}
+
+//------------------------------------------------------------------------------
+bool Client::streamContent(const remus::proto::Job& job,
+                           const std::string& key,
+                           remus::common::ContentFormat::Type format,
+                           const char* data,
+                           std::size_t size)
+{
+  remus::common::MD5Hasher hasher;
+  std::size_t offset = 0;
+  bool streaming = true;
+  while(streaming)
+    {
+    const std::size_t length = std::min(remus::STREAM_CHUNK_SIZE, size - offset);
+    hasher.append(data + offset, length);
+
+    remus::proto::DataChunk chunk(job.id(), format, offset,
+                                  data + offset, length);
+    chunk.key(key);
+    offset += length;
+
+    const bool lastChunk = (offset == size);
+    if(lastChunk)
+      {
+      chunk.markAsFinal(size, hasher.hash());
+      }
+    if(!this->sendSubmissionChunk(job, chunk))
+      {
+      return false;
+      }
+    streaming = !lastChunk;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool Client::streamContent(const remus::proto::Job& job,
+                           const std::string& key,
+                           remus::common::ContentFormat::Type format,
+                           std::istream& content)
+{
+  remus::common::MD5Hasher hasher;
+  std::vector<char> buffer(remus::STREAM_CHUNK_SIZE);
+  boost::uint64_t offset = 0;
+  bool streaming = true;
+  while(streaming)
+    {
+    content.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    const std::size_t length = static_cast<std::size_t>(content.gcount());
+    hasher.append(&buffer[0], length);
+
+    remus::proto::DataChunk chunk(job.id(), format, offset,
+                                  &buffer[0], length);
+    chunk.key(key);
+    offset += length;
+
+    //a short read means we have reached the end of the input. When the
+    //input is a multiple of the chunk size this sends an empty final chunk
+    const bool lastChunk = length < buffer.size();
+    if(lastChunk)
+      {
+      chunk.markAsFinal(offset, hasher.hash());
+      }
+    if(!this->sendSubmissionChunk(job, chunk))
+      {
+      return false;
+      }
+    streaming = !lastChunk;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool Client::sendSubmissionChunk(const remus::proto::Job& job,
+                                 const remus::proto::DataChunk& chunk)
+{
+  //we wait for each chunk to be acknowledged, which keeps the server
+  //from ever having more than a single chunk of ours in flight
+  remus::proto::send_Message(job.type(),
+                             remus::SUBMISSION_CHUNK,
+                             remus::proto::to_string(chunk),
+                             &this->Zmq->Server);
+
+  remus::proto::Response response =
+      remus::proto::receive_Response(&this->Zmq->Server);
+  const std::string ack(response.data(), response.dataSize());
+  return ack != remus::INVALID_MSG;
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
 {
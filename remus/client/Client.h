@@ -13,14 +13,17 @@
 #ifndef remus_client_Client_h
 #define remus_client_Client_h
 
+#include <boost/cstdint.hpp>
 #include <boost/scoped_ptr.hpp>
 
 #include <remus/client/ServerConnection.h>
 
 #include <remus/common/MeshIOType.h>
+#include <remus/common/SharedMemory.h>
 
 //Clients include everything from proto, so that
 //users don't need as many includes
+#include <remus/proto/DataChunk.h>
 #include <remus/proto/Job.h>
 #include <remus/proto/JobRequirements.h>
 #include <remus/proto/JobResult.h>
@@ -30,13 +33,18 @@
 //included for export symbols
 #include <remus/client/ClientExports.h>
 
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
 //The client class is used to submit meshing jobs to a remus server.
 //The class also allows you to query on the state of a given job and
 //to retrieve the results of the job when it is finished.
 namespace remus{
 namespace client{
 
-namespace detail { struct ZmqManagement; }
+namespace detail { struct ZmqManagement; struct RequirementsCache; }
 
 class REMUSCLIENT_EXPORT Client
 {
@@ -66,20 +74,53 @@ public:
 
   //submit a request to the server to see if the server supports
   //the request input and output mesh types. If the server does support
-  //the given types, return a collection of JobRequirements
+  //the given types, return a collection of JobRequirements.
+  //The requirements are cached, and the server only sends the requirements
+  //that changed since the last time we asked for the same types
   remus::proto::JobRequirementsSet
   retrieveRequirements( const remus::common::MeshIOType& meshtypes );
 
   //Submit a job to the server. The job submission has a JobData and
-  //a JobRequirements component
+  //a JobRequirements component. Content larger than remus::STREAM_CHUNK_SIZE
+  //is streamed to the server in chunks after the submission, so that no
+  //single message has to hold all of it, or handed to the server through
+  //shared memory when it is on the same machine. When the server isn't local,
+  //content that is a file is streamed from the file and the worker receives
+  //it as a file of its own. Large in memory content that the server already
+  //holds from an earlier submission isn't sent again. Returns an invalid job
+  //if the server rejected the submission or any of the streamed content.
   remus::proto::Job submitJob(const remus::proto::JobSubmission& submission);
 
+  //Submit a job to the server, streaming the content of the given key
+  //from the input stream in chunks of remus::STREAM_CHUNK_SIZE until the
+  //stream ends. The format and tag of the content are taken from the entry
+  //of the submission with the same key, if there is one. This allows
+  //content that is larger than available memory to be sent from a file.
+  remus::proto::Job submitJob(const remus::proto::JobSubmission& submission,
+                              const std::string& key,
+                              std::istream& content);
+
   //Given a remus Job object returns the status of the job
   remus::proto::JobStatus jobStatus(const remus::proto::Job& job);
 
+  //Blocks until any of the given jobs has finished, failed or expired, or
+  //until the timeout expires. The server holds onto the request and responds
+  //when a job changes, so this replaces polling jobStatus in a loop.
+  //Returns the status of each job, in the same order as the jobs were given.
+  std::vector<remus::proto::JobStatus>
+  waitForJobs(const std::vector<remus::proto::Job>& jobs,
+              boost::int64_t timeoutInMilliseconds);
+
   //Return job result of of a give job
   remus::proto::JobResult retrieveResults(const remus::proto::Job& job);
 
+  //Streams the result of a given job from the server in chunks of
+  //remus::STREAM_CHUNK_SIZE, writing each chunk to the output as it arrives.
+  //This allows results that are larger than available memory to be written
+  //directly to a file. Returns false if the job has no result, or if the
+  //data received doesn't match the checksum computed by the server.
+  bool retrieveResults(const remus::proto::Job& job, std::ostream& output);
+
   //attempts to terminate a given job, will kill the job if the job hasn't
   //started. If the job has been finished and the results
   //are on the server the results will be deleted. If the job is in process
@@ -93,7 +134,58 @@ private:
   Client(const Client&);
   void operator=(const Client&);
 
+  //ask the server for all of the requirements of the mesh types, for
+  //servers that don't support CACHED_MESH_REQUIREMENTS
+  remus::proto::JobRequirementsSet
+  downloadRequirements(const remus::common::MeshIOType& meshtypes);
+
+  //ask the server which of the large content of the submission it already
+  //holds, returning the digests of that content
+  remus::proto::ContentDigests
+  storedContent(const remus::proto::JobSubmission& submission);
+
+  //send the submission and all of its content, except for the stored
+  //content that is referenced by its digest
+  remus::proto::Job uploadSubmission(const remus::proto::JobSubmission& submission,
+                                     const remus::proto::ContentDigests& stored);
+
+  //send the submission, along with the keys of the content that will
+  //be streamed after it, the handles of content in shared memory and
+  //the digests of content the server already holds
+  remus::proto::Job sendSubmission(const remus::proto::JobSubmission& submission,
+                                   const remus::proto::StreamedKeys& keys,
+                                   const remus::common::SharedMemoryHandles& handles,
+                                   const remus::proto::ContentDigests& stored);
+
+  //send the submission, placing the content of the given keys in shared
+  //memory. Returns an invalid job if the server couldn't map the memory
+  remus::proto::Job sendSharedSubmission(const remus::proto::JobSubmission& skeleton,
+                                         const remus::proto::JobSubmission& submission,
+                                         const remus::proto::StreamedKeys& keys,
+                                         const remus::proto::ContentDigests& stored);
+
+  //stream the given content of a job to the server. Returns false
+  //if the server rejected any of the chunks
+  bool streamContent(const remus::proto::Job& job,
+                     const std::string& key,
+                     const remus::proto::JobContent& content);
+  bool streamContent(const remus::proto::Job& job,
+                     const std::string& key,
+                     remus::common::ContentFormat::Type format,
+                     const char* data,
+                     std::size_t size);
+  bool streamContent(const remus::proto::Job& job,
+                     const std::string& key,
+                     remus::common::ContentFormat::Type format,
+                     std::istream& content);
+
+  //send a single chunk of streamed content and wait for the server to
+  //acknowledge it. Returns false if the server rejected the chunk
+  bool sendSubmissionChunk(const remus::proto::Job& job,
+                           const remus::proto::DataChunk& chunk);
+
   boost::scoped_ptr<detail::ZmqManagement> Zmq;
+  boost::scoped_ptr<detail::RequirementsCache> Requirements;
 };
 
 }
@@ -0,0 +1,258 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/ContentHash.h>
+
+#include <remus/common/MD5Hash.h>
+
+#include <boost/cstdint.hpp>
+
+//suppress warnings inside boost headers for gcc, clang and MSVC
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+typedef boost::uint64_t uint64;
+
+//buffers are hashed in blocks of this size, which is what allows
+//large buffers to be hashed on multiple threads
+static const std::size_t HashBlockSize = 4 * 1024 * 1024;
+
+//the size of a single block digest
+static const std::size_t DigestSize = 16;
+
+//stored as a function since C++98 has no 64bit integer literals
+inline uint64 make_uint64(boost::uint32_t high, boost::uint32_t low)
+{
+  return (static_cast<uint64>(high) << 32) | static_cast<uint64>(low);
+}
+
+const uint64 C1 = make_uint64(0x87c37b91, 0x114253d5);
+const uint64 C2 = make_uint64(0x4cf5ad43, 0x2745937f);
+
+inline uint64 rotl64(uint64 x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+//read 8 bytes as a little endian value, so that every platform
+//computes the same digest
+inline uint64 load64(const unsigned char* p)
+{
+  return  static_cast<uint64>(p[0])        |
+         (static_cast<uint64>(p[1]) << 8)  |
+         (static_cast<uint64>(p[2]) << 16) |
+         (static_cast<uint64>(p[3]) << 24) |
+         (static_cast<uint64>(p[4]) << 32) |
+         (static_cast<uint64>(p[5]) << 40) |
+         (static_cast<uint64>(p[6]) << 48) |
+         (static_cast<uint64>(p[7]) << 56);
+}
+
+inline void store64(uint64 v, unsigned char* p)
+{
+  for(int i=0; i < 8; ++i)
+    {
+    p[i] = static_cast<unsigned char>(v >> (8*i));
+    }
+}
+
+inline uint64 fmix64(uint64 k)
+{
+  k ^= k >> 33;
+  k *= make_uint64(0xff51afd7, 0xed558ccd);
+  k ^= k >> 33;
+  k *= make_uint64(0xc4ceb9fe, 0x1a85ec53);
+  k ^= k >> 33;
+  return k;
+}
+
+//MurmurHash3 x64 128bit, which processes the data as two independent
+//64bit lanes. Writes the 16 byte digest into out.
+void murmur128(const unsigned char* data, std::size_t length,
+               unsigned char* out)
+{
+  const std::size_t nblocks = length / 16;
+  uint64 h1 = 0;
+  uint64 h2 = 0;
+
+  for(std::size_t i=0; i < nblocks; ++i)
+    {
+    uint64 k1 = load64(data + (i*16));
+    uint64 k2 = load64(data + (i*16) + 8);
+
+    k1 *= C1; k1 = rotl64(k1,31); k1 *= C2; h1 ^= k1;
+    h1 = rotl64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+    k2 *= C2; k2 = rotl64(k2,33); k2 *= C1; h2 ^= k2;
+    h2 = rotl64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+    }
+
+  const unsigned char* tail = data + (nblocks*16);
+  const std::size_t tailSize = length & 15;
+  uint64 k1 = 0;
+  uint64 k2 = 0;
+  for(std::size_t i=tailSize; i > 8; --i)
+    {
+    k2 ^= static_cast<uint64>(tail[i-1]) << (8*(i-9));
+    }
+  if(tailSize > 8)
+    {
+    k2 *= C2; k2 = rotl64(k2,33); k2 *= C1; h2 ^= k2;
+    }
+  for(std::size_t i=std::min<std::size_t>(tailSize,8); i > 0; --i)
+    {
+    k1 ^= static_cast<uint64>(tail[i-1]) << (8*(i-1));
+    }
+  if(tailSize > 0)
+    {
+    k1 *= C1; k1 = rotl64(k1,31); k1 *= C2; h1 ^= k1;
+    }
+
+  h1 ^= static_cast<uint64>(length);
+  h2 ^= static_cast<uint64>(length);
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+
+  store64(h1, out);
+  store64(h2, out + 8);
+}
+
+//hashes every stride'th block starting at first, storing each block
+//digest at its position in the digests buffer
+struct HashBlocks
+{
+  HashBlocks(const unsigned char* d, std::size_t l,
+             std::size_t f, std::size_t s,
+             unsigned char* o):
+    Data(d), Length(l), First(f), Stride(s), Digests(o)
+  {
+  }
+
+  void operator()() const
+  {
+    const std::size_t numBlocks = (this->Length + HashBlockSize - 1) /
+                                  HashBlockSize;
+    for(std::size_t i=this->First; i < numBlocks; i+=this->Stride)
+      {
+      const std::size_t offset = i * HashBlockSize;
+      const std::size_t size = std::min(HashBlockSize, this->Length - offset);
+      murmur128(this->Data + offset, size, this->Digests + (i*DigestSize));
+      }
+  }
+
+  const unsigned char* Data;
+  std::size_t Length;
+  std::size_t First;
+  std::size_t Stride;
+  unsigned char* Digests;
+};
+
+std::string to_hex(const unsigned char* digest)
+{
+  static const char hex[] = "0123456789abcdef";
+  std::string result(DigestSize*2, '0');
+  for(std::size_t i=0; i < DigestSize; ++i)
+    {
+    result[2*i] = hex[digest[i] >> 4];
+    result[2*i+1] = hex[digest[i] & 0x0f];
+    }
+  return result;
+}
+
+remus::common::HashAlgorithm::Type DefaultAlgorithm =
+  remus::common::HashAlgorithm::Fast128;
+}
+
+namespace remus {
+namespace common {
+
+//------------------------------------------------------------------------------
+std::string FastHash(const char* data, std::size_t length)
+{
+  const unsigned char* udata = reinterpret_cast<const unsigned char*>(data);
+  unsigned char digest[DigestSize];
+  if(length <= HashBlockSize)
+    {
+    murmur128(udata, length, digest);
+    return to_hex(digest);
+    }
+
+  //hash each block on its own, and then hash the block digests
+  //followed by the total length
+  const std::size_t numBlocks = (length + HashBlockSize - 1) / HashBlockSize;
+  std::vector<unsigned char> digests( (numBlocks*DigestSize) + 8 );
+
+  std::size_t numThreads = std::max(1u, boost::thread::hardware_concurrency());
+  numThreads = std::min(numThreads, numBlocks);
+
+  boost::thread_group threads;
+  for(std::size_t i=1; i < numThreads; ++i)
+    {
+    threads.create_thread( HashBlocks(udata, length, i, numThreads,
+                                      &digests[0]) );
+    }
+  //the calling thread does its share of the blocks as well
+  HashBlocks(udata, length, 0, numThreads, &digests[0])();
+  threads.join_all();
+
+  store64(static_cast<uint64>(length), &digests[numBlocks*DigestSize]);
+  murmur128(&digests[0], digests.size(), digest);
+  return to_hex(digest);
+}
+
+//------------------------------------------------------------------------------
+std::string ContentHash(const char* data, std::size_t length,
+                        remus::common::HashAlgorithm::Type algorithm)
+{
+  if(algorithm == remus::common::HashAlgorithm::MD5)
+    {
+    return remus::common::MD5Hash(data, length);
+    }
+  return remus::common::FastHash(data, length);
+}
+
+//------------------------------------------------------------------------------
+std::string ContentHash(const char* data, std::size_t length)
+{
+  return remus::common::ContentHash(data, length, DefaultAlgorithm);
+}
+
+//------------------------------------------------------------------------------
+remus::common::HashAlgorithm::Type defaultHashAlgorithm()
+{
+  return DefaultAlgorithm;
+}
+
+//------------------------------------------------------------------------------
+void defaultHashAlgorithm(remus::common::HashAlgorithm::Type algorithm)
+{
+  DefaultAlgorithm = algorithm;
+}
+
+}
+}
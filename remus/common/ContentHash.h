@@ -0,0 +1,63 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_ContentHash_h
+#define remus_common_ContentHash_h
+
+#include <string>
+#include <remus/common/CommonExports.h>
+
+namespace remus {
+namespace common {
+
+//The algorithms that can be used to compute the digest of content.
+//Fast128 is a 128bit non cryptographic hash, MD5 is kept for users
+//that need digests that match other MD5 based tools.
+struct HashAlgorithm
+{
+  enum Type
+  {
+    Fast128 = 0,
+    MD5 = 1
+  };
+};
+
+//Computes the 128bit non cryptographic hash of the data and returns it as
+//32 hex characters. Buffers larger than a few megabytes are split into fixed
+//size blocks that are hashed on multiple threads, and the digest of the
+//blocks is then hashed. The block size is fixed, so the result doesn't
+//depend on the number of threads used.
+REMUSCOMMON_EXPORT
+std::string FastHash(const char* data, std::size_t length);
+
+//Computes the hex digest of the data with the given algorithm
+REMUSCOMMON_EXPORT
+std::string ContentHash(const char* data, std::size_t length,
+                        remus::common::HashAlgorithm::Type algorithm);
+
+//Computes the hex digest of the data with the default algorithm
+REMUSCOMMON_EXPORT
+std::string ContentHash(const char* data, std::size_t length);
+
+//Get and set the algorithm used when one isn't given. Defaults to Fast128.
+//The default should only be changed before any content has been hashed,
+//as containers of JobContent are ordered by these digests.
+REMUSCOMMON_EXPORT
+remus::common::HashAlgorithm::Type defaultHashAlgorithm();
+
+REMUSCOMMON_EXPORT
+void defaultHashAlgorithm(remus::common::HashAlgorithm::Type algorithm);
+
+}
+}
+
+#endif
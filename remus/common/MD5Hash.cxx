@@ -16,15 +16,32 @@
 
 #include <RemusSysTools/MD5.h>
 
+#include <climits>
+
 namespace
 {
+  //RemusSysToolsMD5_Append takes an int length, and treats a negative one
+  //as a null terminated string, so larger data is fed in pieces
+  void append_data(RemusSysToolsMD5* hasher,
+                   const char* data, std::size_t length)
+  {
+    const std::size_t maxPiece = static_cast<std::size_t>(INT_MAX);
+    while(length > 0)
+      {
+      const std::size_t piece = length < maxPiece ? length : maxPiece;
+      RemusSysToolsMD5_Append(hasher,
+                              reinterpret_cast<const unsigned char*>(data),
+                              static_cast<int>(piece) );
+      data += piece;
+      length -= piece;
+      }
+  }
+
   std::string to_hash(const char* data, const std::size_t length)
   {
     RemusSysToolsMD5* hasher = RemusSysToolsMD5_New();
     RemusSysToolsMD5_Initialize(hasher);
-    RemusSysToolsMD5_Append(hasher,
-                       reinterpret_cast<const unsigned char*>(data),
-                       static_cast<int>(length) );
+    append_data(hasher, data, length);
     char hash[32];
     RemusSysToolsMD5_FinalizeHex(hasher, hash);
     RemusSysToolsMD5_Delete(hasher);
@@ -50,5 +67,41 @@ std::string MD5Hash(const char* data, std::size_t length)
   return to_hash(data,length);
 }
 
+//------------------------------------------------------------------------------
+struct MD5Hasher::InternalImpl
+{
+  RemusSysToolsMD5* Hasher;
+};
+
+//------------------------------------------------------------------------------
+MD5Hasher::MD5Hasher():
+  Implementation(new InternalImpl())
+{
+  this->Implementation->Hasher = RemusSysToolsMD5_New();
+  RemusSysToolsMD5_Initialize(this->Implementation->Hasher);
+}
+
+//------------------------------------------------------------------------------
+MD5Hasher::~MD5Hasher()
+{
+  RemusSysToolsMD5_Delete(this->Implementation->Hasher);
+  delete this->Implementation;
+}
+
+//------------------------------------------------------------------------------
+void MD5Hasher::append(const char* data, std::size_t length)
+{
+  append_data(this->Implementation->Hasher, data, length);
+}
+
+//------------------------------------------------------------------------------
+std::string MD5Hasher::hash()
+{
+  char hash[32];
+  RemusSysToolsMD5_FinalizeHex(this->Implementation->Hasher, hash);
+  RemusSysToolsMD5_Initialize(this->Implementation->Hasher);
+  return std::string(hash,32);
+}
+
 }
 }
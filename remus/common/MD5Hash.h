@@ -31,6 +31,31 @@ std::string MD5Hash(const std::string& data);
 REMUSCOMMON_EXPORT
 std::string MD5Hash(const char* data, std::size_t length);
 
+//Computes the MD5 hash of data that arrives in pieces, such as content
+//that is streamed in chunks. The result of hash() is identical to calling
+//MD5Hash on all the pieces joined together.
+class REMUSCOMMON_EXPORT MD5Hasher
+{
+public:
+  MD5Hasher();
+  ~MD5Hasher();
+
+  //add the next piece of data to the hash
+  void append(const char* data, std::size_t length);
+
+  //return the hex hash of everything appended so far. Once called
+  //the hasher is reset, and will start hashing new data
+  std::string hash();
+
+private:
+  //explicitly state the hasher doesn't support copy or move semantics
+  MD5Hasher(const MD5Hasher&);
+  void operator=(const MD5Hasher&);
+
+  struct InternalImpl;
+  InternalImpl* Implementation;
+};
+
 }
 }
 
@@ -0,0 +1,88 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/MappedFile.h>
+
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+namespace remus {
+namespace common {
+
+struct MappedFile::InternalImpl
+{
+  boost::interprocess::file_mapping Mapping;
+  boost::interprocess::mapped_region Region;
+};
+
+//------------------------------------------------------------------------------
+MappedFile::MappedFile(const remus::common::FileHandle& handle):
+  Valid(false),
+  Data(NULL),
+  Size(0),
+  Implementation(NULL)
+{
+  boost::system::error_code ec;
+  const boost::uintmax_t fileSize =
+                      boost::filesystem::file_size(handle.path(), ec);
+  if(ec)
+    {
+    return;
+    }
+
+  if(fileSize == 0)
+    { //an empty file can't be mapped, but is still a valid file
+    this->Valid = true;
+    return;
+    }
+
+  try
+    {
+    this->Implementation = new InternalImpl();
+    boost::interprocess::file_mapping mapping(handle.path().c_str(),
+                                              boost::interprocess::read_only);
+    boost::interprocess::mapped_region region(mapping,
+                                              boost::interprocess::read_only);
+    this->Implementation->Mapping.swap(mapping);
+    this->Implementation->Region.swap(region);
+
+    this->Data = static_cast<const char*>(this->Implementation->Region.get_address());
+    this->Size = this->Implementation->Region.get_size();
+    this->Valid = true;
+    }
+  catch(const boost::interprocess::interprocess_exception&)
+    {
+    this->Data = NULL;
+    this->Size = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+  delete this->Implementation;
+}
+
+}
+}
@@ -0,0 +1,56 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_MappedFile_h
+#define remus_common_MappedFile_h
+
+#include <string>
+
+#include <remus/common/FileHandle.h>
+#include <remus/common/CommonExports.h>
+
+namespace remus {
+namespace common {
+
+//Maps the contents of a file into memory as read only, so that the file can
+//be sent over the wire without ever being read into a string. The mapping
+//is released when the MappedFile is destroyed.
+class REMUSCOMMON_EXPORT MappedFile
+{
+public:
+  explicit MappedFile(const remus::common::FileHandle& handle);
+  ~MappedFile();
+
+  //returns false if the file doesn't exist or couldn't be mapped
+  bool valid() const { return this->Valid; }
+
+  //the contents of the file. An empty file has a NULL data pointer
+  const char* data() const { return this->Data; }
+  std::size_t size() const { return this->Size; }
+
+private:
+  //explicitly state the mapping doesn't support copy or move semantics
+  MappedFile(const MappedFile&);
+  void operator=(const MappedFile&);
+
+  bool Valid;
+  const char* Data;
+  std::size_t Size;
+
+  struct InternalImpl;
+  InternalImpl* Implementation;
+};
+
+}
+}
+
+#endif
@@ -16,6 +16,48 @@
 //remus proto or not
 #include <remus/common/conversionHelper.h>
 
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+  //the io types built by allRegisteredIOTypes, and the generation of the
+  //registrar they were built from
+  struct AllIOTypesCache
+  {
+    AllIOTypesCache(): Mutex(), Types(), Generation(0) {}
+
+    boost::mutex Mutex;
+    boost::shared_ptr< const std::set< remus::common::MeshIOType > > Types;
+    boost::uint64_t Generation;
+  };
+
+  //like the registry of MeshRegistrar the cache is made on first use with
+  //call_once, as function local statics aren't constructed thread safely
+  //by every compiler we support. It is never destroyed
+  AllIOTypesCache* TheAllIOTypesCache = NULL;
+  void makeAllIOTypesCache()
+  {
+    TheAllIOTypesCache = new AllIOTypesCache();
+  }
+
+  AllIOTypesCache& allIOTypesCache()
+  {
+    static boost::once_flag flag = BOOST_ONCE_INIT;
+    boost::call_once(&makeAllIOTypesCache, flag);
+    return *TheAllIOTypesCache;
+  }
+}
+
 namespace remus {
 namespace common {
 
@@ -65,6 +107,37 @@ bool MeshIOType::operator <(const MeshIOType& b) const
     { return ( this->inputType() < b.inputType() ); }
   }
 
+//------------------------------------------------------------------------------
+boost::shared_ptr< const std::set< MeshIOType > > allRegisteredIOTypes()
+{
+  //the generation of the registrar is bumped by each of the built in types,
+  //so it is never zero
+  const boost::uint64_t generation = MeshRegistrar::generation();
+
+  AllIOTypesCache& cache = allIOTypesCache();
+  boost::lock_guard<boost::mutex> lock(cache.Mutex);
+  if(generation != cache.Generation)
+    {
+    //build a new set instead of clearing the current one, as callers
+    //can still be enumerating it. The names are sorted, so every io
+    //type goes at the end of the set
+    boost::shared_ptr< std::set< MeshIOType > > ioTypes(
+                                              new std::set< MeshIOType >() );
+    const std::vector<std::string> names = MeshRegistrar::allRegisteredNames();
+    typedef std::vector<std::string>::const_iterator cit;
+    for(cit i=names.begin(); i!=names.end(); ++i)
+      {
+      for(cit j=names.begin(); j!=names.end(); ++j)
+        {
+        ioTypes->insert(ioTypes->end(), MeshIOType(*i,*j));
+        }
+      }
+    cache.Types = ioTypes;
+    cache.Generation = generation;
+    }
+  return cache.Types;
+}
+
 //------------------------------------------------------------------------------
 void MeshIOType::serialize(std::ostream& buffer) const
 {
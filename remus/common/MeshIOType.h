@@ -129,26 +129,20 @@ inline remus::common::MeshIOType make_MeshIOType(
   return remus::common::MeshIOType(in,out);
 }
 
-//helper method to generate the cross product of all known mesh io types
+//returns the cross product of all the registered mesh types. The set is
+//only rebuilt after a new mesh type is registered, so enumerating the
+//io types doesn't allocate. The set is never modified once it is handed
+//out, so it stays valid while it is held, even after a rebuild, and it is
+//safe to call from multiple threads.
+REMUSCOMMON_EXPORT
+boost::shared_ptr< const std::set< remus::common::MeshIOType > >
+allRegisteredIOTypes();
+
+//helper method to generate the cross product of all known mesh io types.
+//This copies the set, prefer allRegisteredIOTypes to enumerate them
 inline std::set< remus::common::MeshIOType > generateAllIOTypes()
 {
-  using namespace remus::common;
-  using namespace remus::meshtypes;
-  typedef boost::shared_ptr<remus::meshtypes::MeshTypeBase> MeshType;
-  std::set<MeshType> all_types = remus::common::MeshRegistrar::allRegisteredTypes();
-
-  std::set< MeshIOType > allIOTypes;
-
-  typedef std::set<MeshType>::const_iterator cit;
-  for(cit i=all_types.begin(); i!=all_types.end(); ++i)
-    {
-    for(cit j=all_types.begin(); j!=all_types.end(); ++j)
-      {
-      allIOTypes.insert( MeshIOType(*i,*j) );
-      }
-    }
-
-  return allIOTypes;
+  return *remus::common::allRegisteredIOTypes();
 }
 
 
@@ -14,41 +14,214 @@
 //include the default mesh types
 #include <remus/common/MeshTypes.h>
 
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+
 namespace
 {
-  //a work around so that we always have the default types added to the
-  //mesh registry, no matter what. This does have a small performance
-  //overhead
-  void add_default_types()
+  //the id given to the first plugin mesh type
+  const boost::uint16_t FirstPluginId = 101;
+}
+
+namespace remus {
+namespace common {
+
+//------------------------------------------------------------------------------
+struct MeshRegistrar::Registry
+{
+  struct Entry
   {
-    static bool defaults_added  = false;
-    if(!defaults_added)
-      {
-      //this needs to be set before we add any of the default types or
-      //we will start an endless loop of calling this function.
-      defaults_added = true;
-
-      remus::common::MeshRegistrar a( (remus::meshtypes::Mesh1D()) );
-      remus::common::MeshRegistrar b( (remus::meshtypes::Mesh2D()) );
-      remus::common::MeshRegistrar c( (remus::meshtypes::Mesh3D()) );
-      remus::common::MeshRegistrar d( (remus::meshtypes::Mesh3DSurface()) );
-      remus::common::MeshRegistrar e( (remus::meshtypes::SceneFile()) );
-      remus::common::MeshRegistrar f( (remus::meshtypes::Model()) );
-      remus::common::MeshRegistrar g( (remus::meshtypes::Edges()) );
-      remus::common::MeshRegistrar h( (remus::meshtypes::PiecewiseLinearComplex()) );
+    boost::uint16_t Id;
+    create_function_ptr Create;
+  };
+
+  //the built in types are added before anything else can be registered,
+  //so we no longer need to check that they are present on every lookup
+  Registry():
+    Mutex(),
+    Types(),
+    Names(FirstPluginId),
+    SortedNames(),
+    NextPluginId(FirstPluginId),
+    Generation(0)
+  {
+    using namespace remus::meshtypes;
+    this->addBuiltin<Mesh1D>();
+    this->addBuiltin<Mesh2D>();
+    this->addBuiltin<Mesh3D>();
+    this->addBuiltin<Mesh3DSurface>();
+    this->addBuiltin<SceneFile>();
+    this->addBuiltin<Model>();
+    this->addBuiltin<Edges>();
+    this->addBuiltin<PiecewiseLinearComplex>();
+  }
+
+  template<typename T>
+  void addBuiltin()
+  {
+    this->add(T::typeName(), static_cast<boost::uint16_t>(T::Id), &T::create);
+  }
+
+  void add(const std::string& name, boost::uint16_t id, create_function_ptr fp)
+  {
+    Entry entry;
+    entry.Id = id;
+    entry.Create = fp;
+    this->Types[name] = entry;
 
+    if(id >= this->Names.size())
+      {
+      this->Names.resize(id + 1);
       }
+    this->Names[id] = name;
+
+    this->SortedNames.insert(std::lower_bound(this->SortedNames.begin(),
+                                              this->SortedNames.end(),
+                                              name),
+                             name);
+    ++this->Generation;
   }
+
+  //guards everything below, types are registered from static
+  //initializers of plugins while other threads can be looking them up
+  boost::mutex Mutex;
+
+  typedef boost::unordered_map<std::string, Entry> NameMapType;
+  NameMapType Types;
+
+  //the names of the types indexed by their id
+  std::vector<std::string> Names;
+  std::vector<std::string> SortedNames;
+  boost::uint16_t NextPluginId;
+  boost::uint64_t Generation;
+};
+
+//the registry is never destroyed, so that types can still be looked up
+//from static destructors
+MeshRegistrar::Registry* MeshRegistrar::Instance = NULL;
+
+//------------------------------------------------------------------------------
+void MeshRegistrar::makeRegistry()
+{
+  MeshRegistrar::Instance = new MeshRegistrar::Registry();
 }
 
-namespace remus {
-namespace common {
+//------------------------------------------------------------------------------
+MeshRegistrar::Registry& MeshRegistrar::registry()
+{
+  //function local statics aren't constructed thread safely by every
+  //compiler we support, and plugins register their types from static
+  //initializers, so the registry is made on first use with call_once.
+  //The flag is constant initialized, so it is valid before any of that
+  static boost::once_flag flag = BOOST_ONCE_INIT;
+  boost::call_once(&MeshRegistrar::makeRegistry, flag);
+  return *MeshRegistrar::Instance;
+}
+
+//------------------------------------------------------------------------------
+std::size_t MeshRegistrar::numberOfRegisteredTypes()
+{
+  Registry& reg = registry();
+  boost::lock_guard<boost::mutex> lock(reg.Mutex);
+  return reg.Types.size();
+}
+
+//------------------------------------------------------------------------------
+std::vector<std::string> MeshRegistrar::allRegisteredNames()
+{
+  Registry& reg = registry();
+  boost::lock_guard<boost::mutex> lock(reg.Mutex);
+  return reg.SortedNames;
+}
+
+//------------------------------------------------------------------------------
+boost::uint16_t MeshRegistrar::id(const std::string& name)
+{
+  Registry& reg = registry();
+  boost::lock_guard<boost::mutex> lock(reg.Mutex);
+  Registry::NameMapType::const_iterator it = reg.Types.find(name);
+  return (it == reg.Types.end()) ? 0 : it->second.Id;
+}
+
+//------------------------------------------------------------------------------
+std::string MeshRegistrar::name(boost::uint16_t id)
+{
+  //id 0 is never given out, so its name is always empty
+  Registry& reg = registry();
+  boost::lock_guard<boost::mutex> lock(reg.Mutex);
+  return (id < reg.Names.size()) ? reg.Names[id] : reg.Names[0];
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t MeshRegistrar::generation()
+{
+  Registry& reg = registry();
+  boost::lock_guard<boost::mutex> lock(reg.Mutex);
+  return reg.Generation;
+}
+
+//------------------------------------------------------------------------------
+std::set<MeshRegistrar::ReturnType> MeshRegistrar::allRegisteredTypes()
+{
+  //the types are created without holding the lock, so that a create
+  //function can look up other types
+  std::vector<create_function_ptr> creators;
+    {
+    Registry& reg = registry();
+    boost::lock_guard<boost::mutex> lock(reg.Mutex);
+    creators.reserve(reg.Types.size());
+    Registry::NameMapType::const_iterator it;
+    for(it = reg.Types.begin(); it != reg.Types.end(); ++it)
+      { creators.push_back(it->second.Create); }
+    }
+
+  std::set<ReturnType> result;
+  std::vector<create_function_ptr>::const_iterator i;
+  for(i = creators.begin(); i != creators.end(); ++i)
+    { result.insert( (*i)() ); }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+MeshRegistrar::ReturnType MeshRegistrar::instantiate(std::string const & name)
+{
+  create_function_ptr create = NULL;
+    {
+    Registry& reg = registry();
+    boost::lock_guard<boost::mutex> lock(reg.Mutex);
+    Registry::NameMapType::const_iterator it = reg.Types.find(name);
+    if(it != reg.Types.end())
+      { create = it->second.Create; }
+    }
+  return (create == NULL) ?
+          ReturnType(new remus::meshtypes::MeshTypeBase()) :
+          create();
+}
 
-MeshRegistrar::NameRegisteredMeshMapType & MeshRegistrar::NameRegistry()
+//------------------------------------------------------------------------------
+void MeshRegistrar::registrate(std::string const & name,
+                               create_function_ptr fp)
 {
-  add_default_types();
-  static MeshRegistrar::NameRegisteredMeshMapType NameImplementation;
-  return NameImplementation;
+  Registry& reg = registry();
+  boost::lock_guard<boost::mutex> lock(reg.Mutex);
+  Registry::NameMapType::iterator it = reg.Types.find(name);
+  if(it != reg.Types.end())
+    { //registering a type again keeps its id
+    it->second.Create = fp;
+    return;
+    }
+  reg.add(name, reg.NextPluginId++, fp);
 }
 
 }
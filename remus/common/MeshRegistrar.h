@@ -14,6 +14,7 @@
 
 #include <string>
 #include <set>
+#include <vector>
 
 //suppress warnings inside boost headers for gcc and clang
 //as clang supports pragma GCC diagnostic
@@ -55,6 +56,15 @@ struct REMUSCOMMON_EXPORT MeshTypeBase
 namespace remus {
 namespace common {
 
+//The registry of all the mesh types we know by name. The built in mesh types
+//of MeshTypes.h are always registered, with the fixed ids they declare.
+//Plugin mesh types are registered at runtime by constructing a MeshRegistrar,
+//and are given ids starting at 101 in the order they are registered.
+//
+//Looking up a type by name or id, and enumerating the names of all the types
+//never instantiates a type. Types can be registered and looked up from
+//multiple threads, so lookups return copies instead of references into
+//the registry.
 struct REMUSCOMMON_EXPORT MeshRegistrar
 {
 private:
@@ -69,37 +79,35 @@ public:
     MeshRegistrar::registrate(d.name(), &D::create);
     }
 
-  static std::size_t numberOfRegisteredTypes() {
-    return NameRegistry().size();
-  }
+  static std::size_t numberOfRegisteredTypes();
 
-  static std::set<ReturnType> allRegisteredTypes()
-  {
-    std::set<ReturnType> result;
-    boost::unordered_map<std::string, create_function_ptr>::const_iterator it;
-    for(it = NameRegistry().begin(); it != NameRegistry().end(); ++it)
-        { result.insert( (it->second)() ); }
-    return result;
-  }
+  //returns the names of all the registered types in sorted order
+  static std::vector<std::string> allRegisteredNames();
 
-  static ReturnType instantiate(std::string const & name)
-    {
-    boost::unordered_map<std::string,
-        create_function_ptr>::const_iterator it = NameRegistry().find(name);
-    return (it == NameRegistry().end()) ?
-            ReturnType(new remus::meshtypes::MeshTypeBase()) : (it->second)();
-    }
+  //returns the id of the registered type, or 0 if the name isn't registered
+  static boost::uint16_t id(const std::string& name);
 
-private:
-  static void registrate(std::string const & name, create_function_ptr fp)
-    {
-    NameRegistry()[name] = fp;
-    }
+  //returns the name of the registered type, or an empty string if the
+  //id isn't registered
+  static std::string name(boost::uint16_t id);
+
+  //returns a counter that is bumped every time a new type is registered,
+  //so that callers can tell when what they derived from the names is stale
+  static boost::uint64_t generation();
+
+  //instantiates every registered type, prefer allRegisteredNames when
+  //you only need the names
+  static std::set<ReturnType> allRegisteredTypes();
 
+  static ReturnType instantiate(std::string const & name);
+
+private:
+  static void registrate(std::string const & name, create_function_ptr fp);
 
-  typedef boost::unordered_map<std::string, create_function_ptr>
-                                            NameRegisteredMeshMapType;
-  static NameRegisteredMeshMapType& NameRegistry();
+  struct Registry;
+  static Registry& registry();
+  static void makeRegistry();
+  static Registry* Instance;
 
   MeshRegistrar( const MeshRegistrar& other ); // non construction-copyable
   MeshRegistrar& operator=( const MeshRegistrar& ); // non copyable
@@ -17,65 +17,88 @@
 
 //Remus reserves the right to first 100 meshtypes
 //plugin mesh types should start at id 101
+//
+//The built in mesh types have their id and name fixed at compile time, so
+//code that knows the type it wants can use Mesh2D::Id or Mesh2D::typeName()
+//without a lookup. They are always registered with the MeshRegistrar.
 namespace remus {
 namespace meshtypes {
 
 struct Mesh1D : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 1 };
+    static const char* typeName() { return "Mesh1D"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new Mesh1D()); }
-    std::string name() const { return "Mesh1D"; }
+    std::string name() const { return typeName(); }
 };
 
 struct Mesh2D : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 2 };
+    static const char* typeName() { return "Mesh2D"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new Mesh2D()); }
-    std::string name() const { return "Mesh2D"; }
+    std::string name() const { return typeName(); }
 };
 
 struct Mesh3D : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 3 };
+    static const char* typeName() { return "Mesh3D"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new Mesh3D()); }
-    std::string name() const { return "Mesh3D"; }
+    std::string name() const { return typeName(); }
 };
 
 struct Mesh3DSurface : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 4 };
+    static const char* typeName() { return "Mesh3DSurface"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new Mesh3DSurface()); }
-    std::string name() const { return "Mesh3DSurface"; }
+    std::string name() const { return typeName(); }
 };
 
 struct SceneFile : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 5 };
+    static const char* typeName() { return "SceneFile"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new SceneFile()); }
-    std::string name() const { return "SceneFile"; }
+    std::string name() const { return typeName(); }
 };
 
 struct Model : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 6 };
+    static const char* typeName() { return "Model"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new Model()); }
-    std::string name() const { return "Model"; }
+    std::string name() const { return typeName(); }
 };
 
 struct Edges : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 7 };
+    static const char* typeName() { return "Edges"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new Edges()); }
-    std::string name() const { return "Edges"; }
+    std::string name() const { return typeName(); }
 };
 
 struct PiecewiseLinearComplex : remus::meshtypes::MeshTypeBase
 {
+    enum { Id = 8 };
+    static const char* typeName() { return "PiecewiseLinearComplex"; }
     static boost::shared_ptr<MeshTypeBase> create()
       { return boost::shared_ptr<MeshTypeBase>(new PiecewiseLinearComplex()); }
-    std::string name() const { return "PiecewiseLinearComplex"; }
+    std::string name() const { return typeName(); }
 };
 
+//the number of built in mesh types, which have the ids 1 to NumberOfBuiltinTypes
+enum { NumberOfBuiltinTypes = 8 };
+
 inline boost::shared_ptr<remus::meshtypes::MeshTypeBase>
 to_meshType(const std::string& s)
 {
@@ -23,7 +23,6 @@
 #endif
 
 #include <algorithm>
-#include <numeric>
 
 namespace remus{
 namespace common{
@@ -42,8 +41,10 @@ class PollingMonitor::PollingTracker
   time_duration CurrentPollRate;  //current duration to poll for
   ptime LastPollTime; //the exact time we last polled
 
-  //the frequency we have polled in the past
+  //the frequency we have polled in the past, and their sum so that the
+  //average doesn't need to walk the buffer on every poll
   boost::circular_buffer< time_duration > PollingFrequency;
+  time_duration PollingSum;
 
 public:
   PollingTracker( const boost::int64_t minRate,
@@ -54,7 +55,8 @@ public:
     AveragePollRate(),
     CurrentPollRate(),
     LastPollTime(p),
-    PollingFrequency(5)
+    PollingFrequency(5),
+    PollingSum()
   {
     //clamp at zero
     const boost::int64_t tempMin = std::max(boost::int64_t(0),minRate);
@@ -69,6 +71,7 @@ public:
     this->CurrentPollRate = properMinRate;
 
     this->PollingFrequency.push_back( this->MinTimeOut );
+    this->PollingSum = this->MinTimeOut;
   }
 
   //----------------------------------------------------------------------------
@@ -107,13 +110,17 @@ public:
     const time_duration dur = time - this->LastPollTime;
 
     //take the time duration between the last poll time, and the current time.
-    //that gets us the entry to add to the polling frequency
+    //that gets us the entry to add to the polling frequency. When the
+    //buffer is full the oldest entry falls out of the sum
+    if(this->PollingFrequency.full())
+      {
+      this->PollingSum -= this->PollingFrequency.front();
+      }
     this->PollingFrequency.push_back( dur );
+    this->PollingSum += dur;
 
-    time_duration sum = std::accumulate(this->PollingFrequency.begin(),
-                                        this->PollingFrequency.end(),
-                                        time_duration() );
-    time_duration avg = sum / static_cast<int>(this->PollingFrequency.size());
+    time_duration avg = this->PollingSum /
+                        static_cast<int>(this->PollingFrequency.size());
 
     //update the member vars
     this->LastPollTime = time;
@@ -34,6 +34,11 @@ namespace common{
 // the frequency of the polling rate based on the amount of traffic
 // it receives. If the amount of traffic starts to decrease we increase
 // the polling timeout.
+// The server and workers don't sleep for the current poll rate, instead
+// they sleep until their next timer is due (see TimerQueue), never longer
+// than the max time out. The monitor still watches how long the polls took,
+// so that we can tell when the operating system has let us sleep for far
+// longer than we asked to.
 // PollingMonitor stores all objects behind a shared pointer, so make sure
 // you don't need to create a new PollingMonitor before you modify the class
 class REMUSCOMMON_EXPORT PollingMonitor
@@ -0,0 +1,298 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/SharedMemory.h>
+
+#include <remus/common/conversionHelper.h>
+#include <remus/common/MD5Hash.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+  #include <process.h>
+#else
+  #include <errno.h>
+  #include <signal.h>
+  #include <sys/types.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+namespace bi = boost::interprocess;
+
+//names are the prefix followed by the id of the process that made the
+//segment and part of a random uuid, each written as hex
+const std::string SegmentPrefix("remus-");
+const std::size_t ProcessIdLength = 8;
+const std::size_t SegmentIdLength = 24;
+
+//------------------------------------------------------------------------------
+unsigned long currentProcessId()
+{
+#ifdef _WIN32
+  return static_cast<unsigned long>(_getpid());
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+
+//------------------------------------------------------------------------------
+std::string make_SegmentName()
+{
+  //some platforms limit segment names to 31 characters, so we
+  //only use part of a random uuid
+  char pid[ProcessIdLength + 1];
+  std::sprintf(pid, "%08lx", currentProcessId() & 0xFFFFFFFFul);
+
+  boost::uuids::random_generator generator;
+  std::string id = boost::uuids::to_string(generator());
+  id.erase(std::remove(id.begin(), id.end(), '-'), id.end());
+  return SegmentPrefix + pid + id.substr(0, SegmentIdLength - ProcessIdLength);
+}
+
+//------------------------------------------------------------------------------
+//only segments that we could have made are opened or removed, as the
+//name comes from the peer that sent us the handle
+bool isSegmentName(const std::string& name)
+{
+  if(name.size() != SegmentPrefix.size() + SegmentIdLength ||
+     name.compare(0, SegmentPrefix.size(), SegmentPrefix) != 0)
+    {
+    return false;
+    }
+  return name.find_first_not_of("0123456789abcdef", SegmentPrefix.size()) ==
+         std::string::npos;
+}
+
+//------------------------------------------------------------------------------
+//returns false only when we know the process that made the segment is gone
+bool ownerIsAlive(const std::string& name)
+{
+#ifdef _WIN32
+  (void) name;
+  return true;
+#else
+  const std::string pidHex = name.substr(SegmentPrefix.size(), ProcessIdLength);
+  const unsigned long pid = std::strtoul(pidHex.c_str(), NULL, 16);
+  return pid == 0 ||
+         kill(static_cast<pid_t>(pid), 0) == 0 ||
+         errno != ESRCH;
+#endif
+}
+
+//------------------------------------------------------------------------------
+void removeStaleSegmentsOnce()
+{
+  remus::common::remove_StaleSharedMemory();
+}
+
+//------------------------------------------------------------------------------
+//keeps a segment mapped for as long as the shared_array that points into
+//it is alive
+struct ReleaseMapping
+{
+  explicit ReleaseMapping(const boost::shared_ptr<bi::mapped_region>& region):
+    Region(region)
+  {
+  }
+
+  void operator()(char*) { this->Region.reset(); }
+
+  boost::shared_ptr<bi::mapped_region> Region;
+};
+
+}
+
+namespace remus {
+namespace common {
+
+//------------------------------------------------------------------------------
+std::ostream& operator<<(std::ostream &os, const SharedMemoryHandle& handle)
+{
+  os << handle.Name << std::endl;
+  os << handle.Size << std::endl;
+  os << handle.Checksum << std::endl;
+  return os;
+}
+
+//------------------------------------------------------------------------------
+std::istream& operator>>(std::istream &is, SharedMemoryHandle& handle)
+{
+  handle = SharedMemoryHandle();
+  is >> handle.Name;
+  is >> handle.Size;
+  is >> handle.Checksum;
+  return is;
+}
+
+//------------------------------------------------------------------------------
+SharedMemoryHandle make_SharedMemory(const char* data, std::size_t size)
+{
+  SharedMemoryHandle handle;
+  if(size == 0)
+    {
+    return handle;
+    }
+
+  //segments are only released when the receiver maps them, so clean up
+  //after processes that died before their segments were mapped
+  static boost::once_flag sweepFlag = BOOST_ONCE_INIT;
+  boost::call_once(&removeStaleSegmentsOnce, sweepFlag);
+
+  const std::string name = make_SegmentName();
+  try
+    {
+    bi::shared_memory_object segment(bi::create_only, name.c_str(),
+                                     bi::read_write);
+    segment.truncate(static_cast<bi::offset_t>(size));
+    bi::mapped_region region(segment, bi::read_write);
+    std::memcpy(region.get_address(), data, size);
+    }
+  catch(const bi::interprocess_exception&)
+    {
+    bi::shared_memory_object::remove(name.c_str());
+    return handle;
+    }
+
+  handle.Name = name;
+  handle.Size = size;
+  handle.Checksum = remus::common::MD5Hash(data, size);
+  return handle;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_array<char> map_SharedMemory(const SharedMemoryHandle& handle)
+{
+  boost::shared_array<char> result;
+  if(!handle.valid() || handle.Size == 0 || !isSegmentName(handle.Name))
+    {
+    return result;
+    }
+
+  boost::shared_ptr<bi::mapped_region> region;
+  try
+    {
+    bi::shared_memory_object segment(bi::open_only, handle.Name.c_str(),
+                                     bi::read_only);
+    region = boost::make_shared<bi::mapped_region>(segment, bi::read_only);
+    }
+  catch(const bi::interprocess_exception&)
+    {
+    return result;
+    }
+
+  char* data = static_cast<char*>(region->get_address());
+  const std::size_t size = static_cast<std::size_t>(handle.Size);
+  const bool matches = region->get_size() >= size &&
+                       remus::common::MD5Hash(data, size) == handle.Checksum;
+
+  //the name is no longer needed either way. Removing it means the memory
+  //is released once the last mapping is gone, and that a segment that
+  //didn't match isn't left behind
+  bi::shared_memory_object::remove(handle.Name.c_str());
+  if(matches)
+    {
+    result = boost::shared_array<char>(data, ReleaseMapping(region));
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void remove_SharedMemory(const SharedMemoryHandle& handle)
+{
+  if(handle.valid() && isSegmentName(handle.Name))
+    {
+    bi::shared_memory_object::remove(handle.Name.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t remove_StaleSharedMemory()
+{
+  std::size_t removed = 0;
+#if defined(__linux__)
+  //only linux lists the posix shared memory segments as files
+  namespace fs = boost::filesystem;
+  boost::system::error_code ec;
+  fs::directory_iterator i(fs::path("/dev/shm"), ec);
+  for(; !ec && i != fs::directory_iterator(); i.increment(ec))
+    {
+    const std::string name = i->path().filename().string();
+    if(isSegmentName(name) && !ownerIsAlive(name) &&
+       bi::shared_memory_object::remove(name.c_str()))
+      {
+      ++removed;
+      }
+    }
+#endif
+  return removed;
+}
+
+//------------------------------------------------------------------------------
+void writeSharedMemoryHandles(std::ostream& buffer,
+                              const SharedMemoryHandles& handles)
+{
+  buffer << handles.size() << std::endl;
+  typedef SharedMemoryHandles::const_iterator It;
+  for(It i = handles.begin(); i != handles.end(); ++i)
+    {
+    buffer << i->first.size() << std::endl;
+    remus::internal::writeString(buffer, i->first);
+    buffer << i->second;
+    }
+}
+
+//------------------------------------------------------------------------------
+SharedMemoryHandles readSharedMemoryHandles(std::istream& buffer)
+{
+  SharedMemoryHandles handles;
+  std::size_t numHandles = 0;
+  buffer >> numHandles;
+  for(std::size_t i=0; i < numHandles && buffer.good(); ++i)
+    {
+    std::size_t keySize = 0;
+    buffer >> keySize;
+    const std::string key = remus::internal::extractString(buffer, keySize);
+    buffer >> handles[key];
+    }
+  return handles;
+}
+
+}
+}
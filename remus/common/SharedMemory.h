@@ -0,0 +1,105 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_SharedMemory_h
+#define remus_common_SharedMemory_h
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_array.hpp>
+
+#include <remus/common/CommonExports.h>
+
+//Processes that run on the same machine can pass large payloads to each
+//other through a shared memory segment, so that only a small handle has to
+//travel over the socket instead of the payload.
+namespace remus {
+namespace common {
+
+//describes a payload that has been placed in a shared memory segment
+struct REMUSCOMMON_EXPORT SharedMemoryHandle
+{
+  SharedMemoryHandle():
+    Name(),
+    Size(0),
+    Checksum()
+  {
+  }
+
+  bool valid() const { return !this->Name.empty(); }
+
+  std::string Name;
+  boost::uint64_t Size;
+  std::string Checksum;
+};
+
+REMUSCOMMON_EXPORT
+std::ostream& operator<<(std::ostream &os, const SharedMemoryHandle& handle);
+
+//if the stream holds no handle, the handle is left invalid
+REMUSCOMMON_EXPORT
+std::istream& operator>>(std::istream &is, SharedMemoryHandle& handle);
+
+//copy the data into a new shared memory segment. Returns an invalid handle
+//if the segment couldn't be created. The name of the segment holds the id
+//of our process, so that segments we never got to hand over can be
+//removed by remove_StaleSharedMemory once we are gone. The first call
+//in a process does that sweep.
+REMUSCOMMON_EXPORT
+SharedMemoryHandle make_SharedMemory(const char* data, std::size_t size);
+
+//map the segment of a handle as read only. The handle comes from a peer,
+//so only names made by make_SharedMemory are opened, and only handles from
+//peers on the same machine should be mapped. The name of the segment is
+//removed once it has been checked, whether it matches or not, so the memory
+//is released as soon as the returned array and every other mapping of it
+//are gone, which includes the death of the process. Returns an empty array
+//if the segment can't be opened, or doesn't match the size and checksum of
+//the handle. The returned memory is read only, and must not be written to.
+REMUSCOMMON_EXPORT
+boost::shared_array<char> map_SharedMemory(const SharedMemoryHandle& handle);
+
+//remove the name of a segment. Memory of a segment that has already been
+//mapped stays valid, so senders call this once the receiver has answered
+//to make sure a segment the receiver never mapped doesn't outlive them
+REMUSCOMMON_EXPORT
+void remove_SharedMemory(const SharedMemoryHandle& handle);
+
+//remove the segments made by processes that are no longer running, which
+//are left behind when a sender dies, or its message is dropped, before the
+//receiver maps the segment. Returns the number of segments removed. Only
+//linux lists its segments, on other platforms nothing is removed.
+REMUSCOMMON_EXPORT
+std::size_t remove_StaleSharedMemory();
+
+//------------------------------------------------------------------------------
+//the handles of the JobContent in a JobSubmission that are sent as shared
+//memory, indexed by key
+typedef std::map<std::string, SharedMemoryHandle> SharedMemoryHandles;
+
+REMUSCOMMON_EXPORT
+void writeSharedMemoryHandles(std::ostream& buffer,
+                              const SharedMemoryHandles& handles);
+
+//reads back the handles written by writeSharedMemoryHandles, if the buffer
+//has no handles an empty map is returned
+REMUSCOMMON_EXPORT
+SharedMemoryHandles readSharedMemoryHandles(std::istream& buffer);
+
+}
+}
+
+#endif
@@ -0,0 +1,84 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/TimerQueue.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace common{
+
+//------------------------------------------------------------------------------
+TimerQueue::TimerQueue():
+  Due(),
+  Timers()
+{
+}
+
+//------------------------------------------------------------------------------
+void TimerQueue::schedule(int timer, const ptime& when)
+{
+  this->cancel(timer);
+  this->Timers[timer] = this->Due.insert(std::make_pair(when, timer));
+}
+
+//------------------------------------------------------------------------------
+void TimerQueue::scheduleIn(int timer, const ptime& now,
+                            boost::int64_t milliseconds)
+{
+  this->schedule(timer, now + boost::posix_time::milliseconds(milliseconds));
+}
+
+//------------------------------------------------------------------------------
+void TimerQueue::cancel(int timer)
+{
+  std::map<int, DueMap::iterator>::iterator i = this->Timers.find(timer);
+  if(i != this->Timers.end())
+    {
+    this->Due.erase(i->second);
+    this->Timers.erase(i);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool TimerQueue::isScheduled(int timer) const
+{
+  return this->Timers.count(timer) > 0;
+}
+
+//------------------------------------------------------------------------------
+bool TimerQueue::isDue(int timer, const ptime& now) const
+{
+  std::map<int, DueMap::iterator>::const_iterator i = this->Timers.find(timer);
+  return i != this->Timers.end() && i->second->first <= now;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t TimerQueue::millisecondsToNext(const ptime& now,
+                                    boost::int64_t max_milliseconds) const
+{
+  boost::int64_t result = max_milliseconds;
+  if(!this->Due.empty())
+    {
+    //polls sleep in whole milliseconds, so we round up to not wake up
+    //just before the timer and have to poll again
+    const boost::int64_t microseconds =
+                          (this->Due.begin()->first - now).total_microseconds();
+    const boost::int64_t remaining = microseconds > 0 ?
+                                     (microseconds + 999) / 1000 : 0;
+    result = std::min(result, remaining);
+    }
+  return std::max(result, boost::int64_t(0));
+}
+
+}
+}
@@ -0,0 +1,80 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_TimerQueue_h
+#define remus_common_TimerQueue_h
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <remus/common/CommonExports.h>
+
+#include <map>
+
+namespace remus{
+namespace common{
+
+// Holds when each piece of timed work of an event loop is due, so that the
+// loop can sleep on its sockets until exactly the earliest of them, instead
+// of waking up at a fixed rate to check. Timers are named by the caller, and
+// a timer is only ever due at a single time.
+class REMUSCOMMON_EXPORT TimerQueue
+{
+public:
+  typedef boost::posix_time::ptime ptime;
+
+  TimerQueue();
+
+  //schedule the timer to be due at the given time, replacing the time it
+  //was previously due at
+  void schedule(int timer, const ptime& when);
+
+  //schedule the timer to be due the given number of milliseconds after now
+  void scheduleIn(int timer, const ptime& now, boost::int64_t milliseconds);
+
+  //remove the timer, it will not be due until it is scheduled again
+  void cancel(int timer);
+
+  //returns true if the timer is scheduled
+  bool isScheduled(int timer) const;
+
+  //returns true if the timer is scheduled at or before now
+  bool isDue(int timer, const ptime& now) const;
+
+  //returns the number of milliseconds until the earliest timer is due,
+  //rounded up so that the timer is due once we wake up, and clamped to be
+  //between 0 and the passed in max value
+  boost::int64_t millisecondsToNext(const ptime& now,
+                                    boost::int64_t max_milliseconds) const;
+
+  //returns the number of scheduled timers
+  std::size_t size() const { return this->Timers.size(); }
+  bool empty() const { return this->Timers.empty(); }
+
+private:
+  typedef std::multimap<ptime, int> DueMap;
+
+  DueMap Due;
+  std::map<int, DueMap::iterator> Timers;
+};
+
+}
+}
+
+#endif
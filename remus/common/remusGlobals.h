@@ -29,6 +29,17 @@ static const int SERVER_WORKER_PORT = 50510;
 
 static const std::string INVALID_MSG = "INVALID_MSG";
 
+//STREAM_CHUNK_SIZE is the size in bytes of each piece that large job
+//results and job submission contents are broken into when they are streamed
+//between the client, server and worker. Data no larger than a single chunk
+//is sent in one message
+static const std::size_t STREAM_CHUNK_SIZE = 1024 * 1024;
+
+//STREAM_CHUNK_CREDITS is the number of chunks that can be sent to a worker,
+//or from a worker, before waiting for one of them to be acknowledged. This
+//bounds the memory the messaging layers use while a large stream is in flight
+static const std::size_t STREAM_CHUNK_CREDITS = 4;
+
 //------------------------------------------------------------------------------
 // Severice Type macros.
 #define ServiceTypeMacros() \
@@ -42,7 +53,14 @@ static const std::string INVALID_MSG = "INVALID_MSG";
      ServiceTypeMacro(RETRIEVE_RESULT, 7, "RETRIEVE RESULT"), \
      ServiceTypeMacro(HEARTBEAT, 8, "HEARTBEAT"), \
      ServiceTypeMacro(TERMINATE_JOB, 9, "TERMINATE JOB"), \
-     ServiceTypeMacro(TERMINATE_WORKER, 10, "TERMINATE WORKER")
+     ServiceTypeMacro(TERMINATE_WORKER, 10, "TERMINATE WORKER"), \
+     ServiceTypeMacro(WAIT_FOR_JOBS, 11, "WAIT FOR JOBS"), \
+     ServiceTypeMacro(RESULT_CHUNK, 12, "RESULT CHUNK"), \
+     ServiceTypeMacro(SUBMISSION_CHUNK, 13, "SUBMISSION CHUNK"), \
+     ServiceTypeMacro(MISSING_CONTENT, 14, "MISSING CONTENT"), \
+     ServiceTypeMacro(JOB_STARTED, 15, "JOB STARTED"), \
+     ServiceTypeMacro(JOB_BATCH, 16, "JOB BATCH"), \
+     ServiceTypeMacro(CACHED_MESH_REQUIREMENTS, 17, "CACHED MESH REQUIREMENTS")
 
 
 //------------------------------------------------------------------------------
@@ -86,6 +104,10 @@ namespace common
     StatusTypeMacros()
 #undef StatusTypeMacro
   };
+
+  //the number of service and status types, including the invalid entries
+  static const int num_serv_types = sizeof(serv_types) / sizeof(serv_types[0]);
+  static const int num_stat_types = sizeof(stat_types) / sizeof(stat_types[0]);
   }
 
 //------------------------------------------------------------------------------
@@ -97,7 +119,7 @@ inline std::string to_string(remus::SERVICE_TYPE t)
 //------------------------------------------------------------------------------
 inline remus::SERVICE_TYPE to_serviceType(const std::string& t)
 {
-  for(int i=1; i<=10; i++)
+  for(int i=1; i < remus::common::num_serv_types; i++)
     {
     remus::SERVICE_TYPE mt=static_cast<remus::SERVICE_TYPE>(i);
     if (remus::to_string(mt) == t)
@@ -117,7 +139,7 @@ inline std::string to_string(remus::STATUS_TYPE t)
 //------------------------------------------------------------------------------
 inline remus::STATUS_TYPE to_statusType(const std::string& t)
 {
-  for(int i=1; i <=5; i++)
+  for(int i=1; i < remus::common::num_stat_types; i++)
     {
     remus::STATUS_TYPE mt=static_cast<remus::STATUS_TYPE>(i);
     if (remus::to_string(mt) == t)
@@ -0,0 +1,89 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <string>
+
+#include <remus/common/ContentHash.h>
+#include <remus/common/MD5Hash.h>
+
+#include <remus/testing/Testing.h>
+
+namespace
+{
+
+void verify_known_values()
+{
+  //the fast hash is MurmurHash3 x64 128 for buffers that fit in a block
+  REMUS_ASSERT( (remus::common::FastHash(NULL,0) ==
+                 std::string(32,'0')) );
+
+  const std::string fox("The quick brown fox jumps over the lazy dog");
+  REMUS_ASSERT( (remus::common::FastHash(fox.data(), fox.size()) ==
+                 "6c1b07bc7bbc4be347939ac4a93c437a") );
+
+  //every tail length should produce a different digest
+  const std::string content = remus::testing::AsciiStringGenerator(64);
+  for(std::size_t i=1; i < content.size(); ++i)
+    {
+    REMUS_ASSERT( (remus::common::FastHash(content.data(), i) !=
+                   remus::common::FastHash(content.data(), i-1)) );
+    }
+}
+
+void verify_large_buffers()
+{
+  //large enough to be split into blocks that are hashed on multiple threads
+  std::string binary_junk = remus::testing::BinaryDataGenerator(10240*1024);
+  const std::string hash = remus::common::FastHash(binary_junk.data(),
+                                                   binary_junk.size());
+  REMUS_ASSERT( (hash.size() == 32) );
+
+  //hashing again must give the same result no matter how the
+  //blocks were scheduled
+  REMUS_ASSERT( (hash == remus::common::FastHash(binary_junk.data(),
+                                                 binary_junk.size())) );
+
+  //changing a single byte in the last block changes the hash
+  binary_junk[binary_junk.size()-1] ^= 1;
+  REMUS_ASSERT( (hash != remus::common::FastHash(binary_junk.data(),
+                                                 binary_junk.size())) );
+}
+
+void verify_algorithm_selection()
+{
+  const std::string content("Copyright (c) Kitware, Inc.");
+  using remus::common::HashAlgorithm;
+
+  REMUS_ASSERT( (remus::common::defaultHashAlgorithm() ==
+                 HashAlgorithm::Fast128) );
+  REMUS_ASSERT( (remus::common::ContentHash(content.data(), content.size()) ==
+                 remus::common::FastHash(content.data(), content.size())) );
+
+  REMUS_ASSERT( (remus::common::ContentHash(content.data(), content.size(),
+                                            HashAlgorithm::MD5) ==
+                 remus::common::MD5Hash(content)) );
+
+  remus::common::defaultHashAlgorithm(HashAlgorithm::MD5);
+  REMUS_ASSERT( (remus::common::ContentHash(content.data(), content.size()) ==
+                 remus::common::MD5Hash(content)) );
+  remus::common::defaultHashAlgorithm(HashAlgorithm::Fast128);
+}
+
+}
+
+int UnitTestContentHash(int, char *[])
+{
+  verify_known_values();
+  verify_large_buffers();
+  verify_algorithm_selection();
+  return 0;
+}
@@ -10,6 +10,7 @@
 //
 //=============================================================================
 
+#include <algorithm>
 #include <string>
 
 #include <remus/common/MD5Hash.h>
@@ -62,5 +63,20 @@ int UnitTestMD5Hash(int, char *[])
   REMUS_ASSERT( (empty_storage_hash.size() == 32) );
   REMUS_ASSERT( (remus::common::MD5Hash(bstorage).size() == 32) );
 
+  //verify that hashing in pieces matches hashing everything at once
+  remus::common::MD5Hasher hasher;
+  REMUS_ASSERT( (hasher.hash() == empty_storage_hash) );
+  const std::size_t pieceSize = 1000 * 1024;
+  for(std::size_t i=0; i < binary_junk.size(); i+=pieceSize)
+    {
+    const std::size_t len = std::min(pieceSize, binary_junk.size() - i);
+    hasher.append(binary_junk.data() + i, len);
+    }
+  REMUS_ASSERT( (hasher.hash() == remus::common::MD5Hash(binary_junk)) );
+
+  //verify that after calling hash the hasher starts over
+  hasher.append(content.data(), content.size());
+  REMUS_ASSERT( (hasher.hash() == t_hash) );
+
   return 0;
 }
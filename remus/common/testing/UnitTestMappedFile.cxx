@@ -0,0 +1,79 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/MappedFile.h>
+
+#include <remus/testing/Testing.h>
+
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/filesystem.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <fstream>
+#include <string>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+std::string write_file(const std::string& contents)
+{
+  boost::filesystem::path p = boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path("remus-%%%%-%%%%-%%%%");
+  std::ofstream file(p.string().c_str(), std::ios::out | std::ios::binary);
+  file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  return p.string();
+}
+
+//------------------------------------------------------------------------------
+void verify_missing_file()
+{
+  remus::common::MappedFile mapped(
+                  remus::common::FileHandle("/remus/does/not/exist"));
+  REMUS_ASSERT( (mapped.valid() == false) );
+  REMUS_ASSERT( (mapped.data() == NULL) );
+  REMUS_ASSERT( (mapped.size() == 0) );
+}
+
+//------------------------------------------------------------------------------
+void verify_file(const std::string& contents)
+{
+  const std::string path = write_file(contents);
+  {
+  remus::common::MappedFile mapped( (remus::common::FileHandle(path)) );
+  REMUS_ASSERT( (mapped.valid() == true) );
+  REMUS_ASSERT( (mapped.size() == contents.size()) );
+  REMUS_ASSERT( (std::string(mapped.data(),mapped.size()) == contents) );
+  }
+  boost::filesystem::remove(path);
+}
+
+}
+
+int UnitTestMappedFile(int, char *[])
+{
+  verify_missing_file();
+
+  verify_file( std::string() );
+  verify_file( std::string("Copyright (c) Kitware, Inc.") );
+  verify_file( remus::testing::BinaryDataGenerator(10240*1024) );
+
+  return 0;
+}
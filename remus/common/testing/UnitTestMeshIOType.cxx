@@ -61,6 +61,33 @@ void verify_invalid_type()
   REMUS_ASSERT ( (invalid3.valid()==false) );
 }
 
+void verify_all_io_types()
+{
+  using remus::common::MeshIOType;
+
+  //the cross product of all the registered types is only built once
+  typedef boost::shared_ptr< const std::set< MeshIOType > > IOTypesPtr;
+  const IOTypesPtr before = remus::common::allRegisteredIOTypes();
+  const std::size_t numTypes =
+                  remus::common::MeshRegistrar::numberOfRegisteredTypes();
+  REMUS_ASSERT( (before->size() == numTypes * numTypes) );
+  REMUS_ASSERT( (before == remus::common::allRegisteredIOTypes()) );
+  REMUS_ASSERT( (before->count(MeshIOType("Edges","Mesh2D")) == 1) );
+  REMUS_ASSERT( (remus::common::generateAllIOTypes() == *before) );
+
+  //registering a new type adds it to a new set of io types, and
+  //the set we already hold is left as it was
+  RegisterTextMeshType();
+  const IOTypesPtr after = remus::common::allRegisteredIOTypes();
+  const std::size_t numAfter =
+                  remus::common::MeshRegistrar::numberOfRegisteredTypes();
+  REMUS_ASSERT( (after != before) );
+  REMUS_ASSERT( (before->size() == numTypes * numTypes) );
+  REMUS_ASSERT( (after->size() == numAfter * numAfter) );
+  REMUS_ASSERT( (after->count(MeshIOType("TextMeshType","Mesh2D")) == 1) );
+  REMUS_ASSERT( (after->count(MeshIOType("Mesh2D","TextMeshType")) == 1) );
+}
+
 void verify_custom_type()
 {
   RegisterTextMeshType();
@@ -148,6 +175,7 @@ void verify_serialization()
 int UnitTestMeshIOType(int, char *[])
 {
   verify_invalid_type();
+  verify_all_io_types();
   verify_custom_type();
   verify_set();
   verify_serialization();
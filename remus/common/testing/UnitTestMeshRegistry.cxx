@@ -14,6 +14,16 @@
 #include <remus/common/MeshTypes.h>
 #include <remus/testing/Testing.h>
 
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
 
 namespace
 {
@@ -25,6 +35,35 @@ namespace
   std::string name() const { return "TextMeshType"; }
   };
 
+  //plugin types that are registered from multiple threads
+  template<int N>
+  struct NumberedMeshType : remus::meshtypes::MeshTypeBase
+  {
+  static boost::shared_ptr<MeshTypeBase> create() {
+          return boost::shared_ptr<NumberedMeshType>(new NumberedMeshType()); }
+  std::string name() const
+    { return std::string("NumberedMeshType") + static_cast<char>('A' + N); }
+  };
+
+  template<int N>
+  void RegisterNumberedMeshType()
+    {
+    remus::common::MeshRegistrar a( (NumberedMeshType<N>()) );
+    }
+
+  void LookupMeshTypes()
+    {
+    using remus::common::MeshRegistrar;
+    for(int i=0; i < 1000; ++i)
+      {
+      //the names are copies, so they stay valid while types are added
+      const std::vector<std::string> names = MeshRegistrar::allRegisteredNames();
+      const std::string name = MeshRegistrar::name(MeshRegistrar::id("Model"));
+      REMUS_ASSERT( (names.size() >= 8) );
+      REMUS_ASSERT( (name == "Model") );
+      }
+    }
+
   void RegisterTextMeshType()
     {
     remus::common::MeshRegistrar a( (TextMeshType()) );
@@ -78,8 +117,50 @@ namespace
   REMUS_ASSERT( (all_types.size() == names.size()) );
   }
 
+  template<typename T>
+  void VerifyBuiltin(int id)
+  {
+    using remus::common::MeshRegistrar;
+    REMUS_ASSERT( (T::Id == id) );
+    REMUS_ASSERT( (T().name() == T::typeName()) );
+    REMUS_ASSERT( (MeshRegistrar::id(T::typeName()) == T::Id) );
+    REMUS_ASSERT( (MeshRegistrar::name(T::Id) == T::typeName()) );
+  }
+
+  void verify_builtin_ids()
+  {
+    using namespace remus::meshtypes;
+    using remus::common::MeshRegistrar;
+    VerifyBuiltin<Mesh1D>(1);
+    VerifyBuiltin<Mesh2D>(2);
+    VerifyBuiltin<Mesh3D>(3);
+    VerifyBuiltin<Mesh3DSurface>(4);
+    VerifyBuiltin<SceneFile>(5);
+    VerifyBuiltin<Model>(6);
+    VerifyBuiltin<Edges>(7);
+    VerifyBuiltin<PiecewiseLinearComplex>(8);
+    REMUS_ASSERT( (NumberOfBuiltinTypes == 8) );
+
+    //unknown names and ids are never valid
+    REMUS_ASSERT( (MeshRegistrar::id("NotAMeshType") == 0) );
+    REMUS_ASSERT( (MeshRegistrar::name(0).empty()) );
+    REMUS_ASSERT( (MeshRegistrar::name(42).empty()) );
+    REMUS_ASSERT( (MeshRegistrar::name(65000).empty()) );
+
+    //the names are sorted, and match the registered types
+    const std::vector<std::string>& names =
+                                    MeshRegistrar::allRegisteredNames();
+    REMUS_ASSERT( (names.size() == MeshRegistrar::numberOfRegisteredTypes()) );
+    for(std::size_t i=1; i < names.size(); ++i)
+      {
+      REMUS_ASSERT( (names[i-1] < names[i]) );
+      }
+  }
+
   void can_add_custom_type()
   {
+    using remus::common::MeshRegistrar;
+    const boost::uint64_t generation = MeshRegistrar::generation();
     RegisterTextMeshType();
 
     typedef boost::shared_ptr<remus::meshtypes::MeshTypeBase> MeshType;
@@ -87,6 +168,39 @@ namespace
 
     VerifySame(base, TextMeshType::create() );
     VerifySame(base, remus::meshtypes::to_meshType("TextMeshType"));
+
+    //plugin types are given ids after the ones remus reserves
+    const boost::uint16_t id = MeshRegistrar::id("TextMeshType");
+    REMUS_ASSERT( (id >= 101) );
+    REMUS_ASSERT( (MeshRegistrar::name(id) == "TextMeshType") );
+    REMUS_ASSERT( (MeshRegistrar::generation() != generation) );
+    REMUS_ASSERT( (MeshRegistrar::allRegisteredNames().size() == 9) );
+
+    //registering the type again keeps its id
+    const boost::uint64_t registered = MeshRegistrar::generation();
+    RegisterTextMeshType();
+    REMUS_ASSERT( (MeshRegistrar::id("TextMeshType") == id) );
+    REMUS_ASSERT( (MeshRegistrar::generation() == registered) );
+    REMUS_ASSERT( (MeshRegistrar::numberOfRegisteredTypes() == 9) );
+  }
+
+  void can_register_from_threads()
+  {
+    using remus::common::MeshRegistrar;
+    boost::thread_group threads;
+    threads.create_thread(&LookupMeshTypes);
+    threads.create_thread(&RegisterNumberedMeshType<0>);
+    threads.create_thread(&LookupMeshTypes);
+    threads.create_thread(&RegisterNumberedMeshType<1>);
+    threads.create_thread(&RegisterNumberedMeshType<2>);
+    threads.create_thread(&LookupMeshTypes);
+    threads.join_all();
+
+    REMUS_ASSERT( (MeshRegistrar::numberOfRegisteredTypes() == 12) );
+    REMUS_ASSERT( (MeshRegistrar::allRegisteredNames().size() == 12) );
+    REMUS_ASSERT( (MeshRegistrar::id("NumberedMeshTypeA") >= 101) );
+    REMUS_ASSERT( (MeshRegistrar::id("NumberedMeshTypeB") >= 101) );
+    REMUS_ASSERT( (MeshRegistrar::id("NumberedMeshTypeC") >= 101) );
   }
 }
 
@@ -96,7 +210,9 @@ int UnitTestMeshRegistry(int, char *[])
 {
   verify_create();
   no_conflicting_ids_or_names();
+  verify_builtin_ids();
   can_add_custom_type();
+  can_register_from_threads();
 
   return 0;
 }
@@ -20,7 +20,7 @@
 int UnitTestRemusGlobals(int, char *[])
 {
   //verify all service types
- for(int i=1; i <=9; i++)
+ for(int i=1; i < remus::common::num_serv_types; i++)
     {
     remus::SERVICE_TYPE mt=static_cast<remus::SERVICE_TYPE>(i);
     std::string service_str = remus::to_string(mt);
@@ -30,7 +30,7 @@ int UnitTestRemusGlobals(int, char *[])
     }
 
   //verify all status types
-  for(int i=1; i <=5; i++)
+  for(int i=1; i < remus::common::num_stat_types; i++)
     {
     remus::STATUS_TYPE mt=static_cast<remus::STATUS_TYPE>(i);
     std::string status_str = remus::to_string(mt);
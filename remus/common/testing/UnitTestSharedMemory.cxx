@@ -0,0 +1,201 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/SharedMemory.h>
+
+#include <remus/testing/Testing.h>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/interprocess/shared_memory_object.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <sstream>
+#include <string>
+
+namespace
+{
+using namespace remus::common;
+namespace bi = boost::interprocess;
+
+//------------------------------------------------------------------------------
+void make_Segment(const std::string& name)
+{
+  bi::shared_memory_object segment(bi::create_only, name.c_str(),
+                                   bi::read_write);
+  segment.truncate(16);
+}
+
+//------------------------------------------------------------------------------
+bool segmentExists(const std::string& name)
+{
+  try
+    {
+    bi::shared_memory_object segment(bi::open_only, name.c_str(),
+                                     bi::read_only);
+    return true;
+    }
+  catch(const bi::interprocess_exception&)
+    {
+    return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_round_trip(const std::string& contents)
+{
+  SharedMemoryHandle handle = make_SharedMemory(contents.data(),
+                                                contents.size());
+  REMUS_ASSERT( (handle.valid() == true) );
+  REMUS_ASSERT( (handle.Size == contents.size()) );
+  REMUS_ASSERT( (handle.Name.size() <= 31) );
+
+  //the handle is what travels over the wire
+  std::stringstream buffer;
+  buffer << handle;
+  SharedMemoryHandle from_wire;
+  buffer >> from_wire;
+  REMUS_ASSERT( (from_wire.Name == handle.Name) );
+  REMUS_ASSERT( (from_wire.Size == handle.Size) );
+  REMUS_ASSERT( (from_wire.Checksum == handle.Checksum) );
+
+  boost::shared_array<char> mapped = map_SharedMemory(from_wire);
+  REMUS_ASSERT( (mapped.get() != NULL) );
+  REMUS_ASSERT( (std::string(mapped.get(), contents.size()) == contents) );
+
+  //once mapped the name is gone, so the segment can't be mapped again
+  //but the existing mapping stays valid
+  REMUS_ASSERT( (map_SharedMemory(handle).get() == NULL) );
+  remove_SharedMemory(handle);
+  REMUS_ASSERT( (std::string(mapped.get(), contents.size()) == contents) );
+}
+
+//------------------------------------------------------------------------------
+void verify_invalid_handles()
+{
+  REMUS_ASSERT( (make_SharedMemory(NULL, 0).valid() == false) );
+
+  SharedMemoryHandle empty;
+  REMUS_ASSERT( (empty.valid() == false) );
+  REMUS_ASSERT( (map_SharedMemory(empty).get() == NULL) );
+
+  //reading from a buffer with no handle leaves the handle invalid
+  std::stringstream buffer;
+  buffer >> empty;
+  REMUS_ASSERT( (empty.valid() == false) );
+
+  SharedMemoryHandle missing;
+  missing.Name = "remus-does-not-exist";
+  missing.Size = 10;
+  REMUS_ASSERT( (map_SharedMemory(missing).get() == NULL) );
+
+  //a segment that doesn't match the checksum is rejected, and removed
+  const std::string contents("Copyright (c) Kitware, Inc.");
+  SharedMemoryHandle handle = make_SharedMemory(contents.data(),
+                                                contents.size());
+  SharedMemoryHandle corrupt = handle;
+  corrupt.Checksum = "bad";
+  REMUS_ASSERT( (map_SharedMemory(corrupt).get() == NULL) );
+  REMUS_ASSERT( (map_SharedMemory(handle).get() == NULL) );
+}
+
+//------------------------------------------------------------------------------
+void verify_segment_names()
+{
+  //the name is the prefix, our process id and part of a uuid
+  const std::string contents("Copyright (c) Kitware, Inc.");
+  SharedMemoryHandle handle = make_SharedMemory(contents.data(),
+                                                contents.size());
+  REMUS_ASSERT( (handle.Name.size() == 30) );
+  REMUS_ASSERT( (handle.Name.compare(0, 6, "remus-") == 0) );
+  remove_SharedMemory(handle);
+
+  //the name of a handle comes from a peer, so segments we couldn't have
+  //made are never opened or removed
+  const std::string foreign("remus-not-made-by-remus");
+  make_Segment(foreign);
+  SharedMemoryHandle spoofed = handle;
+  spoofed.Name = foreign;
+  spoofed.Size = 16;
+  REMUS_ASSERT( (map_SharedMemory(spoofed).get() == NULL) );
+  remove_SharedMemory(spoofed);
+  REMUS_ASSERT( (segmentExists(foreign) == true) );
+
+  spoofed.Name = "/remus-0123456789abcdef01234567";
+  REMUS_ASSERT( (map_SharedMemory(spoofed).get() == NULL) );
+  bi::shared_memory_object::remove(foreign.c_str());
+}
+
+//------------------------------------------------------------------------------
+void verify_stale_segments()
+{
+#if defined(__linux__)
+  //a segment made by a process that is gone is removed, segments of
+  //running processes are left alone
+  const std::string stale("remus-7ffffffe0123456789abcdef");
+  make_Segment(stale);
+
+  const std::string contents("Copyright (c) Kitware, Inc.");
+  SharedMemoryHandle live = make_SharedMemory(contents.data(),
+                                              contents.size());
+
+  REMUS_ASSERT( (remove_StaleSharedMemory() >= 1) );
+  REMUS_ASSERT( (segmentExists(stale) == false) );
+  REMUS_ASSERT( (segmentExists(live.Name) == true) );
+  remove_SharedMemory(live);
+#endif
+}
+
+//------------------------------------------------------------------------------
+void verify_keyed_handles()
+{
+  const std::string a("first"), b("second content");
+  SharedMemoryHandles handles;
+  handles["a key"] = make_SharedMemory(a.data(), a.size());
+  handles["b\nkey"] = make_SharedMemory(b.data(), b.size());
+
+  std::stringstream buffer;
+  writeSharedMemoryHandles(buffer, handles);
+  SharedMemoryHandles from_wire = readSharedMemoryHandles(buffer);
+  REMUS_ASSERT( (from_wire.size() == 2) );
+  REMUS_ASSERT( (from_wire["a key"].Name == handles["a key"].Name) );
+  REMUS_ASSERT( (from_wire["b\nkey"].Name == handles["b\nkey"].Name) );
+
+  boost::shared_array<char> mapped = map_SharedMemory(from_wire["b\nkey"]);
+  REMUS_ASSERT( (std::string(mapped.get(), b.size()) == b) );
+  remove_SharedMemory(handles["a key"]);
+
+  //no handles at all reads back as an empty map
+  std::stringstream empty_buffer;
+  REMUS_ASSERT( (readSharedMemoryHandles(empty_buffer).empty() == true) );
+}
+
+}
+
+int UnitTestSharedMemory(int, char *[])
+{
+  verify_round_trip( std::string("Copyright (c) Kitware, Inc.") );
+  verify_round_trip( remus::testing::BinaryDataGenerator(10240*1024) );
+
+  verify_invalid_handles();
+  verify_segment_names();
+  verify_stale_segments();
+  verify_keyed_handles();
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/TimerQueue.h>
+
+#include <remus/testing/Testing.h>
+
+namespace
+{
+typedef remus::common::TimerQueue TimerQueue;
+
+enum Timers { First, Second };
+
+boost::posix_time::ptime after(const boost::posix_time::ptime& t,
+                               boost::int64_t milliseconds)
+{
+  return t + boost::posix_time::milliseconds(milliseconds);
+}
+
+void verify_next_timeout()
+{
+  TimerQueue timers;
+  const boost::posix_time::ptime t =
+                            boost::posix_time::microsec_clock::local_time();
+
+  //with nothing scheduled we can sleep for the max
+  REMUS_ASSERT( (timers.empty() == true) );
+  REMUS_ASSERT( (timers.millisecondsToNext(t, 500) == 500) );
+
+  timers.scheduleIn(Second, t, 200);
+  timers.scheduleIn(First, t, 100);
+  REMUS_ASSERT( (timers.size() == 2) );
+  REMUS_ASSERT( (timers.millisecondsToNext(t, 500) == 100) );
+  REMUS_ASSERT( (timers.millisecondsToNext(t, 50) == 50) );
+  REMUS_ASSERT( (timers.millisecondsToNext(after(t,60), 500) == 40) );
+  REMUS_ASSERT( (timers.millisecondsToNext(after(t,900), 500) == 0) );
+
+  //partial milliseconds are rounded up, so we don't wake up early
+  const boost::posix_time::ptime partial =
+                            t - boost::posix_time::microseconds(300);
+  REMUS_ASSERT( (timers.millisecondsToNext(partial, 500) == 101) );
+
+  //rescheduling replaces when the timer was due
+  timers.scheduleIn(First, t, 300);
+  REMUS_ASSERT( (timers.size() == 2) );
+  REMUS_ASSERT( (timers.millisecondsToNext(t, 500) == 200) );
+
+  timers.cancel(Second);
+  timers.cancel(Second);
+  REMUS_ASSERT( (timers.size() == 1) );
+  REMUS_ASSERT( (timers.millisecondsToNext(t, 500) == 300) );
+}
+
+void verify_due()
+{
+  TimerQueue timers;
+  const boost::posix_time::ptime t =
+                            boost::posix_time::microsec_clock::local_time();
+
+  REMUS_ASSERT( (timers.isScheduled(First) == false) );
+  REMUS_ASSERT( (timers.isDue(First, t) == false) );
+
+  timers.schedule(First, after(t,100));
+  REMUS_ASSERT( (timers.isScheduled(First) == true) );
+  REMUS_ASSERT( (timers.isDue(First, after(t,99)) == false) );
+  REMUS_ASSERT( (timers.isDue(First, after(t,100)) == true) );
+  REMUS_ASSERT( (timers.isDue(Second, after(t,100)) == false) );
+
+  //a due timer stays due until it is rescheduled or cancelled
+  REMUS_ASSERT( (timers.isDue(First, after(t,200)) == true) );
+  timers.cancel(First);
+  REMUS_ASSERT( (timers.isScheduled(First) == false) );
+  REMUS_ASSERT( (timers.isDue(First, after(t,200)) == false) );
+}
+
+}
+
+int UnitTestTimerQueue(int, char *[])
+{
+  verify_next_timeout();
+  verify_due();
+  return 0;
+}
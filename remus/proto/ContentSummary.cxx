@@ -0,0 +1,198 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/ContentSummary.h>
+
+#include <remus/common/conversionHelper.h>
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+
+namespace
+{
+//ten bits per digest with five hashes keeps false positives near one percent
+const std::size_t bitsPerDigest = 10;
+const std::size_t defaultNumberOfHashes = 5;
+
+//------------------------------------------------------------------------------
+//FNV-1a, the digests are already well mixed so we don't need anything
+//stronger. Different offsets give us two independent hashes
+boost::uint32_t fnv1a(const std::string& value, boost::uint32_t hash)
+{
+  for(std::string::const_iterator i = value.begin(); i != value.end(); ++i)
+    {
+    hash ^= static_cast<unsigned char>(*i);
+    hash *= 16777619u;
+    }
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+void writeDigests(std::ostream& buffer, const std::set<std::string>& digests)
+{
+  buffer << digests.size() << std::endl;
+  typedef std::set<std::string>::const_iterator DigestIt;
+  for(DigestIt i = digests.begin(); i != digests.end(); ++i)
+    {
+    buffer << i->size() << std::endl;
+    remus::internal::writeString(buffer, *i);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::set<std::string> readDigests(std::istream& buffer)
+{
+  std::set<std::string> digests;
+  std::size_t numDigests = 0;
+  buffer >> numDigests;
+  for(std::size_t i=0; i < numDigests && buffer.good(); ++i)
+    {
+    std::size_t digestSize = 0;
+    buffer >> digestSize;
+    digests.insert(remus::internal::extractString(buffer, digestSize));
+    }
+  return digests;
+}
+}
+
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+ContentSummary::ContentSummary():
+  Bits(),
+  NumberOfHashes(defaultNumberOfHashes),
+  Count(0)
+{
+}
+
+//------------------------------------------------------------------------------
+ContentSummary::ContentSummary(std::size_t expectedDigests):
+  Bits( (std::max<std::size_t>(expectedDigests,1) * bitsPerDigest + 7) / 8, 0 ),
+  NumberOfHashes(defaultNumberOfHashes),
+  Count(0)
+{
+}
+
+//------------------------------------------------------------------------------
+void ContentSummary::add(const std::string& digest)
+{
+  if(this->Bits.empty())
+    {
+    return;
+    }
+  for(std::size_t i=0; i < this->NumberOfHashes; ++i)
+    {
+    const std::size_t bit = this->bitIndex(digest, i);
+    this->Bits[bit / 8] = static_cast<unsigned char>(
+                                    this->Bits[bit / 8] | (1u << (bit % 8)));
+    }
+  ++this->Count;
+}
+
+//------------------------------------------------------------------------------
+bool ContentSummary::mayContain(const std::string& digest) const
+{
+  if(this->Count == 0)
+    {
+    return false;
+    }
+  for(std::size_t i=0; i < this->NumberOfHashes; ++i)
+    {
+    const std::size_t bit = this->bitIndex(digest, i);
+    if((this->Bits[bit / 8] & (1u << (bit % 8))) == 0)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+std::size_t ContentSummary::bitIndex(const std::string& digest,
+                                     std::size_t i) const
+{
+  //double hashing, which is as good as using independent hashes
+  const boost::uint32_t h1 = fnv1a(digest, 2166136261u);
+  const boost::uint32_t h2 = fnv1a(digest, 3735928559u) | 1u;
+  const boost::uint64_t hash = static_cast<boost::uint64_t>(h1) +
+                               static_cast<boost::uint64_t>(i) * h2;
+  return static_cast<std::size_t>(hash % this->numberOfBits());
+}
+
+//------------------------------------------------------------------------------
+void ContentSummary::serialize(std::ostream& buffer) const
+{
+  buffer << this->Count << std::endl;
+  buffer << this->NumberOfHashes << std::endl;
+  buffer << this->Bits.size() << std::endl;
+  if(!this->Bits.empty())
+    {
+    remus::internal::writeString(buffer,
+                        reinterpret_cast<const char*>(&this->Bits[0]),
+                        this->Bits.size());
+    }
+}
+
+//------------------------------------------------------------------------------
+ContentSummary::ContentSummary(std::istream& buffer):
+  Bits(),
+  NumberOfHashes(defaultNumberOfHashes),
+  Count(0)
+{
+  std::size_t numBytes = 0;
+  buffer >> this->Count;
+  buffer >> this->NumberOfHashes;
+  buffer >> numBytes;
+  if(!buffer.good() || numBytes == 0)
+    {
+    this->Count = 0;
+    return;
+    }
+
+  const std::string bits = remus::internal::extractString(buffer, numBytes);
+  this->Bits.assign(bits.begin(), bits.end());
+}
+
+//------------------------------------------------------------------------------
+void writeContentSummary(std::ostream& buffer, const ContentSummary& summary)
+{
+  buffer << summary;
+}
+
+//------------------------------------------------------------------------------
+ContentSummary readContentSummary(std::istream& buffer)
+{
+  ContentSummary summary;
+  buffer >> summary;
+  return summary;
+}
+
+//------------------------------------------------------------------------------
+void writeContentChanges(std::ostream& buffer, const ContentChanges& changes)
+{
+  writeDigests(buffer, changes.Added);
+  writeDigests(buffer, changes.Dropped);
+}
+
+//------------------------------------------------------------------------------
+ContentChanges readContentChanges(std::istream& buffer)
+{
+  ContentChanges changes;
+  changes.Added = readDigests(buffer);
+  changes.Dropped = readDigests(buffer);
+  return changes;
+}
+
+}
+}
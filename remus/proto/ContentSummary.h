@@ -0,0 +1,114 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_ContentSummary_h
+#define remus_proto_ContentSummary_h
+
+#include <istream>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+//ContentSummary is a compact, fixed size summary of the digests of the
+//JobContent a worker holds, sent with each MAKE_MESH request so the server
+//can prefer giving a job to a worker that already has its content.
+//The summary is a Bloom filter: it never misses a digest that was added,
+//but can claim to hold a digest that wasn't.
+namespace remus {
+namespace proto {
+class REMUSPROTO_EXPORT ContentSummary
+{
+public:
+  //construct an empty summary, that holds no digests
+  ContentSummary();
+
+  //construct an empty summary sized to hold the given number of digests
+  //while keeping false positives around one percent
+  explicit ContentSummary(std::size_t expectedDigests);
+
+  //add the digest of a piece of content to the summary
+  void add(const std::string& digest);
+
+  //returns false if the digest was never added, and true if it
+  //probably was
+  bool mayContain(const std::string& digest) const;
+
+  //returns true if no digest has been added
+  bool empty() const { return this->Count == 0; }
+
+  //the number of bits the summary uses
+  std::size_t numberOfBits() const { return this->Bits.size() * 8; }
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const ContentSummary &summary)
+    { summary.serialize(os); return os; }
+
+  friend std::istream& operator>>(std::istream &is,
+                                  ContentSummary &summary)
+    { summary = ContentSummary(is); return is; }
+
+private:
+  //serialize function
+  void serialize(std::ostream& buffer) const;
+
+  //deserialize constructor function
+  explicit ContentSummary(std::istream& buffer);
+
+  //the bit the given hash of the digest maps to
+  std::size_t bitIndex(const std::string& digest, std::size_t i) const;
+
+  std::vector<unsigned char> Bits;
+  std::size_t NumberOfHashes;
+  std::size_t Count;
+};
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+void writeContentSummary(std::ostream& buffer, const ContentSummary& summary);
+
+//------------------------------------------------------------------------------
+//reads back the summary written by writeContentSummary, if the buffer has
+//no summary an empty summary is returned
+REMUSPROTO_EXPORT
+ContentSummary readContentSummary(std::istream& buffer);
+
+//------------------------------------------------------------------------------
+//The digests of the content a worker started and stopped holding since it
+//last asked for a job. Unlike the summary these are exact, so the server
+//can keep a record of what each worker holds, and only reference content
+//by digest when the worker has acknowledged holding it
+struct ContentChanges
+{
+  std::set<std::string> Added;
+  std::set<std::string> Dropped;
+
+  bool empty() const { return this->Added.empty() && this->Dropped.empty(); }
+};
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+void writeContentChanges(std::ostream& buffer, const ContentChanges& changes);
+
+//------------------------------------------------------------------------------
+//reads back the changes written by writeContentChanges, if the buffer has
+//no changes empty changes are returned
+REMUSPROTO_EXPORT
+ContentChanges readContentChanges(std::istream& buffer);
+
+}
+}
+
+#endif
@@ -0,0 +1,254 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/DataChunk.h>
+
+#include <remus/common/ConditionalStorage.h>
+#include <remus/common/conversionHelper.h>
+
+#include <boost/make_shared.hpp>
+
+//suppress warnings inside boost headers for gcc, clang and MSVC
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/uuid/uuid_io.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <cstring>
+#include <sstream>
+
+namespace remus {
+namespace proto {
+
+struct DataChunk::InternalImpl
+{
+  InternalImpl(const char* d, std::size_t s):
+    Size(s),
+    Data(d),
+    Storage()
+  {
+  }
+
+  InternalImpl(const boost::shared_array<char> d, std::size_t s):
+    Size(s),
+    Data(NULL),
+    Storage()
+  {
+    remus::common::ConditionalStorage temp(d,s);
+    this->Storage.swap(temp);
+    this->Size = this->Storage.size();
+    this->Data = this->Storage.data();
+  }
+
+  std::size_t size() const { return Size; }
+  const char* data() const { return Data; }
+
+private:
+  //store the size of the data being held
+  std::size_t Size;
+
+  //points to the zero copy or data in the conditional storage
+  const char* Data;
+
+  //Storage is an optional allocation that is used when we need to copy data
+  remus::common::ConditionalStorage Storage;
+};
+
+//------------------------------------------------------------------------------
+DataChunk::DataChunk(const boost::uuids::uuid& jid):
+  JobId(jid),
+  Key(),
+  FormatType(),
+  Offset(0),
+  Final(false),
+  TotalSize(0),
+  Checksum(),
+  Implementation( boost::make_shared<InternalImpl>(
+                 static_cast<char*>(NULL),std::size_t(0)) )
+{
+}
+
+//------------------------------------------------------------------------------
+DataChunk::DataChunk(const boost::uuids::uuid& jid,
+                     remus::common::ContentFormat::Type format,
+                     boost::uint64_t offset,
+                     const char* data,
+                     std::size_t size):
+  JobId(jid),
+  Key(),
+  FormatType(format),
+  Offset(offset),
+  Final(false),
+  TotalSize(0),
+  Checksum(),
+  Implementation( boost::make_shared<InternalImpl>(data,size) )
+{
+}
+
+//------------------------------------------------------------------------------
+DataChunk::DataChunk(const boost::uuids::uuid& jid,
+                     remus::common::ContentFormat::Type format,
+                     boost::uint64_t offset,
+                     const boost::shared_array<char>& data,
+                     std::size_t size):
+  JobId(jid),
+  Key(),
+  FormatType(format),
+  Offset(offset),
+  Final(false),
+  TotalSize(0),
+  Checksum(),
+  Implementation( boost::make_shared<InternalImpl>(data,size) )
+{
+}
+
+//------------------------------------------------------------------------------
+void DataChunk::markAsFinal(boost::uint64_t totalSize,
+                            const std::string& checksum)
+{
+  this->Final = true;
+  this->TotalSize = totalSize;
+  this->Checksum = checksum;
+}
+
+//------------------------------------------------------------------------------
+const char* DataChunk::data() const
+{
+  return this->Implementation->data();
+}
+
+//------------------------------------------------------------------------------
+std::size_t DataChunk::dataSize() const
+{
+  return this->Implementation->size();
+}
+
+//------------------------------------------------------------------------------
+void DataChunk::serialize(std::ostream& buffer) const
+{
+  buffer << this->id() << std::endl;
+  buffer << this->Key.size() << std::endl;
+  remus::internal::writeString( buffer, this->Key );
+  buffer << this->formatType() << std::endl;
+  buffer << this->offset() << std::endl;
+  buffer << this->isFinal() << std::endl;
+  buffer << this->totalSize() << std::endl;
+  buffer << this->Checksum.size() << std::endl;
+  remus::internal::writeString( buffer, this->Checksum );
+  buffer << this->Implementation->size() << std::endl;
+  remus::internal::writeString( buffer,
+                                this->Implementation->data(),
+                                this->Implementation->size() );
+}
+
+//------------------------------------------------------------------------------
+DataChunk::DataChunk(std::istream& buffer)
+{
+  int ftype=0;
+  std::size_t keySize=0;
+  std::size_t checksumSize=0;
+  std::size_t contentsSize=0;
+
+  buffer >> this->JobId;
+  buffer >> keySize;
+  this->Key = remus::internal::extractString(buffer,keySize);
+  buffer >> ftype;
+  buffer >> this->Offset;
+  buffer >> this->Final;
+  buffer >> this->TotalSize;
+
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+
+  buffer >> checksumSize;
+  this->Checksum = remus::internal::extractString(buffer,checksumSize);
+
+  buffer >> contentsSize;
+  boost::shared_array<char> contents( new char[contentsSize] );
+  remus::internal::extractArray(buffer, contents.get(), contentsSize);
+
+  //if we have read nothing in, and the array is empty, we need to explicitly
+  //act like we have a null pointer, which doesn't happen if we pass in
+  //contents as it has a non NULL location ( see spec 5.3.4/7 )
+  if( contentsSize == 0)
+    {
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else
+    {
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                contents, contentsSize);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::string to_string(const remus::proto::DataChunk& chunk)
+{
+  std::ostringstream buffer;
+  buffer << chunk;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::DataChunk to_DataChunk(const char* data, std::size_t size)
+{
+  std::stringstream buffer;
+  remus::internal::writeString(buffer, data, size);
+  remus::proto::DataChunk chunk(buffer);
+  return chunk;
+}
+
+//------------------------------------------------------------------------------
+boost::uuids::uuid to_DataChunkId(const char* data, std::size_t size)
+{
+  //the id is the first line of a serialized chunk
+  const char* end = static_cast<const char*>(std::memchr(data, '\n', size));
+  const std::size_t idSize = (end != NULL) ? (end - data) : size;
+
+  std::istringstream buffer(std::string(data, idSize));
+  boost::uuids::uuid id = boost::uuids::uuid();
+  buffer >> id;
+  return id;
+}
+
+//------------------------------------------------------------------------------
+void writeStreamedKeys(std::ostream& buffer, const StreamedKeys& keys)
+{
+  buffer << keys.size() << std::endl;
+  for(StreamedKeys::const_iterator i = keys.begin(); i != keys.end(); ++i)
+    {
+    buffer << i->size() << std::endl;
+    remus::internal::writeString(buffer, *i);
+    }
+}
+
+//------------------------------------------------------------------------------
+StreamedKeys readStreamedKeys(std::istream& buffer)
+{
+  StreamedKeys keys;
+  std::size_t numKeys = 0;
+  buffer >> numKeys;
+  for(std::size_t i=0; i < numKeys && buffer.good(); ++i)
+    {
+    std::size_t keySize = 0;
+    buffer >> keySize;
+    keys.insert( remus::internal::extractString(buffer, keySize) );
+    }
+  return keys;
+}
+
+}
+}
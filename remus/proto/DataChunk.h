@@ -0,0 +1,158 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_DataChunk_h
+#define remus_proto_DataChunk_h
+
+#include <istream>
+#include <ostream>
+#include <set>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+//for ContentFormat
+#include <remus/common/ContentTypes.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+//DataChunk holds a single fixed size piece of a larger payload that is
+//being streamed between the client, server and worker. Chunks are sent in
+//order, and the final chunk carries the total size and the MD5 hash of the
+//whole payload so the receiver can verify what it has reassembled.
+namespace remus {
+namespace proto {
+class REMUSPROTO_EXPORT DataChunk
+{
+public:
+  //construct an empty, non final chunk for the given job
+  explicit DataChunk(const boost::uuids::uuid& jid);
+
+  //construct a chunk that holds the given piece of data. A pointer
+  //to the data is kept and no copy of the data will happen, so
+  //the data can't be deleted while the DataChunk instance is valid.
+  DataChunk(const boost::uuids::uuid& jid,
+            remus::common::ContentFormat::Type format,
+            boost::uint64_t offset,
+            const char* data,
+            std::size_t size);
+
+  //construct a chunk that shares ownership of the given piece of data,
+  //no copy of the data will happen.
+  DataChunk(const boost::uuids::uuid& jid,
+            remus::common::ContentFormat::Type format,
+            boost::uint64_t offset,
+            const boost::shared_array<char>& data,
+            std::size_t size);
+
+  //mark this chunk as the last one of the payload, recording the size and
+  //MD5 hash of the entire payload
+  void markAsFinal(boost::uint64_t totalSize, const std::string& checksum);
+
+  const boost::uuids::uuid& id() const { return JobId; }
+
+  //set the key of the JobContent that this chunk is part of. Chunks of
+  //a job result have no key.
+  void key(const std::string& key_value) { this->Key = key_value; }
+  //get the key of the JobContent that this chunk is part of
+  const std::string& key() const { return this->Key; }
+
+  //get the storage format of the payload this chunk is part of
+  remus::common::ContentFormat::Type formatType() const
+    { return this->FormatType; }
+
+  //the position of this chunk inside the payload
+  boost::uint64_t offset() const { return this->Offset; }
+
+  const char* data() const;
+  std::size_t dataSize() const;
+
+  //returns true if this is the last chunk of the payload
+  bool isFinal() const { return this->Final; }
+
+  //only valid on the final chunk
+  boost::uint64_t totalSize() const { return this->TotalSize; }
+  const std::string& checksum() const { return this->Checksum; }
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const DataChunk &chunk)
+    { chunk.serialize(os); return os; }
+
+  //needed to decode the object from the wire
+  friend std::istream& operator>>(std::istream &is,
+                                  DataChunk &chunk)
+    { chunk = DataChunk(is); return is; }
+
+private:
+  friend remus::proto::DataChunk to_DataChunk(const char* data, std::size_t size);
+  //serialize function
+  void serialize(std::ostream& buffer) const;
+
+  //deserialize constructor function
+  explicit DataChunk(std::istream& buffer);
+
+  boost::uuids::uuid JobId;
+  std::string Key;
+  remus::common::ContentFormat::Type FormatType;
+  boost::uint64_t Offset;
+  bool Final;
+  boost::uint64_t TotalSize;
+  std::string Checksum;
+
+  struct InternalImpl;
+  boost::shared_ptr<InternalImpl> Implementation;
+};
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+std::string to_string(const remus::proto::DataChunk& chunk);
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+remus::proto::DataChunk to_DataChunk(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::DataChunk to_DataChunk(const std::string& msg)
+{
+  return to_DataChunk(msg.c_str(), msg.size());
+}
+
+//------------------------------------------------------------------------------
+//returns the job id of a serialized chunk without decoding the chunk data
+REMUSPROTO_EXPORT
+boost::uuids::uuid to_DataChunkId(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+//The keys of the JobContent in a JobSubmission that are sent as a stream of
+//DataChunks after the submission, instead of as part of the submission.
+//The submission holds an empty JobContent with the format and tag for each
+//of these keys.
+typedef std::set<std::string> StreamedKeys;
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+void writeStreamedKeys(std::ostream& buffer, const StreamedKeys& keys);
+
+//------------------------------------------------------------------------------
+//reads back the keys written by writeStreamedKeys, if the buffer has no
+//keys an empty set is returned
+REMUSPROTO_EXPORT
+StreamedKeys readStreamedKeys(std::istream& buffer);
+
+}
+}
+
+#endif
@@ -13,7 +13,7 @@
 #include <remus/proto/JobContent.h>
 
 #include <remus/common/ConditionalStorage.h>
-#include <remus/common/MD5Hash.h>
+#include <remus/common/ContentHash.h>
 #include <remus/common/conversionHelper.h>
 
 #include <boost/make_shared.hpp>
@@ -32,7 +32,9 @@ struct JobContent::InternalImpl
     Data(NULL),
     Storage(),
     ShortHash(),
-    FullHash()
+    FullHash(),
+    FullHashAlgorithm(remus::common::HashAlgorithm::Fast128),
+    FullHashWasSent(false)
   {
     remus::common::ConditionalStorage temp(t);
     this->Storage.swap(temp);
@@ -45,7 +47,9 @@ struct JobContent::InternalImpl
     Data(d),
     Storage(),
     ShortHash(),
-    FullHash()
+    FullHash(),
+    FullHashAlgorithm(remus::common::HashAlgorithm::Fast128),
+    FullHashWasSent(false)
   {
   }
 
@@ -55,7 +59,9 @@ struct JobContent::InternalImpl
     Data(NULL),
     Storage(),
     ShortHash(),
-    FullHash()
+    FullHash(),
+    FullHashAlgorithm(remus::common::HashAlgorithm::Fast128),
+    FullHashWasSent(false)
 {
     remus::common::ConditionalStorage temp(d,s);
     this->Storage.swap(temp);
@@ -68,16 +74,27 @@ struct JobContent::InternalImpl
 
   bool equal(const boost::shared_ptr<InternalImpl> other)
     {
+    //the same memory can't hold different contents
+    if(this->data() == other->data() && this->size() == other->size())
+      { return true; }
+
+    const remus::common::HashAlgorithm::Type algorithm =
+                                    remus::common::defaultHashAlgorithm();
     return (this->shortHash() == other->shortHash()) &&
-           (this->fullHash() == other->fullHash());
+           (this->fullHash(algorithm) == other->fullHash(algorithm));
     }
 
   bool less(const boost::shared_ptr<InternalImpl> other)
     {
+    //always order by the default algorithm, so that contents that
+    //were hashed by a sender using a different algorithm are still
+    //ordered consistently
+    const remus::common::HashAlgorithm::Type algorithm =
+                                    remus::common::defaultHashAlgorithm();
     if(this->shortHash() != other->shortHash())
       { return this->shortHash() < other->shortHash(); }
-    if(this->fullHash() != other->fullHash())
-      { return this->fullHash() < other->fullHash(); }
+    if(this->fullHash(algorithm) != other->fullHash(algorithm))
+      { return this->fullHash(algorithm) < other->fullHash(algorithm); }
     return false;
     }
 
@@ -91,22 +108,63 @@ struct JobContent::InternalImpl
       {
       //only hash the first 4096 characters
       std::size_t hashsize = 4096;
-      this->ShortHash = remus::common::MD5Hash(this->data(),
-                                               hashsize);
+      this->ShortHash = remus::common::FastHash(this->data(),
+                                                hashsize);
       }
     return this->ShortHash;
   }
 
-  const std::string& fullHash()
+  //returns the digest of all the data using the given algorithm. If we
+  //already hold a digest made with that algorithm, either computed
+  //by us or sent to us, it is reused
+  const std::string& fullHash(remus::common::HashAlgorithm::Type algorithm)
   {
-   if(this->FullHash.size() == 0)
+   if(this->FullHash.size() == 0 || this->FullHashAlgorithm != algorithm)
       {
       //has the whole damn file
-      this->FullHash = remus::common::MD5Hash(this->data(),
-                                              this->size());
+      this->FullHash = remus::common::ContentHash(this->data(),
+                                                  this->size(),
+                                                  algorithm);
+      this->FullHashAlgorithm = algorithm;
+      this->FullHashWasSent = false;
       }
     return this->FullHash;
   }
+
+  //returns true if we hold a digest made with the given algorithm
+  bool hasFullHash(remus::common::HashAlgorithm::Type algorithm) const
+  {
+    return this->FullHash.size() > 0 && this->FullHashAlgorithm == algorithm;
+  }
+
+  //set the digest of the data, used when the digest was computed
+  //by who sent us the data
+  void fullHash(remus::common::HashAlgorithm::Type algorithm,
+                const std::string& hash)
+  {
+    this->FullHash = hash;
+    this->FullHashAlgorithm = algorithm;
+    this->FullHashWasSent = true;
+  }
+
+  //hash the data again when the digest we hold was sent to us, replacing
+  //it with the one we computed. Returns false if the two didn't match
+  bool verifyFullHash()
+  {
+    if(!this->FullHashWasSent)
+      {
+      return true;
+      }
+
+    const std::string sent = this->FullHash;
+    const remus::common::HashAlgorithm::Type algorithm = this->FullHashAlgorithm;
+    this->FullHash = remus::common::ContentHash(this->data(),
+                                                this->size(),
+                                                algorithm);
+    this->FullHashWasSent = false;
+    return this->FullHash == sent;
+  }
+
 private:
 
   //store the size of the data being held
@@ -118,9 +176,14 @@ private:
   //Storage is an optional allocation that is used when we need to copy data
   remus::common::ConditionalStorage Storage;
 
-  //MD5Hash of the data held by us.
+  //hashes of the data held by us, and the algorithm used for the full hash
   std::string ShortHash;
   std::string FullHash;
+  remus::common::HashAlgorithm::Type FullHashAlgorithm;
+
+  //true when FullHash was computed by who sent us the data, and
+  //we haven't verified it against the data
+  bool FullHashWasSent;
 };
 
 //------------------------------------------------------------------------------
@@ -172,6 +235,18 @@ JobContent::JobContent(remus::common::ContentFormat::Type format,
 
 }
 
+//------------------------------------------------------------------------------
+JobContent::JobContent(remus::common::ContentFormat::Type format,
+                       const boost::shared_array<char>& contents,
+                       std::size_t size):
+  SourceType(remus::common::ContentSource::Memory),
+  FormatType(format),
+  Tag(),
+  Implementation( boost::make_shared<InternalImpl>(contents,size) )
+  //make_shared is significantly faster than using manual new
+{
+}
+
 //------------------------------------------------------------------------------
 const char* JobContent::data() const
 {
@@ -184,6 +259,18 @@ std::size_t JobContent::dataSize() const
   return this->Implementation->size();
 }
 
+//------------------------------------------------------------------------------
+const std::string& JobContent::hash() const
+{
+  return this->Implementation->fullHash(remus::common::defaultHashAlgorithm());
+}
+
+//------------------------------------------------------------------------------
+bool JobContent::verifyHash() const
+{
+  return this->Implementation->verifyFullHash();
+}
+
 //------------------------------------------------------------------------------
 bool JobContent::operator<(const JobContent& other) const
 {
@@ -200,7 +287,7 @@ bool JobContent::operator<(const JobContent& other) const
   { return (this->dataSize() < other.dataSize()); }
 
   //instead of comparing the full data of the content, we just compare
-  //cached md5 hashes of the content
+  //cached hashes of the content
   if (!(this->Implementation->equal(other.Implementation)))
     { return (this->Implementation->less(other.Implementation)); }
 
@@ -230,14 +317,28 @@ void JobContent::serialize(std::ostream& buffer) const
   remus::internal::writeString( buffer,
                                 this->Implementation->data(),
                                 this->Implementation->size() );
+
+  //send the digest of the contents when we already hold it, so that the
+  //receiver can compare contents without having to hash them again. We
+  //don't hash the contents just to send the digest, as the receiver
+  //has to verify any digest it is sent before relying on it
+  const remus::common::HashAlgorithm::Type algorithm =
+                                    remus::common::defaultHashAlgorithm();
+  const std::string hash = this->Implementation->hasFullHash(algorithm) ?
+                           this->Implementation->fullHash(algorithm) :
+                           std::string();
+  buffer << algorithm << std::endl;
+  buffer << hash.size() << std::endl;
+  remus::internal::writeString(buffer, hash);
 }
 
 //------------------------------------------------------------------------------
 JobContent::JobContent(std::istream& buffer)
 {
-  int stype=0, ftype=0;
+  int stype=0, ftype=0, htype=0;
   std::size_t tagSize=0;
   std::size_t contentsSize=0;
+  std::size_t hashSize=0;
 
   //read in the source and format types
   buffer >> stype;
@@ -270,6 +371,17 @@ JobContent::JobContent(std::istream& buffer)
     this->Implementation = boost::make_shared<InternalImpl>(
                                                 contents, contentsSize);
     }
+
+  //keep the digest that the sender computed, it is only trusted
+  //once it has been checked with verifyHash
+  buffer >> htype;
+  buffer >> hashSize;
+  const std::string hash = remus::internal::extractString(buffer,hashSize);
+  if(hashSize > 0)
+    {
+    this->Implementation->fullHash(
+      static_cast<remus::common::HashAlgorithm::Type>(htype), hash);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -291,5 +403,38 @@ remus::proto::JobContent to_JobContent(const char* data, std::size_t size)
 }
 
 
+//------------------------------------------------------------------------------
+void writeContentDigests(std::ostream& buffer, const ContentDigests& digests)
+{
+  buffer << digests.size() << std::endl;
+  typedef ContentDigests::const_iterator DigestIt;
+  for(DigestIt i = digests.begin(); i != digests.end(); ++i)
+    {
+    buffer << i->first.size() << std::endl;
+    remus::internal::writeString(buffer, i->first);
+    buffer << i->second.size() << std::endl;
+    remus::internal::writeString(buffer, i->second);
+    }
+}
+
+//------------------------------------------------------------------------------
+ContentDigests readContentDigests(std::istream& buffer)
+{
+  ContentDigests digests;
+  std::size_t numDigests = 0;
+  buffer >> numDigests;
+  for(std::size_t i=0; i < numDigests && buffer.good(); ++i)
+    {
+    std::size_t keySize = 0;
+    buffer >> keySize;
+    const std::string key = remus::internal::extractString(buffer, keySize);
+
+    std::size_t digestSize = 0;
+    buffer >> digestSize;
+    digests[key] = remus::internal::extractString(buffer, digestSize);
+    }
+  return digests;
+}
+
 }
 }
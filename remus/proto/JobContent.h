@@ -13,7 +13,9 @@
 #ifndef remus_proto_JobContent_h
 #define remus_proto_JobContent_h
 
+#include <map>
 #include <string>
+#include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
 
 //for ContentFormat and ContentSource
@@ -33,9 +35,10 @@ public:
   //to allows this class to be stored in containers.
   JobContent();
 
-  //pass in some data to send to the worker. The path to the file
-  //will passed to the worker. In the future we plan to extend remus
-  //to support automatic file reading.
+  //pass in some data to send to the worker. When the client and server are
+  //on the same machine only the path to the file is sent, otherwise the
+  //client sends the contents of the file and the worker receives them
+  //as a file of its own.
   JobContent(remus::common::ContentFormat::Type format,
              const remus::common::FileHandle& fileHandle);
 
@@ -52,6 +55,13 @@ public:
              const char* contents,
              std::size_t size);
 
+  //pass in some Memory data to send to the worker. The JobContent shares
+  //ownership of the contents, so no copy of the data will happen. This is
+  //used when content has been assembled from the chunks of a stream.
+  JobContent(remus::common::ContentFormat::Type format,
+             const boost::shared_array<char>& contents,
+             std::size_t size);
+
   //returns if the source of the content is memory or a file
   remus::common::ContentSource::Type sourceType() const
     { return this->SourceType; }
@@ -68,6 +78,17 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //returns the digest of the data, made with the default hash algorithm.
+  //The digest is computed once and cached, and content that was sent to us
+  //uses the digest computed by the sender, if the sender included one
+  const std::string& hash() const;
+
+  //hash the data again if the digest we hold was computed by the sender,
+  //so that it can be trusted. Returns false if the digest the sender
+  //computed doesn't match the data. Digests we computed aren't checked
+  //again, so this is cheap to call more than once
+  bool verifyHash() const;
+
   ///implement a less than operator and equal operator so you
   //can use the class in containers and algorithms
   bool operator<(const JobContent& other) const;
@@ -130,6 +151,22 @@ inline remus::proto::JobContent to_JobContent(const std::string& msg)
   return to_JobContent(msg.c_str(), msg.size());
 }
 
+//------------------------------------------------------------------------------
+//Maps the keys of JobContent in a JobSubmission to the digest of that
+//content. Used by clients to ask the server which content it already holds,
+//and to reference that content instead of sending it again.
+typedef std::map<std::string, std::string> ContentDigests;
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+void writeContentDigests(std::ostream& buffer, const ContentDigests& digests);
+
+//------------------------------------------------------------------------------
+//reads back the digests written by writeContentDigests, if the buffer has no
+//digests an empty map is returned
+REMUSPROTO_EXPORT
+ContentDigests readContentDigests(std::istream& buffer);
+
 
 
 }
@@ -13,12 +13,89 @@
 #include <remus/proto/JobRequirements.h>
 
 #include <remus/common/ConditionalStorage.h>
+#include <remus/common/ContentHash.h>
 #include <remus/common/conversionHelper.h>
 
 #include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
 
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wshadow"
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#pragma GCC diagnostic pop
+
+#include <cstring>
+#include <map>
 #include <sstream>
 
+namespace
+{
+//FNV-1a, we only need the fingerprint to be cheap and well spread
+const boost::uint64_t FingerprintBasis = 14695981039346656037ULL;
+const boost::uint64_t FingerprintPrime = 1099511628211ULL;
+
+boost::uint64_t fingerprint_bytes(boost::uint64_t hash,
+                                  const char* data, std::size_t size)
+{
+  for(std::size_t i=0; i < size; ++i)
+    {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= FingerprintPrime;
+    }
+  return hash;
+}
+
+boost::uint64_t fingerprint_value(boost::uint64_t hash, boost::uint64_t value)
+{
+  for(int i=0; i < 8; ++i)
+    {
+    hash ^= (value >> (8*i)) & 0xff;
+    hash *= FingerprintPrime;
+    }
+  return hash;
+}
+
+//strings are prefixed with their size so that moving characters between
+//neighbouring strings changes the fingerprint
+boost::uint64_t fingerprint_string(boost::uint64_t hash, const std::string& s)
+{
+  hash = fingerprint_value(hash, s.size());
+  return fingerprint_bytes(hash, s.data(), s.size());
+}
+
+//The interning tables only hold weak references, so an entry goes away
+//once nothing uses it. Expired entries are removed whenever the table has
+//doubled in size since the last time we removed them.
+template<typename Table>
+void remove_expired(Table& table, std::size_t& sizeAfterLastRemoval)
+{
+  if(table.size() < 2 * sizeAfterLastRemoval + 64)
+    {
+    return;
+    }
+  typename Table::iterator i = table.begin();
+  while(i != table.end())
+    {
+    if(i->second.expired())
+      {
+      table.erase(i++);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  sizeAfterLastRemoval = table.size();
+}
+
+boost::mutex& interning_mutex()
+{
+  static boost::mutex m;
+  return m;
+}
+}
+
 namespace remus{
 namespace proto{
 
@@ -68,13 +145,96 @@ private:
   remus::common::ConditionalStorage Storage;
 };
 
+//------------------------------------------------------------------------------
+boost::shared_ptr<const JobRequirements::IdentityRecord>
+JobRequirements::intern(remus::common::ContentSource::Type stype,
+                        remus::common::ContentFormat::Type ftype,
+                        const remus::common::MeshIOType& mtype,
+                        const std::string& wname,
+                        const std::string& tag)
+{
+  boost::uint64_t fingerprint = FingerprintBasis;
+  fingerprint = fingerprint_value(fingerprint, static_cast<boost::uint64_t>(stype));
+  fingerprint = fingerprint_value(fingerprint, static_cast<boost::uint64_t>(ftype));
+  fingerprint = fingerprint_string(fingerprint, mtype.inputType());
+  fingerprint = fingerprint_string(fingerprint, mtype.outputType());
+  fingerprint = fingerprint_string(fingerprint, wname);
+  fingerprint = fingerprint_string(fingerprint, tag);
+
+  typedef std::map< boost::uint64_t,
+                    boost::weak_ptr<const IdentityRecord> > TableType;
+  static TableType table;
+  static std::size_t sizeAfterLastRemoval = 0;
+
+  boost::lock_guard<boost::mutex> lock(interning_mutex());
+  boost::weak_ptr<const IdentityRecord>& entry = table[fingerprint];
+  boost::shared_ptr<const IdentityRecord> record = entry.lock();
+  if(record &&
+     record->SourceType == stype && record->FormatType == ftype &&
+     record->MeshType == mtype && record->WorkerName == wname &&
+     record->Tag == tag)
+    {
+    return record;
+    }
+
+  boost::shared_ptr<IdentityRecord> created =
+                                        boost::make_shared<IdentityRecord>();
+  created->SourceType = stype;
+  created->FormatType = ftype;
+  created->MeshType = mtype;
+  created->WorkerName = wname;
+  created->Tag = tag;
+  created->Fingerprint = fingerprint;
+
+  //when two live identities share a fingerprint the newer one isn't
+  //interned, which only costs us the pointer compare fast path for it
+  if(!record)
+    {
+    entry = created;
+    remove_expired(table, sizeAfterLastRemoval);
+    }
+  return created;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<JobRequirements::InternalImpl>
+JobRequirements::intern(const boost::shared_array<char>& contents,
+                        std::size_t size)
+{
+  const std::string digest = remus::common::FastHash(contents.get(), size);
+
+  typedef std::map< std::string,
+                    boost::weak_ptr<InternalImpl> > TableType;
+  static TableType table;
+  static std::size_t sizeAfterLastRemoval = 0;
+
+  boost::lock_guard<boost::mutex> lock(interning_mutex());
+  boost::weak_ptr<InternalImpl>& entry = table[digest];
+  boost::shared_ptr<InternalImpl> impl = entry.lock();
+  if(impl && impl->size() == size &&
+     std::memcmp(impl->data(), contents.get(), size) == 0)
+    {
+    return impl;
+    }
+
+  //make_shared is significantly faster than using manual new
+  boost::shared_ptr<InternalImpl> created =
+                              boost::make_shared<InternalImpl>(contents, size);
+  if(!impl)
+    {
+    entry = created;
+    remove_expired(table, sizeAfterLastRemoval);
+    }
+  return created;
+}
+
 //------------------------------------------------------------------------------
 JobRequirements::JobRequirements():
-  SourceType(),
-  FormatType(),
-  MeshType(),
-  WorkerName(),
-  Tag(),
+  Identity(intern(remus::common::ContentSource::Type(),
+                  remus::common::ContentFormat::Type(),
+                  remus::common::MeshIOType(),
+                  std::string(),
+                  std::string())),
   Implementation(boost::make_shared<InternalImpl>(
                  static_cast<char*>(NULL),std::size_t(0)))
 {
@@ -85,11 +245,8 @@ JobRequirements::JobRequirements(remus::common::ContentFormat::Type ftype,
                                  remus::common::MeshIOType mtype,
                                  const std::string& wname,
                                  const remus::common::FileHandle& reqs_file ):
-  SourceType(remus::common::ContentSource::File),
-  FormatType(ftype),
-  MeshType(mtype),
-  WorkerName(wname),
-  Tag(),
+  Identity(intern(remus::common::ContentSource::File,
+                  ftype, mtype, wname, std::string())),
   Implementation(boost::make_shared<InternalImpl>(reqs_file))
 {
 }
@@ -100,11 +257,8 @@ JobRequirements::JobRequirements(remus::common::ContentFormat::Type ftype,
                                  remus::common::MeshIOType mtype,
                                  const std::string& wname,
                                  const std::string& reqs ):
-  SourceType(remus::common::ContentSource::Memory),
-  FormatType(ftype),
-  MeshType(mtype),
-  WorkerName(wname),
-  Tag(),
+  Identity(intern(remus::common::ContentSource::Memory,
+                  ftype, mtype, wname, std::string())),
   Implementation(boost::make_shared<InternalImpl>(reqs))
 {
 }
@@ -115,16 +269,28 @@ JobRequirements::JobRequirements(remus::common::ContentFormat::Type ftype,
                                  const std::string& wname,
                                  const char* reqs,
                                  std::size_t reqs_size ):
-  SourceType(remus::common::ContentSource::Memory),
-  FormatType(ftype),
-  MeshType(mtype),
-  WorkerName(wname),
-  Tag(),
+  Identity(intern(remus::common::ContentSource::Memory,
+                  ftype, mtype, wname, std::string())),
   Implementation(boost::make_shared<InternalImpl>(reqs,reqs_size))
 {
 }
 
 
+//------------------------------------------------------------------------------
+void JobRequirements::tag(const std::string& t)
+{
+  this->Identity = intern(this->sourceType(), this->formatType(),
+                          this->meshTypes(), this->workerName(), t);
+}
+
+//------------------------------------------------------------------------------
+JobRequirements JobRequirements::withoutRequirements() const
+{
+  JobRequirements light;
+  light.Identity = this->Identity;
+  return light;
+}
+
 //------------------------------------------------------------------------------
 bool JobRequirements::hasRequirements() const
 {
@@ -146,6 +312,9 @@ const char* JobRequirements::requirements() const
 //------------------------------------------------------------------------------
  bool JobRequirements::operator<(const JobRequirements& other) const
 {
+  if(this->Identity == other.Identity)
+    { return false; }
+
   //the sort order as follows.
   //first comes mesh input & output type, this allows us to group all
   //requirements for a given input & output type together
@@ -176,6 +345,12 @@ const char* JobRequirements::requirements() const
 //------------------------------------------------------------------------------
  bool JobRequirements::operator==(const JobRequirements& other) const
  {
+  //equal identities are interned to the same record, so we only need
+  //to compare the fields when the fingerprints collide
+  if(this->Identity == other.Identity)
+    { return true; }
+  if(this->fingerprint() != other.fingerprint())
+    { return false; }
   return ((this->meshTypes() == other.meshTypes()) &&
           (this->sourceType() == other.sourceType()) &&
           (this->formatType() == other.formatType()) &&
@@ -206,20 +381,24 @@ void JobRequirements::serialize(std::ostream& buffer) const
 JobRequirements::JobRequirements(std::istream& buffer)
 {
   int stype=0, ftype=0, workerNameSize=0, tagSize=0, contentsSize=0;
+  remus::common::MeshIOType mtype;
 
   //read in the source and format types
   buffer >> stype;
   buffer >> ftype;
-  buffer >> this->MeshType;
-
-  this->SourceType = static_cast<remus::common::ContentSource::Type>(stype);
-  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+  buffer >> mtype;
 
   buffer >> workerNameSize;
-  this->WorkerName = remus::internal::extractString(buffer,workerNameSize);
+  const std::string wname =
+                      remus::internal::extractString(buffer,workerNameSize);
 
   buffer >> tagSize;
-  this->Tag = remus::internal::extractString(buffer,tagSize);
+  const std::string t = remus::internal::extractString(buffer,tagSize);
+
+  this->Identity =
+        intern(static_cast<remus::common::ContentSource::Type>(stype),
+               static_cast<remus::common::ContentFormat::Type>(ftype),
+               mtype, wname, t);
 
   //read in the contents. By using a shared_array instead of a vector
   //we reduce the memory overhead, as that shared_array is used by
@@ -239,9 +418,8 @@ JobRequirements::JobRequirements(std::istream& buffer)
                                     static_cast<char*>(NULL),std::size_t(0));
     }
   else
-    { //make_shared is significantly faster than using manual new
-    this->Implementation = boost::make_shared<InternalImpl>(
-                                                contents, contentsSize);
+    { //every job and worker with the same requirements shares the contents
+    this->Implementation = intern(contents, contentsSize);
     }
 }
 
@@ -263,6 +441,61 @@ remus::proto::JobRequirements to_JobRequirements(const char* data, std::size_t s
   return reqs;
 }
 
+//------------------------------------------------------------------------------
+std::string requirementsDigest(const remus::proto::JobRequirements& reqs)
+{
+  const std::string data = to_string(reqs);
+  return remus::common::ContentHash(data.c_str(), data.size());
+}
+
+//------------------------------------------------------------------------------
+void writeCachedRequirements(std::ostream& buffer,
+                             const CachedRequirements& cached)
+{
+  buffer << cached.Tag.size() << std::endl;
+  remus::internal::writeString(buffer, cached.Tag);
+  buffer << (cached.Modified ? 1 : 0) << std::endl;
+
+  buffer << cached.Requirements.size() << std::endl;
+  typedef std::map<std::string, std::string>::const_iterator ReqIt;
+  for(ReqIt i = cached.Requirements.begin();
+      i != cached.Requirements.end(); ++i)
+    {
+    buffer << i->first.size() << std::endl;
+    remus::internal::writeString(buffer, i->first);
+    buffer << i->second.size() << std::endl;
+    remus::internal::writeString(buffer, i->second);
+    }
+}
+
+//------------------------------------------------------------------------------
+CachedRequirements readCachedRequirements(std::istream& buffer)
+{
+  CachedRequirements cached;
+  std::size_t tagSize = 0;
+  buffer >> tagSize;
+  cached.Tag = remus::internal::extractString(buffer, tagSize);
+
+  int modified = 1;
+  buffer >> modified;
+  cached.Modified = (modified != 0);
+
+  std::size_t numRequirements = 0;
+  buffer >> numRequirements;
+  for(std::size_t i=0; i < numRequirements && buffer.good(); ++i)
+    {
+    std::size_t digestSize = 0;
+    buffer >> digestSize;
+    const std::string digest = remus::internal::extractString(buffer,
+                                                              digestSize);
+    std::size_t dataSize = 0;
+    buffer >> dataSize;
+    cached.Requirements[digest] =
+                        remus::internal::extractString(buffer, dataSize);
+    }
+  return cached;
+}
+
 //------------------------------------------------------------------------------
 JobRequirementsSet::JobRequirementsSet():
 Container()
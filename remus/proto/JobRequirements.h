@@ -14,8 +14,12 @@
 #define remus_proto_JobRequirements_h
 
 #include <string>
+#include <map>
 #include <set>
+#include <string>
 
+#include <boost/cstdint.hpp>
+#include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
 
 //for ContentFormat and ContentSource
@@ -72,23 +76,30 @@ public:
   //returns if the source of the mesh requirements is memory or a file
   //this can allow people to pass just file paths for local workers
   remus::common::ContentSource::Type sourceType() const
-    { return this->SourceType; }
+    { return this->Identity->SourceType; }
 
   //get the storage format that we currently have setup for the
   //mesh requirements. This is something like XML, or JSON.
   remus::common::ContentFormat::Type formatType() const
-    { return this->FormatType; }
+    { return this->Identity->FormatType; }
 
   //get the mesh types for the given workers job mesh requirements
-  const remus::common::MeshIOType& meshTypes() const { return MeshType; }
+  const remus::common::MeshIOType& meshTypes() const
+    { return this->Identity->MeshType; }
 
   //get the name of the worker that this job mesh requirements is for
-  const std::string& workerName() const { return this->WorkerName; }
+  const std::string& workerName() const
+    { return this->Identity->WorkerName; }
 
   //get a worker specified tag that holds meta data information
   //about this job mesh requirements
-  const std::string& tag() const { return this->Tag; }
-  void tag(const std::string& t) { this->Tag=t; }
+  const std::string& tag() const { return this->Identity->Tag; }
+  void tag(const std::string& t);
+
+  //get a 64 bit fingerprint of the mesh types, source type, format type,
+  //worker name and tag. Requirements that are equal have the same
+  //fingerprint, so requirements with different fingerprints are never equal
+  boost::uint64_t fingerprint() const { return this->Identity->Fingerprint; }
 
   bool hasRequirements() const;
   std::size_t requirementsSize() const;
@@ -99,7 +110,9 @@ public:
   const char* requirements() const;
 
   //implement a less than operator and equal operator so you
-  //can use the class in containers and algorithms
+  //can use the class in containers and algorithms. Neither looks at the
+  //requirements data, and requirements that are equal share the same
+  //identity, so comparing equal requirements is a pointer compare.
   bool operator<(const JobRequirements& other) const;
   bool operator==(const JobRequirements& other) const;
 
@@ -116,21 +129,45 @@ private:
   //of the full requirements to the server. This is the easiest way to do so.
   friend class remus::worker::Worker;
 
-
   //serialize function
   void serialize(std::ostream& buffer) const;
 
   //deserialize constructor function
   explicit JobRequirements(std::istream& buffer);
 
-  remus::common::ContentSource::Type SourceType;
-  remus::common::ContentFormat::Type FormatType;
-  remus::common::MeshIOType MeshType;
-  std::string WorkerName;
-  std::string Tag;
+  //returns a copy that shares our identity, but holds no requirements data
+  JobRequirements withoutRequirements() const;
+
+  //Everything but the requirements data that makes up a JobRequirements.
+  //Identities are immutable and interned, so all the jobs and workers
+  //that have equal requirements share a single identity.
+  struct IdentityRecord
+  {
+    remus::common::ContentSource::Type SourceType;
+    remus::common::ContentFormat::Type FormatType;
+    remus::common::MeshIOType MeshType;
+    std::string WorkerName;
+    std::string Tag;
+    boost::uint64_t Fingerprint;
+  };
+
+  static boost::shared_ptr<const IdentityRecord> intern(
+                              remus::common::ContentSource::Type stype,
+                              remus::common::ContentFormat::Type ftype,
+                              const remus::common::MeshIOType& mtype,
+                              const std::string& wname,
+                              const std::string& tag);
+
+  boost::shared_ptr<const IdentityRecord> Identity;
 
   struct InternalImpl;
   boost::shared_ptr<InternalImpl> Implementation;
+
+  //returns the storage of deserialized requirements data, which is shared
+  //with all other live requirements whose data has the same digest
+  static boost::shared_ptr<InternalImpl> intern(
+                              const boost::shared_array<char>& contents,
+                              std::size_t size);
 };
 
 //a simple container so we can send a collection of requirements
@@ -221,6 +258,42 @@ inline remus::proto::JobRequirements to_JobRequirements(const std::string& msg)
   return to_JobRequirements(msg.c_str(), msg.size());
 }
 
+//------------------------------------------------------------------------------
+//returns the digest of the serialized requirements, which changes whenever
+//any part of them, including the requirements document, changes
+REMUSPROTO_EXPORT
+std::string requirementsDigest(const remus::proto::JobRequirements& reqs);
+
+//------------------------------------------------------------------------------
+//The requirements for a MeshIOType that a client holds from an earlier
+//CACHED_MESH_REQUIREMENTS answer, and the answer of the server to them.
+//The tag names the answer the requirements came from. When the server's
+//answer still has the same tag it isn't modified, and no requirements are
+//sent. Otherwise each of the requirements is sent by its digest, along with
+//its serialized form when the client doesn't already hold it.
+struct REMUSPROTO_EXPORT CachedRequirements
+{
+  CachedRequirements(): Tag(), Modified(true), Requirements() {}
+
+  std::string Tag;
+  bool Modified;
+
+  //maps the digest of each of the requirements to their serialized form,
+  //which is empty for requirements the client already holds
+  std::map<std::string, std::string> Requirements;
+};
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+void writeCachedRequirements(std::ostream& buffer,
+                             const CachedRequirements& cached);
+
+//------------------------------------------------------------------------------
+//reads back what was written by writeCachedRequirements, if the buffer
+//is empty a modified answer without a tag or requirements is returned
+REMUSPROTO_EXPORT
+CachedRequirements readCachedRequirements(std::istream& buffer);
+
 }
 }
 
@@ -85,6 +85,7 @@ private:
 //------------------------------------------------------------------------------
 JobResult::JobResult(const boost::uuids::uuid& jid):
   JobId(jid),
+  SourceType(),
   FormatType(),
   Implementation( boost::make_shared<InternalImpl>(
                  static_cast<char*>(NULL),std::size_t(0)) )
@@ -97,6 +98,7 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
             remus::common::ContentFormat::Type format,
             const remus::common::FileHandle& fileHandle):
   JobId(jid),
+  SourceType(remus::common::ContentSource::File),
   FormatType(format),
   Implementation( boost::make_shared<InternalImpl>(fileHandle) )
   //make_shared is significantly faster than using manual new
@@ -109,6 +111,7 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
             remus::common::ContentFormat::Type format,
             const std::string& contents):
   JobId(jid),
+  SourceType(remus::common::ContentSource::Memory),
   FormatType(format),
   Implementation( boost::make_shared<InternalImpl>(contents) )
   //make_shared is significantly faster than using manual new
@@ -121,6 +124,7 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
             const char* contents,
             std::size_t size):
   JobId(jid),
+  SourceType(remus::common::ContentSource::Memory),
   FormatType(format),
   Implementation( boost::make_shared<InternalImpl>(contents,size) )
   //make_shared is significantly faster than using manual new
@@ -128,6 +132,19 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
 
 }
 
+//------------------------------------------------------------------------------
+JobResult::JobResult(const boost::uuids::uuid& jid,
+            remus::common::ContentFormat::Type format,
+            const boost::shared_array<char>& contents,
+            std::size_t size):
+  JobId(jid),
+  SourceType(remus::common::ContentSource::Memory),
+  FormatType(format),
+  Implementation( boost::make_shared<InternalImpl>(contents,size) )
+  //make_shared is significantly faster than using manual new
+{
+}
+
 //------------------------------------------------------------------------------
 bool JobResult::valid() const
 {
@@ -163,6 +180,7 @@ bool JobResult::operator==(const JobResult& other) const
 void JobResult::serialize(std::ostream& buffer) const
 {
   buffer << this->id() << std::endl;
+  buffer << this->sourceType() << std::endl;
   buffer << this->formatType() << std::endl;
   buffer << this->Implementation->size() << std::endl;
   remus::internal::writeString( buffer,
@@ -173,12 +191,14 @@ void JobResult::serialize(std::ostream& buffer) const
 //------------------------------------------------------------------------------
 JobResult::JobResult(std::istream& buffer)
 {
-  int ftype=0;
+  int stype=0, ftype=0;
   std::size_t contentsSize=0;
 
   buffer >> this->JobId;
+  buffer >> stype;
   buffer >> ftype;
 
+  this->SourceType = static_cast<remus::common::ContentSource::Type>(stype);
   this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
 
   //read in the contents. By using a shared_array instead of a vector
@@ -15,6 +15,7 @@
 
 #include <string>
 
+#include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
 
 //for ContentFormat and ContentSource
@@ -37,9 +38,10 @@ public:
   //construct an invalid JobResult
   JobResult(const boost::uuids::uuid& jid);
 
-  //pass in some data to send back to the client. The path to the file
-  //will passed to the client. In the future we plan to extend remus
-  //to support automatic file reading.
+  //pass in some data to send back to the client. When the worker and server
+  //are on the same machine only the path to the file is sent, otherwise the
+  //worker sends the contents of the file and the client receives them as
+  //an in memory result.
   //The result should be considered invalid if the file names length is zero
   JobResult(const boost::uuids::uuid& jid,
             remus::common::ContentFormat::Type format,
@@ -61,6 +63,18 @@ public:
             const char* contents,
             std::size_t size);
 
+  //pass in some data to send back to the client. The JobResult shares
+  //ownership of the contents, so no copy of the data will happen. This is
+  //used when a result has been assembled from the chunks of a stream.
+  JobResult(const boost::uuids::uuid& jid,
+            remus::common::ContentFormat::Type format,
+            const boost::shared_array<char>& contents,
+            std::size_t size);
+
+  //returns if the source of the result is memory or a file
+  remus::common::ContentSource::Type sourceType() const
+    { return this->SourceType; }
+
   //get the storage format that we currently have setup for the source
   remus::common::ContentFormat::Type formatType() const
     { return this->FormatType; }
@@ -96,6 +110,7 @@ private:
   explicit JobResult(std::istream& buffer);
 
   boost::uuids::uuid JobId;
+  remus::common::ContentSource::Type SourceType;
   remus::common::ContentFormat::Type FormatType;
 
   struct InternalImpl;
@@ -23,7 +23,8 @@ namespace proto {
 JobStatus::JobStatus(const boost::uuids::uuid& jid, remus::STATUS_TYPE statusType):
   JobId(jid),
   Status(statusType),
-  Progress(statusType)
+  Progress(statusType),
+  Retries(0)
 {
 }
 
@@ -34,7 +35,8 @@ JobStatus::JobStatus(const boost::uuids::uuid& jid,
                      const remus::proto::JobProgress& jprogress):
   JobId(jid),
   Status(remus::IN_PROGRESS),
-  Progress(jprogress)
+  Progress(jprogress),
+  Retries(0)
 {
 }
 
@@ -51,15 +53,18 @@ void JobStatus::serialize(std::ostream& buffer) const
   buffer << this->id() << std::endl;
   buffer << this->status() << std::endl;
   buffer << this->progress() << std::endl;
+  buffer << this->retries() << std::endl;
 }
 
 //------------------------------------------------------------------------------
-JobStatus::JobStatus(std::istream& buffer)
+JobStatus::JobStatus(std::istream& buffer):
+  Retries(0)
 {
   int t;
   buffer >> this->JobId;
   buffer >> t;
   buffer >> this->Progress;
+  buffer >> this->Retries;
   this->Status = static_cast<remus::STATUS_TYPE>(t);
 }
 
@@ -99,13 +99,21 @@ public:
   //get back the status flag type for this job
   remus::STATUS_TYPE status() const { return Status; }
 
+  //returns the number of times the server has requeued the job because
+  //the worker running it died
+  int retries() const { return Retries; }
+
+  //set the number of times the job has been requeued
+  void retries(int count) { this->Retries = count > 0 ? count : 0; }
+
   //overload on the job status object to make it easier to detect when
   //job status has been changed.
   bool operator ==(const JobStatus& b) const
   {
     return (this->JobId == b.JobId)   &&
            (this->Status == b.Status) &&
-           (this->Progress == b.Progress);
+           (this->Progress == b.Progress) &&
+           (this->Retries == b.Retries);
   }
 
   //overload on the job status object to make it easier to detect when
@@ -132,6 +140,7 @@ private:
   boost::uuids::uuid JobId;
   remus::STATUS_TYPE Status;
   remus::proto::JobProgress Progress;
+  int Retries;
 };
 
 //------------------------------------------------------------------------------
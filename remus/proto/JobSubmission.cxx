@@ -24,7 +24,11 @@ namespace proto{
 JobSubmission::JobSubmission(  ):
   MeshType( ),
   Requirements( ),
-  Content()
+  Content(),
+  QueueTimeout(0),
+  RunTimeout(0),
+  RetryLimit(0),
+  RetryBackoff(0)
 {
 }
 
@@ -32,7 +36,11 @@ JobSubmission::JobSubmission(  ):
 JobSubmission::JobSubmission( const remus::proto::JobRequirements& reqs ):
   MeshType(reqs.meshTypes()),
   Requirements(reqs),
-  Content()
+  Content(),
+  QueueTimeout(0),
+  RunTimeout(0),
+  RetryLimit(0),
+  RetryBackoff(0)
 {
 }
 
@@ -41,7 +49,11 @@ JobSubmission::JobSubmission( const remus::proto::JobRequirements& reqs,
                               const remus::proto::JobContent& content ):
   MeshType(reqs.meshTypes()),
   Requirements(reqs),
-  Content( )
+  Content( ),
+  QueueTimeout(0),
+  RunTimeout(0),
+  RetryLimit(0),
+  RetryBackoff(0)
 {
   this->Content[this->default_key()]=content;
 }
@@ -51,7 +63,11 @@ JobSubmission::JobSubmission( const remus::proto::JobRequirements& reqs,
             const std::map<std::string,remus::proto::JobContent>& content ):
   MeshType(reqs.meshTypes()),
   Requirements(reqs),
-  Content(content)
+  Content(content),
+  QueueTimeout(0),
+  RunTimeout(0),
+  RetryLimit(0),
+  RetryBackoff(0)
 {
 }
 
@@ -98,10 +114,21 @@ void JobSubmission::serialize(std::ostream& buffer) const
     remus::internal::writeString(buffer,i->first);
     buffer << i->second << std::endl;
     }
+  buffer << this->QueueTimeout << std::endl;
+  buffer << this->RunTimeout << std::endl;
+  buffer << this->RetryLimit << std::endl;
+  buffer << this->RetryBackoff << std::endl;
 }
 
 //------------------------------------------------------------------------------
-JobSubmission::JobSubmission(std::istream& buffer)
+JobSubmission::JobSubmission(std::istream& buffer):
+  MeshType(),
+  Requirements(),
+  Content(),
+  QueueTimeout(0),
+  RunTimeout(0),
+  RetryLimit(0),
+  RetryBackoff(0)
 {
   std::size_t contentSize=0;
   buffer >> this->MeshType;
@@ -118,6 +145,10 @@ JobSubmission::JobSubmission(std::istream& buffer)
     buffer >> value;
     this->Content[key]=value;
     }
+  buffer >> this->QueueTimeout;
+  buffer >> this->RunTimeout;
+  buffer >> this->RetryLimit;
+  buffer >> this->RetryBackoff;
 }
 
 //------------------------------------------------------------------------------
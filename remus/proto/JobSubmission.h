@@ -16,6 +16,8 @@
 #include <string>
 #include <map>
 
+#include <boost/cstdint.hpp>
+
 #include <remus/proto/JobContent.h>
 #include <remus/proto/JobRequirements.h>
 
@@ -86,6 +88,31 @@ public:
   const remus::proto::JobRequirements& requirements( ) const
     { return this->Requirements; }
 
+  //set the number of milliseconds the job can wait in the server queue
+  //before it is dropped, and can run on a worker before it is terminated.
+  //Both fail the job. Zero, the default, uses the default timeouts the
+  //server has for the requirements of the job
+  void queueTimeout( boost::int64_t milliseconds )
+    { this->QueueTimeout = milliseconds > 0 ? milliseconds : 0; }
+  boost::int64_t queueTimeout( ) const { return this->QueueTimeout; }
+
+  void runTimeout( boost::int64_t milliseconds )
+    { this->RunTimeout = milliseconds > 0 ? milliseconds : 0; }
+  boost::int64_t runTimeout( ) const { return this->RunTimeout; }
+
+  //set the number of times the server requeues the job when the worker
+  //running it dies, and the milliseconds it waits before the first requeue.
+  //The wait doubles with every retry. Zero retries, the default, fails the
+  //job as EXPIRED when its worker dies. The server holds onto the
+  //submission for as long as the job can be retried
+  void retryLimit( int retries )
+    { this->RetryLimit = retries > 0 ? retries : 0; }
+  int retryLimit( ) const { return this->RetryLimit; }
+
+  void retryBackoff( boost::int64_t milliseconds )
+    { this->RetryBackoff = milliseconds > 0 ? milliseconds : 0; }
+  boost::int64_t retryBackoff( ) const { return this->RetryBackoff; }
+
   //implement a less than operator and equal operator so you
   //can use the class in containers and algorithms
   bool operator<(const JobSubmission& other) const;
@@ -110,7 +137,10 @@ private:
   remus::common::MeshIOType MeshType;
   remus::proto::JobRequirements Requirements;
   ContainerType Content;
-
+  boost::int64_t QueueTimeout;
+  boost::int64_t RunTimeout;
+  int RetryLimit;
+  boost::int64_t RetryBackoff;
 
 };
 
@@ -0,0 +1,153 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/MD5Hash.h>
+#include <remus/proto/ContentSummary.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <sstream>
+#include <vector>
+
+namespace {
+
+using namespace remus::proto;
+
+//------------------------------------------------------------------------------
+std::vector<std::string> make_digests(std::size_t count, const std::string& prefix)
+{
+  std::vector<std::string> digests;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    const std::string content = prefix + boost::lexical_cast<std::string>(i);
+    digests.push_back( remus::common::MD5Hash(content.c_str(), content.size()) );
+    }
+  return digests;
+}
+
+//------------------------------------------------------------------------------
+void verify_empty()
+{
+  ContentSummary summary;
+  REMUS_ASSERT( (summary.empty()) )
+  REMUS_ASSERT( (summary.numberOfBits() == 0) )
+  REMUS_ASSERT( (!summary.mayContain("digest")) )
+
+  //adding to a summary without bits is ignored
+  summary.add("digest");
+  REMUS_ASSERT( (summary.empty()) )
+
+  ContentSummary sized(16);
+  REMUS_ASSERT( (sized.empty()) )
+  REMUS_ASSERT( (sized.numberOfBits() >= 160) )
+  REMUS_ASSERT( (!sized.mayContain("digest")) )
+}
+
+//------------------------------------------------------------------------------
+void verify_membership()
+{
+  const std::vector<std::string> added = make_digests(64, "added");
+  const std::vector<std::string> others = make_digests(1000, "other");
+
+  ContentSummary summary(added.size());
+  for(std::size_t i=0; i < added.size(); ++i)
+    {
+    summary.add(added[i]);
+    }
+  REMUS_ASSERT( (!summary.empty()) )
+
+  //a digest that was added is never missed
+  for(std::size_t i=0; i < added.size(); ++i)
+    {
+    REMUS_ASSERT( (summary.mayContain(added[i])) )
+    }
+
+  //false positives should be rare
+  std::size_t falsePositives = 0;
+  for(std::size_t i=0; i < others.size(); ++i)
+    {
+    falsePositives += summary.mayContain(others[i]) ? 1 : 0;
+    }
+  REMUS_ASSERT( (falsePositives < 50) )
+}
+
+//------------------------------------------------------------------------------
+void verify_serialization()
+{
+  const std::vector<std::string> added = make_digests(8, "added");
+  ContentSummary summary(added.size());
+  for(std::size_t i=0; i < added.size(); ++i)
+    {
+    summary.add(added[i]);
+    }
+
+  std::stringstream buffer;
+  writeContentSummary(buffer, summary);
+  buffer << "trailing" << std::endl;
+
+  ContentSummary from_buffer = readContentSummary(buffer);
+  REMUS_ASSERT( (from_buffer.numberOfBits() == summary.numberOfBits()) )
+  for(std::size_t i=0; i < added.size(); ++i)
+    {
+    REMUS_ASSERT( (from_buffer.mayContain(added[i])) )
+    }
+
+  //what follows the summary is left in the buffer
+  std::string trailing;
+  buffer >> trailing;
+  REMUS_ASSERT( (trailing == "trailing") )
+
+  //an empty summary round trips
+  std::stringstream empty_buffer;
+  writeContentSummary(empty_buffer, ContentSummary());
+  REMUS_ASSERT( (readContentSummary(empty_buffer).empty()) )
+
+  //a buffer without a summary gives an empty summary
+  std::stringstream no_summary;
+  REMUS_ASSERT( (readContentSummary(no_summary).empty()) )
+}
+
+
+//------------------------------------------------------------------------------
+void verify_changes()
+{
+  ContentChanges changes;
+  REMUS_ASSERT( (changes.empty()) )
+  changes.Added.insert("first");
+  changes.Added.insert("second");
+  changes.Dropped.insert("third");
+
+  std::stringstream buffer;
+  writeContentSummary(buffer, ContentSummary());
+  writeContentChanges(buffer, changes);
+
+  REMUS_ASSERT( (readContentSummary(buffer).empty()) )
+  ContentChanges from_buffer = readContentChanges(buffer);
+  REMUS_ASSERT( (from_buffer.Added == changes.Added) )
+  REMUS_ASSERT( (from_buffer.Dropped == changes.Dropped) )
+
+  //a buffer without changes gives empty changes
+  std::stringstream no_changes;
+  REMUS_ASSERT( (readContentChanges(no_changes).empty()) )
+}
+
+}
+
+int UnitTestContentSummary(int, char *[])
+{
+  verify_empty();
+  verify_membership();
+  verify_serialization();
+  verify_changes();
+  return 0;
+}
@@ -0,0 +1,125 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <boost/uuid/uuid.hpp>
+#include <algorithm>
+#include <remus/common/MD5Hash.h>
+#include <remus/proto/DataChunk.h>
+#include <remus/testing/Testing.h>
+
+namespace {
+
+using namespace remus::proto;
+
+boost::uuids::uuid make_id()
+{
+  return remus::testing::UUIDGenerator();
+}
+
+void validate_serialization(const DataChunk& c)
+{
+  std::string temp = to_string(c);
+  DataChunk from_string = to_DataChunk(temp);
+
+  REMUS_ASSERT( (from_string.id() == c.id()) );
+  REMUS_ASSERT( (from_string.key() == c.key()) );
+  REMUS_ASSERT( (from_string.formatType() == c.formatType()) );
+  REMUS_ASSERT( (from_string.offset() == c.offset()) );
+  REMUS_ASSERT( (from_string.isFinal() == c.isFinal()) );
+  REMUS_ASSERT( (from_string.totalSize() == c.totalSize()) );
+  REMUS_ASSERT( (from_string.checksum() == c.checksum()) );
+  REMUS_ASSERT( (from_string.dataSize() == c.dataSize()) );
+
+  std::string data_from_string(from_string.data(),from_string.dataSize());
+  std::string data_c(c.data(),c.dataSize());
+  REMUS_ASSERT( (data_from_string == data_c) );
+
+  std::stringstream buffer;
+  DataChunk from_buffer(make_id());
+  buffer << c;
+  buffer >> from_buffer;
+
+  REMUS_ASSERT( (from_buffer.id() == c.id()) );
+  REMUS_ASSERT( (from_buffer.key() == c.key()) );
+  REMUS_ASSERT( (from_buffer.offset() == c.offset()) );
+  REMUS_ASSERT( (from_buffer.isFinal() == c.isFinal()) );
+  REMUS_ASSERT( (from_buffer.checksum() == c.checksum()) );
+
+  std::string data_from_buffer(from_buffer.data(),from_buffer.dataSize());
+  REMUS_ASSERT( (data_from_buffer == data_c) );
+}
+
+void serialize_test()
+{
+  DataChunk empty(make_id());
+  REMUS_ASSERT( (empty.dataSize() == 0) );
+  REMUS_ASSERT( (!empty.isFinal()) );
+  validate_serialization(empty);
+
+  const std::string ascii = remus::testing::AsciiStringGenerator(1024);
+  DataChunk a(make_id(), remus::common::ContentFormat::XML,
+              0, ascii.c_str(), ascii.size());
+  validate_serialization(a);
+
+  //verify that a final chunk round trips its size and checksum
+  const std::string binary = remus::testing::BinaryDataGenerator(10240);
+  DataChunk b(make_id(), remus::common::ContentFormat::BSON,
+              4096, binary.c_str(), binary.size());
+  b.markAsFinal(4096 + binary.size(), remus::common::MD5Hash(binary));
+  REMUS_ASSERT( (b.isFinal()) );
+  REMUS_ASSERT( (b.totalSize() == 4096 + binary.size()) );
+  validate_serialization(b);
+
+  //a final chunk with no data is valid, and is used to terminate a stream
+  DataChunk c(make_id());
+  c.markAsFinal(0, remus::common::MD5Hash(std::string()));
+  validate_serialization(c);
+
+  //chunks of a job submission have the key of the content they are part of
+  boost::shared_array<char> owned( new char[binary.size()] );
+  std::copy(binary.begin(), binary.end(), owned.get());
+  DataChunk d(make_id(), remus::common::ContentFormat::User,
+              0, owned, binary.size());
+  d.key("mesh data");
+  REMUS_ASSERT( (d.key() == "mesh data") );
+  validate_serialization(d);
+
+  //the id can be read without decoding the chunk
+  const std::string d_str = to_string(d);
+  REMUS_ASSERT( (to_DataChunkId(d_str.c_str(), d_str.size()) == d.id()) );
+}
+
+void streamed_keys_test()
+{
+  StreamedKeys keys;
+  keys.insert("data");
+  keys.insert(std::string("binary\nkey\0", 11));
+  keys.insert(std::string());
+
+  std::stringstream buffer;
+  writeStreamedKeys(buffer, keys);
+  REMUS_ASSERT( (readStreamedKeys(buffer) == keys) );
+
+  //a buffer without keys is an empty set
+  std::stringstream empty;
+  REMUS_ASSERT( (readStreamedKeys(empty).empty()) );
+}
+
+}
+
+int UnitTestDataChunk(int, char *[])
+{
+  serialize_test();
+  streamed_keys_test();
+  return 0;
+}
@@ -10,6 +10,7 @@
 //
 //=============================================================================
 
+#include <remus/common/ContentHash.h>
 #include <remus/proto/JobContent.h>
 #include <remus/testing/Testing.h>
 
@@ -281,6 +282,70 @@ void verify_zero_copy_serilization(StringFactory factory)
   REMUS_ASSERT( (from_wire == input_content) );
 }
 
+void verify_shared_ownership()
+{
+  const std::string contents = make_small_binary_string()();
+  boost::shared_array<char> storage( new char[contents.size()] );
+  std::copy(contents.begin(), contents.end(), storage.get());
+
+  JobContent shared_content(ContentFormat::BSON, storage, contents.size());
+  REMUS_ASSERT( (shared_content.sourceType() == ContentSource::Memory) );
+  REMUS_ASSERT( (shared_content.formatType() == ContentFormat::BSON) );
+  REMUS_ASSERT( (shared_content.data() == storage.get()) );
+  REMUS_ASSERT( (shared_content.dataSize() == contents.size()) );
+
+  //the content keeps the data alive once the caller lets go of it
+  storage.reset();
+  const std::string held(shared_content.data(), shared_content.dataSize());
+  REMUS_ASSERT( (held == contents) );
+
+  JobContent from_wire = to_JobContent(to_string(shared_content));
+  REMUS_ASSERT( (from_wire == shared_content) );
+}
+
+void verify_transmitted_hash()
+{
+  JobContent content = make_JobContent( make_large_string()() );
+
+  //content that hasn't been hashed is sent without a digest
+  const std::string unhashed_wire = to_string(content);
+  JobContent unhashed = to_JobContent(unhashed_wire);
+  REMUS_ASSERT( (unhashed == content) );
+  REMUS_ASSERT( (unhashed.verifyHash()) );
+
+  //the digest is the last thing written, followed by a newline
+  const std::string digest = content.hash();
+  std::string wire = to_string(content);
+  REMUS_ASSERT( (wire.size() == unhashed_wire.size() + 33) );
+  const std::size_t hashStart = wire.size() - 33;
+  REMUS_ASSERT( (wire.substr(hashStart, 32) == digest) );
+  JobContent from_wire = to_JobContent(wire);
+  REMUS_ASSERT( (from_wire == content) );
+  REMUS_ASSERT( (from_wire.verifyHash()) );
+  REMUS_ASSERT( (from_wire.hash() == digest) );
+
+  //the receiver keeps the digest it was sent, and doesn't rehash the
+  //contents. So corrupting the digest makes the contents differ
+  wire.replace(hashStart, 32, std::string(32,'0'));
+  JobContent bad_hash = to_JobContent(wire);
+  REMUS_ASSERT( (bad_hash.dataSize() == content.dataSize()) );
+  REMUS_ASSERT( !(bad_hash == content) );
+  REMUS_ASSERT( ((bad_hash < content) != (content < bad_hash)) );
+
+  //until the digest is verified, which replaces it with the real one
+  REMUS_ASSERT( (!bad_hash.verifyHash()) );
+  REMUS_ASSERT( (bad_hash.hash() == digest) );
+  REMUS_ASSERT( (bad_hash == content) );
+  REMUS_ASSERT( (bad_hash.verifyHash()) );
+
+  //contents hashed with another algorithm are rehashed when compared
+  remus::common::defaultHashAlgorithm(remus::common::HashAlgorithm::MD5);
+  JobContent md5_content = to_JobContent(to_string(content));
+  remus::common::defaultHashAlgorithm(remus::common::HashAlgorithm::Fast128);
+  REMUS_ASSERT( (md5_content == content) );
+  REMUS_ASSERT( !(md5_content < content) && !(content < md5_content) );
+}
+
 }
 
 int UnitTestJobContent(int, char *[])
@@ -329,5 +394,8 @@ int UnitTestJobContent(int, char *[])
   verify_zero_copy_serilization( (make_really_large_string()) );
   std::cout << std::endl;
 
+  verify_shared_ownership();
+  verify_transmitted_hash();
+
   return 0;
 }
@@ -284,6 +284,119 @@ void verify_req_set()
   REMUS_ASSERT( same );
 }
 
+void verify_cached_requirements()
+{
+  const JobRequirements reqs = make_JobRequirements(
+                          MeshIOType(remus::meshtypes::Edges(),
+                                     remus::meshtypes::Mesh2D()),
+                          "worker", "<requirements/>");
+  JobRequirements changed = reqs;
+  changed.tag("changed");
+
+  //the digest changes when any part of the requirements change
+  REMUS_ASSERT( (requirementsDigest(reqs) == requirementsDigest(reqs)) );
+  REMUS_ASSERT( (requirementsDigest(reqs) != requirementsDigest(changed)) );
+
+  CachedRequirements to_wire;
+  to_wire.Tag = "server:2";
+  to_wire.Modified = true;
+  to_wire.Requirements[requirementsDigest(reqs)] = std::string();
+  to_wire.Requirements[requirementsDigest(changed)] = to_string(changed);
+
+  std::stringstream buffer;
+  writeCachedRequirements(buffer, to_wire);
+  const CachedRequirements from_wire = readCachedRequirements(buffer);
+  REMUS_ASSERT( (from_wire.Tag == to_wire.Tag) );
+  REMUS_ASSERT( (from_wire.Modified == true) );
+  REMUS_ASSERT( (from_wire.Requirements == to_wire.Requirements) );
+  REMUS_ASSERT( (to_JobRequirements(
+              from_wire.Requirements.find(requirementsDigest(changed))->second)
+              == changed) );
+
+  //an answer that isn't modified is just the tag
+  CachedRequirements current;
+  current.Tag = "server:2";
+  current.Modified = false;
+  std::stringstream current_buffer;
+  writeCachedRequirements(current_buffer, current);
+  const CachedRequirements read_current =
+                                readCachedRequirements(current_buffer);
+  REMUS_ASSERT( (read_current.Modified == false) );
+  REMUS_ASSERT( (read_current.Requirements.empty() == true) );
+
+  //an empty buffer is a modified answer without a tag
+  std::stringstream empty_buffer;
+  const CachedRequirements empty = readCachedRequirements(empty_buffer);
+  REMUS_ASSERT( (empty.Tag.empty() == true) );
+  REMUS_ASSERT( (empty.Modified == true) );
+}
+
+//------------------------------------------------------------------------------
+void verify_fingerprint()
+{
+  const MeshIOType types = MeshIOType(remus::meshtypes::Edges(),
+                                      remus::meshtypes::Mesh2D());
+  const JobRequirements a = make_JobRequirements(types, "worker", "<a/>");
+  const JobRequirements b = make_JobRequirements(types, "worker", "<b/>");
+  JobRequirements tagged = a;
+  tagged.tag("tagged");
+
+  //the fingerprint ignores the requirements data, just like operator==
+  REMUS_ASSERT( (a.fingerprint() == b.fingerprint()) );
+  REMUS_ASSERT( (a == b) );
+  REMUS_ASSERT( (!(a < b) && !(b < a)) );
+
+  //changing any other part of the requirements changes the fingerprint
+  REMUS_ASSERT( (a.fingerprint() != tagged.fingerprint()) );
+  REMUS_ASSERT( (a.fingerprint() !=
+          make_JobRequirements(types, "other", "<a/>").fingerprint()) );
+  REMUS_ASSERT( (a.fingerprint() !=
+          make_JobRequirements(MeshIOType(remus::meshtypes::Edges(),
+                                          remus::meshtypes::Mesh3D()),
+                               "worker", "<a/>").fingerprint()) );
+  REMUS_ASSERT( (a.fingerprint() !=
+          make_JobRequirements(types, "worker", "<a/>",
+                               ContentFormat::XML).fingerprint()) );
+
+  //tagging back gives us the original requirements
+  tagged.tag("");
+  REMUS_ASSERT( (tagged == a) );
+  REMUS_ASSERT( (tagged.fingerprint() == a.fingerprint()) );
+
+  //the fingerprint survives serialization
+  const JobRequirements from_wire = to_JobRequirements(to_string(tagged));
+  REMUS_ASSERT( (from_wire == a) );
+  REMUS_ASSERT( (from_wire.fingerprint() == a.fingerprint()) );
+}
+
+//------------------------------------------------------------------------------
+void verify_shared_requirements()
+{
+  const std::string data(4096, 'r');
+  const JobRequirements reqs = make_JobRequirements(
+                          MeshIOType(remus::meshtypes::Edges(),
+                                     remus::meshtypes::Mesh2D()),
+                          "worker", data);
+  const std::string serialized = to_string(reqs);
+
+  //requirements that are deserialized from the same data share it
+  const JobRequirements first = to_JobRequirements(serialized);
+  const JobRequirements second = to_JobRequirements(serialized);
+  REMUS_ASSERT( (first == second) );
+  REMUS_ASSERT( (first.requirementsSize() == data.size()) );
+  REMUS_ASSERT( (first.requirements() == second.requirements()) );
+  REMUS_ASSERT( (std::string(second.requirements(),
+                             second.requirementsSize()) == data) );
+
+  //but requirements with different data don't
+  std::string otherData = data;
+  otherData[otherData.size()-1] = 'x';
+  const JobRequirements other = to_JobRequirements(to_string(
+                    make_JobRequirements(reqs.meshTypes(), "worker", otherData)));
+  REMUS_ASSERT( (other.requirements() != first.requirements()) );
+  REMUS_ASSERT( (std::string(other.requirements(),
+                             other.requirementsSize()) == otherData) );
+}
 
 }
 
@@ -301,5 +414,9 @@ int UnitTestJobRequirements(int, char *[])
   verify_serilization();
 
   verify_req_set();
+
+  verify_cached_requirements();
+  verify_fingerprint();
+  verify_shared_requirements();
   return 0;
 }
\ No newline at end of file
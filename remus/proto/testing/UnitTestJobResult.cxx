@@ -33,6 +33,7 @@ remus::common::ContentFormat::Type ftype = remus::common::ContentFormat::User)
   REMUS_ASSERT( (from_string.dataSize() == s.dataSize()) );
   REMUS_ASSERT( (from_string.valid() == s.valid()) );
   REMUS_ASSERT( (from_string.formatType() == ftype) );
+  REMUS_ASSERT( (from_string.sourceType() == s.sourceType()) );
 
   std::string data_from_string(from_string.data(),from_string.dataSize());
   std::string data_s(s.data(),s.dataSize());
@@ -48,6 +49,7 @@ remus::common::ContentFormat::Type ftype = remus::common::ContentFormat::User)
   REMUS_ASSERT( (from_buffer.dataSize() == s.dataSize()) );
   REMUS_ASSERT( (from_buffer.valid() == s.valid()) );
   REMUS_ASSERT( (from_buffer.formatType() == ftype) );
+  REMUS_ASSERT( (from_buffer.sourceType() == s.sourceType()) );
 
   std::string data_from_buffer(from_buffer.data(),from_buffer.dataSize());
   REMUS_ASSERT( (data_from_string == data_s) );
@@ -97,6 +99,11 @@ void serialize_test()
   JobResult c(make_id(), remus::common::ContentFormat::User,
               remus::common::FileHandle(std::string()));
   validate_serialization(c);
+  REMUS_ASSERT( (c.sourceType() == remus::common::ContentSource::File) );
+
+  JobResult d(make_id(), remus::common::ContentFormat::User, std::string("a"));
+  REMUS_ASSERT( (d.sourceType() == remus::common::ContentSource::Memory) );
+  validate_serialization(d);
 }
 
 }
@@ -189,6 +189,7 @@ void validate_serialization(JobStatus s)
   REMUS_ASSERT( (from_string.id() == s.id()) );
   REMUS_ASSERT( (from_string.status() == s.status()) );
   REMUS_ASSERT( (from_string.progress() == s.progress()) );
+  REMUS_ASSERT( (from_string.retries() == s.retries()) );
 
   REMUS_ASSERT( (from_string.failed() == s.failed() ) );
   REMUS_ASSERT( (from_string.good() == s.good() ) );
@@ -218,6 +219,24 @@ void serialize_test()
   JobProgress value_msg_progress(24,"message"); //progress with just a message
   JobStatus e(make_id(),value_msg_progress);
   validate_serialization(e);
+
+  JobStatus f(make_id(),remus::QUEUED); //a job that has been requeued
+  f.retries(2);
+  validate_serialization(f);
+}
+
+void retries_test()
+{
+  JobStatus a(make_id(),remus::QUEUED);
+  REMUS_ASSERT( (a.retries() == 0) );
+
+  a.retries(-3);
+  REMUS_ASSERT( (a.retries() == 0) );
+
+  JobStatus b = a;
+  b.retries(1);
+  REMUS_ASSERT( (b.retries() == 1) );
+  REMUS_ASSERT( (a != b) );
 }
 
 void valid_test()
@@ -295,6 +314,7 @@ int UnitTestJobStatus(int, char *[])
   progress_test();
   serialize_test();
   valid_test();
+  retries_test();
   make_functions();
 
   return 0;
@@ -302,6 +302,45 @@ void multiple_content_test()
 
 }
 
+void timeout_test()
+{ //verify that the timeouts default to none, and survive the wire
+  JobSubmission sub(make_random_MeshReqs());
+  REMUS_ASSERT( (sub.queueTimeout()==0) );
+  REMUS_ASSERT( (sub.runTimeout()==0) );
+
+  sub.queueTimeout(250);
+  sub.runTimeout(-5);
+  REMUS_ASSERT( (sub.queueTimeout()==250) );
+  REMUS_ASSERT( (sub.runTimeout()==0) );
+
+  sub.runTimeout(1000);
+  sub["a"]= remus::proto::make_JobContent(remus::testing::AsciiStringGenerator(128));
+  JobSubmission from_wire = to_JobSubmission(to_string(sub));
+  REMUS_ASSERT( (sub==from_wire) );
+  REMUS_ASSERT( (from_wire.queueTimeout()==250) );
+  REMUS_ASSERT( (from_wire.runTimeout()==1000) );
+}
+
+void retry_test()
+{ //verify that jobs aren't retried by default, and the policy survives the wire
+  JobSubmission sub(make_random_MeshReqs());
+  REMUS_ASSERT( (sub.retryLimit()==0) );
+  REMUS_ASSERT( (sub.retryBackoff()==0) );
+
+  sub.retryLimit(-1);
+  sub.retryBackoff(-20);
+  REMUS_ASSERT( (sub.retryLimit()==0) );
+  REMUS_ASSERT( (sub.retryBackoff()==0) );
+
+  sub.retryLimit(3);
+  sub.retryBackoff(500);
+  sub["a"]= remus::proto::make_JobContent(remus::testing::AsciiStringGenerator(128));
+  JobSubmission from_wire = to_JobSubmission(to_string(sub));
+  REMUS_ASSERT( (sub==from_wire) );
+  REMUS_ASSERT( (from_wire.retryLimit()==3) );
+  REMUS_ASSERT( (from_wire.retryBackoff()==500) );
+}
+
 
 int UnitTestJobSubmission(int, char *[])
 {
@@ -312,5 +351,8 @@ int UnitTestJobSubmission(int, char *[])
 
   multiple_content_test();
 
+  timeout_test();
+  retry_test();
+
   return 0;
 }
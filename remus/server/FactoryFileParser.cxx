@@ -178,6 +178,16 @@ namespace {
           environ[oneenv->string] = oneenv->valuestring;
       }
 
+    // Add the default timeouts of jobs, in milliseconds
+    boost::int64_t queueTimeout = 0;
+    boost::int64_t runTimeout = 0;
+    cJSON* queueobj = cJSON_GetObjectItem(root, "QueueTimeout");
+    if (queueobj && queueobj->type == cJSON_Number && queueobj->valuedouble > 0)
+      queueTimeout = static_cast<boost::int64_t>(queueobj->valuedouble);
+    cJSON* runobj = cJSON_GetObjectItem(root, "RunTimeout");
+    if (runobj && runobj->type == cJSON_Number && runobj->valuedouble > 0)
+      runTimeout = static_cast<boost::int64_t>(runobj->valuedouble);
+
     cJSON_Delete(root);
 
     //try the executableName as an absolute path, if that isn't
@@ -193,7 +203,10 @@ namespace {
     #endif
       exec_path = new_path;
       }
-    return remus::server::FactoryWorkerSpecification(exec_path, cmdline, environ, reqs);
+    remus::server::FactoryWorkerSpecification spec(exec_path, cmdline, environ, reqs);
+    spec.QueueTimeout = queueTimeout;
+    spec.RunTimeout = runTimeout;
+    return spec;
   }
 }
 
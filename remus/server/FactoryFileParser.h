@@ -22,6 +22,8 @@
 #define BOOST_FILESYSTEM_VERSION 3
 #include <boost/filesystem.hpp>
 
+#include <boost/cstdint.hpp>
+
 #include <map>
 #include <vector>
 
@@ -32,12 +34,18 @@ namespace server{
 //factory can launch. Currently the ExtraCommandLineArguments and
 //EnvironmentVariables are ignored by the default WorkerFactory, but
 //exist to allow for better worker factories designed by users of remus
+//
+//QueueTimeout and RunTimeout are the default number of milliseconds a job
+//for these requirements can wait in the queue, and can run, before it fails.
+//Zero means forever. Jobs that set their own timeouts ignore these
 struct REMUSSERVER_EXPORT FactoryWorkerSpecification
 {
   remus::proto::JobRequirements Requirements;
   boost::filesystem::path ExecutionPath;
   std::vector< std::string > ExtraCommandLineArguments;
   std::map< std::string, std::string > EnvironmentVariables;
+  boost::int64_t QueueTimeout;
+  boost::int64_t RunTimeout;
   bool isValid;
 
   FactoryWorkerSpecification():
@@ -45,6 +53,8 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(),
     EnvironmentVariables(),
+    QueueTimeout(0),
+    RunTimeout(0),
     isValid(false)
     {
     }
@@ -55,6 +65,8 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(),
     EnvironmentVariables(),
+    QueueTimeout(0),
+    RunTimeout(0),
     isValid(false)
     {
     if(boost::filesystem::is_regular_file(exec_path))
@@ -72,6 +84,8 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(extra_args),
     EnvironmentVariables(),
+    QueueTimeout(0),
+    RunTimeout(0),
     isValid(false)
     {
     if(boost::filesystem::is_regular_file(exec_path))
@@ -90,6 +104,8 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(extra_args),
     EnvironmentVariables(environment),
+    QueueTimeout(0),
+    RunTimeout(0),
     isValid(false)
     {
     if(boost::filesystem::is_regular_file(exec_path))
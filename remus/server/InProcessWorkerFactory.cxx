@@ -0,0 +1,437 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/InProcessWorkerFactory.h>
+
+#include <remus/proto/zmqHelper.h>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#include <boost/thread/locks.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <deque>
+#include <exception>
+#include <map>
+#include <set>
+
+namespace remus{
+namespace server{
+
+//------------------------------------------------------------------------------
+class InProcessWorkerFactory::Internals
+{
+public:
+  typedef std::map< remus::proto::JobRequirements,
+                    boost::shared_ptr<remus::server::InProcessJobFunction> >
+          FunctionMap;
+
+  Internals(std::size_t numberOfThreads):
+    NumberOfThreads(numberOfThreads),
+    Mutex(),
+    JobAdded(),
+    Functions(),
+    Jobs(),
+    Running(0),
+    Terminated(),
+    Statuses(),
+    Results(),
+    Shutdown(false),
+    Stopping(false),
+    Threads(),
+    WakeMutex(),
+    Wakeup()
+  {
+  }
+
+  const std::size_t NumberOfThreads;
+
+  //guards everything but the threads and the wakeup socket
+  mutable boost::mutex Mutex;
+  boost::condition_variable JobAdded;
+
+  FunctionMap Functions;
+
+  //jobs waiting for a thread, and the number of jobs being processed
+  std::deque<remus::worker::Job> Jobs;
+  std::size_t Running;
+
+  //jobs being processed that the client has terminated
+  std::set<boost::uuids::uuid> Terminated;
+
+  //what the jobs have reported that the server hasn't taken yet
+  std::vector<remus::proto::JobStatus> Statuses;
+  std::vector<remus::proto::JobResult> Results;
+
+  //the server is shutting down
+  bool Shutdown;
+  //the factory is being destroyed, so the threads should exit
+  bool Stopping;
+
+  boost::thread_group Threads;
+
+  //zmq sockets can't be shared between threads, so sending
+  //on the wakeup socket holds this lock
+  boost::mutex WakeMutex;
+  boost::scoped_ptr<zmq::socket_t> Wakeup;
+};
+
+//------------------------------------------------------------------------------
+InProcessJob::InProcessJob(InProcessWorkerFactory& factory,
+                           const remus::worker::Job& job):
+  Factory(factory),
+  CurrentJob(job),
+  Done(false)
+{
+}
+
+//------------------------------------------------------------------------------
+void InProcessJob::updateStatus(const remus::proto::JobStatus& status)
+{
+  if(status.failed())
+    {
+    this->Done = true;
+    }
+  this->Factory.post(status);
+}
+
+//------------------------------------------------------------------------------
+void InProcessJob::returnResult(const remus::proto::JobResult& result)
+{
+  this->Done = true;
+  this->Factory.post(result);
+}
+
+//------------------------------------------------------------------------------
+bool InProcessJob::jobShouldBeTerminated() const
+{
+  return this->Factory.isTerminated(this->CurrentJob.id());
+}
+
+//------------------------------------------------------------------------------
+bool InProcessJob::workerShouldTerminate() const
+{
+  return this->Factory.isShutdown();
+}
+
+//------------------------------------------------------------------------------
+InProcessWorkerFactory::InProcessWorkerFactory(std::size_t numberOfThreads):
+  WorkerFactoryBase(),
+  State( new Internals(numberOfThreads) )
+{
+  this->setMaxWorkerCount( static_cast<unsigned int>(numberOfThreads) );
+  for(std::size_t i=0; i < numberOfThreads; ++i)
+    {
+    this->State->Threads.add_thread(
+              new boost::thread(&InProcessWorkerFactory::processJobs, this));
+    }
+}
+
+//------------------------------------------------------------------------------
+InProcessWorkerFactory::~InProcessWorkerFactory()
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  this->State->Shutdown = true;
+  this->State->Stopping = true;
+  this->State->Jobs.clear();
+  }
+  this->State->JobAdded.notify_all();
+  this->State->Threads.join_all();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::registerJobFunction(
+                const remus::proto::JobRequirements& reqs,
+                boost::shared_ptr<remus::server::InProcessJobFunction> function)
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  this->State->Functions[reqs] = function;
+  this->registryChanged();
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t InProcessWorkerFactory::registryGeneration() const
+{
+  //functions can be registered while the server is brokering
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  return this->WorkerFactoryBase::registryGeneration();
+}
+
+//------------------------------------------------------------------------------
+std::size_t InProcessWorkerFactory::numberOfThreads() const
+{
+  return this->State->NumberOfThreads;
+}
+
+//------------------------------------------------------------------------------
+remus::common::MeshIOTypeSet InProcessWorkerFactory::supportedIOTypes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  remus::common::MeshIOTypeSet result;
+  typedef Internals::FunctionMap::const_iterator It;
+  for(It i = this->State->Functions.begin();
+      i != this->State->Functions.end(); ++i)
+    {
+    result.insert(i->first.meshTypes());
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet InProcessWorkerFactory::workerRequirements(
+                                      remus::common::MeshIOType type) const
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  remus::proto::JobRequirementsSet result;
+  typedef Internals::FunctionMap::const_iterator It;
+  for(It i = this->State->Functions.begin();
+      i != this->State->Functions.end(); ++i)
+    {
+    if(i->first.meshTypes() == type)
+      {
+      result.insert(i->first);
+      }
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool InProcessWorkerFactory::haveSupport(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  return this->State->Functions.count(reqs) > 0;
+}
+
+//------------------------------------------------------------------------------
+bool InProcessWorkerFactory::createWorker(
+                          const remus::proto::JobRequirements& type,
+                          WorkerFactoryBase::FactoryDeletionBehavior lifespan)
+{
+  (void) type;
+  (void) lifespan;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::updateWorkerCount()
+{
+  //jobs are tracked as they start and finish, so there is nothing to update
+}
+
+//------------------------------------------------------------------------------
+unsigned int InProcessWorkerFactory::currentWorkerCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  return static_cast<unsigned int>(this->State->Jobs.size() +
+                                   this->State->Running);
+}
+
+//------------------------------------------------------------------------------
+bool InProcessWorkerFactory::canRunJob(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  const std::size_t maxJobs = std::min<std::size_t>(this->maxWorkerCount(),
+                                                    this->numberOfThreads());
+  return this->haveSupport(reqs) && this->currentWorkerCount() < maxJobs;
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::runJob(const remus::worker::Job& job)
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  if(this->State->Shutdown)
+    {
+    return;
+    }
+  this->State->Jobs.push_back(job);
+  }
+  this->State->JobAdded.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::terminateJob(const boost::uuids::uuid& id)
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  typedef std::deque<remus::worker::Job>::iterator It;
+  for(It i = this->State->Jobs.begin(); i != this->State->Jobs.end(); ++i)
+    {
+    if(i->id() == id)
+      {
+      this->State->Jobs.erase(i);
+      return;
+      }
+    }
+  this->State->Terminated.insert(id);
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::terminateAllJobs()
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  this->State->Shutdown = true;
+  this->State->Jobs.clear();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::takeUpdates(
+                          std::vector<remus::proto::JobStatus>& statuses,
+                          std::vector<remus::proto::JobResult>& results)
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  statuses.swap(this->State->Statuses);
+  results.swap(this->State->Results);
+  this->State->Statuses.clear();
+  this->State->Results.clear();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::connectToServer(zmq::context_t& context,
+                                             const std::string& endpoint)
+{
+  boost::lock_guard<boost::mutex> lock(this->State->WakeMutex);
+  this->State->Wakeup.reset(new zmq::socket_t(context, ZMQ_PAIR));
+  zmq::connectToAddress(*this->State->Wakeup, endpoint);
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::disconnectFromServer()
+{
+  boost::lock_guard<boost::mutex> lock(this->State->WakeMutex);
+  this->State->Wakeup.reset();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::post(const remus::proto::JobStatus& status)
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  this->State->Statuses.push_back(status);
+  }
+  this->wakeServer();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::post(const remus::proto::JobResult& result)
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  this->State->Results.push_back(result);
+  }
+  this->wakeServer();
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::wakeServer()
+{
+  boost::lock_guard<boost::mutex> lock(this->State->WakeMutex);
+  if(this->State->Wakeup)
+    {
+    //the message is empty, it only tells the server to take our updates.
+    //If the server already has wakeups waiting there is no need to block
+    zmq::message_t wakeup(0);
+    this->State->Wakeup->send(wakeup, ZMQ_DONTWAIT);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool InProcessWorkerFactory::isTerminated(const boost::uuids::uuid& id) const
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  return this->State->Terminated.count(id) > 0;
+}
+
+//------------------------------------------------------------------------------
+bool InProcessWorkerFactory::isShutdown() const
+{
+  boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+  return this->State->Shutdown;
+}
+
+//------------------------------------------------------------------------------
+void InProcessWorkerFactory::processJobs()
+{
+  while(true)
+    {
+    remus::worker::Job job;
+    boost::shared_ptr<remus::server::InProcessJobFunction> function;
+    {
+    boost::unique_lock<boost::mutex> lock(this->State->Mutex);
+    while(this->State->Jobs.empty() && !this->State->Stopping)
+      {
+      this->State->JobAdded.wait(lock);
+      }
+    if(this->State->Stopping)
+      {
+      return;
+      }
+
+    job = this->State->Jobs.front();
+    this->State->Jobs.pop_front();
+    ++this->State->Running;
+
+    Internals::FunctionMap::const_iterator f =
+          this->State->Functions.find(job.submission().requirements());
+    if(f != this->State->Functions.end())
+      {
+      function = f->second;
+      }
+    }
+
+    InProcessJob handle(*this, job);
+    std::string failure("no job function is registered for the job");
+    if(function)
+      {
+      failure = "job function returned without a result";
+      try
+        {
+        (*function)(handle);
+        }
+      catch(std::exception& e)
+        {
+        failure = e.what();
+        }
+      catch(...)
+        {
+        failure = "job function threw an unknown exception";
+        }
+      }
+
+    //a worker that goes away without finishing a job has that job
+    //expire, our equivalent is a function that returns without finishing
+    if(!handle.Done && !handle.jobShouldBeTerminated())
+      {
+      this->post( remus::proto::make_FailedJobStatus(job.id(), failure) );
+      }
+
+    {
+    boost::lock_guard<boost::mutex> lock(this->State->Mutex);
+    --this->State->Running;
+    this->State->Terminated.erase(job.id());
+    }
+
+    //a thread is free, so the server can give us another job
+    this->wakeServer();
+    }
+}
+
+}
+}
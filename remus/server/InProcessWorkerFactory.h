@@ -0,0 +1,190 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_InProcessWorkerFactory_h
+#define remus_server_InProcessWorkerFactory_h
+
+#include <remus/server/WorkerFactoryBase.h>
+
+#include <remus/proto/JobResult.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/worker/Job.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <string>
+#include <vector>
+
+//included for export symbols
+#include <remus/server/ServerExports.h>
+
+//forward declaration of classes only the implementation needs
+namespace zmq { class context_t; }
+
+namespace remus{
+namespace server{
+
+class InProcessWorkerFactory;
+
+//The interface a job function uses to report the status and result of the
+//job it is processing, mirroring what remus::worker::Worker offers to
+//workers that run in their own process. Nothing is serialized, the status
+//and result are handed to the server as is.
+class REMUSSERVER_EXPORT InProcessJob
+{
+public:
+  //get the job that should be processed
+  const remus::worker::Job& job() const { return this->CurrentJob; }
+
+  //update the status of the job
+  void updateStatus(const remus::proto::JobStatus& status);
+
+  //give the server the result of the job
+  void returnResult(const remus::proto::JobResult& result);
+
+  //ask if the job should stop being processed, which happens when the
+  //client terminates the job
+  bool jobShouldBeTerminated() const;
+
+  //ask if the server is shutting down, in which case the job
+  //should stop being processed
+  bool workerShouldTerminate() const;
+
+private:
+  friend class InProcessWorkerFactory;
+  InProcessJob(InProcessWorkerFactory& factory,
+               const remus::worker::Job& job);
+
+  InProcessWorkerFactory& Factory;
+  remus::worker::Job CurrentJob;
+  //true once the job has a result or has failed
+  bool Done;
+};
+
+//The function an InProcessWorkerFactory runs for each job it is given. The
+//function is called from every thread of the factory at the same time, so
+//it must be safe to call from multiple threads.
+class REMUSSERVER_EXPORT InProcessJobFunction
+{
+public:
+  virtual ~InProcessJobFunction() {}
+
+  virtual void operator()(remus::server::InProcessJob& job) = 0;
+};
+
+//A factory that processes jobs inside the server instead of launching
+//workers. For very cheap jobs launching a worker process, registering it
+//and sending the job and result over sockets costs more than the job
+//itself. Job functions are registered for the requirements they can mesh,
+//and are run on a fixed pool of threads that the factory owns. The server
+//hands queued jobs straight to the factory, and the status and results
+//of the jobs go straight into the server's list of active jobs.
+//
+//Jobs processed by the factory behave like jobs given to a worker. They are
+//QUEUED until the function updates their status, clients can terminate them,
+//and the function is told to stop when the server shuts down. A job whose
+//function returns, or throws, without a result or a failed status is
+//marked as FAILED.
+class REMUSSERVER_EXPORT InProcessWorkerFactory : public WorkerFactoryBase
+{
+public:
+  //construct a factory that can process numberOfThreads jobs at once.
+  //The max worker count of the factory is the number of threads
+  explicit InProcessWorkerFactory(std::size_t numberOfThreads);
+
+  //stops the threads, waiting for the jobs being processed to finish
+  virtual ~InProcessWorkerFactory();
+
+  //register the function that processes jobs with the given requirements
+  void registerJobFunction(const remus::proto::JobRequirements& reqs,
+                   boost::shared_ptr<remus::server::InProcessJobFunction> function);
+
+  //return the number of jobs that can be processed at once
+  std::size_t numberOfThreads() const;
+
+  remus::common::MeshIOTypeSet supportedIOTypes() const;
+
+  remus::proto::JobRequirementsSet workerRequirements(
+                                      remus::common::MeshIOType type) const;
+
+  bool haveSupport(const remus::proto::JobRequirements& reqs) const;
+
+  //we never launch workers, the server hands us jobs with runJob instead
+  bool createWorker(const remus::proto::JobRequirements& type,
+                    WorkerFactoryBase::FactoryDeletionBehavior lifespan);
+
+  void updateWorkerCount();
+
+  //returns the number of jobs being processed or waiting for a thread
+  unsigned int currentWorkerCount() const;
+
+  boost::uint64_t registryGeneration() const;
+
+  //The following methods are used by the server while brokering
+
+  //returns true if we have a function for the requirements and a thread
+  //that is free to run it
+  bool canRunJob(const remus::proto::JobRequirements& reqs) const;
+
+  //hand a job to the factory, it is run by the next free thread
+  void runJob(const remus::worker::Job& job);
+
+  //tell the function processing the job that it should stop. Jobs that
+  //haven't started are dropped
+  void terminateJob(const boost::uuids::uuid& id);
+
+  //tell every function that the server is shutting down,
+  //and drop the jobs that haven't started
+  void terminateAllJobs();
+
+  //take the statuses and results reported since the last call, in the
+  //order they were reported. The statuses of a job are always reported
+  //before its result
+  void takeUpdates(std::vector<remus::proto::JobStatus>& statuses,
+                   std::vector<remus::proto::JobResult>& results);
+
+  //connect to the inproc endpoint the server polls, so that we can wake
+  //the server up when a job has reported something or has finished
+  void connectToServer(zmq::context_t& context, const std::string& endpoint);
+
+  //stop waking the server up, must be called before the server's
+  //socket is closed
+  void disconnectFromServer();
+
+private:
+  friend class InProcessJob;
+
+  //queue a status or result for the server and wake it up
+  void post(const remus::proto::JobStatus& status);
+  void post(const remus::proto::JobResult& result);
+  void wakeServer();
+
+  bool isTerminated(const boost::uuids::uuid& id) const;
+  bool isShutdown() const;
+
+  //the loop that each thread runs
+  void processJobs();
+
+  //explicitly state the factory doesn't support copy or move semantics
+  InProcessWorkerFactory(const InProcessWorkerFactory&);
+  void operator=(const InProcessWorkerFactory&);
+
+  class Internals;
+  boost::scoped_ptr<Internals> State;
+};
+
+}
+}
+
+#endif
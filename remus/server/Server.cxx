@@ -26,6 +26,8 @@
 #include <boost/thread/locks.hpp>
 #include <boost/uuid/uuid.hpp>
 
+#include <remus/proto/ContentSummary.h>
+#include <remus/proto/DataChunk.h>
 #include <remus/proto/Job.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
@@ -37,17 +39,34 @@
 
 #include <remus/worker/Job.h>
 
+#include <remus/common/ContentHash.h>
+#include <remus/common/MD5Hash.h>
 #include <remus/common/PollingMonitor.h>
+#include <remus/common/SharedMemory.h>
+#include <remus/common/TimerQueue.h>
 
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/server/detail/ActiveJobs.h>
+#include <remus/server/detail/ContentStore.h>
+#include <remus/server/detail/JobDeadlines.h>
 #include <remus/server/detail/JobQueue.h>
+#include <remus/server/detail/JobRetries.h>
+#include <remus/server/detail/SocketIdentities.h>
 #include <remus/server/detail/SocketMonitor.h>
+#include <remus/server/detail/SpeculativeJobs.h>
+#include <remus/server/detail/StreamedResults.h>
+#include <remus/server/detail/StreamedSubmissions.h>
+#include <remus/server/detail/SupportCache.h>
+#include <remus/server/detail/WaitingClients.h>
 #include <remus/server/detail/WorkerPool.h>
+#include <remus/server/InProcessWorkerFactory.h>
 #include <remus/server/WorkerFactory.h>
 
+#include <algorithm>
 #include <set>
+#include <sstream>
 #include <ctime>
+#include <vector>
 
 
 //initialize the static instance variable in signal catcher in the class
@@ -86,6 +105,88 @@ void send_terminateJob(boost::uuids::uuid jobId,
                                          workerId);
 }
 
+//------------------------------------------------------------------------------
+//returns the digests of the content of a job that a worker can hold onto
+//between jobs, which is the large content we keep in the ContentStore
+std::vector<std::string> cacheableDigests(const remus::worker::Job& job,
+                          const remus::server::detail::ContentStore& store)
+{
+  std::vector<std::string> digests;
+  const remus::proto::JobSubmission& submission = job.submission();
+  typedef remus::proto::JobSubmission::const_iterator ContentIt;
+  for(ContentIt i = submission.begin(); i != submission.end(); ++i)
+    {
+    if(i->second.sourceType() == remus::common::ContentSource::Memory &&
+       i->second.dataSize() > remus::STREAM_CHUNK_SIZE &&
+       store.have(i->second.hash()))
+      {
+      digests.push_back(i->second.hash());
+      }
+    }
+  return digests;
+}
+
+//------------------------------------------------------------------------------
+//returns the number of bytes of content a job sends to a worker, which
+//doesn't count the content we only send the worker a reference to
+boost::uint64_t bytesToSend(const remus::worker::Job& job,
+                            remus::server::detail::SocketHandle worker,
+                            const remus::server::detail::WorkerPool& pool,
+                            const remus::server::detail::ContentStore& store)
+{
+  const std::vector<std::string> digests = cacheableDigests(job, store);
+  boost::uint64_t bytes = 0;
+  const remus::proto::JobSubmission& submission = job.submission();
+  typedef remus::proto::JobSubmission::const_iterator ContentIt;
+  for(ContentIt i = submission.begin(); i != submission.end(); ++i)
+    {
+    const std::string& digest = i->second.hash();
+    if(!pool.holdsContent(worker, digest) ||
+       std::find(digests.begin(), digests.end(), digest) == digests.end())
+      {
+      bytes += i->second.dataSize();
+      }
+    }
+  return bytes;
+}
+
+//------------------------------------------------------------------------------
+//the worker address of jobs that are processed by an InProcessWorkerFactory.
+//Zmq generated identities start with a zero byte, so this can't collide
+const zmq::SocketIdentity& inProcessIdentity()
+{
+  static const zmq::SocketIdentity identity("remus-in-process", 16);
+  return identity;
+}
+
+//------------------------------------------------------------------------------
+//the timed work of the broker, which is kept in a single TimerQueue
+enum BrokerTimer
+{
+  DeadWorkerTimer,
+  RetryTimer,
+  DeadlineTimer,
+  WaitingClientTimer,
+  StragglerTimer
+};
+
+//------------------------------------------------------------------------------
+//schedules the timer for when the earliest work of a source is due. The
+//sources report the max when they have nothing timed, so the timer is dropped
+void scheduleTimer(remus::common::TimerQueue& timers, BrokerTimer timer,
+                   const boost::posix_time::ptime& now,
+                   boost::int64_t remaining, boost::int64_t max_milliseconds)
+{
+  if(remaining < max_milliseconds)
+    {
+    timers.scheduleIn(timer, now, remaining);
+    }
+  else
+    {
+    timers.cancel(timer);
+    }
+}
+
 //------------------------------------------------------------------------------
 struct UUIDManagement
 {
@@ -115,7 +216,9 @@ struct ThreadManagement
     BrokerThread( new boost::thread() ),
     BrokeringStatus(),
     BrokerStatusChanged(),
-    BrokerIsRunning(false)
+    BrokerIsRunning(false),
+    WakeContext(),
+    WakeEndpoint()
   {
   }
 
@@ -161,9 +264,21 @@ struct ThreadManagement
   void stop()
   {
   this->setIsBrokering(false);
+  this->wakeBroker();
   this->BrokerThread->join();
   }
 
+  //----------------------------------------------------------------------------
+  //the broker sleeps until it has traffic or timed work, so it listens on
+  //this endpoint for us to wake it up when it needs to stop
+  void wakeUpOn(const boost::shared_ptr<zmq::context_t>& context,
+                const std::string& endpoint)
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  this->WakeContext = context;
+  this->WakeEndpoint = endpoint;
+  }
+
   //----------------------------------------------------------------------------
   void waitForThreadToStart()
   {
@@ -198,12 +313,35 @@ struct ThreadManagement
   }
 
 private:
+  //----------------------------------------------------------------------------
+  void wakeBroker()
+  {
+  boost::shared_ptr<zmq::context_t> context;
+  std::string endpoint;
+    {
+    boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+    context = this->WakeContext;
+    endpoint = this->WakeEndpoint;
+    }
+  if(context)
+    {
+    //the message is empty, it only wakes up the broker. If the broker has
+    //already stopped nobody is listening, so we don't block
+    zmq::socket_t wakeup(*context, ZMQ_PUSH);
+    zmq::connectToAddress(wakeup, endpoint);
+    zmq::message_t message(0);
+    wakeup.send(message, ZMQ_DONTWAIT);
+    }
+  }
+
   boost::scoped_ptr<boost::thread> BrokerThread;
 
   boost::mutex BrokeringStatus;
   boost::condition_variable BrokerStatusChanged;
   bool BrokerIsRunning;
 
+  boost::shared_ptr<zmq::context_t> WakeContext;
+  std::string WakeEndpoint;
 
 };
 
@@ -217,39 +355,82 @@ namespace server{
 //------------------------------------------------------------------------------
 Server::Server():
   PortInfo(),
+  Batching(16, 64 * 1024),
+  Speculation(0.9, 0.0),
+  Identities( new remus::server::detail::SocketIdentities() ),
+  InProcessWorker( Identities->intern(detail::SocketIdentities::WORKER,
+                                     detail::inProcessIdentity()) ),
   QueuedJobs( new remus::server::detail::JobQueue() ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  StreamedResults( new remus::server::detail::StreamedResults() ),
+  StreamedSubmissions( new remus::server::detail::StreamedSubmissions() ),
+  ContentStore( new remus::server::detail::ContentStore() ),
+  WaitingClients( new remus::server::detail::WaitingClients() ),
+  Deadlines( new remus::server::detail::JobDeadlines() ),
+  Retries( new remus::server::detail::JobRetries() ),
+  SpeculativeJobs( new remus::server::detail::SpeculativeJobs() ),
+  SupportCache( new remus::server::detail::SupportCache() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
+  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() ),
+  InProcessFactory()
 {
 }
 
 //------------------------------------------------------------------------------
 Server::Server(const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory):
   PortInfo(),
+  Batching(16, 64 * 1024),
+  Speculation(0.9, 0.0),
+  Identities( new remus::server::detail::SocketIdentities() ),
+  InProcessWorker( Identities->intern(detail::SocketIdentities::WORKER,
+                                     detail::inProcessIdentity()) ),
   QueuedJobs( new remus::server::detail::JobQueue() ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  StreamedResults( new remus::server::detail::StreamedResults() ),
+  StreamedSubmissions( new remus::server::detail::StreamedSubmissions() ),
+  ContentStore( new remus::server::detail::ContentStore() ),
+  WaitingClients( new remus::server::detail::WaitingClients() ),
+  Deadlines( new remus::server::detail::JobDeadlines() ),
+  Retries( new remus::server::detail::JobRetries() ),
+  SpeculativeJobs( new remus::server::detail::SpeculativeJobs() ),
+  SupportCache( new remus::server::detail::SupportCache() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( factory )
+  WorkerFactory( factory ),
+  InProcessFactory(
+    boost::dynamic_pointer_cast<remus::server::InProcessWorkerFactory>(factory) )
 {
 }
 
 //------------------------------------------------------------------------------
 Server::Server(const remus::server::ServerPorts& ports):
   PortInfo( ports ),
+  Batching(16, 64 * 1024),
+  Speculation(0.9, 0.0),
+  Identities( new remus::server::detail::SocketIdentities() ),
+  InProcessWorker( Identities->intern(detail::SocketIdentities::WORKER,
+                                     detail::inProcessIdentity()) ),
   QueuedJobs( new remus::server::detail::JobQueue() ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  StreamedResults( new remus::server::detail::StreamedResults() ),
+  StreamedSubmissions( new remus::server::detail::StreamedSubmissions() ),
+  ContentStore( new remus::server::detail::ContentStore() ),
+  WaitingClients( new remus::server::detail::WaitingClients() ),
+  Deadlines( new remus::server::detail::JobDeadlines() ),
+  Retries( new remus::server::detail::JobRetries() ),
+  SpeculativeJobs( new remus::server::detail::SpeculativeJobs() ),
+  SupportCache( new remus::server::detail::SupportCache() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
+  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() ),
+  InProcessFactory()
 {
 }
 
@@ -257,13 +438,28 @@ Server::Server(const remus::server::ServerPorts& ports):
 Server::Server(const remus::server::ServerPorts& ports,
                const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory):
   PortInfo( ports ),
+  Batching(16, 64 * 1024),
+  Speculation(0.9, 0.0),
+  Identities( new remus::server::detail::SocketIdentities() ),
+  InProcessWorker( Identities->intern(detail::SocketIdentities::WORKER,
+                                     detail::inProcessIdentity()) ),
   QueuedJobs( new remus::server::detail::JobQueue() ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  StreamedResults( new remus::server::detail::StreamedResults() ),
+  StreamedSubmissions( new remus::server::detail::StreamedSubmissions() ),
+  ContentStore( new remus::server::detail::ContentStore() ),
+  WaitingClients( new remus::server::detail::WaitingClients() ),
+  Deadlines( new remus::server::detail::JobDeadlines() ),
+  Retries( new remus::server::detail::JobRetries() ),
+  SpeculativeJobs( new remus::server::detail::SpeculativeJobs() ),
+  SupportCache( new remus::server::detail::SupportCache() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( factory )
+  WorkerFactory( factory ),
+  InProcessFactory(
+    boost::dynamic_pointer_cast<remus::server::InProcessWorkerFactory>(factory) )
 {
 }
 
@@ -294,6 +490,30 @@ remus::server::PollingRates Server::pollingRates() const
   return remus::server::PollingRates(low,high);
 }
 
+//------------------------------------------------------------------------------
+void Server::jobBatching(const remus::server::JobBatching& batching)
+{
+  this->Batching = batching;
+}
+
+//------------------------------------------------------------------------------
+remus::server::JobBatching Server::jobBatching() const
+{
+  return this->Batching;
+}
+
+//------------------------------------------------------------------------------
+void Server::jobSpeculation(const remus::server::JobSpeculation& speculation)
+{
+  this->Speculation = speculation;
+}
+
+//------------------------------------------------------------------------------
+remus::server::JobSpeculation Server::jobSpeculation() const
+{
+  return this->Speculation;
+}
+
 //------------------------------------------------------------------------------
 bool Server::Brokering(Server::SignalHandling sh)
   {
@@ -305,6 +525,10 @@ bool Server::Brokering(Server::SignalHandling sh)
     this->StartCatchingSignals();
     }
 
+  //remove the shared memory segments that peers which died before we
+  //mapped them left behind
+  remus::common::remove_StaleSharedMemory();
+
   zmq::socket_t clientChannel(*(this->PortInfo.context()),ZMQ_ROUTER);
   zmq::socket_t workerChannel(*(this->PortInfo.context()),ZMQ_ROUTER);
 
@@ -316,26 +540,47 @@ bool Server::Brokering(Server::SignalHandling sh)
   //setup workers. This needs to happen after the binding of the worker socket
   this->WorkerFactory->portForWorkersToUse( this->PortInfo.worker() );
 
+  //a factory that runs jobs inside the server wakes us up over this
+  //socket whenever a job has reported something, or a thread is free
+  zmq::socket_t inProcessChannel(*(this->PortInfo.context()),ZMQ_PAIR);
+  if(this->InProcessFactory)
+    {
+    zmq::socketInfo<zmq::proto::inproc> inProcessInfo(
+            "remus_in_process_" +
+            boost::lexical_cast<std::string>((*this->UUIDGenerator)()));
+    zmq::bindToAddress(inProcessChannel,inProcessInfo);
+    this->InProcessFactory->connectToServer(*(this->PortInfo.context()),
+                                            inProcessInfo.endpoint());
+    }
+
+  //we only wake up for traffic or timed work, so stopping the broker wakes
+  //us up over this socket
+  zmq::socket_t wakeChannel(*(this->PortInfo.context()),ZMQ_PULL);
+  zmq::socketInfo<zmq::proto::inproc> wakeInfo(
+          "remus_wake_" +
+          boost::lexical_cast<std::string>((*this->UUIDGenerator)()));
+  zmq::bindToAddress(wakeChannel,wakeInfo);
+  Thread->wakeUpOn(this->PortInfo.context(), wakeInfo.endpoint());
+
   //construct the pollitems to have client and workers so that we process
   //messages from both sockets.
-  zmq::pollitem_t items[2] = {
+  zmq::pollitem_t items[4] = {
       { clientChannel,  0, ZMQ_POLLIN, 0 },
-      { workerChannel, 0, ZMQ_POLLIN, 0 } };
+      { workerChannel, 0, ZMQ_POLLIN, 0 },
+      { wakeChannel, 0, ZMQ_POLLIN, 0 },
+      { inProcessChannel, 0, ZMQ_POLLIN, 0 } };
+  const int numberOfItems = this->InProcessFactory ? 4 : 3;
 
-  //keeps track of what our polling interval is, and adjusts it to
-  //handle operating systems that throttle our polling.
+  //we never sleep longer than the max time out, and the monitor tells us
+  //when the operating system has made us sleep for far longer than asked
   remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
 
-  //keep track of current time since we last purged dead workers
-  //we want to clear every dead workers every 250ms.
+  //all the timed work of the broker, so that we sleep until exactly the
+  //earliest of it is due
+  remus::common::TimerQueue timers;
   boost::posix_time::ptime currentTime =
                             boost::posix_time::microsec_clock::local_time();
 
-  const boost::int64_t deadWorkersCheckInterval(250);
-  boost::posix_time::ptime whenToCheckForDeadWorkers =
-                      boost::posix_time::microsec_clock::local_time() +
-                      boost::posix_time::milliseconds(deadWorkersCheckInterval);
-
   //We need to notify the Thread management that brokering is about to start.
   //This allows the calling thread to resume, as it has been waiting for this
   //notification, and will also allow threads that have been holding on
@@ -343,7 +588,16 @@ bool Server::Brokering(Server::SignalHandling sh)
   Thread->setIsBrokering(true);
   while (Thread->isBrokering())
     {
-    zmq::poll(&items[0], 2, static_cast<long>(monitor.current()) );
+    //never sleep past a worker missing its heartbeat, the deadline of a
+    //client that is waiting on jobs, the deadline of a job, the end of a
+    //retry backoff, or a job becoming a straggler, otherwise they would be
+    //handled late
+    const boost::posix_time::ptime beforePoll =
+                            boost::posix_time::microsec_clock::local_time();
+    this->ScheduleTimers(timers, beforePoll);
+    const boost::int64_t pollTimeout =
+                  timers.millisecondsToNext(beforePoll, monitor.maxTimeOut());
+    zmq::poll(&items[0], numberOfItems, static_cast<long>(pollTimeout) );
     monitor.pollOccurred();
 
     //update the current time
@@ -352,7 +606,9 @@ bool Server::Brokering(Server::SignalHandling sh)
     if (items[0].revents & ZMQ_POLLIN)
       {
       //we need to strip the client address from the message
-      zmq::SocketIdentity clientIdentity = zmq::address_recv(clientChannel);
+      const detail::SocketHandle clientIdentity =
+                    this->Identities->intern(detail::SocketIdentities::CLIENT,
+                                             zmq::address_recv(clientChannel));
       this->DetermineClientResponse(clientChannel, clientIdentity,
                                     workerChannel);
       // std::cout << "c" << std::endl;
@@ -361,25 +617,124 @@ bool Server::Brokering(Server::SignalHandling sh)
       {
       //a worker is registering
       //we need to strip the worker address from the message
-      zmq::SocketIdentity workerIdentity = zmq::address_recv(workerChannel);
+      const detail::SocketHandle workerIdentity =
+                    this->Identities->intern(detail::SocketIdentities::WORKER,
+                                             zmq::address_recv(workerChannel));
       this->DetermineWorkerResponse(workerChannel,workerIdentity);
+      //the pool holds its own reference to workers it knows about
+      this->Identities->release(workerIdentity);
       // std::cout << "w" << std::endl;
       }
+    if (items[2].revents & ZMQ_POLLIN)
+      {
+      //we are being told to stop, the loop condition will see that
+      zmq::message_t wakeup;
+      while(wakeChannel.recv(&wakeup, ZMQ_DONTWAIT))
+        {
+        }
+      }
+    if (numberOfItems > 3 && (items[3].revents & ZMQ_POLLIN))
+      {
+      //the wakeups carry nothing, so we drain them all at once
+      zmq::message_t wakeup;
+      while(inProcessChannel.recv(&wakeup, ZMQ_DONTWAIT))
+        {
+        }
+      }
+    if(this->InProcessFactory)
+      {
+      this->StoreInProcessUpdates();
+      }
 
-    //only purge dead workers every 250ms to reduce server load
-    if(whenToCheckForDeadWorkers <= currentTime)
+    //only purge dead workers once a worker could have missed its heartbeat
+    if(timers.isDue(detail::DeadWorkerTimer, currentTime))
       {
       // std::cout << "checking for dead workers" << std::endl;
+      //jobs run inside the server never miss a heartbeat
+      if(this->InProcessFactory)
+        {
+        this->SocketMonitor->refresh(this->InProcessWorker);
+        }
+
+      //a copied job whose worker died carries on with its copy, and any
+      //result the dead worker was sending is dropped
+      std::vector<detail::SpeculativeJobs::JobWorker> promoted;
+      std::vector<boost::uuids::uuid> lostResults;
+      this->SpeculativeJobs->promoteCopies((*this->SocketMonitor),
+                                           promoted, lostResults);
+      typedef std::vector<detail::SpeculativeJobs::JobWorker>::const_iterator
+              PromotedIt;
+      for(PromotedIt i = promoted.begin(); i != promoted.end(); ++i)
+        {
+        this->ActiveJobs->reassign(i->first, i->second);
+        }
+      typedef std::vector<boost::uuids::uuid>::const_iterator LostIt;
+      for(LostIt i = lostResults.begin(); i != lostResults.end(); ++i)
+        {
+        this->StreamedResults->remove(*i);
+        }
+
+      //jobs that a dead worker prefetched but never started are put
+      //back on the queue, so that another worker can take them
+      std::vector<remus::worker::Job> unstartedJobs =
+                  this->ActiveJobs->takeUnstartedJobs((*this->SocketMonitor));
+      typedef std::vector<remus::worker::Job>::const_iterator UnstartedIt;
+      for(UnstartedIt i = unstartedJobs.begin(); i != unstartedJobs.end(); ++i)
+        {
+        //drop any content we were streaming because the worker
+        //didn't hold what the job referenced
+        this->StreamedSubmissions->remove(i->id());
+        this->QueuedJobs->addJob(i->id(), i->submission());
+        this->TrackJobDeadlines(i->id(), i->submission());
+        }
+
       //mark all jobs whose worker haven't sent a heartbeat in time
       //as a job that failed.
-      this->ActiveJobs->markExpiredJobs((*this->SocketMonitor));
+      std::set<boost::uuids::uuid> expiredJobs =
+                    this->ActiveJobs->markExpiredJobs((*this->SocketMonitor));
+      typedef std::set<boost::uuids::uuid>::const_iterator ExpiredIt;
+      for(ExpiredIt i = expiredJobs.begin(); i != expiredJobs.end(); ++i)
+        {
+        //drop any partial result the dead worker was streaming to us
+        this->StreamedResults->remove(*i);
+        this->Deadlines->remove(*i);
+        this->SpeculativeJobs->stop(*i);
+
+        //a job with retries left isn't expired, instead it waits out its
+        //backoff and is requeued with the submission we held onto. The
+        //dead worker is purged below, so another worker takes the job.
+        //Content we were streaming to the dead worker is streamed from
+        //the start of its spool to the next one
+        if(this->Retries->retry(*i, currentTime))
+          {
+          this->StreamedSubmissions->rewind(*i);
+          this->ActiveJobs->remove(*i);
+          continue;
+          }
+        this->StreamedSubmissions->remove(*i);
+        this->ContentStore->release(*i);
+        this->WaitingClients->jobChanged(*i);
+        }
+
+      //purge all pending workers with jobs that haven't sent a heartbeat,
+      //and release the reference the pool held to their handles so the
+      //identity table doesn't only grow
+      const std::set<detail::SocketHandle> purged =
+                    this->WorkerPool->purgeDeadWorkers((*this->SocketMonitor));
+      typedef std::set<detail::SocketHandle>::const_iterator PurgedIt;
+      for(PurgedIt i = purged.begin(); i != purged.end(); ++i)
+        {
+        this->Identities->release(*i);
+        }
+      timers.cancel(detail::DeadWorkerTimer);
+      }
 
-      //purge all pending workers with jobs that haven't sent a heartbeat
-      this->WorkerPool->purgeDeadWorkers((*this->SocketMonitor));
+    //requeue the retried jobs that have waited out their backoff
+    this->RequeueRetriedJobs();
 
-      whenToCheckForDeadWorkers = currentTime +
-                      boost::posix_time::milliseconds(deadWorkersCheckInterval);
-      }
+    //fail the jobs that have waited or run past their deadline, before
+    //we look for workers for the queued jobs
+    this->ExpireJobDeadlines( workerChannel );
 
     //see if we have a worker in the pool for the next job in the queue,
     //otherwise as the factory to generate a new worker to handle that job
@@ -387,12 +742,48 @@ bool Server::Brokering(Server::SignalHandling sh)
       {
       this->FindWorkerForQueuedJob( workerChannel );
       }
+
+    //workers that are still idle can run copies of straggling jobs, and
+    //the workers that lost the race to finish a job are told to stop
+    if(Thread->isBrokering())
+      {
+      this->SpeculateOnStragglers( workerChannel );
+      }
+    this->TerminateLosingCopies( workerChannel );
+
+    //answer any client that is waiting on a job that has finished, failed
+    //or expired, or whose wait has timed out
+    if(!this->WaitingClients->empty())
+      {
+      this->AnswerWaitingClients( clientChannel );
+      }
     }
 
   //this should only happen with interrupted threads is hit; lets make sure we close
   //down all workers.
   this->WorkerFactory->setMaxWorkerCount(0);
   this->TerminateAllWorkers( workerChannel );
+  if(this->InProcessFactory)
+    {
+    //the jobs can still be running, but they will only stop waking us up
+    //once they see that we are shutting down
+    this->InProcessFactory->terminateAllJobs();
+    this->InProcessFactory->disconnectFromServer();
+    }
+
+  //release every client that is still waiting, so they don't block forever
+  //on a server that is going away
+  std::vector<detail::WaitingClients::Waiter> waiters =
+                                            this->WaitingClients->takeAll();
+  typedef std::vector<detail::WaitingClients::Waiter>::const_iterator WaitIt;
+  for(WaitIt i = waiters.begin(); i != waiters.end(); ++i)
+    {
+    remus::proto::send_NonBlockingResponse(remus::WAIT_FOR_JOBS,
+                                           this->currentJobStatuses(i->Jobs),
+                                           &clientChannel,
+                                           this->Identities->resolve(i->Address));
+    this->Identities->release(i->Address);
+    }
 
   if(sh == CAPTURE)
     {
@@ -434,7 +825,7 @@ void Server::waitForBrokeringToStart()
 
 //------------------------------------------------------------------------------
 void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
-                                     const zmq::SocketIdentity& clientIdentity,
+                                     detail::SocketHandle clientIdentity,
                                      zmq::socket_t& workerChannel)
 {
   remus::proto::Message msg = remus::proto::receive_Message(&clientChannel);
@@ -446,7 +837,8 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
     remus::proto::send_NonBlockingResponse(remus::INVALID_SERVICE,
                                            remus::INVALID_MSG,
                                            &clientChannel,
-                                           clientIdentity);
+                                           this->Identities->resolve(clientIdentity));
+    this->Identities->release(clientIdentity);
     return; //no need to continue
     }
 
@@ -481,11 +873,30 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
       //by checking the worker pool and factory
       response_data = this->meshRequirements(msg);
       break;
+    case remus::CACHED_MESH_REQUIREMENTS:
+      //Generates all the JobRequirements that have the passed in
+      //MeshIOType, like MESH_REQUIREMENTS_FOR_IO_TYPE, but is given the
+      //proto::CachedRequirements the client holds. Returns if they are
+      //still current, otherwise only the requirements the client lacks
+      response_data = this->cachedMeshRequirements(msg);
+      break;
     case remus::MAKE_MESH:
       //queues the proto::JobSubmission and returns
       //a proto::Job that can be used to track that job
       response_data = this->queueJob(msg);
       break;
+    case remus::SUBMISSION_CHUNK:
+      //spools the next proto::DataChunk of a job submission whose content
+      //is being streamed, and forwards it to the worker if the job
+      //has been assigned to one.
+      //Returns INVALID_MSG if the chunk was rejected
+      response_data = this->storeSubmissionChunk(workerChannel,msg);
+      break;
+    case remus::MISSING_CONTENT:
+      //returns which of the passed proto::ContentDigests we don't hold,
+      //so the client only has to upload that content.
+      response_data = this->missingContent(msg);
+      break;
     case remus::MESH_STATUS:
       //retrieves the current status of the job related to the passed
       //proto::Job. Returns a proto::JobStatus
@@ -498,6 +909,14 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
       //If no result exists will return an invalid JobResult
       response_data = this->retrieveResult(msg);
       break;
+    case remus::RESULT_CHUNK:
+      //retrieves a single chunk of the result of the job related to the
+      //passed proto::Job, starting at the requested offset. Returns a
+      //proto::DataChunk. Once the final chunk has been sent the result
+      //is deleted from the server.
+      //If no result exists will return an empty non final DataChunk
+      response_data = this->retrieveResultChunk(msg);
+      break;
     case remus::TERMINATE_JOB:
       //Will try to terminate the given proto::Job.
       //If the job is currently queued on the server it will be eliminated
@@ -507,6 +926,18 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
       //we can do nothing to stop it
       response_data = this->terminateJob(workerChannel,msg);
       break;
+    case remus::WAIT_FOR_JOBS:
+      //Blocks the client until one of the given proto::Jobs reaches
+      //a terminal state or the requested timeout expires. Returns
+      //the proto::JobStatus of each job. When no job has finished yet
+      //the client is parked and we don't respond now.
+      response_data = this->waitForJobs(clientIdentity,msg);
+      if(response_data.empty())
+        {
+        this->Identities->release(clientIdentity);
+        return;
+        }
+      break;
     default:
       response_service = remus::INVALID_SERVICE;
       response_data = remus::INVALID_MSG;
@@ -516,13 +947,30 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
   //blocking manner so the server doesn't stall out sending to a client
   //that has disconnected
   remus::proto::send_NonBlockingResponse(response_service, response_data,
-                                         &clientChannel,   clientIdentity);
+                                         &clientChannel,
+                                         this->Identities->resolve(clientIdentity));
+
+  //once the request is answered we are done with the reference to the
+  //handle it took. A parked client is still held by the waiting list
+  //until it is answered
+  this->Identities->release(clientIdentity);
   return;
 }
 
 //------------------------------------------------------------------------------
 std::string Server::allSupportedMeshIOTypes(const remus::proto::Message& )
 {
+  //the answer only changes when workers or the factory change, so we
+  //send the answer we serialized the last time we were asked
+  std::string answer;
+  this->SupportCache->validate(this->WorkerFactory->registryGeneration(),
+                               this->WorkerPool->generation());
+  if(this->SupportCache->find(remus::SUPPORTED_IO_TYPES,
+                              remus::common::MeshIOType(), answer))
+    {
+    return answer;
+    }
+
   //we ask the worker factory and Worker Pool for the MeshIO types for
   //all workers they know about
   remus::common::MeshIOTypeSet supportedTypes, poolTypes;
@@ -534,13 +982,26 @@ std::string Server::allSupportedMeshIOTypes(const remus::proto::Message& )
   supportedTypes.insert(poolTypes.begin(),poolTypes.end());
   std::ostringstream buffer;
   buffer << supportedTypes;
-  return buffer.str();
+  answer = buffer.str();
+
+  this->SupportCache->store(remus::SUPPORTED_IO_TYPES,
+                            remus::common::MeshIOType(), answer);
+  return answer;
 }
 
 
 //------------------------------------------------------------------------------
 std::string Server::canMesh(const remus::proto::Message& msg)
 {
+  std::string answer;
+  this->SupportCache->validate(this->WorkerFactory->registryGeneration(),
+                               this->WorkerPool->generation());
+  if(this->SupportCache->find(remus::CAN_MESH_IO_TYPE,
+                              msg.MeshIOType(), answer))
+    {
+    return answer;
+    }
+
   //we state that the factory can support a mesh type by having a worker
   //registered to it that supports the mesh type.
   bool workerSupport =
@@ -554,7 +1015,10 @@ std::string Server::canMesh(const remus::proto::Message& msg)
 
   std::ostringstream buffer;
   buffer << (workerSupport || poolSupport);
-  return buffer.str();
+  answer = buffer.str();
+
+  this->SupportCache->store(remus::CAN_MESH_IO_TYPE, msg.MeshIOType(), answer);
+  return answer;
 }
 
 //------------------------------------------------------------------------------
@@ -578,39 +1042,186 @@ std::string Server::canMeshRequirements(const remus::proto::Message& msg)
 
 //------------------------------------------------------------------------------
 std::string Server::meshRequirements(const remus::proto::Message& msg)
+{
+  std::string answer;
+  this->SupportCache->validate(this->WorkerFactory->registryGeneration(),
+                               this->WorkerPool->generation());
+  if(this->SupportCache->find(remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
+                              msg.MeshIOType(), answer))
+    {
+    return answer;
+    }
+
+  std::ostringstream buffer;
+  buffer << this->supportedRequirements(msg.MeshIOType());
+  answer = buffer.str();
+
+  this->SupportCache->store(remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
+                            msg.MeshIOType(), answer);
+  return answer;
+}
+
+//------------------------------------------------------------------------------
+std::string Server::cachedMeshRequirements(const remus::proto::Message& msg)
+{
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+  const remus::proto::CachedRequirements held =
+                              remus::proto::readCachedRequirements(buffer);
+
+  this->SupportCache->validate(this->WorkerFactory->registryGeneration(),
+                               this->WorkerPool->generation());
+  const detail::SupportCache::DigestedRequirements* requirements =
+                  this->SupportCache->findRequirements(msg.MeshIOType());
+  if(!requirements)
+    {
+    //digest each of the requirements once per generation, so that
+    //answering a client only has to compare digests
+    detail::SupportCache::DigestedRequirements digested;
+    const remus::proto::JobRequirementsSet reqSet =
+                            this->supportedRequirements(msg.MeshIOType());
+    typedef remus::proto::JobRequirementsSet::const_iterator ReqIt;
+    for(ReqIt i = reqSet.begin(); i != reqSet.end(); ++i)
+      {
+      const std::string serialized = remus::proto::to_string(*i);
+      digested[remus::common::ContentHash(serialized.c_str(),
+                                          serialized.size())] = serialized;
+      }
+    this->SupportCache->storeRequirements(msg.MeshIOType(), digested);
+    requirements = this->SupportCache->findRequirements(msg.MeshIOType());
+    }
+
+  //when the client holds the answer of the current generation we only
+  //tell it so, otherwise we only send the requirements it doesn't hold
+  remus::proto::CachedRequirements answer;
+  answer.Tag = this->SupportCache->tag();
+  answer.Modified = (held.Tag != answer.Tag);
+  typedef detail::SupportCache::DigestedRequirements::const_iterator DigestIt;
+  for(DigestIt i = requirements->begin();
+      answer.Modified && i != requirements->end(); ++i)
+    {
+    answer.Requirements[i->first] = held.Requirements.count(i->first) != 0 ?
+                                    std::string() : i->second;
+    }
+
+  std::ostringstream response;
+  remus::proto::writeCachedRequirements(response, answer);
+  return response.str();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet
+Server::supportedRequirements(const remus::common::MeshIOType& type)
 {
   //we state that the factory can support a mesh type by having a worker
   //registered to it that supports the mesh type.
   remus::proto::JobRequirementsSet reqSet(
-            this->WorkerFactory->workerRequirements(msg.MeshIOType()));
+            this->WorkerFactory->workerRequirements(type));
 
   //Query the worker pool to get the set of requirements for waiting
   //workers that support the given mesh type info
   remus::proto::JobRequirementsSet poolSet =
-            this->WorkerPool->waitingWorkerRequirements(msg.MeshIOType());
+            this->WorkerPool->waitingWorkerRequirements(type);
 
   //combine the two sets to get all the valid requirements
   reqSet.insert(poolSet.begin(),poolSet.end());
+  return reqSet;
+}
 
+//------------------------------------------------------------------------------
+std::string Server::meshStatus(const remus::proto::Message& msg)
+{
+  remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
+  return remus::proto::to_string(this->currentJobStatus(job.id()));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Server::currentJobStatus(const boost::uuids::uuid& id)
+{
+  remus::proto::JobStatus js(id,remus::INVALID_STATUS);
+  if(this->QueuedJobs->haveUUID(id) || this->Retries->waiting(id))
+    {
+    //jobs waiting out a retry backoff are reported as queued
+    js = remus::proto::JobStatus(id,remus::QUEUED);
+    js.retries(this->Retries->retries(id));
+    }
+  else if(this->ActiveJobs->haveUUID(id))
+    {
+    js = this->ActiveJobs->status(id);
+    }
+  return js;
+}
+
+//------------------------------------------------------------------------------
+std::string Server::currentJobStatuses(
+                                  const std::vector<boost::uuids::uuid>& ids)
+{
   std::ostringstream buffer;
-  buffer << reqSet;
+  buffer << ids.size() << std::endl;
+  typedef std::vector<boost::uuids::uuid>::const_iterator IdIt;
+  for(IdIt i = ids.begin(); i != ids.end(); ++i)
+    {
+    buffer << this->currentJobStatus(*i);
+    }
   return buffer.str();
 }
 
 //------------------------------------------------------------------------------
-std::string Server::meshStatus(const remus::proto::Message& msg)
+std::string Server::waitForJobs(detail::SocketHandle clientIdentity,
+                                const remus::proto::Message& msg)
 {
-  remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
-  remus::proto::JobStatus js(job.id(),remus::INVALID_STATUS);
-  if(this->QueuedJobs->haveUUID(job.id()))
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+
+  boost::int64_t timeoutInMilliseconds = 0;
+  std::size_t numberOfJobs = 0;
+  buffer >> timeoutInMilliseconds;
+  buffer >> numberOfJobs;
+
+  std::vector<boost::uuids::uuid> ids;
+  bool haveTerminalJob = false;
+  for(std::size_t i=0; i < numberOfJobs && buffer.good(); ++i)
     {
-    js = remus::proto::JobStatus(job.id(),remus::QUEUED);
+    remus::proto::Job job = remus::proto::make_invalidJob();
+    buffer >> job;
+    ids.push_back(job.id());
+
+    //a job that isn't queued or in progress will never change, so we
+    //can respond right away. This covers unknown jobs too
+    haveTerminalJob = haveTerminalJob || !this->currentJobStatus(job.id()).good();
     }
-  else if(this->ActiveJobs->haveUUID(job.id()))
+
+  if(haveTerminalJob || ids.empty() || timeoutInMilliseconds <= 0)
     {
-    js = this->ActiveJobs->status(job.id());
+    return this->currentJobStatuses(ids);
+    }
+
+  const boost::posix_time::ptime deadline =
+                boost::posix_time::microsec_clock::local_time() +
+                boost::posix_time::milliseconds(timeoutInMilliseconds);
+  //the waiting list holds its own reference to the handle, which is
+  //released once the client is answered
+  this->Identities->retain(clientIdentity);
+  this->WaitingClients->add(clientIdentity, ids, deadline);
+  return std::string();
+}
+
+//------------------------------------------------------------------------------
+void Server::AnswerWaitingClients(zmq::socket_t& clientChannel)
+{
+  std::vector<detail::WaitingClients::Waiter> ready =
+    this->WaitingClients->takeReady(
+                          boost::posix_time::microsec_clock::local_time());
+
+  typedef std::vector<detail::WaitingClients::Waiter>::const_iterator WaitIt;
+  for(WaitIt i = ready.begin(); i != ready.end(); ++i)
+    {
+    remus::proto::send_NonBlockingResponse(remus::WAIT_FOR_JOBS,
+                                           this->currentJobStatuses(i->Jobs),
+                                           &clientChannel,
+                                           this->Identities->resolve(i->Address));
+    this->Identities->release(i->Address);
     }
-  return remus::proto::to_string(js);
 }
 
 //------------------------------------------------------------------------------
@@ -620,16 +1231,172 @@ std::string Server::queueJob(const remus::proto::Message& msg)
   const boost::uuids::uuid jobUUID = (*this->UUIDGenerator)();
 
   //create a new job to place on the queue
-  const remus::proto::JobSubmission submission =
-                  remus::proto::to_JobSubmission(msg.data(),msg.dataSize());
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+  remus::proto::JobSubmission submission;
+  buffer >> submission;
+
+  //content that is too large to send with the submission follows
+  //it as a stream of chunks, which we spool until a worker takes the job
+  const remus::proto::StreamedKeys streamedKeys =
+                                      remus::proto::readStreamedKeys(buffer);
+  if(!streamedKeys.empty() &&
+     !this->StreamedSubmissions->add(jobUUID,streamedKeys))
+    {
+    return remus::proto::to_string(remus::proto::make_invalidJob());
+    }
+
+  //a client on the same machine places large content in shared memory,
+  //which we map instead of receiving it over the socket. If we can't map
+  //it the job is rejected, and the client falls back to streaming. Clients
+  //that can reach us from another machine never get their handles mapped
+  const remus::common::SharedMemoryHandles sharedHandles =
+                              remus::common::readSharedMemoryHandles(buffer);
+  if(!sharedHandles.empty() && !this->PortInfo.client().isLocalEndpoint())
+    {
+    this->StreamedSubmissions->remove(jobUUID);
+    return remus::proto::to_string(remus::proto::make_invalidJob());
+    }
+  typedef remus::common::SharedMemoryHandles::const_iterator SharedIt;
+  for(SharedIt i = sharedHandles.begin(); i != sharedHandles.end(); ++i)
+    {
+    boost::shared_array<char> data = remus::common::map_SharedMemory(i->second);
+    if(!data)
+      {
+      this->StreamedSubmissions->remove(jobUUID);
+      return remus::proto::to_string(remus::proto::make_invalidJob());
+      }
+    remus::proto::JobContent& placeholder = submission[i->first];
+    remus::proto::JobContent content(placeholder.formatType(), data,
+                                     static_cast<std::size_t>(i->second.Size));
+    content.tag(placeholder.tag());
+    placeholder = content;
+    }
+
+  //content that we already hold from an earlier submission is only
+  //referenced by its digest. If we no longer hold it the job is rejected,
+  //and the client falls back to sending the content
+  const remus::proto::ContentDigests storedDigests =
+                              remus::proto::readContentDigests(buffer);
+  typedef remus::proto::ContentDigests::const_iterator DigestIt;
+  for(DigestIt i = storedDigests.begin(); i != storedDigests.end(); ++i)
+    {
+    remus::proto::JobContent& placeholder = submission[i->first];
+    remus::proto::JobContent content;
+    if(!this->ContentStore->retain(jobUUID, i->second,
+                                   placeholder.formatType(), content))
+      {
+      this->StreamedSubmissions->remove(jobUUID);
+      this->ContentStore->release(jobUUID);
+      return remus::proto::to_string(remus::proto::make_invalidJob());
+      }
+    content.tag(placeholder.tag());
+    placeholder = content;
+    }
+
+  //check the digests the client sent along with the content, as they are
+  //used to key the content we hold and the content cached by workers.
+  //Then keep the large content we were sent, so that later submissions
+  //can reference it instead of sending it again
+  typedef remus::proto::JobSubmission::const_iterator ContentIt;
+  for(ContentIt i = submission.begin(); i != submission.end(); ++i)
+    {
+    if(!i->second.verifyHash())
+      {
+      this->StreamedSubmissions->remove(jobUUID);
+      this->ContentStore->release(jobUUID);
+      return remus::proto::to_string(remus::proto::make_invalidJob());
+      }
+
+    if(i->second.sourceType() == remus::common::ContentSource::Memory &&
+       i->second.dataSize() > remus::STREAM_CHUNK_SIZE &&
+       storedDigests.count(i->first) == 0)
+      {
+      this->ContentStore->add(jobUUID, i->second);
+      }
+    }
 
   this->QueuedJobs->addJob(jobUUID,submission);
+  this->TrackJobDeadlines(jobUUID,submission);
+  this->Retries->add(jobUUID,submission,streamedKeys);
   //return the UUID
 
   const remus::proto::Job validJob(jobUUID,msg.MeshIOType());
   return remus::proto::to_string(validJob);
 }
 
+//------------------------------------------------------------------------------
+std::string Server::storeSubmissionChunk(zmq::socket_t& workerChannel,
+                                         const remus::proto::Message& msg)
+{
+  remus::proto::DataChunk chunk = remus::proto::to_DataChunk(msg.data(),
+                                                             msg.dataSize());
+  const boost::uuids::uuid id = chunk.id();
+  if(!this->StreamedSubmissions->append(chunk))
+    {
+    return remus::INVALID_MSG;
+    }
+
+  if(!this->StreamedSubmissions->isValid(id))
+    {
+    //the content doesn't match what the client sent, so the job
+    //can't be run.
+    this->StreamedSubmissions->remove(id);
+    this->ContentStore->release(id);
+    this->Retries->remove(id);
+    if(!this->QueuedJobs->remove(id))
+      {
+      detail::SocketHandle worker = this->ActiveJobs->workerAddress(id);
+      this->ActiveJobs->updateStatus( remus::proto::make_FailedJobStatus(id,
+                                      "submission content failed verification") );
+      if(worker == this->InProcessWorker)
+        {
+        this->InProcessFactory->terminateJob(id);
+        }
+      else if(worker != 0)
+        {
+        detail::send_terminateJob(id, workerChannel,
+                                  this->Identities->resolve(worker));
+        }
+      }
+    this->WaitingClients->jobChanged(id);
+    return remus::INVALID_MSG;
+    }
+
+  //keep the content of the key once it has all arrived, so that later
+  //submissions can reference it instead of streaming it again, and so
+  //that a job that can be retried holds all of its submission. The
+  //content is the mapped spool file, so it isn't read back into memory,
+  //and its digest is computed by us from the spooled data
+  remus::proto::JobContent content;
+  if(chunk.isFinal() &&
+     this->StreamedSubmissions->content(id, chunk.key(), content))
+    {
+    this->Retries->content(id, chunk.key(), content);
+    if(chunk.totalSize() > remus::STREAM_CHUNK_SIZE)
+      {
+      this->ContentStore->add(id, content);
+      }
+    }
+
+  this->ForwardSubmissionChunks(workerChannel, id);
+  return boost::lexical_cast<std::string>(chunk.offset());
+}
+
+//------------------------------------------------------------------------------
+std::string Server::missingContent(const remus::proto::Message& msg)
+{
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+  const remus::proto::ContentDigests digests =
+                                  remus::proto::readContentDigests(buffer);
+
+  std::ostringstream response;
+  remus::proto::writeContentDigests(response,
+                                    this->ContentStore->missing(digests));
+  return response.str();
+}
+
 //------------------------------------------------------------------------------
 std::string Server::retrieveResult(const remus::proto::Message& msg)
 {
@@ -648,26 +1415,96 @@ std::string Server::retrieveResult(const remus::proto::Message& msg)
   return remus::proto::to_string(result);
 }
 
+//------------------------------------------------------------------------------
+std::string Server::retrieveResultChunk(const remus::proto::Message& msg)
+{
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+
+  boost::uint64_t offset = 0;
+  remus::proto::Job job = remus::proto::make_invalidJob();
+  buffer >> offset;
+  buffer >> job;
+
+  //an empty chunk that isn't final states that we have no result
+  remus::proto::DataChunk chunk(job.id());
+  if( this->ActiveJobs->haveChunkedResult(job.id()) )
+    {
+    //a result that was streamed to us is sent from the chunks it arrived
+    //in, with the checksum the worker sent
+    chunk = this->ActiveJobs->chunkedResult(job.id()).chunkAt(offset);
+    }
+  else if( this->ActiveJobs->haveUUID(job.id()) &&
+           this->ActiveJobs->haveResult(job.id()))
+    {
+    const remus::proto::JobResult result = this->ActiveJobs->result(job.id());
+    const boost::uint64_t resultSize = result.dataSize();
+    if(offset <= resultSize)
+      {
+      const std::size_t length = static_cast<std::size_t>(
+        std::min<boost::uint64_t>(remus::STREAM_CHUNK_SIZE, resultSize - offset));
+      chunk = remus::proto::DataChunk(job.id(), result.formatType(), offset,
+                                      result.data() + offset, length);
+      //the checksum is built as the chunks are sent, so the result
+      //isn't read again for the final chunk
+      const std::string checksum =
+                       this->ActiveJobs->hashResult(job.id(), offset, length);
+      if(offset + length == resultSize)
+        {
+        chunk.markAsFinal(resultSize, checksum);
+        }
+      }
+    }
+
+  //the chunk references the result data so we have to serialize it
+  //before the result is removed
+  const std::string response = remus::proto::to_string(chunk);
+  if(chunk.isFinal())
+    {
+    //the client has all of the result, so remove the job
+    this->ActiveJobs->remove(job.id());
+    }
+  return response;
+}
+
 //------------------------------------------------------------------------------
 std::string Server::terminateJob(zmq::socket_t& workerChannel,
                                  const remus::proto::Message& msg)
 {
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
 
-  bool removed = this->QueuedJobs->remove(job.id());
+  //a job waiting out a retry backoff isn't on the queue or on a worker
+  bool removed = this->QueuedJobs->remove(job.id()) ||
+                 this->Retries->waiting(job.id());
   if(!removed)
     {
-    zmq::SocketIdentity worker = this->ActiveJobs->workerAddress(job.id());
+    detail::SocketHandle worker = this->ActiveJobs->workerAddress(job.id());
     removed = this->ActiveJobs->remove(job.id());
+    this->StreamedResults->remove(job.id());
 
     //send an out of band message to the worker to terminate a job
     //if the job is in the worker queue it will be removed, if the worker
     //is currently processing the job, we will just ignore the result
     //when they are submitted
-    if(removed && worker.size() > 0)
+    if(removed && worker == this->InProcessWorker)
       {
-      detail::send_terminateJob(job.id(), workerChannel, worker);
+      this->InProcessFactory->terminateJob(job.id());
       }
+    else if(removed && worker != 0)
+      {
+      detail::send_terminateJob(job.id(), workerChannel,
+                                this->Identities->resolve(worker));
+      }
+    }
+
+  if(removed)
+    {
+    this->StreamedSubmissions->remove(job.id());
+    this->ContentStore->release(job.id());
+    this->Deadlines->remove(job.id());
+    this->Retries->remove(job.id());
+    this->SpeculativeJobs->stop(job.id());
+    this->WaitingClients->jobChanged(job.id());
     }
 
   remus::STATUS_TYPE status = (removed) ? remus::FAILED : remus::INVALID_STATUS;
@@ -676,7 +1513,7 @@ std::string Server::terminateJob(zmq::socket_t& workerChannel,
 
 //------------------------------------------------------------------------------
 void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
-                                     const zmq::SocketIdentity &workerIdentity)
+                                     detail::SocketHandle workerIdentity)
 {
   remus::proto::Message msg = remus::proto::receive_Message(&workerChannel);
   //if we have an invalid message just ignore it
@@ -702,27 +1539,57 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       //to response is required to this
       const remus::proto::JobRequirements reqs =
             remus::proto::to_JobRequirements(msg.data(),msg.dataSize());
+      //the pool holds onto the handle until the worker is purged
+      if(!this->WorkerPool->haveWorker(workerIdentity))
+        {
+        this->Identities->retain(workerIdentity);
+        }
       this->WorkerPool->addWorker(workerIdentity,reqs);
       }
       break;
     case remus::MAKE_MESH:
       {
       //Mark that the given worker is ready to accept a job with the passed
-      //in set of requirements
+      //in set of requirements, and remember what content the worker holds
       //The worker is waiting for us to respond to the service call
-      const remus::proto::JobRequirements reqs =
-            remus::proto::to_JobRequirements(msg.data(),msg.dataSize());
-      this->WorkerPool->readyForWork(workerIdentity,reqs);
+      const std::string data(msg.data(),msg.dataSize());
+      std::istringstream buffer(data);
+      remus::proto::JobRequirements reqs;
+      buffer >> reqs;
+      const remus::proto::ContentSummary content =
+                                  remus::proto::readContentSummary(buffer);
+      const remus::proto::ContentChanges changes =
+                                  remus::proto::readContentChanges(buffer);
+
+      //a single request can ask for several jobs
+      std::size_t numberOfJobs = 1;
+      buffer >> numberOfJobs;
+      if(buffer.fail() || numberOfJobs == 0)
+        {
+        numberOfJobs = 1;
+        }
+      this->WorkerPool->readyForWork(workerIdentity,reqs,content,changes,
+                                     numberOfJobs);
       }
       break;
+    case remus::MISSING_CONTENT:
+      //the worker doesn't hold content we only sent a reference to,
+      //so stream that content to it. No response needed
+      this->resendMissingContent(workerChannel,workerIdentity,msg);
+      break;
     case remus::MESH_STATUS:
       //store the mesh status msg which is a proto::JobStatus
       //no response needed
       this->storeMeshStatus(msg);
       break;
+    case remus::JOB_STARTED:
+      //the worker has taken a job it prefetched, so the job can no longer
+      //be given to another worker. No response needed
+      this->ActiveJobs->markStarted(remus::to_uuid(msg));
+      break;
     case remus::RETRIEVE_RESULT:
       //we need to store the mesh result, no response needed
-      this->storeMesh(msg);
+      this->storeMesh(workerIdentity,msg);
 
       {
       //now that we have stored the mesh we can tell the worker
@@ -733,9 +1600,32 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       remus::proto::send_NonBlockingResponse(remus::RETRIEVE_RESULT,
                                              remus::INVALID_MSG,
                                              &workerChannel,
-                                             workerIdentity);
+                                             this->Identities->resolve(workerIdentity));
       }
 
+      break;
+    case remus::RESULT_CHUNK:
+      //store the next chunk of a result that is being streamed to us, and
+      //acknowledge it so the worker can send more
+      this->storeMeshChunk(workerChannel,workerIdentity,msg);
+      break;
+    case remus::SUBMISSION_CHUNK:
+      //the worker has received a chunk of a job submission, so we can
+      //send it more. Once it has everything we can drop the spool, unless
+      //the job can be retried and the spool has to be streamed again
+      {
+      const boost::uuids::uuid id =
+              remus::proto::to_DataChunkId(msg.data(),msg.dataSize());
+      this->StreamedSubmissions->acknowledged(id);
+      if(!this->StreamedSubmissions->isForwarded(id))
+        {
+        this->ForwardSubmissionChunks(workerChannel,id);
+        }
+      else if(!this->Retries->have(id))
+        {
+        this->StreamedSubmissions->remove(id);
+        }
+      }
       break;
     case remus::HEARTBEAT:
       //pass along to the worker monitor what worker just sent a heartbeat
@@ -752,7 +1642,8 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       //we have found out the worker is dead, dead since it has told
       //us itself that it is shutting down. We don't need to do anything
       //else as the WorkerPool and ActiveJobs will find out about the dead
-      //worker by asking the SocketMonitor
+      //worker by asking the SocketMonitor. The pool releases its
+      //reference to the handle once it purges the worker
       this->SocketMonitor->markAsDead(workerIdentity);
     default:
 
@@ -774,34 +1665,374 @@ void Server::storeMeshStatus(const remus::proto::Message& msg)
   //the string in the data is actually a job status object
   remus::proto::JobStatus js = remus::proto::to_JobStatus(msg.data(),
                                                           msg.dataSize());
+  this->updateJobStatus(js);
+}
+
+//------------------------------------------------------------------------------
+void Server::updateJobStatus(const remus::proto::JobStatus& js)
+{
   this->ActiveJobs->updateStatus(js);
+
+  //a worker reporting a failure is a terminal change for waiting clients
+  if(this->ActiveJobs->haveUUID(js.id()) &&
+     !this->ActiveJobs->status(js.id()).good())
+    {
+    this->StreamedSubmissions->remove(js.id());
+    this->ContentStore->release(js.id());
+    this->Deadlines->remove(js.id());
+    this->Retries->remove(js.id());
+    this->SpeculativeJobs->stop(js.id());
+    this->WaitingClients->jobChanged(js.id());
+    }
 }
 
 //------------------------------------------------------------------------------
-void Server::storeMesh(const remus::proto::Message& msg)
+void Server::storeMesh(detail::SocketHandle workerIdentity,
+                       const remus::proto::Message& msg)
 {
-  remus::proto::JobResult jr = remus::proto::to_JobResult(msg.data(),
-                                                            msg.dataSize());
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+  remus::proto::JobResult jr( (boost::uuids::uuid()) );
+  buffer >> jr;
+
+  //the result of a copied job is only taken from the first worker to
+  //send it
+  if(!this->SpeculativeJobs->claimResult(jr.id(), workerIdentity))
+    {
+    return;
+    }
+
+  //a worker on the same machine places large results in shared memory.
+  //Workers that can reach us from another machine never get their
+  //handles mapped
+  remus::common::SharedMemoryHandle handle;
+  buffer >> handle;
+  if(handle.valid())
+    {
+    boost::shared_array<char> contents;
+    if(this->PortInfo.worker().isLocalEndpoint())
+      {
+      contents = remus::common::map_SharedMemory(handle);
+      }
+    if(!contents)
+      {
+      this->updateJobStatus( remus::proto::make_FailedJobStatus(jr.id(),
+                             "shared result could not be mapped") );
+      return;
+      }
+    jr = remus::proto::JobResult(jr.id(), jr.formatType(), contents,
+                                 static_cast<std::size_t>(handle.Size));
+    }
+
+  this->updateJobResult(workerIdentity, jr);
+}
+
+//------------------------------------------------------------------------------
+void Server::updateJobResult(detail::SocketHandle workerIdentity,
+                             const remus::proto::JobResult& jr)
+{
+  //a result for a job we aren't running, such as one from a worker we
+  //gave up on while the job waits to be retried, is dropped. So is the
+  //result of a copied job that lost
+  if(!this->ActiveJobs->haveUUID(jr.id()) ||
+     this->ActiveJobs->haveResult(jr.id()))
+    {
+    return;
+    }
+
+  //the job is done with its submission content
+  this->StreamedSubmissions->remove(jr.id());
+  this->ContentStore->release(jr.id());
+  this->Deadlines->remove(jr.id());
+  this->Retries->remove(jr.id());
+  this->SpeculativeJobs->finished(jr.id(), workerIdentity,
+                            boost::posix_time::microsec_clock::local_time());
   this->ActiveJobs->updateResult(jr);
+  this->WaitingClients->jobChanged(jr.id());
+}
+
+//------------------------------------------------------------------------------
+void Server::storeMeshChunk(zmq::socket_t& workerChannel,
+                            detail::SocketHandle workerIdentity,
+                            const remus::proto::Message& msg)
+{
+  remus::proto::DataChunk chunk = remus::proto::to_DataChunk(msg.data(),
+                                                             msg.dataSize());
+  const boost::uuids::uuid id = chunk.id();
+
+  //only accept chunks for jobs that are still being worked on. Jobs that
+  //have been terminated or have expired have their partial result dropped.
+  //A copied job only takes the chunks of the first worker to send one,
+  //and the partial result of that worker is kept
+  const bool claimed = this->SpeculativeJobs->claimResult(id, workerIdentity);
+  const bool accepted = claimed &&
+                        this->ActiveJobs->haveUUID(id) &&
+                        this->ActiveJobs->status(id).good() &&
+                        this->StreamedResults->add(chunk);
+  if(!accepted && claimed)
+    {
+    this->StreamedResults->remove(id);
+    }
+  else if(accepted && chunk.isFinal())
+    {
+    this->StreamedSubmissions->remove(id);
+    this->ContentStore->release(id);
+    this->Retries->remove(id);
+    detail::ChunkedResult result;
+    if(this->StreamedResults->take(id,result))
+      {
+      this->ActiveJobs->updateResult(id, result);
+      this->SpeculativeJobs->finished(id, workerIdentity,
+                            boost::posix_time::microsec_clock::local_time());
+      }
+    else
+      {
+      this->ActiveJobs->updateStatus( remus::proto::make_FailedJobStatus(id,
+                                      "streamed result failed verification") );
+      this->SpeculativeJobs->stop(id);
+      }
+    this->WaitingClients->jobChanged(id);
+    }
+
+  //acknowledge the chunk which gives the worker back the credit it used
+  //to send it. A rejected chunk tells the worker to stop streaming
+  const std::string ack = accepted ?
+                          boost::lexical_cast<std::string>(chunk.offset()) :
+                          remus::INVALID_MSG;
+  remus::proto::send_NonBlockingResponse(remus::RESULT_CHUNK, ack,
+                                         &workerChannel,
+                                         this->Identities->resolve(workerIdentity));
 }
 
 //------------------------------------------------------------------------------
 void Server::assignJobToWorker(zmq::socket_t& workerChannel,
-                               const zmq::SocketIdentity &workerIdentity,
+                               detail::SocketHandle workerIdentity,
                                const remus::worker::Job& job )
 {
-  this->ActiveJobs->add( workerIdentity, job.id() );
+  this->assignJobsToWorker(workerChannel, workerIdentity,
+                           std::vector<remus::worker::Job>(1, job));
+}
 
-  remus::proto::Response response =
+//------------------------------------------------------------------------------
+void Server::assignJobsToWorker(zmq::socket_t& workerChannel,
+                                detail::SocketHandle workerIdentity,
+                                const std::vector<remus::worker::Job>& jobs)
+{
+  if(jobs.empty())
+    {
+    return;
+    }
+
+  std::vector<std::string> messages;
+  typedef std::vector<remus::worker::Job>::const_iterator JobIt;
+  for(JobIt job = jobs.begin(); job != jobs.end(); ++job)
+    {
+    messages.push_back(this->jobMessage(workerIdentity, *job));
+    }
+
+  remus::proto::Response response = (messages.size() == 1) ?
         remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                               remus::worker::to_string(job),
+                                               messages[0],
+                                               &workerChannel,
+                                               this->Identities->resolve(workerIdentity)) :
+        remus::proto::send_NonBlockingResponse(remus::JOB_BATCH,
+                                     remus::worker::to_JobBatch(messages),
                                                &workerChannel,
-                                               workerIdentity);
+                                               this->Identities->resolve(workerIdentity));
   if(response.isValid())
-    { //consider sending the job to be refreshing the worker
+    { //consider sending the jobs to be refreshing the worker
     this->SocketMonitor->refresh(workerIdentity);
     }
 
+  //send the worker any content that was spooled before it took the jobs
+  for(JobIt job = jobs.begin(); job != jobs.end(); ++job)
+    {
+    this->ForwardSubmissionChunks(workerChannel, job->id());
+    }
+}
+
+//------------------------------------------------------------------------------
+std::string Server::jobMessage(detail::SocketHandle workerIdentity,
+                               const remus::worker::Job& job)
+{
+  //the run deadline of the job starts once it is given to a worker, and
+  //so does the runtime we use to find stragglers
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  this->Deadlines->dispatched(job.id(), now);
+  this->SpeculativeJobs->dispatched(job.id(), job.submission().requirements(),
+                                    workerIdentity, now);
+
+  if(this->StreamedSubmissions->have(job.id()))
+    { //streamed content is only sent to a single worker, so the job
+      //can't be requeued if the worker dies before starting it
+    this->ActiveJobs->add( workerIdentity, job.id() );
+    }
+  else
+    {
+    this->ActiveJobs->add( workerIdentity, job );
+    if(this->Speculation.maxFraction() > 0)
+      {
+      this->SpeculativeJobs->holdForCopies(job);
+      }
+    }
+  this->ActiveJobs->markRetried( job.id(), this->Retries->retries(job.id()) );
+
+  std::string jobData;
+  if(this->StreamedSubmissions->have(job.id()))
+    {
+    //tell the worker which content will follow the job as a stream. A
+    //retried job holds the content it was streamed, which we stream
+    //again instead of sending it with the job
+    const remus::proto::StreamedKeys keys =
+                                    this->StreamedSubmissions->keys(job.id());
+    remus::proto::JobSubmission submission = job.submission();
+    typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+    for(KeyIt k = keys.begin(); k != keys.end(); ++k)
+      {
+      remus::proto::JobContent& content = submission[*k];
+      remus::proto::JobContent placeholder(content.formatType(),
+                                           std::string());
+      placeholder.tag(content.tag());
+      content = placeholder;
+      }
+
+    std::ostringstream buffer;
+    buffer << remus::worker::to_string(
+                            remus::worker::Job(job.id(), submission));
+    remus::proto::writeStreamedKeys(buffer, keys);
+    jobData = buffer.str();
+    }
+  else
+    {
+    //content the worker acknowledged holding is only sent as a reference
+    //to its digest. If the worker dropped it since, the worker asks
+    //for it with a MISSING_CONTENT message
+    const std::vector<std::string> digests =
+                    detail::cacheableDigests(job, *this->ContentStore);
+
+    remus::proto::JobSubmission submission = job.submission();
+    remus::proto::ContentDigests references;
+    typedef remus::proto::JobSubmission::iterator ContentIt;
+    for(ContentIt i = submission.begin(); i != submission.end(); ++i)
+      {
+      const std::string& digest = i->second.hash();
+      if(this->WorkerPool->holdsContent(workerIdentity, digest) &&
+         std::find(digests.begin(), digests.end(), digest) != digests.end())
+        {
+        references[i->first] = digest;
+        remus::proto::JobContent placeholder(i->second.formatType(),
+                                             std::string());
+        placeholder.tag(i->second.tag());
+        i->second = placeholder;
+        }
+      }
+
+    std::ostringstream buffer;
+    if(references.empty())
+      {
+      buffer << remus::worker::to_string(job);
+      }
+    else
+      {
+      buffer << remus::worker::to_string(
+                              remus::worker::Job(job.id(), submission));
+      remus::proto::writeStreamedKeys(buffer, remus::proto::StreamedKeys());
+      remus::proto::writeContentDigests(buffer, references);
+      }
+    jobData = buffer.str();
+    }
+  return jobData;
+}
+
+//------------------------------------------------------------------------------
+void Server::resendMissingContent(zmq::socket_t& workerChannel,
+                                  detail::SocketHandle workerIdentity,
+                                  const remus::proto::Message& msg)
+{
+  const std::string data(msg.data(),msg.dataSize());
+  std::istringstream buffer(data);
+  boost::uuids::uuid id;
+  buffer >> id;
+  const remus::proto::ContentDigests missing =
+                                  remus::proto::readContentDigests(buffer);
+
+  //ignore jobs the worker no longer holds, or that we are already
+  //streaming content for
+  if(missing.empty() || !this->ActiveJobs->haveUUID(id) ||
+     !(this->ActiveJobs->workerAddress(id) == workerIdentity) ||
+     this->StreamedSubmissions->have(id))
+    {
+    return;
+    }
+
+  remus::proto::StreamedKeys keys;
+  std::vector<remus::proto::JobContent> contents;
+  typedef remus::proto::ContentDigests::const_iterator DigestIt;
+  for(DigestIt i = missing.begin(); i != missing.end(); ++i)
+    {
+    remus::proto::JobContent content;
+    if(!this->ContentStore->find(i->second, content))
+      { //we no longer hold the content, so the job can't be run
+      this->updateJobStatus( remus::proto::make_FailedJobStatus(id,
+                             "referenced content is no longer held") );
+      detail::send_terminateJob(id, workerChannel,
+                                this->Identities->resolve(workerIdentity));
+      return;
+      }
+    keys.insert(i->first);
+    contents.push_back(content);
+    }
+
+  //stream the content like content the client streamed to us, so that
+  //the worker can't be flooded with data
+  this->StreamedSubmissions->add(id, keys);
+  std::vector<remus::proto::JobContent>::const_iterator content =
+                                                            contents.begin();
+  for(DigestIt i = missing.begin(); i != missing.end(); ++i, ++content)
+    {
+    const std::size_t size = content->dataSize();
+    std::size_t offset = 0;
+    remus::common::MD5Hasher hasher;
+    do
+      {
+      const std::size_t chunkSize = std::min(remus::STREAM_CHUNK_SIZE,
+                                             size - offset);
+      remus::proto::DataChunk chunk(id, content->formatType(), offset,
+                                    content->data() + offset, chunkSize);
+      chunk.key(i->first);
+      hasher.append(content->data() + offset, chunkSize);
+      offset += chunkSize;
+      if(offset == size)
+        {
+        chunk.markAsFinal(size, hasher.hash());
+        }
+      this->StreamedSubmissions->append(chunk);
+      }
+    while(offset < size);
+    }
+
+  this->ForwardSubmissionChunks(workerChannel, id);
+}
+
+//------------------------------------------------------------------------------
+void Server::ForwardSubmissionChunks(zmq::socket_t& workerChannel,
+                                     const boost::uuids::uuid& id)
+{
+  if(!this->StreamedSubmissions->have(id) || !this->ActiveJobs->haveUUID(id))
+    {
+    return;
+    }
+
+  const detail::SocketHandle worker = this->ActiveJobs->workerAddress(id);
+  remus::proto::DataChunk chunk(id);
+  while(this->StreamedSubmissions->nextChunkToForward(id,chunk))
+    {
+    remus::proto::send_NonBlockingResponse(remus::SUBMISSION_CHUNK,
+                                           remus::proto::to_string(chunk),
+                                           &workerChannel,
+                                           this->Identities->resolve(worker));
+    }
 }
 
 //see if we have a worker in the pool for the next job in the queue,
@@ -833,10 +2064,7 @@ void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
     {
     if(this->WorkerPool->haveWaitingWorker(*type))
       {
-      //give this job to that worker
-      this->assignJobToWorker(workerChannel,
-                              this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
+      this->DispatchQueuedJobs(workerChannel, *type);
       }
     }
 
@@ -848,13 +2076,13 @@ void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
     {
     if(this->WorkerPool->haveWaitingWorker(*type))
       {
-      //give this job to that worker
-      this->assignJobToWorker(workerChannel,
-                              this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
+      this->DispatchQueuedJobs(workerChannel, *type);
       }
     }
 
+  //jobs the factory can run inside the server don't need a worker at all
+  this->RunQueuedJobsInProcess();
+
   //now if we have room in our worker pool for more pending workers create some
   //make sure we ask the worker pool what its limit on number of pending
   //workers is before creating more. We have to requery to get the updated
@@ -872,6 +2100,346 @@ void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
     }
 }
 
+//------------------------------------------------------------------------------
+void Server::DispatchQueuedJobs(zmq::socket_t& workerChannel,
+                                const remus::proto::JobRequirements& reqs)
+{
+  //a worker is only sent its share of the queued jobs, so that a worker
+  //that asked for many jobs can't starve the other waiting workers
+  const std::size_t waitingWorkers =
+                        this->WorkerPool->numberOfWaitingWorkers(reqs);
+  const std::size_t share = (waitingWorkers == 0) ? 1 :
+        (this->QueuedJobs->numJobs(reqs) + waitingWorkers - 1) / waitingWorkers;
+  const std::size_t maxJobs = std::min(share, this->Batching.maxJobs());
+
+  //give the first job to the worker that holds the most of its content
+  std::vector<remus::worker::Job> jobs;
+  jobs.push_back(this->QueuedJobs->takeJob(reqs));
+  const detail::SocketHandle worker = this->WorkerPool->takeWorker(reqs,
+                  detail::cacheableDigests(jobs.back(), *this->ContentStore));
+
+  //jobs with streamed content aren't small, so they are never batched
+  if(this->StreamedSubmissions->have(jobs.back().id()))
+    {
+    this->assignJobsToWorker(workerChannel, worker, jobs);
+    return;
+    }
+
+  //fill the batch with the next jobs in the queue while the worker still
+  //wants jobs, and their content fits in the bytes of the batch
+  boost::uint64_t bytes = detail::bytesToSend(jobs.back(), worker,
+                                              *this->WorkerPool,
+                                              *this->ContentStore);
+  while(jobs.size() < maxJobs &&
+        this->WorkerPool->numberOfJobsWanted(worker, reqs) > 0)
+    {
+    const remus::worker::Job next = this->QueuedJobs->peekJob(reqs);
+    if(!next.valid() || this->StreamedSubmissions->have(next.id()))
+      {
+      break;
+      }
+
+    bytes += detail::bytesToSend(next, worker, *this->WorkerPool,
+                                 *this->ContentStore);
+    if(bytes > this->Batching.maxBytes())
+      {
+      break;
+      }
+
+    this->QueuedJobs->takeJob(reqs);
+    this->WorkerPool->takeAnotherJob(worker, reqs);
+    jobs.push_back(next);
+    }
+
+  this->assignJobsToWorker(workerChannel, worker, jobs);
+}
+
+//------------------------------------------------------------------------------
+void Server::RunQueuedJobsInProcess()
+{
+  if(!this->InProcessFactory)
+    {
+    return;
+    }
+
+  typedef remus::proto::JobRequirementsSet::const_iterator it;
+  remus::proto::JobRequirementsSet types =
+                                  this->QueuedJobs->queuedJobRequirements();
+  for(it type = types.begin(); type != types.end(); ++type)
+    {
+    while(this->InProcessFactory->canRunJob(*type))
+      {
+      remus::worker::Job job = this->QueuedJobs->peekJob(*type);
+      if(!job.valid())
+        {
+        break;
+        }
+
+      //the factory gets the submission as is, so we have to wait for
+      //streamed content to be uploaded before it can take the job. The
+      //job stays at the front of the queue, so no later job of the same
+      //type overtakes it
+      const bool streamed = this->StreamedSubmissions->have(job.id());
+      if(streamed && !this->StreamedSubmissions->isUploaded(job.id()))
+        {
+        break;
+        }
+      this->QueuedJobs->takeJob(*type);
+
+      if(streamed)
+        {
+        remus::proto::JobSubmission submission = job.submission();
+        const remus::proto::StreamedKeys keys =
+                                  this->StreamedSubmissions->keys(job.id());
+        typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+        for(KeyIt k = keys.begin(); k != keys.end(); ++k)
+          {
+          remus::proto::JobContent content;
+          this->StreamedSubmissions->content(job.id(), *k, content);
+          content.tag(submission[*k].tag());
+          submission[*k] = content;
+          }
+        this->StreamedSubmissions->remove(job.id());
+        job = remus::worker::Job(job.id(), submission);
+        }
+
+      //like streamed jobs, jobs run in process are never requeued
+      this->ActiveJobs->add( this->InProcessWorker, job.id() );
+      this->ActiveJobs->markRetried(job.id(),this->Retries->retries(job.id()));
+      const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+      this->Deadlines->dispatched(job.id(), now);
+      this->SpeculativeJobs->dispatched(job.id(),
+                                        job.submission().requirements(),
+                                        this->InProcessWorker, now);
+      this->InProcessFactory->runJob(job);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::StoreInProcessUpdates()
+{
+  std::vector<remus::proto::JobStatus> statuses;
+  std::vector<remus::proto::JobResult> results;
+  this->InProcessFactory->takeUpdates(statuses, results);
+
+  typedef std::vector<remus::proto::JobStatus>::const_iterator StatusIt;
+  for(StatusIt i = statuses.begin(); i != statuses.end(); ++i)
+    {
+    this->updateJobStatus(*i);
+    }
+
+  typedef std::vector<remus::proto::JobResult>::const_iterator ResultIt;
+  for(ResultIt i = results.begin(); i != results.end(); ++i)
+    {
+    this->updateJobResult(this->InProcessWorker, *i);
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::TrackJobDeadlines(const boost::uuids::uuid& id,
+                               const remus::proto::JobSubmission& submission)
+{
+  const remus::proto::JobRequirements& reqs = submission.requirements();
+  const boost::int64_t queueTimeout = (submission.queueTimeout() > 0) ?
+                                 submission.queueTimeout() :
+                                 this->WorkerFactory->queueTimeout(reqs);
+  const boost::int64_t runTimeout = (submission.runTimeout() > 0) ?
+                                 submission.runTimeout() :
+                                 this->WorkerFactory->runTimeout(reqs);
+  this->Deadlines->add(id, queueTimeout, runTimeout,
+                       boost::posix_time::microsec_clock::local_time());
+}
+
+//------------------------------------------------------------------------------
+void Server::ExpireJobDeadlines(zmq::socket_t& workerChannel)
+{
+  if(this->Deadlines->empty())
+    {
+    return;
+    }
+
+  typedef std::vector<detail::JobDeadlines::Expired>::const_iterator ExpiredIt;
+  const std::vector<detail::JobDeadlines::Expired> expired =
+    this->Deadlines->takeExpired(boost::posix_time::microsec_clock::local_time());
+  for(ExpiredIt i = expired.begin(); i != expired.end(); ++i)
+    {
+    const boost::uuids::uuid& id = i->Id;
+    if(i->Type == detail::JobDeadlines::QUEUE)
+      {
+      //a stale queued job is dropped before it is ever dispatched. We keep
+      //it as an active job without a worker so the client sees it failed
+      if(!this->QueuedJobs->remove(id))
+        {
+        continue;
+        }
+      this->StreamedSubmissions->remove(id);
+      this->ActiveJobs->add( detail::SocketHandle(0), id );
+      this->updateJobStatus( remus::proto::make_FailedJobStatus(id,
+                             "job waited in the queue past its deadline") );
+      }
+    else
+      {
+      //a job that is still running is terminated, which frees its worker
+      //for queued work. A result it sends after this doesn't finish it
+      if(!this->ActiveJobs->haveUUID(id) ||
+         !this->ActiveJobs->status(id).good())
+        {
+        continue;
+        }
+      const detail::SocketHandle worker = this->ActiveJobs->workerAddress(id);
+      this->StreamedResults->remove(id);
+      this->StreamedSubmissions->remove(id);
+      this->updateJobStatus( remus::proto::make_FailedJobStatus(id,
+                             "job ran past its deadline") );
+      if(worker == this->InProcessWorker)
+        {
+        this->InProcessFactory->terminateJob(id);
+        }
+      else if(worker != 0)
+        {
+        detail::send_terminateJob(id, workerChannel,
+                                  this->Identities->resolve(worker));
+        }
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::RequeueRetriedJobs()
+{
+  if(this->Retries->empty())
+    {
+    return;
+    }
+
+  //the job keeps its id, so the client sees it go back to being queued
+  const std::vector<remus::worker::Job> ready =
+    this->Retries->takeReady(boost::posix_time::microsec_clock::local_time());
+  typedef std::vector<remus::worker::Job>::const_iterator JobIt;
+  for(JobIt i = ready.begin(); i != ready.end(); ++i)
+    {
+    this->QueuedJobs->addJob(i->id(), i->submission());
+    this->TrackJobDeadlines(i->id(), i->submission());
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::SpeculateOnStragglers(zmq::socket_t& workerChannel)
+{
+  if(this->Speculation.maxFraction() <= 0 || this->SpeculativeJobs->empty())
+    {
+    return;
+    }
+
+  //copies can only use their share of the workers we know about
+  const std::size_t maxCopies = static_cast<std::size_t>(
+                        this->Speculation.maxFraction() *
+                        static_cast<double>(this->WorkerPool->allWorkers().size()));
+  if(this->SpeculativeJobs->numberOfCopies() >= maxCopies)
+    {
+    return;
+    }
+
+  const std::vector<remus::worker::Job> stragglers =
+          this->SpeculativeJobs->stragglers(this->Speculation.percentile(),
+                              boost::posix_time::microsec_clock::local_time());
+  typedef std::vector<remus::worker::Job>::const_iterator JobIt;
+  for(JobIt job = stragglers.begin(); job != stragglers.end() &&
+      this->SpeculativeJobs->numberOfCopies() < maxCopies; ++job)
+    {
+    //queued jobs always come before copies
+    const remus::proto::JobRequirements& reqs = job->submission().requirements();
+    if(this->QueuedJobs->numJobs(reqs) > 0 ||
+       !this->WorkerPool->haveWaitingWorker(reqs))
+      {
+      continue;
+      }
+
+    const detail::SocketHandle worker = this->WorkerPool->takeOtherWorker(reqs,
+                                    this->ActiveJobs->workerAddress(job->id()));
+    if(worker == 0)
+      {
+      continue;
+      }
+
+    //the copy is sent with all of its content, since we only stream
+    //content the worker is missing to the worker that has the job
+    remus::proto::Response response =
+        remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
+                                          remus::worker::to_string(*job),
+                                               &workerChannel,
+                                               this->Identities->resolve(worker));
+    if(response.isValid())
+      {
+      this->SocketMonitor->refresh(worker);
+      }
+    this->SpeculativeJobs->copied(job->id(), worker);
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::TerminateLosingCopies(zmq::socket_t& workerChannel)
+{
+  const std::vector<detail::SpeculativeJobs::JobWorker> losers =
+                                        this->SpeculativeJobs->takeLosers();
+  typedef std::vector<detail::SpeculativeJobs::JobWorker>::const_iterator It;
+  for(It i = losers.begin(); i != losers.end(); ++i)
+    {
+    if(i->second == this->InProcessWorker)
+      {
+      this->InProcessFactory->terminateJob(i->first);
+      }
+    else
+      {
+      detail::send_terminateJob(i->first, workerChannel,
+                                this->Identities->resolve(i->second));
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::ScheduleTimers(remus::common::TimerQueue& timers,
+                            const boost::posix_time::ptime& now)
+{
+  remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
+  const boost::int64_t maxTimeout = monitor.maxTimeOut();
+
+  //workers are checked once one could have missed its heartbeat. While
+  //our polling has been abnormal every worker is given a pass, so we check
+  //again soon after, once the polling has settled down
+  if(monitor.hasAbnormalEvent())
+    {
+    timers.scheduleIn(detail::DeadWorkerTimer, now, monitor.minTimeOut());
+    }
+  else
+    {
+    detail::scheduleTimer(timers, detail::DeadWorkerTimer, now,
+      this->SocketMonitor->millisecondsToNextExpiry(now, maxTimeout),
+      maxTimeout);
+    }
+
+  detail::scheduleTimer(timers, detail::RetryTimer, now,
+    this->Retries->millisecondsToNextRetry(now, maxTimeout), maxTimeout);
+  detail::scheduleTimer(timers, detail::DeadlineTimer, now,
+    this->Deadlines->millisecondsToNextDeadline(now, maxTimeout), maxTimeout);
+  detail::scheduleTimer(timers, detail::WaitingClientTimer, now,
+    this->WaitingClients->millisecondsToNextDeadline(now, maxTimeout),
+    maxTimeout);
+
+  if(this->Speculation.maxFraction() > 0)
+    {
+    detail::scheduleTimer(timers, detail::StragglerTimer, now,
+      this->SpeculativeJobs->millisecondsToNextStraggler(
+                          this->Speculation.percentile(), now, maxTimeout),
+      maxTimeout);
+    }
+  else
+    {
+    timers.cancel(detail::StragglerTimer);
+    }
+}
 
 //We are crashing we need to terminate all workers
 //------------------------------------------------------------------------------
@@ -890,28 +2458,34 @@ void Server::TerminateAllWorkers( zmq::socket_t& workerChannel )
 {
 
   //next we take workers from the worker pool and kill them all off
-  std::set<zmq::SocketIdentity> pendingWorkers =
+  std::set<detail::SocketHandle> pendingWorkers =
                                               this->WorkerPool->allWorkers();
 
-  typedef std::set<zmq::SocketIdentity>::const_iterator iterator;
+  typedef std::set<detail::SocketHandle>::const_iterator iterator;
   for(iterator i=pendingWorkers.begin(); i != pendingWorkers.end(); ++i)
     {
     //make a fake id and send that with the terminate command
     const boost::uuids::uuid jobId = (*this->UUIDGenerator)();
 
-    detail::send_terminateWorker(jobId, workerChannel, *i);
+    detail::send_terminateWorker(jobId, workerChannel,
+                                 this->Identities->resolve(*i));
     }
 
   //lastly we will kill any still active worker
-  std::set<zmq::SocketIdentity> activeWorkers =
+  std::set<detail::SocketHandle> activeWorkers =
                                         this->ActiveJobs->activeWorkers();
 
   //only call terminate again on workers that are active
   for(iterator i=activeWorkers.begin(); i != activeWorkers.end(); ++i)
     {
+    if(*i == this->InProcessWorker)
+      { //jobs run inside the server aren't processed by a worker
+      continue;
+      }
     //make a fake id and send that with the terminate command
     const boost::uuids::uuid jobId = (*this->UUIDGenerator)();
-    detail::send_terminateWorker(jobId, workerChannel, *i);
+    detail::send_terminateWorker(jobId, workerChannel,
+                                 this->Identities->resolve(*i));
     }
 
 }
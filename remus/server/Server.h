@@ -15,6 +15,7 @@
 
 #include <remus/common/SignalCatcher.h>
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #ifndef _MSC_VER
@@ -32,13 +33,22 @@
 //included for export symbols
 #include <remus/server/ServerExports.h>
 
+#include <vector>
+
 
 //forward declaration of classes only the implementation needs
-namespace zmq { struct SocketIdentity; }
+namespace boost { namespace posix_time {  class ptime;  } }
 
 namespace remus {
   //forward declaration of classes only the implementation needs
+  namespace common {
+  class TimerQueue;
+  }
+
   namespace proto {
+  class JobResult;
+  class JobStatus;
+  class JobSubmission;
   class Message;
   }
 
@@ -49,15 +59,30 @@ namespace remus {
 
 namespace remus{
 namespace server{
+  class InProcessWorkerFactory;
+
   namespace detail
     {
     //forward declaration of classes only the implementation needs
     class ActiveJobs;
+    class ContentStore;
+    class JobDeadlines;
+    class JobRetries;
     class JobQueue;
+    class SocketIdentities;
     class SocketMonitor;
+    class SpeculativeJobs;
+    class StreamedResults;
+    class StreamedSubmissions;
+    class SupportCache;
+    class WaitingClients;
     class WorkerPool;
     struct ThreadManagement;
     struct UUIDManagement;
+
+    //compact handle to the identity of a socket, must match the typedef
+    //in SocketIdentities.h
+    typedef boost::uint64_t SocketHandle;
     }
 
 //helper class that allows users to set and get the polling rates for
@@ -79,6 +104,50 @@ private:
   boost::int64_t MaxRateMillisec;
 };
 
+//helper class that allows users to set and get how the server bundles
+//small jobs into a single message to a worker that asked for several jobs.
+//A batch holds at most max_jobs jobs, and at most max_bytes bytes of job
+//content, where the first job is always sent. A max_jobs of one or less
+//sends every job in a message of its own
+class REMUSSERVER_EXPORT JobBatching
+{
+public:
+  JobBatching(std::size_t max_jobs, boost::uint64_t max_bytes):
+    MaxJobs(max_jobs > 0 ? max_jobs : 1),
+    MaxBytes(max_bytes)
+    {
+    }
+
+  const std::size_t& maxJobs() const { return MaxJobs; }
+  const boost::uint64_t& maxBytes() const { return MaxBytes; }
+
+private:
+  std::size_t MaxJobs;
+  boost::uint64_t MaxBytes;
+};
+
+//helper class that allows users to set and get when the server sends a
+//copy of a straggling job to an idle worker. A job is a straggler once it
+//has run longer than the given percentile of the recent runtimes of jobs
+//with the same requirements. Copies can use at most max_fraction of the
+//workers connected to the server, where zero turns speculation off
+class REMUSSERVER_EXPORT JobSpeculation
+{
+public:
+  JobSpeculation(double percentile, double max_fraction):
+    Percentile(percentile < 0 ? 0 : (percentile > 1 ? 1 : percentile)),
+    MaxFraction(max_fraction < 0 ? 0 : (max_fraction > 1 ? 1 : max_fraction))
+    {
+    }
+
+  const double& percentile() const { return Percentile; }
+  const double& maxFraction() const { return MaxFraction; }
+
+private:
+  double Percentile;
+  double MaxFraction;
+};
+
 
 //Server is the broker of Remus. It handles accepting client
 //connections, worker connections, and manages the life cycle of submitted jobs.
@@ -118,6 +187,21 @@ public:
   void pollingRates( const remus::server::PollingRates& rates );
   remus::server::PollingRates pollingRates() const;
 
+  //Modify how the server bundles small jobs for workers that ask for
+  //several jobs at once. A worker is only sent its share of the queued jobs
+  //of a type, which is the number of queued jobs divided by the number of
+  //workers waiting for that type, so batching never starves other workers.
+  //Defaults to batches of at most 16 jobs and 64KB of job content
+  void jobBatching( const remus::server::JobBatching& batching );
+  remus::server::JobBatching jobBatching() const;
+
+  //Modify when the server runs a copy of a straggling job on an idle
+  //worker. The first of the two to send a result wins, and the other is
+  //told to terminate the job. Jobs with streamed content are never copied.
+  //Defaults to the 90th percentile with speculation turned off
+  void jobSpeculation( const remus::server::JobSpeculation& speculation );
+  remus::server::JobSpeculation jobSpeculation() const;
+
   //when you call start brokering the server will actually start accepting
   //worker and client requests.
   //IMPORTANT:
@@ -181,7 +265,7 @@ protected:
 
   //processes all client queries
   void DetermineClientResponse(zmq::socket_t& clientChannel,
-                               const zmq::SocketIdentity &clientIdentity,
+                               detail::SocketHandle clientIdentity,
                                zmq::socket_t& WorkerChannel);
 
   //These methods are all to do with sending responses to clients
@@ -189,22 +273,78 @@ protected:
   std::string canMesh(const remus::proto::Message& msg);
   std::string canMeshRequirements(const remus::proto::Message& msg);
   std::string meshRequirements(const remus::proto::Message& msg);
+  std::string cachedMeshRequirements(const remus::proto::Message& msg);
   std::string meshStatus(const remus::proto::Message& msg);
   std::string queueJob(const remus::proto::Message& msg);
+  std::string storeSubmissionChunk(zmq::socket_t& workerChannel,
+                                   const remus::proto::Message& msg);
+  std::string missingContent(const remus::proto::Message& msg);
   std::string retrieveResult(const remus::proto::Message& msg);
+  std::string retrieveResultChunk(const remus::proto::Message& msg);
   std::string terminateJob(zmq::socket_t& WorkerChannel,const remus::proto::Message& msg);
 
+  //parks the client until one of the jobs in the message reaches a terminal
+  //state or the requested timeout expires. If a job has already reached
+  //a terminal state the response is returned right away, otherwise an empty
+  //string is returned and the response is sent by AnswerWaitingClients
+  std::string waitForJobs(detail::SocketHandle clientIdentity,
+                          const remus::proto::Message& msg);
+
+  //send responses to all parked clients that had a watched job change
+  //or whose timeout has expired
+  void AnswerWaitingClients(zmq::socket_t& clientChannel);
+
+  //returns the requirements of the factory and the waiting workers
+  //that support the given mesh types
+  remus::proto::JobRequirementsSet
+  supportedRequirements(const remus::common::MeshIOType& type);
+
+  //returns the status of a job whether it is queued or active
+  remus::proto::JobStatus currentJobStatus(const boost::uuids::uuid& id);
+
+  //returns the serialized status of each job, in the same order as given
+  std::string currentJobStatuses(const std::vector<boost::uuids::uuid>& ids);
+
   //Methods for processing Worker queries
   void DetermineWorkerResponse(zmq::socket_t& clientChannel,
-                               const zmq::SocketIdentity &workerIdentity);
+                               detail::SocketHandle workerIdentity);
 
   //These methods are all to do with sending/recving to workers
   void storeMeshStatus(const remus::proto::Message& msg);
-  void storeMesh(const remus::proto::Message& msg);
+  void storeMesh(detail::SocketHandle workerIdentity,
+                 const remus::proto::Message& msg);
+  void updateJobStatus(const remus::proto::JobStatus& status);
+  void updateJobResult(detail::SocketHandle workerIdentity,
+                       const remus::proto::JobResult& result);
+  void storeMeshChunk(zmq::socket_t& workerChannel,
+                      detail::SocketHandle workerIdentity,
+                      const remus::proto::Message& msg);
   void assignJobToWorker(zmq::socket_t& workerChannel,
-                         const zmq::SocketIdentity &workerIdentity,
+                         detail::SocketHandle workerIdentity,
                          const remus::worker::Job& job);
 
+  //send the jobs, which share the same requirements, to the worker. More
+  //than one job is sent as a single JOB_BATCH message
+  void assignJobsToWorker(zmq::socket_t& workerChannel,
+                          detail::SocketHandle workerIdentity,
+                          const std::vector<remus::worker::Job>& jobs);
+
+  //mark the job as being given to the worker, and return the data of the
+  //message that sends it to that worker
+  std::string jobMessage(detail::SocketHandle workerIdentity,
+                         const remus::worker::Job& job);
+
+  //stream to the worker of a job the content we only sent a reference
+  //to, which the worker told us it doesn't hold
+  void resendMissingContent(zmq::socket_t& workerChannel,
+                            detail::SocketHandle workerIdentity,
+                            const remus::proto::Message& msg);
+
+  //send the worker of a job the spooled submission chunks it has
+  //credits for. Does nothing if the job hasn't been given to a worker
+  void ForwardSubmissionChunks(zmq::socket_t& workerChannel,
+                               const boost::uuids::uuid& id);
+
   //see if we have a worker in the pool for the next job in the queue,
   //otherwise ask the factory to generate a new worker to handle that job
   //virtual so that people using custom factories can decide the lifespan
@@ -213,6 +353,45 @@ protected:
   //of queued jobs and workers
   virtual void FindWorkerForQueuedJob(zmq::socket_t& workerChannel);
 
+  //take the next queued job with the given requirements, and give it to
+  //the waiting worker that holds the most of its content, along with a
+  //batch of further small jobs if the worker asked for several
+  void DispatchQueuedJobs(zmq::socket_t& workerChannel,
+                          const remus::proto::JobRequirements& reqs);
+
+  //hand queued jobs to the in process factory, if we have one, while
+  //it has free threads
+  void RunQueuedJobsInProcess();
+
+  //store the statuses and results the in process factory has collected
+  void StoreInProcessUpdates();
+
+  //start tracking the queue and run deadlines of a queued job, using the
+  //default timeouts of the factory for timeouts the job doesn't set
+  void TrackJobDeadlines(const boost::uuids::uuid& id,
+                         const remus::proto::JobSubmission& submission);
+
+  //fail the jobs whose deadlines have passed. Queued jobs are dropped
+  //before they are dispatched, and running jobs are terminated
+  void ExpireJobDeadlines(zmq::socket_t& workerChannel);
+
+  //put the jobs that were retried after their worker died back on the
+  //queue, once they have waited out their backoff
+  void RequeueRetriedJobs();
+
+  //send a copy of the jobs that run past most of their siblings to idle
+  //workers, while copies use less than their share of the workers
+  void SpeculateOnStragglers(zmq::socket_t& workerChannel);
+
+  //tell the workers that lost the race to finish a copied job to
+  //terminate it
+  void TerminateLosingCopies(zmq::socket_t& workerChannel);
+
+  //schedule when each piece of timed work of the broker is next due, so
+  //that the broker sleeps until the earliest of it, or until it has traffic
+  void ScheduleTimers(remus::common::TimerQueue& timers,
+                      const boost::posix_time::ptime& now);
+
   //terminate all workers that are doing jobs or waiting for jobs
   void TerminateAllWorkers(zmq::socket_t& workerChannel);
 
@@ -222,18 +401,35 @@ private:
   void operator=(const Server&);
 
   remus::server::ServerPorts PortInfo;
+  remus::server::JobBatching Batching;
+  remus::server::JobSpeculation Speculation;
 
 protected:
   //allow subclasses to override these detail containers
+  boost::scoped_ptr<remus::server::detail::SocketIdentities> Identities;
+  //the handle of the worker that jobs run by the InProcessFactory are given to
+  remus::server::detail::SocketHandle InProcessWorker;
+
   boost::scoped_ptr<remus::server::detail::JobQueue> QueuedJobs;
   boost::scoped_ptr<remus::server::detail::SocketMonitor> SocketMonitor;
   boost::scoped_ptr<remus::server::detail::WorkerPool> WorkerPool;
   boost::scoped_ptr<remus::server::detail::ActiveJobs> ActiveJobs;
+  boost::scoped_ptr<remus::server::detail::StreamedResults> StreamedResults;
+  boost::scoped_ptr<remus::server::detail::StreamedSubmissions> StreamedSubmissions;
+  boost::scoped_ptr<remus::server::detail::ContentStore> ContentStore;
+  boost::scoped_ptr<remus::server::detail::WaitingClients> WaitingClients;
+  boost::scoped_ptr<remus::server::detail::JobDeadlines> Deadlines;
+  boost::scoped_ptr<remus::server::detail::JobRetries> Retries;
+  boost::scoped_ptr<remus::server::detail::SpeculativeJobs> SpeculativeJobs;
+  boost::scoped_ptr<remus::server::detail::SupportCache> SupportCache;
   boost::scoped_ptr<detail::UUIDManagement> UUIDGenerator;
   boost::scoped_ptr<detail::ThreadManagement> Thread;
 
   //needs to be a shared_ptr since we can be passed in a WorkerFactoryBase
   boost::shared_ptr<remus::server::WorkerFactoryBase> WorkerFactory;
+
+  //the WorkerFactory when it runs jobs inside the server, otherwise empty
+  boost::shared_ptr<remus::server::InProcessWorkerFactory> InProcessFactory;
 };
 
 }
@@ -59,6 +59,12 @@ public:
   //will return -1
   int port() const { return this->Port; }
 
+  //returns true if only processes on this machine can connect to the
+  //endpoint. Like zmq::isLocalEndpoint only the loopback address is
+  //treated as local for tcp
+  bool isLocalEndpoint() const
+    { return this->Scheme != "tcp" || this->Host == "127.0.0.1"; }
+
 private:
   std::string Endpoint;
   std::string Host;
@@ -203,6 +203,7 @@ WorkerFactory::WorkerFactory(const std::string& ext):
   this->Tracker->PossibleWorkers.insert(this->Tracker->PossibleWorkers.end(),
                                         finder.begin(),
                                         finder.end());
+  this->registryChanged();
 }
 
 //----------------------------------------------------------------------------
@@ -296,6 +297,22 @@ unsigned int  WorkerFactory::currentWorkerCount() const
   return this->Tracker->CurrentProcesses.size();
 }
 
+//----------------------------------------------------------------------------
+boost::int64_t WorkerFactory::queueTimeout(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  const ValidWorker w = find_worker_path(reqs, this->Tracker->PossibleWorkers);
+  return w.valid ? w.spec.QueueTimeout : 0;
+}
+
+//----------------------------------------------------------------------------
+boost::int64_t WorkerFactory::runTimeout(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  const ValidWorker w = find_worker_path(reqs, this->Tracker->PossibleWorkers);
+  return w.valid ? w.spec.RunTimeout : 0;
+}
+
 //----------------------------------------------------------------------------
 bool WorkerFactory::addWorker(
   const FactoryWorkerSpecification& spec,
@@ -76,6 +76,13 @@ public:
 
   virtual unsigned int currentWorkerCount() const;
 
+  //return the QueueTimeout and RunTimeout of the worker file that matches
+  //the given requirements, or zero if no worker file matches
+  virtual boost::int64_t queueTimeout(
+                    const remus::proto::JobRequirements& reqs) const;
+  virtual boost::int64_t runTimeout(
+                    const remus::proto::JobRequirements& reqs) const;
+
   //return the worker file extension we have
   std::string workerExtension() const { return this->WorkerExtension;  }
 
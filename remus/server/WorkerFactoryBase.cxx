@@ -21,6 +21,7 @@ namespace server{
 //----------------------------------------------------------------------------
 WorkerFactoryBase::WorkerFactoryBase():
   MaxWorkers(1),
+  RegistryGeneration(0),
   WorkerEndpoint(),
   GlobalCommandLineArguments()
 {
@@ -33,12 +34,36 @@ WorkerFactoryBase::~WorkerFactoryBase()
 
 }
 
+//----------------------------------------------------------------------------
+void WorkerFactoryBase::setMaxWorkerCount(unsigned int count)
+{
+  if(count != this->MaxWorkers)
+    {
+    this->MaxWorkers = count;
+    this->registryChanged();
+    }
+}
+
 //----------------------------------------------------------------------------
 void WorkerFactoryBase::portForWorkersToUse(const remus::server::PortConnection& port)
 {
   this->WorkerEndpoint = port.endpoint();
 }
 
+//----------------------------------------------------------------------------
+boost::int64_t WorkerFactoryBase::queueTimeout(
+                        const remus::proto::JobRequirements&) const
+{
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+boost::int64_t WorkerFactoryBase::runTimeout(
+                        const remus::proto::JobRequirements&) const
+{
+  return 0;
+}
+
 }
 
 }
@@ -15,6 +15,7 @@
 
 #include <vector>
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <remus/common/MeshIOType.h>
@@ -85,13 +86,34 @@ public:
 
   virtual void updateWorkerCount() = 0;
 
+  //return the number of milliseconds a job with the given requirements can
+  //wait in the queue, or run on a worker, before the server fails it. Used
+  //for jobs that don't set their own timeouts. Zero, the default, means
+  //forever
+  virtual boost::int64_t queueTimeout(
+                    const remus::proto::JobRequirements& reqs) const;
+  virtual boost::int64_t runTimeout(
+                    const remus::proto::JobRequirements& reqs) const;
+
   //Set the maximum number of total workers that can be returning at once
-  void setMaxWorkerCount(unsigned int count){MaxWorkers = count;}
+  void setMaxWorkerCount(unsigned int count);
   unsigned int maxWorkerCount() const {return MaxWorkers;}
   virtual unsigned int currentWorkerCount() const =0;
 
+  //returns a counter that changes whenever the types and requirements the
+  //factory supports, or its max worker count, change. The server caches
+  //its answers to client queries about what it can mesh until it changes
+  virtual boost::uint64_t registryGeneration() const
+    { return this->RegistryGeneration; }
+
+protected:
+  //factories need to call this whenever the answers of supportedIOTypes,
+  //workerRequirements or haveSupport change
+  void registryChanged() { ++this->RegistryGeneration; }
+
 private:
   unsigned int MaxWorkers;
+  boost::uint64_t RegistryGeneration;
   std::string WorkerEndpoint;
 
   std::vector<std::string> GlobalCommandLineArguments;
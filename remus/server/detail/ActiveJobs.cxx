@@ -14,18 +14,27 @@
 
 #include <remus/server/detail/uuidHelper.h>
 
+#include <algorithm>
+
 namespace remus{
 namespace server{
 namespace detail{
 
 //-----------------------------------------------------------------------------
-ActiveJobs::JobState::JobState(const zmq::SocketIdentity& workerIdentity,
+ActiveJobs::JobState::JobState(SocketHandle workerIdentity,
          const boost::uuids::uuid& id,
          remus::STATUS_TYPE stat):
   WorkerAddress(workerIdentity),
   jstatus(id,stat),
   jresult(id),
-  haveResult(false)
+  jchunked(),
+  haveResult(false),
+  haveChunked(false),
+  jhasher(),
+  jhashed(0),
+  jchecksum(),
+  job(),
+  started(false)
 {
 
 }
@@ -43,7 +52,20 @@ bool ActiveJobs::JobState::canUpdateStatusTo(remus::proto::JobStatus s) const
 }
 
 //-----------------------------------------------------------------------------
-bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
+void ActiveJobs::JobState::markFinished(const boost::uuids::uuid& id)
+{
+  //once we get a result we can state our status is now finished,
+  //since the uploading of data has finished.
+  if( jstatus.status() != remus::FAILED )
+    {
+    const int retries = jstatus.retries();
+    jstatus = remus::proto::JobStatus(id,remus::FINISHED);
+    jstatus.retries(retries);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool ActiveJobs::add(SocketHandle workerIdentity,
                      const boost::uuids::uuid& id)
 {
   if(!this->haveUUID(id))
@@ -56,6 +78,54 @@ bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
   return false;
 }
 
+//-----------------------------------------------------------------------------
+bool ActiveJobs::add(SocketHandle workerIdentity,
+                     const remus::worker::Job& job)
+{
+  if(!this->haveUUID(job.id()))
+    {
+    JobState ws(workerIdentity,job.id(),remus::QUEUED);
+    ws.job = job;
+    InfoPair pair(job.id(),ws);
+    this->Info.insert(pair);
+    return true;
+    }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::markStarted(const boost::uuids::uuid& id)
+{
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
+    {
+    //we no longer need to hold onto the job, since it can't be requeued
+    item->second.started = true;
+    item->second.job = remus::worker::Job();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::markRetried(const boost::uuids::uuid& id, int retries)
+{
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
+    {
+    item->second.jstatus.retries(retries);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::reassign(const boost::uuids::uuid& id,
+                          SocketHandle workerIdentity)
+{
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
+    {
+    item->second.WorkerAddress = workerIdentity;
+    }
+}
+
 //-----------------------------------------------------------------------------
 bool ActiveJobs::remove(const boost::uuids::uuid& id)
 {
@@ -68,13 +138,13 @@ bool ActiveJobs::remove(const boost::uuids::uuid& id)
 }
 
 //-----------------------------------------------------------------------------
-zmq::SocketIdentity ActiveJobs::workerAddress(
+SocketHandle ActiveJobs::workerAddress(
                                           const boost::uuids::uuid& id) const
 {
   InfoConstIt item = this->Info.find(id);
   if(item == this->Info.end())
     {
-    return zmq::SocketIdentity();
+    return SocketHandle();
     }
   return item->second.WorkerAddress;
 }
@@ -105,11 +175,64 @@ const remus::proto::JobStatus& ActiveJobs::status(
 }
 
 //-----------------------------------------------------------------------------
-const remus::proto::JobResult& ActiveJobs::result(
-    const boost::uuids::uuid& id)
+remus::proto::JobResult ActiveJobs::result(const boost::uuids::uuid& id)
+{
+  InfoConstIt item = this->Info.find(id);
+  return item->second.haveChunked ? item->second.jchunked.join() :
+                                    item->second.jresult;
+}
+
+//-----------------------------------------------------------------------------
+bool ActiveJobs::haveChunkedResult(const boost::uuids::uuid& id) const
 {
   InfoConstIt item = this->Info.find(id);
-  return item->second.jresult;
+  return item != this->Info.end() && item->second.haveChunked;
+}
+
+//-----------------------------------------------------------------------------
+const ChunkedResult& ActiveJobs::chunkedResult(const boost::uuids::uuid& id)
+{
+  InfoConstIt item = this->Info.find(id);
+  return item->second.jchunked;
+}
+
+//-----------------------------------------------------------------------------
+std::string ActiveJobs::hashResult(const boost::uuids::uuid& id,
+                                   boost::uint64_t offset, std::size_t length)
+{
+  InfoIt item = this->Info.find(id);
+  if(item == this->Info.end() || !item->second.haveResult ||
+     item->second.haveChunked)
+    {
+    return std::string();
+    }
+
+  JobState& state = item->second;
+  if(!state.jhasher)
+    {
+    state.jhasher.reset(new remus::common::MD5Hasher());
+    state.jhashed = 0;
+    }
+
+  //clients ask for the chunks in order, but can ask for a chunk again.
+  //Anything a client skipped is fed before the chunk
+  const boost::uint64_t size = state.jresult.dataSize();
+  const boost::uint64_t end = std::min<boost::uint64_t>(offset + length, size);
+  if(end > state.jhashed)
+    {
+    state.jhasher->append(state.jresult.data() + state.jhashed,
+                          static_cast<std::size_t>(end - state.jhashed));
+    state.jhashed = end;
+    if(state.jhashed == size)
+      {
+      state.jchecksum = state.jhasher->hash();
+      }
+    }
+  else if(size == 0 && state.jchecksum.empty())
+    {
+    state.jchecksum = state.jhasher->hash();
+    }
+  return state.jhashed == size ? state.jchecksum : std::string();
 }
 
 //-----------------------------------------------------------------------------
@@ -121,8 +244,15 @@ void ActiveJobs::updateStatus(const remus::proto::JobStatus& s)
     {
     //we don't want the worker to ever explicitly state it has finished the
     //job. That is why we use canUpdateStatusTo, which checks the status
-    //we are moving too
+    //we are moving too. The worker doesn't know how often the job has
+    //been retried, so we keep our count
+    const int retries = item->second.jstatus.retries();
     item->second.jstatus = s;
+    item->second.jstatus.retries(retries);
+
+    //a worker sending status has started the job
+    item->second.started = true;
+    item->second.job = remus::worker::Job();
     }
 }
 
@@ -132,22 +262,42 @@ void ActiveJobs::updateResult(const remus::proto::JobResult& r)
   InfoIt item = this->Info.find(r.id());
   if(item != this->Info.end())
     {
-    //once we get a result we can state our status is now finished,
-    //since the uploading of data has finished.
-    if( item->second.jstatus.status() != remus::FAILED )
-      {
-      item->second.jstatus = remus::proto::JobStatus(r.id(),remus::FINISHED);
-      }
+    item->second.markFinished(r.id());
 
     //update the client result data to equal the server data
     item->second.jresult = r;
     item->second.haveResult = true;
+    item->second.jchunked = ChunkedResult();
+    item->second.haveChunked = false;
+    item->second.jhasher.reset();
+    item->second.jhashed = 0;
+    item->second.jchecksum.clear();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::updateResult(const boost::uuids::uuid& id,
+                              const ChunkedResult& r)
+{
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
+    {
+    item->second.markFinished(id);
+
+    //hold onto the chunks, the result is only joined for clients
+    //that don't stream it
+    item->second.jresult = remus::proto::JobResult(id);
+    item->second.jchunked = r;
+    item->second.haveResult = true;
+    item->second.haveChunked = true;
     }
 }
 
 //-----------------------------------------------------------------------------
-void ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
+std::set<boost::uuids::uuid>
+ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
 {
+  std::set<boost::uuids::uuid> expiredJobs;
   for(InfoIt item = this->Info.begin(); item != this->Info.end(); ++item)
     {
     //we can only mark jobs that are IN_PROGRESS or QUEUED as failed.
@@ -159,16 +309,46 @@ void ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
     if (is_status_valid_to_expire && worker_is_unresponsive)
       {
       //marking the job status as expired
+      const int retries = item->second.jstatus.retries();
       item->second.jstatus =
           remus::proto::JobStatus( item->second.jstatus.id(),remus::EXPIRED);
+      item->second.jstatus.retries(retries);
+      expiredJobs.insert(item->first);
+      }
+    }
+  return expiredJobs;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<remus::worker::Job>
+ActiveJobs::takeUnstartedJobs(remus::server::detail::SocketMonitor monitor)
+{
+  std::vector<remus::worker::Job> unstartedJobs;
+  InfoIt item = this->Info.begin();
+  while(item != this->Info.end())
+    {
+    //only jobs that the worker prefetched, and never started or sent a
+    //status for can be given to another worker
+    const bool is_unstarted = item->second.jstatus.queued() &&
+                              !item->second.started &&
+                              item->second.job.valid();
+    if(is_unstarted && monitor.isUnresponsive(item->second.WorkerAddress))
+      {
+      unstartedJobs.push_back(item->second.job);
+      this->Info.erase(item++);
+      }
+    else
+      {
+      ++item;
       }
     }
+  return unstartedJobs;
 }
 
 //-----------------------------------------------------------------------------
-std::set<zmq::SocketIdentity> ActiveJobs::activeWorkers() const
+std::set<SocketHandle> ActiveJobs::activeWorkers() const
 {
-  std::set<zmq::SocketIdentity> workerAddresses;
+  std::set<SocketHandle> workerAddresses;
   for(InfoConstIt item = this->Info.begin(); item != this->Info.end(); ++item)
     {
     workerAddresses.insert(item->second.WorkerAddress);
@@ -13,14 +13,21 @@
 #ifndef remus_server_detail_ActiveJobs_h
 #define remus_server_detail_ActiveJobs_h
 
+#include <remus/common/MD5Hash.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
-#include <remus/proto/zmqSocketIdentity.h>
 
+#include <remus/server/detail/SocketIdentities.h>
 #include <remus/server/detail/SocketMonitor.h>
+#include <remus/server/detail/StreamedResults.h>
+
+#include <remus/worker/Job.h>
+
+#include <boost/shared_ptr.hpp>
 
 #include <map>
 #include <set>
+#include <vector>
 
 namespace remus{
 namespace server{
@@ -31,12 +38,30 @@ class ActiveJobs
   public:
     ActiveJobs():Info(){}
 
-    bool add(const zmq::SocketIdentity& workerIdentity,
+    bool add(SocketHandle workerIdentity,
              const boost::uuids::uuid& id);
 
+    //add a job that can be given to another worker if its worker dies
+    //before starting it. We hold onto the job until it has started
+    bool add(SocketHandle workerIdentity,
+             const remus::worker::Job& job);
+
+    //mark that the worker has taken the job and started working on it.
+    //Until then the job has only been prefetched by the worker
+    void markStarted(const boost::uuids::uuid& id);
+
+    //record the number of times the job has been requeued after its
+    //worker died. It is reported with every status of the job
+    void markRetried(const boost::uuids::uuid& id, int retries);
+
+    //move the job to another worker, which is then the worker whose
+    //heartbeats decide if the job has expired
+    void reassign(const boost::uuids::uuid& id,
+                  SocketHandle workerIdentity);
+
     bool remove(const boost::uuids::uuid& id);
 
-    zmq::SocketIdentity workerAddress(const boost::uuids::uuid& id) const;
+    SocketHandle workerAddress(const boost::uuids::uuid& id) const;
 
     bool haveUUID(const boost::uuids::uuid& id) const;
 
@@ -45,8 +70,21 @@ class ActiveJobs
     //returns a worker side job status object for a job
     const remus::proto::JobStatus& status(const boost::uuids::uuid& id);
 
-    //returns a worker side job result object for a job
-    const remus::proto::JobResult& result(const boost::uuids::uuid& id);
+    //returns a worker side job result object for a job. A result that was
+    //streamed to us is joined into a single result
+    remus::proto::JobResult result(const boost::uuids::uuid& id);
+
+    //returns true if the result of the job was streamed to us, in which
+    //case it is held as the chunks it was streamed in
+    bool haveChunkedResult(const boost::uuids::uuid& id) const;
+    const ChunkedResult& chunkedResult(const boost::uuids::uuid& id);
+
+    //feeds the part of a result that isn't chunked that is about to be
+    //streamed to a client into the checksum of the result, so the result
+    //isn't read a second time for the final chunk. Returns the checksum
+    //once all of the result has been fed, otherwise an empty string
+    std::string hashResult(const boost::uuids::uuid& id,
+                           boost::uint64_t offset, std::size_t length);
 
     //update the job status of a job.
     //valid values are:
@@ -59,24 +97,50 @@ class ActiveJobs
     void updateStatus(const remus::proto::JobStatus& s);
 
     void updateResult(const remus::proto::JobResult& r);
+    void updateResult(const boost::uuids::uuid& id, const ChunkedResult& r);
+
+    //marks all queued or in progress jobs whose worker is unresponsive
+    //as EXPIRED. Returns the ids of the jobs that were just expired
+    std::set<boost::uuids::uuid>
+    markExpiredJobs(remus::server::detail::SocketMonitor monitor);
 
-    void markExpiredJobs(remus::server::detail::SocketMonitor monitor);
+    //removes and returns all the jobs whose worker is unresponsive, that
+    //the worker never started, and that were added with the job so they
+    //can be requeued. Must be called before markExpiredJobs, otherwise
+    //these jobs are marked as EXPIRED
+    std::vector<remus::worker::Job>
+    takeUnstartedJobs(remus::server::detail::SocketMonitor monitor);
 
-    std::set<zmq::SocketIdentity> activeWorkers() const;
+    std::set<SocketHandle> activeWorkers() const;
 
 private:
     struct JobState
     {
-      zmq::SocketIdentity WorkerAddress;
+      SocketHandle WorkerAddress;
       remus::proto::JobStatus jstatus;
       remus::proto::JobResult jresult;
+      ChunkedResult jchunked;
       bool haveResult;
+      bool haveChunked;
 
-      JobState(const zmq::SocketIdentity& workerIdentity,
+      //the checksum of jresult as it is streamed to the client
+      boost::shared_ptr<remus::common::MD5Hasher> jhasher;
+      boost::uint64_t jhashed;
+      std::string jchecksum;
+
+      //the job we sent to the worker, held so it can be requeued until
+      //the worker has started it. Is invalid when it can't be requeued
+      remus::worker::Job job;
+      bool started;
+
+      JobState(SocketHandle workerIdentity,
                const boost::uuids::uuid& id,
                remus::STATUS_TYPE stat);
 
       bool canUpdateStatusTo(remus::proto::JobStatus s) const;
+
+      //the job has finished, unless it has already failed
+      void markFinished(const boost::uuids::uuid& id);
     };
 
     typedef std::pair<boost::uuids::uuid, JobState> InfoPair;
@@ -0,0 +1,126 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ContentStore.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+ContentStore::ContentStore():
+  Contents(),
+  References()
+{
+}
+
+//------------------------------------------------------------------------------
+bool ContentStore::have(const std::string& digest) const
+{
+  return this->Contents.count(digest) != 0;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ContentDigests
+ContentStore::missing(const remus::proto::ContentDigests& digests) const
+{
+  remus::proto::ContentDigests result;
+  typedef remus::proto::ContentDigests::const_iterator DigestIt;
+  for(DigestIt i = digests.begin(); i != digests.end(); ++i)
+    {
+    if(!this->have(i->second))
+      {
+      result.insert(*i);
+      }
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void ContentStore::add(const boost::uuids::uuid& id,
+                       const remus::proto::JobContent& content)
+{
+  content.verifyHash();
+  const std::string& digest = content.hash();
+  It item = this->Contents.find(digest);
+  if(item == this->Contents.end())
+    {
+    StoredContent stored;
+    stored.Content = content;
+    item = this->Contents.insert(std::make_pair(digest, stored)).first;
+    }
+
+  item->second.Jobs.insert(id);
+  this->References[id].insert(digest);
+}
+
+//------------------------------------------------------------------------------
+bool ContentStore::retain(const boost::uuids::uuid& id,
+                          const std::string& digest,
+                          remus::common::ContentFormat::Type format,
+                          remus::proto::JobContent& content)
+{
+  It item = this->Contents.find(digest);
+  if(item == this->Contents.end() ||
+     item->second.Content.formatType() != format)
+    {
+    return false;
+    }
+
+  item->second.Jobs.insert(id);
+  this->References[id].insert(digest);
+  content = item->second.Content;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ContentStore::find(const std::string& digest,
+                        remus::proto::JobContent& content) const
+{
+  ConstIt item = this->Contents.find(digest);
+  if(item == this->Contents.end())
+    {
+    return false;
+    }
+  content = item->second.Content;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ContentStore::release(const boost::uuids::uuid& id)
+{
+  std::map<boost::uuids::uuid, std::set<std::string> >::iterator refs =
+                                                  this->References.find(id);
+  if(refs == this->References.end())
+    {
+    return;
+    }
+
+  typedef std::set<std::string>::const_iterator DigestIt;
+  for(DigestIt i = refs->second.begin(); i != refs->second.end(); ++i)
+    {
+    It item = this->Contents.find(*i);
+    if(item != this->Contents.end())
+      {
+      item->second.Jobs.erase(id);
+      if(item->second.Jobs.empty())
+        {
+        this->Contents.erase(item);
+        }
+      }
+    }
+  this->References.erase(refs);
+}
+
+}
+}
+}
@@ -0,0 +1,95 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_ContentStore_h
+#define remus_server_detail_ContentStore_h
+
+#include <remus/proto/JobContent.h>
+
+#include <boost/uuid/uuid.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Holds large submission content keyed by the digest of the content, so
+//that clients submitting the same content for many jobs only upload it
+//once. Every queued or active job that uses a piece of content holds a
+//reference to it, and the content is dropped once no job references it.
+//The content is shared with the jobs, so no copy of the data is made, and
+//content that was streamed to us stays in its mapped spool file.
+class ContentStore
+{
+public:
+  ContentStore();
+
+  //returns true if we hold content with the given digest
+  bool have(const std::string& digest) const;
+
+  //returns the entries of digests whose content we don't hold
+  remus::proto::ContentDigests missing(
+                          const remus::proto::ContentDigests& digests) const;
+
+  //store the content under its digest, with a reference to it held by
+  //the given job. If we already hold the content only the reference is added.
+  //A digest that was computed by the sender is verified first, so content
+  //is always stored under the digest of its data
+  void add(const boost::uuids::uuid& id,
+           const remus::proto::JobContent& content);
+
+  //find the content with the given digest and format, and add a reference to
+  //it held by the given job. Returns false if we don't hold that content
+  bool retain(const boost::uuids::uuid& id,
+              const std::string& digest,
+              remus::common::ContentFormat::Type format,
+              remus::proto::JobContent& content);
+
+  //find the content with the given digest without adding a reference
+  //to it. Returns false if we don't hold that content
+  bool find(const std::string& digest,
+            remus::proto::JobContent& content) const;
+
+  //drop every reference the given job holds, removing the content
+  //that is no longer referenced by any job
+  void release(const boost::uuids::uuid& id);
+
+  //returns the number of pieces of content we hold
+  std::size_t size() const { return this->Contents.size(); }
+
+private:
+  //explicitly state the class doesn't support copy or move semantics
+  ContentStore(const ContentStore&);
+  void operator=(const ContentStore&);
+
+  struct StoredContent
+  {
+    remus::proto::JobContent Content;
+    std::set<boost::uuids::uuid> Jobs;
+  };
+
+  typedef std::map<std::string, StoredContent>::const_iterator ConstIt;
+  typedef std::map<std::string, StoredContent>::iterator It;
+  std::map<std::string, StoredContent> Contents;
+
+  //the digests each job holds a reference to
+  std::map<boost::uuids::uuid, std::set<std::string> > References;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,134 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobDeadlines.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+JobDeadlines::JobDeadlines():
+  Timers(),
+  Jobs()
+{
+}
+
+//------------------------------------------------------------------------------
+void JobDeadlines::add(const boost::uuids::uuid& id,
+                       boost::int64_t queueTimeout,
+                       boost::int64_t runTimeout,
+                       const boost::posix_time::ptime& now)
+{
+  this->remove(id);
+  if(queueTimeout <= 0 && runTimeout <= 0)
+    {
+    return;
+    }
+
+  Entry entry;
+  entry.RunTimeout = std::max(runTimeout, boost::int64_t(0));
+  entry.Type = QUEUE;
+  entry.HasTimer = false;
+  It job = this->Jobs.insert(std::make_pair(id, entry)).first;
+  if(queueTimeout > 0)
+    {
+    this->schedule(job, QUEUE,
+                   now + boost::posix_time::milliseconds(queueTimeout));
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobDeadlines::dispatched(const boost::uuids::uuid& id,
+                              const boost::posix_time::ptime& now)
+{
+  It job = this->Jobs.find(id);
+  if(job == this->Jobs.end())
+    {
+    return;
+    }
+
+  this->unschedule(job);
+  if(job->second.RunTimeout <= 0)
+    { //without a run deadline there is nothing left to track
+    this->Jobs.erase(job);
+    return;
+    }
+  this->schedule(job, RUN,
+                 now + boost::posix_time::milliseconds(job->second.RunTimeout));
+}
+
+//------------------------------------------------------------------------------
+void JobDeadlines::remove(const boost::uuids::uuid& id)
+{
+  It job = this->Jobs.find(id);
+  if(job != this->Jobs.end())
+    {
+    this->unschedule(job);
+    this->Jobs.erase(job);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<JobDeadlines::Expired>
+JobDeadlines::takeExpired(const boost::posix_time::ptime& now)
+{
+  std::vector<Expired> expired;
+  while(!this->Timers.empty() && this->Timers.begin()->first <= now)
+    {
+    It job = this->Jobs.find(this->Timers.begin()->second);
+    expired.push_back( Expired(job->first, job->second.Type) );
+    this->Timers.erase(this->Timers.begin());
+    this->Jobs.erase(job);
+    }
+  return expired;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t JobDeadlines::millisecondsToNextDeadline(
+                                    const boost::posix_time::ptime& now,
+                                    boost::int64_t max_milliseconds) const
+{
+  boost::int64_t result = max_milliseconds;
+  if(!this->Timers.empty())
+    {
+    const boost::int64_t remaining =
+                      (this->Timers.begin()->first - now).total_milliseconds();
+    result = std::min(result, remaining);
+    }
+  return std::max(result, boost::int64_t(0));
+}
+
+//------------------------------------------------------------------------------
+void JobDeadlines::schedule(It job, DeadlineType type,
+                            const boost::posix_time::ptime& when)
+{
+  job->second.Type = type;
+  job->second.HasTimer = true;
+  job->second.Timer = this->Timers.insert(std::make_pair(when, job->first));
+}
+
+//------------------------------------------------------------------------------
+void JobDeadlines::unschedule(It job)
+{
+  if(job->second.HasTimer)
+    {
+    this->Timers.erase(job->second.Timer);
+    job->second.HasTimer = false;
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,101 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobDeadlines_h
+#define remus_server_detail_JobDeadlines_h
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <map>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Holds the deadlines of jobs, ordered by when they pass. A job can have a
+//deadline for how long it waits in the queue, and one for how long it runs
+//once it has been given to a worker. The run deadline only starts once the
+//job is dispatched, which also drops the queue deadline.
+class JobDeadlines
+{
+public:
+  enum DeadlineType {QUEUE, RUN};
+
+  struct Expired
+  {
+    boost::uuids::uuid Id;
+    DeadlineType Type;
+
+    Expired(const boost::uuids::uuid& id, DeadlineType type):
+      Id(id), Type(type) {}
+  };
+
+  JobDeadlines();
+
+  //track a queued job that can wait in the queue for queueTimeout
+  //milliseconds, and run for runTimeout milliseconds. A timeout of zero
+  //is forever. Jobs without any timeout aren't tracked
+  void add(const boost::uuids::uuid& id,
+           boost::int64_t queueTimeout,
+           boost::int64_t runTimeout,
+           const boost::posix_time::ptime& now);
+
+  //state that the job was given to a worker, so it no longer has a queue
+  //deadline, and its run deadline starts now. A job that is dispatched
+  //again restarts its run deadline
+  void dispatched(const boost::uuids::uuid& id,
+                  const boost::posix_time::ptime& now);
+
+  //stop tracking the job
+  void remove(const boost::uuids::uuid& id);
+
+  //remove and return every job whose deadline is at or before now, in
+  //the order the deadlines passed
+  std::vector<Expired> takeExpired(const boost::posix_time::ptime& now);
+
+  //returns the number of milliseconds until the earliest deadline, clamped
+  //to be between 0 and the passed in max value
+  boost::int64_t millisecondsToNextDeadline(const boost::posix_time::ptime& now,
+                                            boost::int64_t max_milliseconds) const;
+
+  //returns the number of jobs we track
+  std::size_t size() const { return this->Jobs.size(); }
+  bool empty() const { return this->Jobs.empty(); }
+
+private:
+  typedef std::multimap<boost::posix_time::ptime,
+                        boost::uuids::uuid> TimerMap;
+
+  struct Entry
+  {
+    boost::int64_t RunTimeout;
+    DeadlineType Type;
+    bool HasTimer;
+    TimerMap::iterator Timer;
+  };
+  typedef std::map<boost::uuids::uuid, Entry>::iterator It;
+
+  void schedule(It job, DeadlineType type, const boost::posix_time::ptime& when);
+  void unschedule(It job);
+
+  TimerMap Timers;
+  std::map<boost::uuids::uuid, Entry> Jobs;
+};
+
+}
+}
+}
+
+#endif
@@ -76,6 +76,40 @@ remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
   return job;
 }
 
+//------------------------------------------------------------------------------
+remus::worker::Job JobQueue::peekJob(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  typedef std::vector<QueuedJob>::const_iterator iter;
+
+  JobTypeMatches pred(reqs);
+  iter item = std::find_if(this->QueuedJobsForWorkers.begin(),
+                           this->QueuedJobsForWorkers.end(),
+                           pred);
+  if(item != this->QueuedJobsForWorkers.end())
+    {
+    return remus::worker::Job(item->Id,item->Submission);
+    }
+
+  item = std::find_if(this->QueuedJobs.begin(), this->QueuedJobs.end(), pred);
+  if(item != this->QueuedJobs.end())
+    {
+    return remus::worker::Job(item->Id,item->Submission);
+    }
+  return remus::worker::Job();
+}
+
+//------------------------------------------------------------------------------
+std::size_t JobQueue::numJobs(const remus::proto::JobRequirements& reqs) const
+{
+  JobTypeMatches pred(reqs);
+  return static_cast<std::size_t>(
+          std::count_if(this->QueuedJobsForWorkers.begin(),
+                        this->QueuedJobsForWorkers.end(), pred) +
+          std::count_if(this->QueuedJobs.begin(), this->QueuedJobs.end(),
+                        pred));
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobRequirementsSet JobQueue::waitingJobRequirements() const
 {
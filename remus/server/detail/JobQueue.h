@@ -53,6 +53,13 @@ public:
   //workers, and than take jobs that are just queued.
   remus::worker::Job takeJob(const remus::proto::JobRequirements& reqs);
 
+  //returns the job that takeJob would remove for the given mesh type,
+  //without removing it. Returns an invalid job if there is none
+  remus::worker::Job peekJob(const remus::proto::JobRequirements& reqs) const;
+
+  //return the number of queued and waiting for worker jobs of a mesh type
+  std::size_t numJobs(const remus::proto::JobRequirements& reqs) const;
+
   //returns the types of jobs that are waiting for a worker
   remus::proto::JobRequirementsSet waitingJobRequirements() const;
 
@@ -0,0 +1,165 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobRetries.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+JobRetries::JobRetries():
+  Timers(),
+  Jobs()
+{
+}
+
+//------------------------------------------------------------------------------
+void JobRetries::add(const boost::uuids::uuid& id,
+                     const remus::proto::JobSubmission& submission,
+                     const remus::proto::StreamedKeys& streamedKeys)
+{
+  this->remove(id);
+  if(submission.retryLimit() <= 0)
+    {
+    return;
+    }
+
+  Entry entry;
+  entry.Submission = submission;
+  entry.Missing = streamedKeys;
+  entry.Retries = 0;
+  entry.Waiting = false;
+  this->Jobs.insert(std::make_pair(id, entry));
+}
+
+//------------------------------------------------------------------------------
+void JobRetries::content(const boost::uuids::uuid& id,
+                         const std::string& key,
+                         const remus::proto::JobContent& content)
+{
+  It job = this->Jobs.find(id);
+  if(job == this->Jobs.end() || job->second.Missing.erase(key) == 0)
+    {
+    return;
+    }
+
+  remus::proto::JobContent& placeholder = job->second.Submission[key];
+  remus::proto::JobContent arrived = content;
+  arrived.tag(placeholder.tag());
+  placeholder = arrived;
+}
+
+//------------------------------------------------------------------------------
+bool JobRetries::retry(const boost::uuids::uuid& id,
+                       const boost::posix_time::ptime& now)
+{
+  It job = this->Jobs.find(id);
+  if(job == this->Jobs.end())
+    {
+    return false;
+    }
+
+  Entry& entry = job->second;
+  if(entry.Waiting)
+    {
+    return true;
+    }
+  if(entry.Retries >= entry.Submission.retryLimit() || !entry.Missing.empty())
+    {
+    this->Jobs.erase(job);
+    return false;
+    }
+
+  //the backoff doubles with every retry, stopping before it overflows
+  boost::int64_t backoff = entry.Submission.retryBackoff();
+  for(int i=0; i < entry.Retries && backoff <= (boost::int64_t(1) << 40); ++i)
+    {
+    backoff *= 2;
+    }
+
+  ++entry.Retries;
+  entry.Waiting = true;
+  entry.Timer = this->Timers.insert(std::make_pair(
+                        now + boost::posix_time::milliseconds(backoff), id));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool JobRetries::have(const boost::uuids::uuid& id) const
+{
+  return this->Jobs.count(id) != 0;
+}
+
+//------------------------------------------------------------------------------
+bool JobRetries::waiting(const boost::uuids::uuid& id) const
+{
+  ConstIt job = this->Jobs.find(id);
+  return job != this->Jobs.end() && job->second.Waiting;
+}
+
+//------------------------------------------------------------------------------
+int JobRetries::retries(const boost::uuids::uuid& id) const
+{
+  ConstIt job = this->Jobs.find(id);
+  return (job != this->Jobs.end()) ? job->second.Retries : 0;
+}
+
+//------------------------------------------------------------------------------
+void JobRetries::remove(const boost::uuids::uuid& id)
+{
+  It job = this->Jobs.find(id);
+  if(job != this->Jobs.end())
+    {
+    if(job->second.Waiting)
+      {
+      this->Timers.erase(job->second.Timer);
+      }
+    this->Jobs.erase(job);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::worker::Job>
+JobRetries::takeReady(const boost::posix_time::ptime& now)
+{
+  std::vector<remus::worker::Job> ready;
+  while(!this->Timers.empty() && this->Timers.begin()->first <= now)
+    {
+    It job = this->Jobs.find(this->Timers.begin()->second);
+    job->second.Waiting = false;
+    ready.push_back( remus::worker::Job(job->first, job->second.Submission) );
+    this->Timers.erase(this->Timers.begin());
+    }
+  return ready;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t JobRetries::millisecondsToNextRetry(
+                                    const boost::posix_time::ptime& now,
+                                    boost::int64_t max_milliseconds) const
+{
+  boost::int64_t result = max_milliseconds;
+  if(!this->Timers.empty())
+    {
+    const boost::int64_t remaining =
+                      (this->Timers.begin()->first - now).total_milliseconds();
+    result = std::min(result, remaining);
+    }
+  return std::max(result, boost::int64_t(0));
+}
+
+}
+}
+}
@@ -0,0 +1,107 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobRetries_h
+#define remus_server_detail_JobRetries_h
+
+#include <remus/proto/DataChunk.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/worker/Job.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <map>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Holds the submissions of jobs that can be requeued when the worker running
+//them dies, and how many times each has been requeued. Streamed content is
+//held as the mapped spool file of the server, not as a copy in memory. A job that is
+//retried waits out its backoff before it is put back on the queue, and the
+//backoff doubles with every retry.
+class JobRetries
+{
+public:
+  JobRetries();
+
+  //hold onto the submission of a job that was just queued. Jobs whose
+  //retry limit is zero aren't tracked. The content listed in streamedKeys
+  //hasn't arrived yet, and the job can't be retried until it has
+  void add(const boost::uuids::uuid& id,
+           const remus::proto::JobSubmission& submission,
+           const remus::proto::StreamedKeys& streamedKeys);
+
+  //fill in the streamed content of a key once all of it has arrived
+  void content(const boost::uuids::uuid& id,
+               const std::string& key,
+               const remus::proto::JobContent& content);
+
+  //the worker running the job died. If the job has retries left, and we
+  //hold all of its content, it waits out its backoff and true is returned.
+  //Otherwise we stop tracking the job
+  bool retry(const boost::uuids::uuid& id,
+             const boost::posix_time::ptime& now);
+
+  //returns true if we track the job, so it can still be retried
+  bool have(const boost::uuids::uuid& id) const;
+
+  //returns true if the job is waiting out its backoff
+  bool waiting(const boost::uuids::uuid& id) const;
+
+  //returns the number of times the job has been retried
+  int retries(const boost::uuids::uuid& id) const;
+
+  //stop tracking the job
+  void remove(const boost::uuids::uuid& id);
+
+  //return the jobs whose backoff is at or before now, so that they can
+  //be put back on the queue. We keep tracking them
+  std::vector<remus::worker::Job> takeReady(const boost::posix_time::ptime& now);
+
+  //returns the number of milliseconds until the earliest backoff ends,
+  //clamped to be between 0 and the passed in max value
+  boost::int64_t millisecondsToNextRetry(const boost::posix_time::ptime& now,
+                                         boost::int64_t max_milliseconds) const;
+
+  //returns the number of jobs we track
+  std::size_t size() const { return this->Jobs.size(); }
+  bool empty() const { return this->Jobs.empty(); }
+
+private:
+  typedef std::multimap<boost::posix_time::ptime,
+                        boost::uuids::uuid> TimerMap;
+
+  struct Entry
+  {
+    remus::proto::JobSubmission Submission;
+    remus::proto::StreamedKeys Missing;
+    int Retries;
+    bool Waiting;
+    TimerMap::iterator Timer;
+  };
+  typedef std::map<boost::uuids::uuid, Entry>::iterator It;
+  typedef std::map<boost::uuids::uuid, Entry>::const_iterator ConstIt;
+
+  TimerMap Timers;
+  std::map<boost::uuids::uuid, Entry> Jobs;
+};
+
+}
+}
+}
+
+#endif
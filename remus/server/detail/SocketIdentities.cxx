@@ -0,0 +1,149 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/SocketIdentities.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+//------------------------------------------------------------------------------
+inline boost::uint32_t slotOf(SocketHandle handle)
+{
+  return static_cast<boost::uint32_t>(handle & 0xFFFFFFFFu);
+}
+
+//------------------------------------------------------------------------------
+inline boost::uint32_t generationOf(SocketHandle handle)
+{
+  return static_cast<boost::uint32_t>(handle >> 32);
+}
+
+//------------------------------------------------------------------------------
+inline SocketHandle make_Handle(boost::uint32_t slot,
+                                boost::uint32_t generation)
+{
+  return (static_cast<SocketHandle>(generation) << 32) | slot;
+}
+}
+
+//------------------------------------------------------------------------------
+SocketIdentities::SocketIdentities():
+  Slots(),
+  FreeSlots(),
+  Handles()
+{
+  Slot empty;
+  empty.Channel = CLIENT;
+  empty.Generation = 0;
+  empty.References = 0;
+  this->Slots.push_back(empty);
+}
+
+//------------------------------------------------------------------------------
+SocketHandle SocketIdentities::intern(ChannelType channel,
+                                      const zmq::SocketIdentity& identity)
+{
+  if(identity.size() == 0)
+    { //the empty identity isn't counted, it is never removed
+    return SocketHandle(0);
+    }
+
+  const KeyType key(channel, std::string(identity.data(), identity.size()));
+  std::map<KeyType, SocketHandle>::const_iterator i = this->Handles.find(key);
+  if(i != this->Handles.end())
+    {
+    ++this->Slots[slotOf(i->second)].References;
+    return i->second;
+    }
+
+  boost::uint32_t slot = 0;
+  if(this->FreeSlots.empty())
+    {
+    slot = static_cast<boost::uint32_t>(this->Slots.size());
+    Slot added;
+    added.Generation = 0;
+    this->Slots.push_back(added);
+    }
+  else
+    {
+    slot = this->FreeSlots.back();
+    this->FreeSlots.pop_back();
+    }
+  this->Slots[slot].Identity = identity;
+  this->Slots[slot].Channel = channel;
+  this->Slots[slot].References = 1;
+
+  const SocketHandle handle = make_Handle(slot, this->Slots[slot].Generation);
+  this->Handles.insert(std::make_pair(key, handle));
+  return handle;
+}
+
+//------------------------------------------------------------------------------
+void SocketIdentities::retain(SocketHandle handle)
+{
+  if(handle != SocketHandle(0) && this->find(handle) != NULL)
+    {
+    ++this->Slots[slotOf(handle)].References;
+    }
+}
+
+//------------------------------------------------------------------------------
+const zmq::SocketIdentity& SocketIdentities::resolve(SocketHandle handle) const
+{
+  const Slot* slot = this->find(handle);
+  return slot ? slot->Identity : this->Slots.front().Identity;
+}
+
+//------------------------------------------------------------------------------
+void SocketIdentities::release(SocketHandle handle)
+{
+  if(handle == SocketHandle(0) || this->find(handle) == NULL)
+    {
+    return;
+    }
+
+  const boost::uint32_t index = slotOf(handle);
+  Slot& slot = this->Slots[index];
+  if(--slot.References > 0)
+    {
+    return;
+    }
+  this->Handles.erase(KeyType(slot.Channel,
+                      std::string(slot.Identity.data(), slot.Identity.size())));
+
+  //bumping the generation is what stops the released handle from
+  //resolving to the next identity that gets this slot
+  slot.Identity = zmq::SocketIdentity();
+  ++slot.Generation;
+  this->FreeSlots.push_back(index);
+}
+
+//------------------------------------------------------------------------------
+const SocketIdentities::Slot* SocketIdentities::find(SocketHandle handle) const
+{
+  const boost::uint32_t index = slotOf(handle);
+  if(index >= this->Slots.size())
+    {
+    return NULL;
+    }
+
+  const Slot& slot = this->Slots[index];
+  const bool inUse = index == 0 || slot.Identity.size() > 0;
+  return (inUse && slot.Generation == generationOf(handle)) ? &slot : NULL;
+}
+
+}
+}
+}
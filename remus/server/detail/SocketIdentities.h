@@ -0,0 +1,110 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_SocketIdentities_h
+#define remus_server_detail_SocketIdentities_h
+
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <boost/cstdint.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//a compact handle to the identity of a socket that talks to the server.
+//The low 32 bits are the slot the identity is held in, and the high 32 bits
+//the generation of that slot. The handle is 64 bits so that the generation
+//gets a full 32 bits: a 16 bit generation would wrap after 65536 clients
+//reused a slot, which a busy server reaches quickly, and a handle that was
+//held across the wrap would then resolve to another socket. Server.h
+//forward declares this typedef, and has to match it.
+typedef boost::uint64_t SocketHandle;
+
+//Interns the identities of the sockets that talk to the server, so that
+//the bookkeeping of the server only holds handles, which are cheap to copy
+//and compare. Identities are interned when a message is received, and only
+//resolved back to their bytes when we send to the socket.
+//The client and worker ROUTER sockets pick their identities independently,
+//so the same bytes can be a client and a worker at once. Identities are
+//therefore held per channel, and each gets its own handle.
+//The empty identity is always handle zero, so a default constructed handle
+//refers to no socket.
+//Every handle is reference counted. Interning takes a reference for the
+//message being handled, and anything that holds onto the handle past that
+//message retains its own. Once the last reference is released, the slot
+//is reused for the next identity we intern. Every reuse bumps the
+//generation of the slot, so a handle that is held after it was released
+//resolves to the empty identity instead of another socket.
+class SocketIdentities
+{
+public:
+  enum ChannelType {CLIENT, WORKER};
+
+  SocketIdentities();
+
+  //returns the handle of the identity on the channel, and takes a reference
+  //to it. The identity is added to the table the first time we see it, or
+  //the first time since it was released
+  SocketHandle intern(ChannelType channel,
+                      const zmq::SocketIdentity& identity);
+
+  //take another reference to the handle. Retaining the empty identity,
+  //or a handle that was released, does nothing
+  void retain(SocketHandle handle);
+
+  //returns the identity of the handle. Unknown and released handles
+  //resolve to the empty identity. The returned identity stays valid
+  //until the handle is released
+  const zmq::SocketIdentity& resolve(SocketHandle handle) const;
+
+  //drop a reference to the handle. Once the last one is dropped the
+  //identity is removed, so that its slot can be reused. Releasing the
+  //empty identity, or a handle that was already released, does nothing
+  void release(SocketHandle handle);
+
+  //returns the number of identities we hold, including the
+  //empty identity
+  std::size_t size() const { return this->Handles.size() + 1; }
+
+private:
+  struct Slot
+  {
+    zmq::SocketIdentity Identity;
+    ChannelType Channel;
+    boost::uint32_t Generation;
+    boost::uint32_t References;
+  };
+
+  //returns the slot the handle refers to, or NULL if the handle
+  //is unknown or was released
+  const Slot* find(SocketHandle handle) const;
+
+  typedef std::pair<ChannelType, std::string> KeyType;
+
+  //a deque so that resolved identities stay valid as we intern more
+  std::deque<Slot> Slots;
+  std::vector<boost::uint32_t> FreeSlots;
+  std::map<KeyType, SocketHandle> Handles;
+};
+
+}
+}
+}
+
+#endif
@@ -32,22 +32,34 @@ class SocketMonitor::WorkerTracker
 {
   typedef boost::posix_time::ptime ptime;
 
+  typedef std::multimap< ptime, SocketHandle > ExpiryMap;
+
   struct BeatInfo
     {
+    BeatInfo(): Duration(0), LastOccurrence(), HasExpiry(false), Expiry() {}
+
     boost::int64_t Duration;
     ptime LastOccurrence;
+    bool HasExpiry;
+    ExpiryMap::iterator Expiry;
     };
 
 public:
   remus::common::PollingMonitor PollMonitor;
 
-  std::map< zmq::SocketIdentity, BeatInfo > HeartBeats;
+  std::map< SocketHandle, BeatInfo > HeartBeats;
+
+  //when each socket misses its heartbeat, ordered so that we can find
+  //the next one without visiting every socket
+  ExpiryMap Expiries;
 
-  typedef std::pair< zmq::SocketIdentity, BeatInfo > InsertType;
-  typedef std::map< zmq::SocketIdentity, BeatInfo >::iterator IteratorType;
+  typedef std::pair< SocketHandle, BeatInfo > InsertType;
+  typedef std::map< SocketHandle, BeatInfo >::iterator IteratorType;
 
   WorkerTracker( remus::common::PollingMonitor p):
-    PollMonitor(p)
+    PollMonitor(p),
+    HeartBeats(),
+    Expiries()
   {}
 
   //----------------------------------------------------------------------------
@@ -55,11 +67,11 @@ public:
 
 
   //----------------------------------------------------------------------------
-  bool exists( const zmq::SocketIdentity& socket ) const
+  bool exists( SocketHandle socket ) const
     { return this->HeartBeats.count(socket) > 0; }
 
   //----------------------------------------------------------------------------
-  void refresh(const zmq::SocketIdentity& socket)
+  void refresh(SocketHandle socket)
   {
     //insert a new item if it doesn't exist, otherwise get the beatInfo already
     //in the map
@@ -79,10 +91,11 @@ public:
     //decoding a message that is really large we don't want to mark it as
     //expired, so we always use our max time out
     beat.Duration = std::max( beat.Duration, PollMonitor.maxTimeOut() );
+    this->updateExpiry(iter);
   }
 
   //----------------------------------------------------------------------------
-  void heartbeat( const zmq::SocketIdentity& socket, boost::int64_t dur )
+  void heartbeat( SocketHandle socket, boost::int64_t dur )
   {
     //insert a new item if it doesn't exist, otherwise get the beatInfo already
     //in the map
@@ -95,10 +108,11 @@ public:
     //Now we choose the greatest value between the poller and the sent in duration
     //from the socket.
     beat.Duration = std::max( dur, PollMonitor.maxTimeOut() );
+    this->updateExpiry(iter);
   }
 
   //----------------------------------------------------------------------------
-  boost::int64_t heartbeatInterval(const zmq::SocketIdentity& socket)
+  boost::int64_t heartbeatInterval(SocketHandle socket)
   {
     //insert a new item if it doesn't exist, otherwise get the beatInfo already
     //in the map
@@ -113,13 +127,54 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  void markAsDead( const zmq::SocketIdentity& socket )
+  void markAsDead( SocketHandle socket )
+  {
+    IteratorType iter = this->HeartBeats.find(socket);
+    if(iter != this->HeartBeats.end())
+      {
+      if(iter->second.HasExpiry)
+        {
+        this->Expiries.erase(iter->second.Expiry);
+        }
+      this->HeartBeats.erase(iter);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  boost::int64_t millisecondsToNextExpiry( const ptime& now,
+                                           boost::int64_t max ) const
+  {
+    //sockets that have already missed their heartbeat are skipped, they
+    //have been handled, or were given a pass due to abnormal polling
+    boost::int64_t result = max;
+    ExpiryMap::const_iterator next = this->Expiries.upper_bound(now);
+    if(next != this->Expiries.end())
+      {
+      //round up, so the socket has missed its heartbeat once we wake up
+      const boost::int64_t microseconds =
+                                      (next->first - now).total_microseconds();
+      result = std::min(result, (microseconds + 999) / 1000);
+      }
+    return std::max(result, boost::int64_t(0));
+  }
+
+  //----------------------------------------------------------------------------
+  //a socket is expected to heartbeat within twice its duration
+  void updateExpiry( IteratorType iter )
   {
-    this->HeartBeats.erase(socket);
+    BeatInfo& beat = iter->second;
+    if(beat.HasExpiry)
+      {
+      this->Expiries.erase(beat.Expiry);
+      }
+    const ptime expectedHB = beat.LastOccurrence +
+                             boost::posix_time::milliseconds(beat.Duration*2);
+    beat.Expiry = this->Expiries.insert(std::make_pair(expectedHB, iter->first));
+    beat.HasExpiry = true;
   }
 
   //----------------------------------------------------------------------------
-  bool isMostlyDead( const zmq::SocketIdentity& socket ) const
+  bool isMostlyDead( SocketHandle socket ) const
   {
     if(this->exists(socket))
       {
@@ -183,13 +238,13 @@ remus::common::PollingMonitor SocketMonitor::pollingMonitor() const
 }
 
 //------------------------------------------------------------------------------
-void SocketMonitor::refresh( const zmq::SocketIdentity& socket )
+void SocketMonitor::refresh( SocketHandle socket )
 {
   this->Tracker->refresh(socket);
 }
 
 //------------------------------------------------------------------------------
-void SocketMonitor::heartbeat( const zmq::SocketIdentity& socket,
+void SocketMonitor::heartbeat( SocketHandle socket,
                                boost::int64_t dur_in_milli )
 {
   this->Tracker->heartbeat(socket, dur_in_milli);
@@ -197,30 +252,38 @@ void SocketMonitor::heartbeat( const zmq::SocketIdentity& socket,
 
 //------------------------------------------------------------------------------
 boost::int64_t SocketMonitor::heartbeatInterval(
-                                    const zmq::SocketIdentity& socket) const
+                                    SocketHandle socket) const
 {
   return this->Tracker->heartbeatInterval(socket);
 }
 
 //------------------------------------------------------------------------------
-void SocketMonitor::markAsDead( const zmq::SocketIdentity& socket )
+void SocketMonitor::markAsDead( SocketHandle socket )
 {
   //we need to explicitly mark a socket as dead
   return this->Tracker->markAsDead(socket);
 }
 
 //------------------------------------------------------------------------------
-bool SocketMonitor::isDead( const zmq::SocketIdentity& socket ) const
+bool SocketMonitor::isDead( SocketHandle socket ) const
 {
   return !this->Tracker->exists(socket);
 }
 
 //------------------------------------------------------------------------------
-bool SocketMonitor::isUnresponsive( const zmq::SocketIdentity& socket ) const
+bool SocketMonitor::isUnresponsive( SocketHandle socket ) const
 {
   return this->Tracker->isMostlyDead(socket);
 }
 
+//------------------------------------------------------------------------------
+boost::int64_t SocketMonitor::millisecondsToNextExpiry(
+                                  const boost::posix_time::ptime& now,
+                                  boost::int64_t max_milliseconds) const
+{
+  return this->Tracker->millisecondsToNextExpiry(now, max_milliseconds);
+}
+
 }
 }
 }
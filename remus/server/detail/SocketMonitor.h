@@ -16,10 +16,13 @@
 #include <boost/shared_ptr.hpp>
 
 #include <remus/proto/Message.h>
-#include <remus/proto/zmqSocketIdentity.h>
 
 #include <remus/common/PollingMonitor.h>
 
+#include <remus/server/detail/SocketIdentities.h>
+
+namespace boost { namespace posix_time {  class ptime;  } }
+
 namespace remus{
 namespace server{
 namespace detail{
@@ -42,30 +45,37 @@ public:
 
   //refresh a socket stating it is alive. Uses the pollingMontior
   //to determine the expect time of the next heartbeat from the socket.
-  void refresh( const zmq::SocketIdentity& socket);
+  void refresh( SocketHandle socket);
 
   //update a sockets heartbeat duration, marks the socket as alive.
   //Compares the heart beat interval and the pollingMontior
   //to determine the expect time of the next heartbeat from the socket
-  void heartbeat( const zmq::SocketIdentity& socket,
+  void heartbeat( SocketHandle socket,
                   boost::int64_t dur_in_milli );
 
   //returns the interval in milliseconds between heartbeats for a socket.
   //This should always be a positive value.
-  boost::int64_t heartbeatInterval( const zmq::SocketIdentity& socket) const;
+  boost::int64_t heartbeatInterval( SocketHandle socket) const;
 
   //we have been told by the socket it is shutting down, so we mark
   //the socket as fully dead.
-  void markAsDead( const zmq::SocketIdentity& socket );
+  void markAsDead( SocketHandle socket );
 
   //returns true if a socket is fully dead, and not mostly-dead
-  bool isDead( const zmq::SocketIdentity& socket ) const;
+  bool isDead( SocketHandle socket ) const;
 
   //returns true if a socket is not fully dead, but mostly-dead
   //this occurs when a socket has missed a heartbeat, but we some contextual
   //info from the polling monitor that some abnormal behavior has happened,
   //and we should expect sockets to come back.
-  bool isUnresponsive( const zmq::SocketIdentity& socket ) const;
+  bool isUnresponsive( SocketHandle socket ) const;
+
+  //returns the number of milliseconds until the next socket misses its
+  //heartbeat, clamped to be between 0 and the passed in max value. Sockets
+  //that have already missed their heartbeat aren't counted. This lets the
+  //server sleep until it has to check for unresponsive sockets.
+  boost::int64_t millisecondsToNextExpiry(const boost::posix_time::ptime& now,
+                                          boost::int64_t max_milliseconds) const;
 
 private:
   class WorkerTracker;
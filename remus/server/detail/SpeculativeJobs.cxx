@@ -0,0 +1,301 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/SpeculativeJobs.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+typedef std::pair<boost::int64_t, remus::worker::Job> RunningJob;
+
+struct LongestRunningFirst
+{
+  bool operator()(const RunningJob& a, const RunningJob& b) const
+    { return a.first > b.first; }
+};
+}
+
+//------------------------------------------------------------------------------
+SpeculativeJobs::SpeculativeJobs(std::size_t window, std::size_t minSamples):
+  Window(window > 0 ? window : 1),
+  MinSamples(minSamples > 0 ? minSamples : 1),
+  Copies(0),
+  Jobs(),
+  Runtimes(),
+  Losers()
+{
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::dispatched(const boost::uuids::uuid& id,
+                                 const remus::proto::JobRequirements& reqs,
+                                 SocketHandle worker,
+                                 const boost::posix_time::ptime& now)
+{
+  It job = this->Jobs.find(id);
+  if(job != this->Jobs.end())
+    { //a job that was requeued starts over
+    this->stop(id);
+    }
+
+  Entry entry;
+  entry.Reqs = reqs;
+  entry.Start = now;
+  entry.Worker = worker;
+  this->Jobs[id] = entry;
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::holdForCopies(const remus::worker::Job& job)
+{
+  It entry = this->Jobs.find(job.id());
+  if(entry != this->Jobs.end())
+    {
+    entry->second.Job = job;
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::worker::Job> SpeculativeJobs::stragglers(double percentile,
+                                  const boost::posix_time::ptime& now) const
+{
+  std::map<remus::proto::JobRequirements, boost::int64_t> thresholds;
+  std::vector<RunningJob> running;
+  for(ConstIt i = this->Jobs.begin(); i != this->Jobs.end(); ++i)
+    {
+    if(!i->second.Job.valid() || i->second.Copy != 0 ||
+       i->second.Claimant != 0)
+      {
+      continue;
+      }
+
+    std::map<remus::proto::JobRequirements, boost::int64_t>::iterator t =
+                                              thresholds.find(i->second.Reqs);
+    if(t == thresholds.end())
+      {
+      t = thresholds.insert(std::make_pair(i->second.Reqs,
+                this->percentileRuntime(i->second.Reqs, percentile))).first;
+      }
+
+    const boost::int64_t elapsed = (now - i->second.Start).total_milliseconds();
+    if(t->second >= 0 && elapsed > t->second)
+      {
+      running.push_back( RunningJob(elapsed, i->second.Job) );
+      }
+    }
+
+  std::sort(running.begin(), running.end(), LongestRunningFirst());
+  std::vector<remus::worker::Job> jobs;
+  for(std::size_t i=0; i < running.size(); ++i)
+    {
+    jobs.push_back(running[i].second);
+    }
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t SpeculativeJobs::millisecondsToNextStraggler(double percentile,
+                                  const boost::posix_time::ptime& now,
+                                  boost::int64_t max_milliseconds) const
+{
+  std::map<remus::proto::JobRequirements, boost::int64_t> thresholds;
+  boost::int64_t result = max_milliseconds;
+  for(ConstIt i = this->Jobs.begin(); i != this->Jobs.end(); ++i)
+    {
+    if(!i->second.Job.valid() || i->second.Copy != 0 ||
+       i->second.Claimant != 0)
+      {
+      continue;
+      }
+
+    std::map<remus::proto::JobRequirements, boost::int64_t>::iterator t =
+                                              thresholds.find(i->second.Reqs);
+    if(t == thresholds.end())
+      {
+      t = thresholds.insert(std::make_pair(i->second.Reqs,
+                this->percentileRuntime(i->second.Reqs, percentile))).first;
+      }
+
+    //a job becomes a straggler once it has run past the threshold
+    const boost::int64_t elapsed = (now - i->second.Start).total_milliseconds();
+    if(t->second >= 0 && elapsed <= t->second)
+      {
+      result = std::min(result, t->second - elapsed + 1);
+      }
+    }
+  return std::max(result, boost::int64_t(0));
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t SpeculativeJobs::percentileRuntime(
+                                const remus::proto::JobRequirements& reqs,
+                                double percentile) const
+{
+  std::map<remus::proto::JobRequirements,
+           std::deque<boost::int64_t> >::const_iterator runtimes =
+                                                    this->Runtimes.find(reqs);
+  if(runtimes == this->Runtimes.end() ||
+     runtimes->second.size() < this->MinSamples)
+    {
+    return -1;
+    }
+
+  std::vector<boost::int64_t> sorted(runtimes->second.begin(),
+                                     runtimes->second.end());
+  std::sort(sorted.begin(), sorted.end());
+
+  const double p = std::min(std::max(percentile, 0.0), 1.0);
+  std::size_t rank = static_cast<std::size_t>(
+                          std::ceil(p * static_cast<double>(sorted.size())));
+  rank = std::min(std::max(rank, std::size_t(1)), sorted.size());
+  return sorted[rank - 1];
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::copied(const boost::uuids::uuid& id,
+                             SocketHandle worker)
+{
+  It job = this->Jobs.find(id);
+  if(job != this->Jobs.end() && job->second.Copy == 0)
+    {
+    job->second.Copy = worker;
+    ++this->Copies;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool SpeculativeJobs::claimResult(const boost::uuids::uuid& id,
+                                  SocketHandle worker)
+{
+  It job = this->Jobs.find(id);
+  if(job == this->Jobs.end())
+    {
+    return true;
+    }
+
+  if(job->second.Claimant == 0)
+    {
+    job->second.Claimant = worker;
+    }
+  return job->second.Claimant == worker;
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::finished(const boost::uuids::uuid& id,
+                               SocketHandle worker,
+                               const boost::posix_time::ptime& now)
+{
+  It job = this->Jobs.find(id);
+  if(job == this->Jobs.end())
+    {
+    return;
+    }
+
+  std::deque<boost::int64_t>& runtimes = this->Runtimes[job->second.Reqs];
+  runtimes.push_back( (now - job->second.Start).total_milliseconds() );
+  if(runtimes.size() > this->Window)
+    {
+    runtimes.pop_front();
+    }
+
+  if(job->second.Copy != 0)
+    {
+    const SocketHandle loser = (job->second.Copy == worker) ?
+                               job->second.Worker : job->second.Copy;
+    this->Losers.push_back( JobWorker(id, loser) );
+    }
+  this->erase(job);
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::stop(const boost::uuids::uuid& id)
+{
+  It job = this->Jobs.find(id);
+  if(job == this->Jobs.end())
+    {
+    return;
+    }
+
+  if(job->second.Copy != 0)
+    {
+    this->Losers.push_back( JobWorker(id, job->second.Copy) );
+    }
+  this->erase(job);
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::promoteCopies(
+                          remus::server::detail::SocketMonitor monitor,
+                          std::vector<JobWorker>& promoted,
+                          std::vector<boost::uuids::uuid>& lostResults)
+{
+  for(It i = this->Jobs.begin(); i != this->Jobs.end(); ++i)
+    {
+    Entry& entry = i->second;
+    if(entry.Copy == 0)
+      {
+      continue;
+      }
+
+    SocketHandle dead = 0;
+    if(monitor.isUnresponsive(entry.Copy))
+      {
+      dead = entry.Copy;
+      }
+    else if(monitor.isUnresponsive(entry.Worker))
+      {
+      dead = entry.Worker;
+      entry.Worker = entry.Copy;
+      promoted.push_back( JobWorker(i->first, entry.Worker) );
+      }
+    else
+      {
+      continue;
+      }
+
+    entry.Copy = SocketHandle();
+    --this->Copies;
+    if(entry.Claimant != 0 && entry.Claimant == dead)
+      {
+      entry.Claimant = SocketHandle();
+      lostResults.push_back(i->first);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<SpeculativeJobs::JobWorker> SpeculativeJobs::takeLosers()
+{
+  std::vector<JobWorker> losers;
+  losers.swap(this->Losers);
+  return losers;
+}
+
+//------------------------------------------------------------------------------
+void SpeculativeJobs::erase(It job)
+{
+  if(job->second.Copy != 0)
+    {
+    --this->Copies;
+    }
+  this->Jobs.erase(job);
+}
+
+}
+}
+}
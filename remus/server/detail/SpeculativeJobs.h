@@ -0,0 +1,144 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_SpeculativeJobs_h
+#define remus_server_detail_SpeculativeJobs_h
+
+#include <remus/proto/JobRequirements.h>
+#include <remus/server/detail/SocketIdentities.h>
+#include <remus/server/detail/SocketMonitor.h>
+#include <remus/worker/Job.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Tracks how long the jobs of each set of requirements take to finish, and
+//the copies of jobs that run past most of their siblings. A job can have a
+//single copy on another worker, and whichever worker sends a result first
+//wins. The worker that lost is then told to terminate the job.
+class SpeculativeJobs
+{
+public:
+  typedef std::pair<boost::uuids::uuid, SocketHandle> JobWorker;
+
+  //keep the runtimes of the last window jobs of each set of requirements,
+  //and only look for stragglers once minSamples jobs have finished
+  SpeculativeJobs(std::size_t window = 100, std::size_t minSamples = 10);
+
+  //record that the job was given to the worker, which starts its runtime
+  void dispatched(const boost::uuids::uuid& id,
+                  const remus::proto::JobRequirements& reqs,
+                  SocketHandle worker,
+                  const boost::posix_time::ptime& now);
+
+  //hold onto a job that was dispatched, so that a copy of it can be sent
+  //to another worker. Only jobs we hold are ever copied
+  void holdForCopies(const remus::worker::Job& job);
+
+  //returns the jobs we hold that have no copy, haven't started sending
+  //their result, and have run longer than the given percentile of the
+  //runtimes of their requirements. The jobs that have run the longest
+  //come first
+  std::vector<remus::worker::Job> stragglers(double percentile,
+                              const boost::posix_time::ptime& now) const;
+
+  //returns the number of milliseconds until the next job we hold becomes a
+  //straggler, clamped to be between 0 and the passed in max value. Jobs
+  //that already are stragglers aren't counted, as they wait on a worker
+  //becoming idle
+  boost::int64_t millisecondsToNextStraggler(double percentile,
+                                    const boost::posix_time::ptime& now,
+                                    boost::int64_t max_milliseconds) const;
+
+  //returns the runtime in milliseconds that the given percentile of the
+  //finished jobs with these requirements didn't exceed, or -1 if not
+  //enough jobs have finished
+  boost::int64_t percentileRuntime(const remus::proto::JobRequirements& reqs,
+                                   double percentile) const;
+
+  //record that a copy of the job was given to the worker
+  void copied(const boost::uuids::uuid& id, SocketHandle worker);
+
+  //returns the number of copies that are running
+  std::size_t numberOfCopies() const { return this->Copies; }
+
+  //returns true if the worker can send the result of the job. The first
+  //worker to send any of the result of a job claims it
+  bool claimResult(const boost::uuids::uuid& id,
+                   SocketHandle worker);
+
+  //the job finished with the result of the worker. Records the runtime,
+  //and the other worker of a copied job lost
+  void finished(const boost::uuids::uuid& id,
+                SocketHandle worker,
+                const boost::posix_time::ptime& now);
+
+  //the job stopped without a result, so its copy lost
+  void stop(const boost::uuids::uuid& id);
+
+  //a copied job whose worker died moves to the worker of its copy, and
+  //a copy whose worker died is dropped. Fills promoted with the jobs that
+  //moved along with their new worker, and lostResults with the jobs whose
+  //result was being sent by a worker that died
+  void promoteCopies(remus::server::detail::SocketMonitor monitor,
+                     std::vector<JobWorker>& promoted,
+                     std::vector<boost::uuids::uuid>& lostResults);
+
+  //remove and return the workers that lost a job, and need to be told
+  //to terminate it
+  std::vector<JobWorker> takeLosers();
+
+  //returns the number of jobs we track
+  std::size_t size() const { return this->Jobs.size(); }
+  bool empty() const { return this->Jobs.empty(); }
+
+private:
+  struct Entry
+  {
+    Entry(): Reqs(), Start(), Worker(0), Copy(0), Claimant(0), Job() {}
+
+    remus::proto::JobRequirements Reqs;
+    boost::posix_time::ptime Start;
+    SocketHandle Worker;
+    SocketHandle Copy;
+    SocketHandle Claimant;
+    remus::worker::Job Job;
+  };
+  typedef std::map<boost::uuids::uuid, Entry>::iterator It;
+  typedef std::map<boost::uuids::uuid, Entry>::const_iterator ConstIt;
+
+  void erase(It job);
+
+  std::size_t Window;
+  std::size_t MinSamples;
+  std::size_t Copies;
+  std::map<boost::uuids::uuid, Entry> Jobs;
+  std::map<remus::proto::JobRequirements,
+           std::deque<boost::int64_t> > Runtimes;
+  std::vector<JobWorker> Losers;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,211 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/StreamedResults.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/common/remusGlobals.h>
+
+#include <boost/shared_array.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+//orders chunks by the offset they start at
+bool starts_after(boost::uint64_t offset, const remus::proto::DataChunk& chunk)
+{
+  return offset < chunk.offset();
+}
+}
+
+//------------------------------------------------------------------------------
+ChunkedResult::ChunkedResult():
+  Id(),
+  Format(),
+  Chunks(),
+  Size(0),
+  Checksum()
+{
+}
+
+//------------------------------------------------------------------------------
+ChunkedResult::ChunkedResult(const boost::uuids::uuid& id,
+                             remus::common::ContentFormat::Type format,
+                             const std::vector<remus::proto::DataChunk>& chunks,
+                             boost::uint64_t size,
+                             const std::string& checksum):
+  Id(id),
+  Format(format),
+  Chunks(chunks),
+  Size(size),
+  Checksum(checksum)
+{
+}
+
+//------------------------------------------------------------------------------
+remus::proto::DataChunk ChunkedResult::chunkAt(boost::uint64_t offset) const
+{
+  //an offset past the end of the result means we have nothing to send
+  remus::proto::DataChunk piece(this->Id);
+  if(offset > this->Size)
+    {
+    return piece;
+    }
+
+  //find the last chunk that starts at or before the offset
+  typedef std::vector<remus::proto::DataChunk>::const_iterator ChunkIt;
+  ChunkIt chunk = std::upper_bound(this->Chunks.begin(), this->Chunks.end(),
+                                   offset, starts_after);
+  if(chunk != this->Chunks.begin() && offset < this->Size)
+    {
+    --chunk;
+    const std::size_t skip = static_cast<std::size_t>(offset - chunk->offset());
+    const std::size_t length = std::min(remus::STREAM_CHUNK_SIZE,
+                                        chunk->dataSize() - skip);
+    piece = remus::proto::DataChunk(this->Id, this->Format, offset,
+                                    chunk->data() + skip, length);
+    }
+  else
+    {
+    piece = remus::proto::DataChunk(this->Id, this->Format, offset,
+                                    static_cast<const char*>(NULL), 0);
+    }
+
+  if(offset + piece.dataSize() == this->Size)
+    {
+    piece.markAsFinal(this->Size, this->Checksum);
+    }
+  return piece;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult ChunkedResult::join() const
+{
+  const std::size_t size = static_cast<std::size_t>(this->Size);
+  boost::shared_array<char> contents( new char[size] );
+  std::size_t pos = 0;
+  typedef std::vector<remus::proto::DataChunk>::const_iterator ChunkIt;
+  for(ChunkIt i = this->Chunks.begin(); i != this->Chunks.end(); ++i)
+    {
+    std::memcpy(contents.get() + pos, i->data(), i->dataSize());
+    pos += i->dataSize();
+    }
+  return remus::proto::JobResult(this->Id, this->Format, contents, size);
+}
+
+//------------------------------------------------------------------------------
+StreamedResults::Stream::Stream():
+  Format(),
+  Chunks(),
+  BytesReceived(0),
+  Hasher(new remus::common::MD5Hasher()),
+  Checksum(),
+  Complete(false),
+  Valid(false)
+{
+}
+
+//------------------------------------------------------------------------------
+StreamedResults::StreamedResults():
+  Streams()
+{
+}
+
+//------------------------------------------------------------------------------
+bool StreamedResults::add(const remus::proto::DataChunk& chunk)
+{
+  It item = this->Streams.find(chunk.id());
+  if(item == this->Streams.end())
+    {
+    //a new stream has to start at the beginning of the result
+    if(chunk.offset() != 0)
+      {
+      return false;
+      }
+    item = this->Streams.insert(std::make_pair(chunk.id(), Stream())).first;
+    item->second.Format = chunk.formatType();
+    }
+
+  Stream& stream = item->second;
+  if(stream.Complete || chunk.offset() != stream.BytesReceived)
+    {
+    return false;
+    }
+
+  if(chunk.dataSize() > 0)
+    {
+    stream.Hasher->append(chunk.data(), chunk.dataSize());
+    stream.BytesReceived += chunk.dataSize();
+    stream.Chunks.push_back(chunk);
+    }
+
+  if(chunk.isFinal())
+    {
+    stream.Complete = true;
+    stream.Checksum = chunk.checksum();
+    stream.Valid = stream.BytesReceived == chunk.totalSize() &&
+                   stream.Hasher->hash() == chunk.checksum();
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedResults::have(const boost::uuids::uuid& id) const
+{
+  return this->Streams.count(id) != 0;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedResults::isComplete(const boost::uuids::uuid& id) const
+{
+  ConstIt item = this->Streams.find(id);
+  return item != this->Streams.end() && item->second.Complete;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedResults::take(const boost::uuids::uuid& id,
+                           ChunkedResult& result)
+{
+  It item = this->Streams.find(id);
+  if(item == this->Streams.end() || !item->second.Complete)
+    {
+    return false;
+    }
+
+  const bool valid = item->second.Valid;
+  if(valid)
+    {
+    //the chunks are shared with the result, not copied
+    const Stream& stream = item->second;
+    result = ChunkedResult(id, stream.Format, stream.Chunks,
+                           stream.BytesReceived, stream.Checksum);
+    }
+
+  this->Streams.erase(item);
+  return valid;
+}
+
+//------------------------------------------------------------------------------
+void StreamedResults::remove(const boost::uuids::uuid& id)
+{
+  this->Streams.erase(id);
+}
+
+}
+}
+}
@@ -0,0 +1,123 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_StreamedResults_h
+#define remus_server_detail_StreamedResults_h
+
+#include <remus/proto/DataChunk.h>
+#include <remus/proto/JobResult.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace common{ class MD5Hasher; }
+}
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//A result that was streamed to the server, held as the chunks it arrived in.
+//Clients that stream the result are sent pieces of those chunks, along with
+//the checksum the worker sent, so the result is never joined or hashed again.
+class ChunkedResult
+{
+public:
+  //construct an empty result
+  ChunkedResult();
+
+  ChunkedResult(const boost::uuids::uuid& id,
+                remus::common::ContentFormat::Type format,
+                const std::vector<remus::proto::DataChunk>& chunks,
+                boost::uint64_t size,
+                const std::string& checksum);
+
+  boost::uint64_t size() const { return this->Size; }
+  const std::string& checksum() const { return this->Checksum; }
+
+  //returns the piece of the result that starts at the given offset, which
+  //is at most STREAM_CHUNK_SIZE bytes and never spans two of our chunks.
+  //The piece that ends the result is final. The returned chunk references
+  //our data, so it is only valid as long as we are.
+  remus::proto::DataChunk chunkAt(boost::uint64_t offset) const;
+
+  //joins the chunks into a single JobResult, for clients that ask for
+  //the whole result at once
+  remus::proto::JobResult join() const;
+
+private:
+  boost::uuids::uuid Id;
+  remus::common::ContentFormat::Type Format;
+  std::vector<remus::proto::DataChunk> Chunks;
+  boost::uint64_t Size;
+  std::string Checksum;
+};
+
+//Holds the results that workers are in the middle of streaming to the server.
+//Chunks are kept as they arrive, without being copied, and are handed over
+//as a ChunkedResult once the final chunk has been received and the size and
+//checksum of the stream have been verified.
+class StreamedResults
+{
+public:
+  StreamedResults();
+
+  //add the next chunk of a job's result. Chunks must be added in order,
+  //returns false if the chunk doesn't continue the stream of its job.
+  bool add(const remus::proto::DataChunk& chunk);
+
+  //returns true if we have a stream for the given job
+  bool have(const boost::uuids::uuid& id) const;
+
+  //returns true if the final chunk for the given job has been added
+  bool isComplete(const boost::uuids::uuid& id) const;
+
+  //removes a complete stream and hands its chunks over to the result.
+  //Returns false if the stream isn't complete, or if the data received
+  //doesn't match the total size and checksum of the final chunk.
+  bool take(const boost::uuids::uuid& id, ChunkedResult& result);
+
+  //discard any chunks we have for the given job
+  void remove(const boost::uuids::uuid& id);
+
+  //returns the number of jobs with results being streamed
+  std::size_t size() const { return this->Streams.size(); }
+
+private:
+  struct Stream
+  {
+    remus::common::ContentFormat::Type Format;
+    std::vector<remus::proto::DataChunk> Chunks;
+    boost::uint64_t BytesReceived;
+    boost::shared_ptr<remus::common::MD5Hasher> Hasher;
+    std::string Checksum;
+    bool Complete;
+    bool Valid;
+
+    Stream();
+  };
+
+  typedef std::map<boost::uuids::uuid, Stream>::const_iterator ConstIt;
+  typedef std::map<boost::uuids::uuid, Stream>::iterator It;
+  std::map<boost::uuids::uuid, Stream> Streams;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,394 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/StreamedSubmissions.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/common/MappedFile.h>
+#include <remus/common/remusGlobals.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_array.hpp>
+
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+//Releases the mapping of a spool file, and removes the file, once the
+//last JobContent that shares the mapped data is gone. The content can
+//outlive the upload when it is held by the ContentStore, so on platforms
+//that can't remove a mapped file the upload leaves the file to us.
+struct ReleaseSpool
+{
+  ReleaseSpool(const boost::shared_ptr<remus::common::MappedFile>& mapped,
+               const std::string& path):
+    Mapped(mapped),
+    Path(path)
+  {
+  }
+
+  void operator()(char*)
+  {
+    this->Mapped.reset();
+    boost::system::error_code ec;
+    boost::filesystem::remove(this->Path, ec);
+  }
+
+  boost::shared_ptr<remus::common::MappedFile> Mapped;
+  std::string Path;
+};
+
+//------------------------------------------------------------------------------
+void removeSpool(const std::string& path,
+                 const boost::shared_ptr<std::fstream>& spool)
+{
+  if(spool)
+    {
+    spool->close();
+    }
+  boost::system::error_code ec;
+  boost::filesystem::remove(path, ec);
+}
+}
+
+//------------------------------------------------------------------------------
+StreamedSubmissions::KeyState::KeyState():
+  BytesReceived(0),
+  Hasher(new remus::common::MD5Hasher()),
+  Format(remus::common::ContentFormat::User),
+  SpoolPath(),
+  Spool(),
+  Complete(false),
+  Valid(false)
+{
+}
+
+//------------------------------------------------------------------------------
+StreamedSubmissions::StreamedSubmissions():
+  Uploads()
+{
+}
+
+//------------------------------------------------------------------------------
+StreamedSubmissions::~StreamedSubmissions()
+{
+  //make sure we don't leave spool files behind
+  while(!this->Uploads.empty())
+    {
+    this->remove(this->Uploads.begin()->first);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::add(const boost::uuids::uuid& id,
+                              const remus::proto::StreamedKeys& keys)
+{
+  if(keys.empty() || this->have(id))
+    {
+    return false;
+    }
+
+  Upload upload;
+  typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+  for(KeyIt i = keys.begin(); i != keys.end(); ++i)
+    {
+    const boost::filesystem::path spoolPath =
+                        boost::filesystem::temp_directory_path() /
+                        boost::filesystem::unique_path("remus-%%%%-%%%%-%%%%");
+
+    KeyState state;
+    state.SpoolPath = spoolPath.string();
+    state.Spool.reset( new std::fstream(state.SpoolPath.c_str(),
+                                        std::ios::in | std::ios::out |
+                                        std::ios::binary | std::ios::trunc) );
+    upload.Keys[*i] = state;
+    if(!state.Spool->is_open())
+      {
+      typedef std::map<std::string, KeyState>::const_iterator StateIt;
+      for(StateIt j = upload.Keys.begin(); j != upload.Keys.end(); ++j)
+        {
+        removeSpool(j->second.SpoolPath, j->second.Spool);
+        }
+      return false;
+      }
+    }
+  upload.Forwarded = 0;
+  upload.Acknowledged = 0;
+
+  this->Uploads[id] = upload;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::have(const boost::uuids::uuid& id) const
+{
+  return this->Uploads.count(id) != 0;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::StreamedKeys
+StreamedSubmissions::keys(const boost::uuids::uuid& id) const
+{
+  remus::proto::StreamedKeys result;
+  ConstIt item = this->Uploads.find(id);
+  if(item != this->Uploads.end())
+    {
+    typedef std::map<std::string, KeyState>::const_iterator KeyIt;
+    for(KeyIt i = item->second.Keys.begin(); i != item->second.Keys.end(); ++i)
+      {
+      result.insert(i->first);
+      }
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::append(const remus::proto::DataChunk& chunk)
+{
+  It item = this->Uploads.find(chunk.id());
+  if(item == this->Uploads.end())
+    {
+    return false;
+    }
+
+  Upload& upload = item->second;
+  std::map<std::string, KeyState>::iterator keyItem =
+                                            upload.Keys.find(chunk.key());
+  if(keyItem == upload.Keys.end())
+    {
+    return false;
+    }
+
+  KeyState& state = keyItem->second;
+  if(state.Complete || chunk.offset() != state.BytesReceived)
+    {
+    return false;
+    }
+
+  SpooledChunk spooled;
+  spooled.Key = chunk.key();
+  spooled.Format = chunk.formatType();
+  spooled.Offset = chunk.offset();
+  spooled.Final = chunk.isFinal();
+  spooled.TotalSize = chunk.totalSize();
+  spooled.Checksum = chunk.checksum();
+  spooled.Size = chunk.dataSize();
+
+  if(chunk.dataSize() > 0)
+    {
+    state.Spool->seekp(static_cast<std::streamoff>(chunk.offset()));
+    state.Spool->write(chunk.data(),
+                       static_cast<std::streamsize>(chunk.dataSize()));
+    if(!state.Spool->good())
+      {
+      return false;
+      }
+
+    state.Hasher->append(chunk.data(), chunk.dataSize());
+    state.BytesReceived += chunk.dataSize();
+    }
+  upload.Chunks.push_back(spooled);
+  state.Format = chunk.formatType();
+
+  if(chunk.isFinal())
+    {
+    //the spool is mapped once the key is complete, so everything
+    //we wrote has to be in the file
+    state.Spool->flush();
+    state.Complete = true;
+    state.Valid = state.BytesReceived == chunk.totalSize() &&
+                  state.Hasher->hash() == chunk.checksum();
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::isUploaded(const boost::uuids::uuid& id) const
+{
+  ConstIt item = this->Uploads.find(id);
+  if(item == this->Uploads.end())
+    {
+    return false;
+    }
+
+  typedef std::map<std::string, KeyState>::const_iterator KeyIt;
+  for(KeyIt i = item->second.Keys.begin(); i != item->second.Keys.end(); ++i)
+    {
+    if(!i->second.Complete)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::isValid(const boost::uuids::uuid& id) const
+{
+  ConstIt item = this->Uploads.find(id);
+  if(item == this->Uploads.end())
+    {
+    return false;
+    }
+
+  typedef std::map<std::string, KeyState>::const_iterator KeyIt;
+  for(KeyIt i = item->second.Keys.begin(); i != item->second.Keys.end(); ++i)
+    {
+    if(i->second.Complete && !i->second.Valid)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::content(const boost::uuids::uuid& id,
+                                  const std::string& key,
+                                  remus::proto::JobContent& content) const
+{
+  ConstIt item = this->Uploads.find(id);
+  if(item == this->Uploads.end())
+    {
+    return false;
+    }
+
+  std::map<std::string, KeyState>::const_iterator keyItem =
+                                              item->second.Keys.find(key);
+  if(keyItem == item->second.Keys.end() ||
+     !keyItem->second.Complete || !keyItem->second.Valid)
+    {
+    return false;
+    }
+
+  const KeyState& state = keyItem->second;
+  if(state.BytesReceived == 0)
+    {
+    content = remus::proto::JobContent(state.Format, std::string());
+    return true;
+    }
+
+  boost::shared_ptr<remus::common::MappedFile> mapped =
+      boost::make_shared<remus::common::MappedFile>(
+                              remus::common::FileHandle(state.SpoolPath));
+  if(!mapped->valid() || mapped->size() != state.BytesReceived)
+    {
+    return false;
+    }
+
+  const std::size_t size = mapped->size();
+  boost::shared_array<char> data(const_cast<char*>(mapped->data()),
+                                 ReleaseSpool(mapped, state.SpoolPath));
+  content = remus::proto::JobContent(state.Format, data, size);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::nextChunkToForward(const boost::uuids::uuid& id,
+                                             remus::proto::DataChunk& chunk)
+{
+  It item = this->Uploads.find(id);
+  if(item == this->Uploads.end())
+    {
+    return false;
+    }
+
+  Upload& upload = item->second;
+  const std::size_t inFlight = upload.Forwarded - upload.Acknowledged;
+  if(upload.Forwarded >= upload.Chunks.size() ||
+     inFlight >= remus::STREAM_CHUNK_CREDITS)
+    {
+    return false;
+    }
+
+  const SpooledChunk& spooled = upload.Chunks[upload.Forwarded];
+  const boost::shared_ptr<std::fstream>& spool =
+                                      upload.Keys[spooled.Key].Spool;
+  boost::shared_array<char> contents( new char[spooled.Size] );
+  if(spooled.Size > 0)
+    {
+    spool->seekg(static_cast<std::streamoff>(spooled.Offset));
+    spool->read(contents.get(), static_cast<std::streamsize>(spooled.Size));
+    if(!spool->good())
+      {
+      spool->clear();
+      return false;
+      }
+    }
+
+  chunk = remus::proto::DataChunk(id, spooled.Format, spooled.Offset,
+                                  contents, spooled.Size);
+  chunk.key(spooled.Key);
+  if(spooled.Final)
+    {
+    chunk.markAsFinal(spooled.TotalSize, spooled.Checksum);
+    }
+
+  ++upload.Forwarded;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void StreamedSubmissions::acknowledged(const boost::uuids::uuid& id)
+{
+  It item = this->Uploads.find(id);
+  if(item != this->Uploads.end() &&
+     item->second.Acknowledged < item->second.Forwarded)
+    {
+    ++item->second.Acknowledged;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool StreamedSubmissions::isForwarded(const boost::uuids::uuid& id) const
+{
+  ConstIt item = this->Uploads.find(id);
+  return item != this->Uploads.end() &&
+         this->isUploaded(id) &&
+         item->second.Acknowledged == item->second.Chunks.size();
+}
+
+//------------------------------------------------------------------------------
+void StreamedSubmissions::rewind(const boost::uuids::uuid& id)
+{
+  It item = this->Uploads.find(id);
+  if(item != this->Uploads.end())
+    {
+    item->second.Forwarded = 0;
+    item->second.Acknowledged = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+void StreamedSubmissions::remove(const boost::uuids::uuid& id)
+{
+  It item = this->Uploads.find(id);
+  if(item != this->Uploads.end())
+    {
+    typedef std::map<std::string, KeyState>::const_iterator KeyIt;
+    for(KeyIt i = item->second.Keys.begin(); i != item->second.Keys.end(); ++i)
+      {
+      removeSpool(i->second.SpoolPath, i->second.Spool);
+      }
+    this->Uploads.erase(item);
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,150 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_StreamedSubmissions_h
+#define remus_server_detail_StreamedSubmissions_h
+
+#include <remus/proto/DataChunk.h>
+#include <remus/proto/JobContent.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace common{ class MD5Hasher; }
+}
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Holds the content of job submissions that clients are streaming to the
+//server. Chunks are appended to a spool file per key as they arrive, so the
+//server never holds more than a single chunk of a submission in memory. Once
+//the job has been assigned to a worker the spooled chunks are read back and
+//forwarded, with at most remus::STREAM_CHUNK_CREDITS chunks waiting to be
+//acknowledged by the worker.
+class StreamedSubmissions
+{
+public:
+  StreamedSubmissions();
+  ~StreamedSubmissions();
+
+  //start spooling the content of the given keys for a job
+  bool add(const boost::uuids::uuid& id, const remus::proto::StreamedKeys& keys);
+
+  //returns true if we are spooling content for the given job
+  bool have(const boost::uuids::uuid& id) const;
+
+  //returns the keys that are streamed for the given job
+  remus::proto::StreamedKeys keys(const boost::uuids::uuid& id) const;
+
+  //append the next chunk of a key to the spool. Chunks of each key must be
+  //added in order, returns false if the chunk doesn't continue the stream
+  //of its key, or the key isn't streamed for the job.
+  bool append(const remus::proto::DataChunk& chunk);
+
+  //returns true once the final chunk of every key has been appended
+  bool isUploaded(const boost::uuids::uuid& id) const;
+
+  //returns false if any key of the job didn't match the total size and
+  //checksum of its final chunk
+  bool isValid(const boost::uuids::uuid& id) const;
+
+  //map the spool file of a key as memory content, so that the content can
+  //be held without being read back into memory. The content keeps the
+  //mapping alive after the spool is removed. Returns false if the key
+  //hasn't been completely uploaded, didn't pass verification, or couldn't
+  //be mapped
+  bool content(const boost::uuids::uuid& id, const std::string& key,
+               remus::proto::JobContent& content) const;
+
+  //read back the next spooled chunk that should be sent to the worker.
+  //Returns false when every spooled chunk has been sent, or when all the
+  //credits for the job are in use.
+  bool nextChunkToForward(const boost::uuids::uuid& id,
+                          remus::proto::DataChunk& chunk);
+
+  //the worker has acknowledged a chunk, returning the credit it used
+  void acknowledged(const boost::uuids::uuid& id);
+
+  //returns true once every chunk has been uploaded, forwarded to the worker
+  //and acknowledged. At this point the spool is no longer needed
+  bool isForwarded(const boost::uuids::uuid& id) const;
+
+  //forward every spooled chunk again, from the start of the spool. Used
+  //when a job is retried on another worker, so the content is streamed
+  //to it instead of being sent with the job
+  void rewind(const boost::uuids::uuid& id);
+
+  //discard the spool of the given job
+  void remove(const boost::uuids::uuid& id);
+
+  //returns the number of jobs with content being spooled
+  std::size_t size() const { return this->Uploads.size(); }
+
+private:
+  //explicitly state the class doesn't support copy or move semantics
+  StreamedSubmissions(const StreamedSubmissions&);
+  void operator=(const StreamedSubmissions&);
+
+  //the content of a key is spooled in order, so a chunk is stored
+  //in the spool file of its key at the offset of the chunk
+  struct KeyState
+  {
+    boost::uint64_t BytesReceived;
+    boost::shared_ptr<remus::common::MD5Hasher> Hasher;
+    remus::common::ContentFormat::Type Format;
+    std::string SpoolPath;
+    boost::shared_ptr<std::fstream> Spool;
+    bool Complete;
+    bool Valid;
+
+    KeyState();
+  };
+
+  //the chunks in the order they arrived, which is the order they are
+  //forwarded to the worker
+  struct SpooledChunk
+  {
+    std::string Key;
+    remus::common::ContentFormat::Type Format;
+    boost::uint64_t Offset;
+    bool Final;
+    boost::uint64_t TotalSize;
+    std::string Checksum;
+    std::size_t Size;
+  };
+
+  struct Upload
+  {
+    std::map<std::string, KeyState> Keys;
+    std::vector<SpooledChunk> Chunks;
+    std::size_t Forwarded;
+    std::size_t Acknowledged;
+  };
+
+  typedef std::map<boost::uuids::uuid, Upload>::const_iterator ConstIt;
+  typedef std::map<boost::uuids::uuid, Upload>::iterator It;
+  std::map<boost::uuids::uuid, Upload> Uploads;
+};
+
+}
+}
+}
+
+#endif
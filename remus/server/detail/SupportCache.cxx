@@ -0,0 +1,95 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/SupportCache.h>
+
+#include <remus/server/detail/uuidHelper.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+SupportCache::SupportCache():
+  Instance( remus::to_string(boost::uuids::random_generator()()) ),
+  FactoryGeneration(0),
+  PoolGeneration(0),
+  Generation(0),
+  Answers(),
+  Requirements()
+{
+}
+
+//------------------------------------------------------------------------------
+void SupportCache::validate(boost::uint64_t factoryGeneration,
+                            boost::uint64_t poolGeneration)
+{
+  if(factoryGeneration != this->FactoryGeneration ||
+     poolGeneration != this->PoolGeneration)
+    {
+    this->FactoryGeneration = factoryGeneration;
+    this->PoolGeneration = poolGeneration;
+    this->Answers.clear();
+    this->Requirements.clear();
+    ++this->Generation;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool SupportCache::find(remus::SERVICE_TYPE service,
+                        const remus::common::MeshIOType& type,
+                        std::string& answer) const
+{
+  std::map<Query, std::string>::const_iterator i =
+                      this->Answers.find(Query(static_cast<int>(service), type));
+  if(i == this->Answers.end())
+    {
+    return false;
+    }
+  answer = i->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void SupportCache::store(remus::SERVICE_TYPE service,
+                         const remus::common::MeshIOType& type,
+                         const std::string& answer)
+{
+  this->Answers[Query(static_cast<int>(service), type)] = answer;
+}
+
+//------------------------------------------------------------------------------
+const SupportCache::DigestedRequirements*
+SupportCache::findRequirements(const remus::common::MeshIOType& type) const
+{
+  std::map<remus::common::MeshIOType, DigestedRequirements>::const_iterator i =
+                                                  this->Requirements.find(type);
+  return (i != this->Requirements.end()) ? &i->second : NULL;
+}
+
+//------------------------------------------------------------------------------
+void SupportCache::storeRequirements(const remus::common::MeshIOType& type,
+                                     const DigestedRequirements& requirements)
+{
+  this->Requirements[type] = requirements;
+}
+
+//------------------------------------------------------------------------------
+std::string SupportCache::tag() const
+{
+  return this->Instance + ":" +
+         boost::lexical_cast<std::string>(this->Generation);
+}
+
+}
+}
+}
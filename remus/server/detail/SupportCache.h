@@ -0,0 +1,99 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_SupportCache_h
+#define remus_server_detail_SupportCache_h
+
+#include <remus/common/MeshIOType.h>
+#include <remus/common/remusGlobals.h>
+
+#include <boost/cstdint.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Holds the serialized answers to the client queries about what the server
+//can mesh (SUPPORTED_IO_TYPES, CAN_MESH_IO_TYPE and
+//MESH_REQUIREMENTS_FOR_IO_TYPE), so that asking again is a lookup instead
+//of merging the factory and the worker pool. For CACHED_MESH_REQUIREMENTS
+//queries we hold the digest and serialized form of each of the requirements
+//of a MeshIOType, so that clients are only sent requirements they don't hold.
+//The answers are only valid for the generations of the factory and the
+//pool they were computed with. Once either generation changes all answers
+//are dropped, and the generation of the cache is bumped.
+class SupportCache
+{
+public:
+  //maps the digest of each of the requirements to their serialized form
+  typedef std::map<std::string, std::string> DigestedRequirements;
+
+  SupportCache();
+
+  //drop all the answers if either generation differs from the generations
+  //the answers were computed with
+  void validate(boost::uint64_t factoryGeneration,
+                boost::uint64_t poolGeneration);
+
+  //returns true and sets answer if we hold the answer to the query.
+  //SUPPORTED_IO_TYPES queries use the default MeshIOType
+  bool find(remus::SERVICE_TYPE service,
+            const remus::common::MeshIOType& type,
+            std::string& answer) const;
+
+  //hold the answer to the query until the next generation change
+  void store(remus::SERVICE_TYPE service,
+             const remus::common::MeshIOType& type,
+             const std::string& answer);
+
+  //returns the requirements of the type if we hold them, otherwise NULL.
+  //The pointer is valid until the next call to validate or storeRequirements
+  const DigestedRequirements*
+  findRequirements(const remus::common::MeshIOType& type) const;
+
+  //hold the requirements of the type until the next generation change
+  void storeRequirements(const remus::common::MeshIOType& type,
+                         const DigestedRequirements& requirements);
+
+  //returns a counter that is bumped every time the answers are dropped,
+  //so it only changes when what the server can mesh may have changed
+  boost::uint64_t generation() const { return this->Generation; }
+
+  //returns the generation combined with an id that is unique to this
+  //cache, so that a tag handed to clients by a server that has since
+  //restarted doesn't match the answers of the new server
+  std::string tag() const;
+
+  //returns the number of answers we hold
+  std::size_t size() const
+    { return this->Answers.size() + this->Requirements.size(); }
+
+private:
+  typedef std::pair<int, remus::common::MeshIOType> Query;
+
+  std::string Instance;
+  boost::uint64_t FactoryGeneration;
+  boost::uint64_t PoolGeneration;
+  boost::uint64_t Generation;
+  std::map<Query, std::string> Answers;
+  std::map<remus::common::MeshIOType, DigestedRequirements> Requirements;
+};
+
+}
+}
+}
+
+#endif
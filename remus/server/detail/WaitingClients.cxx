@@ -0,0 +1,127 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WaitingClients.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+WaitingClients::Waiter::Waiter(SocketHandle address,
+                               const std::vector<boost::uuids::uuid>& jobs,
+                               const boost::posix_time::ptime& deadline):
+  Address(address),
+  Jobs(jobs),
+  Deadline(deadline)
+{
+}
+
+//------------------------------------------------------------------------------
+WaitingClients::WaitingClients():
+  Clients(),
+  ChangedJobs()
+{
+}
+
+//------------------------------------------------------------------------------
+void WaitingClients::add(SocketHandle clientIdentity,
+                         const std::vector<boost::uuids::uuid>& jobs,
+                         const boost::posix_time::ptime& deadline)
+{
+  this->Clients.push_back( Waiter(clientIdentity, jobs, deadline) );
+}
+
+//------------------------------------------------------------------------------
+void WaitingClients::jobChanged(const boost::uuids::uuid& id)
+{
+  //only track changes for jobs that somebody is waiting on, otherwise
+  //the set would grow with every job the server finishes
+  if(this->Clients.empty())
+    {
+    return;
+    }
+  this->ChangedJobs.insert(id);
+}
+
+//------------------------------------------------------------------------------
+bool WaitingClients::isReady(const Waiter& waiter,
+                             const boost::posix_time::ptime& now) const
+{
+  if(waiter.Deadline <= now)
+    {
+    return true;
+    }
+
+  typedef std::vector<boost::uuids::uuid>::const_iterator JobIt;
+  for(JobIt i = waiter.Jobs.begin(); i != waiter.Jobs.end(); ++i)
+    {
+    if(this->ChangedJobs.count(*i) != 0)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+std::vector<WaitingClients::Waiter>
+WaitingClients::takeReady(const boost::posix_time::ptime& now)
+{
+  std::vector<Waiter> ready;
+  It i = this->Clients.begin();
+  while(i != this->Clients.end())
+    {
+    if(this->isReady(*i, now))
+      {
+      ready.push_back(*i);
+      i = this->Clients.erase(i);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+
+  //every client that cared about the changed jobs has been handed back
+  this->ChangedJobs.clear();
+  return ready;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t WaitingClients::millisecondsToNextDeadline(
+                                    const boost::posix_time::ptime& now,
+                                    boost::int64_t max_milliseconds) const
+{
+  boost::int64_t result = max_milliseconds;
+  for(ConstIt i = this->Clients.begin(); i != this->Clients.end(); ++i)
+    {
+    const boost::int64_t remaining = (i->Deadline - now).total_milliseconds();
+    result = std::min(result, remaining);
+    }
+  return std::max(result, boost::int64_t(0));
+}
+
+//------------------------------------------------------------------------------
+std::vector<WaitingClients::Waiter> WaitingClients::takeAll()
+{
+  std::vector<Waiter> all(this->Clients.begin(), this->Clients.end());
+  this->Clients.clear();
+  this->ChangedJobs.clear();
+  return all;
+}
+
+}
+}
+}
@@ -0,0 +1,93 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_WaitingClients_h
+#define remus_server_detail_WaitingClients_h
+
+#include <remus/server/detail/SocketIdentities.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <list>
+#include <set>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Holds the clients that have asked to be told when any job in a collection
+//of jobs has reached a terminal state. A client is parked here until one of
+//the jobs it is watching changes, or its deadline passes. The client is
+//blocked on its REQ socket, so each client only ever has a single entry.
+class WaitingClients
+{
+public:
+  struct Waiter
+  {
+    SocketHandle Address;
+    std::vector<boost::uuids::uuid> Jobs;
+    boost::posix_time::ptime Deadline;
+
+    Waiter(SocketHandle address,
+           const std::vector<boost::uuids::uuid>& jobs,
+           const boost::posix_time::ptime& deadline);
+  };
+
+  WaitingClients();
+
+  //park a client until one of the given jobs changes or the deadline passes
+  void add(SocketHandle clientIdentity,
+           const std::vector<boost::uuids::uuid>& jobs,
+           const boost::posix_time::ptime& deadline);
+
+  //state that the given job has reached a terminal state, any client
+  //watching this job will be returned by the next call to takeReady
+  void jobChanged(const boost::uuids::uuid& id);
+
+  //remove and return every client that has a watched job that changed
+  //or whose deadline is at or before now.
+  std::vector<Waiter> takeReady(const boost::posix_time::ptime& now);
+
+  //returns the number of milliseconds until the earliest deadline, clamped
+  //to be between 0 and the passed in max value
+  boost::int64_t millisecondsToNextDeadline(const boost::posix_time::ptime& now,
+                                            boost::int64_t max_milliseconds) const;
+
+  //returns true if no clients are waiting
+  bool empty() const { return this->Clients.empty(); }
+
+  //returns the number of clients that are waiting
+  std::size_t size() const { return this->Clients.size(); }
+
+  //remove all waiting clients, returning them so that they can be told
+  //the server is shutting down
+  std::vector<Waiter> takeAll();
+
+private:
+  bool isReady(const Waiter& waiter, const boost::posix_time::ptime& now) const;
+
+  typedef std::list<Waiter>::const_iterator ConstIt;
+  typedef std::list<Waiter>::iterator It;
+  std::list<Waiter> Clients;
+
+  //jobs that have changed since the last call to takeReady
+  std::set<boost::uuids::uuid> ChangedJobs;
+};
+
+}
+}
+}
+
+#endif
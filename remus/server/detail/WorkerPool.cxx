@@ -13,7 +13,7 @@
 #include <remus/server/detail/WorkerPool.h>
 
 #include <remus/server/detail/uuidHelper.h>
-#include <remus/proto/zmqSocketIdentity.h>
+#include <remus/server/detail/SocketIdentities.h>
 
 #include <algorithm>
 
@@ -22,29 +22,48 @@ namespace server{
 namespace detail{
 
 //------------------------------------------------------------------------------
-WorkerPool::WorkerInfo::WorkerInfo(const zmq::SocketIdentity& address,
+WorkerPool::WorkerInfo::WorkerInfo(SocketHandle address,
                                    const remus::proto::JobRequirements& reqs):
   NumberOfDesiredJobs(0),
   Reqs(reqs),
   Address(address),
-  IsResponsive(true)
+  IsResponsive(true),
+  Content(),
+  WaitingSince()
 {
 }
 
+//------------------------------------------------------------------------------
+void WorkerPool::WorkerInfo::addJobs(int numberOfJobs)
+{
+  //the worker starts waiting when it first asks for a job, asking for
+  //more jobs doesn't move it back in line
+  if(this->NumberOfDesiredJobs <= 0)
+    {
+    this->WaitingSince = boost::posix_time::microsec_clock::local_time();
+    }
+  this->NumberOfDesiredJobs += numberOfJobs;
+}
+
 //------------------------------------------------------------------------------
 WorkerPool::WorkerPool():
-  Pool()
+  Pool(),
+  FairnessTimeout(1000),
+  Generation(0),
+  Waiting(),
+  HeldContent()
 {
 
 }
 
 //------------------------------------------------------------------------------
-bool WorkerPool::addWorker(zmq::SocketIdentity workerIdentity,
+bool WorkerPool::addWorker(SocketHandle workerIdentity,
                            const remus::proto::JobRequirements& reqs)
 {
   if(!this->haveWorker(workerIdentity,reqs))
     {
     this->Pool.push_back( WorkerPool::WorkerInfo(workerIdentity,reqs) );
+    ++this->Generation;
     }
   return true;
 }
@@ -87,7 +106,18 @@ bool WorkerPool::haveWaitingWorker(
 }
 
 //------------------------------------------------------------------------------
-bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
+bool WorkerPool::haveWorker(SocketHandle address) const
+{
+  bool found = false;
+  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
+    {
+    found = ( i->Address == address );
+    }
+  return found;
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::haveWorker(SocketHandle address,
                             const remus::proto::JobRequirements& reqs) const
 {
   bool found = false;
@@ -99,8 +129,9 @@ bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
 }
 
 //------------------------------------------------------------------------------
-bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
-                              const remus::proto::JobRequirements& reqs)
+bool WorkerPool::readyForWork(SocketHandle address,
+                              const remus::proto::JobRequirements& reqs,
+                              std::size_t numberOfJobs)
 {
   //a worker can be registered multiple times, we need to iterate
   //over the entire vector and find the correct address and reqs that match
@@ -112,8 +143,14 @@ bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
     {
     if(i->Address == address && i->Reqs == reqs)
       {
+      const bool wasWaiting = i->isWaitingForWork();
+      this->Generation += i->IsResponsive ? 0 : 1;
       i->IsResponsive = true; //mark the worker as responsive
-      i->addJob();
+      i->addJobs(static_cast<int>(numberOfJobs));
+      if(wasWaiting != i->isWaitingForWork())
+        {
+        this->waitingChanged(i->Reqs, true);
+        }
       ++count;
       }
     }
@@ -122,59 +159,287 @@ bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
 
 
 //------------------------------------------------------------------------------
-zmq::SocketIdentity WorkerPool::takeWorker(
+bool WorkerPool::readyForWork(SocketHandle address,
+                              const remus::proto::JobRequirements& reqs,
+                              const remus::proto::ContentSummary& content,
+                              const remus::proto::ContentChanges& changes,
+                              std::size_t numberOfJobs)
+{
+  bool found = this->readyForWork(address, reqs, numberOfJobs);
+  for(It i=this->Pool.begin(); found && i != this->Pool.end(); ++i)
+    {
+    if(i->Address == address && i->Reqs == reqs)
+      {
+      i->Content = content;
+      }
+    }
+
+  if(found && !changes.empty())
+    {
+    std::set<std::string>& held = this->HeldContent[address];
+    typedef std::set<std::string>::const_iterator DigestIt;
+    for(DigestIt i = changes.Dropped.begin(); i != changes.Dropped.end(); ++i)
+      {
+      held.erase(*i);
+      }
+    held.insert(changes.Added.begin(), changes.Added.end());
+    }
+  return found;
+}
+
+//------------------------------------------------------------------------------
+std::size_t WorkerPool::numberOfWaitingWorkers(
+                           const remus::proto::JobRequirements& reqs) const
+{
+  std::size_t count = 0;
+  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+    {
+    if( i->Reqs == reqs && i->isWaitingForWork() )
+      { ++count; }
+    }
+  return count;
+}
+
+//------------------------------------------------------------------------------
+std::size_t WorkerPool::numberOfJobsWanted(SocketHandle address,
+                           const remus::proto::JobRequirements& reqs) const
+{
+  std::size_t count = 0;
+  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+    {
+    if( i->Address == address && i->Reqs == reqs && i->isWaitingForWork() )
+      { count += static_cast<std::size_t>(i->NumberOfDesiredJobs); }
+    }
+  return count;
+}
+
+//------------------------------------------------------------------------------
+SocketHandle WorkerPool::takeWorker(
                              const remus::proto::JobRequirements& reqs)
 {
-  bool found = false;
-  It i;
-  for(i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
+  return this->takeWorker(reqs, std::vector<std::string>());
+}
+
+//------------------------------------------------------------------------------
+SocketHandle WorkerPool::takeWorker(
+                             const remus::proto::JobRequirements& reqs,
+                             const std::vector<std::string>& digests)
+{
+  const boost::posix_time::ptime now =
+                              boost::posix_time::microsec_clock::local_time();
+  const boost::posix_time::ptime overdue =
+                  now - boost::posix_time::milliseconds(this->FairnessTimeout);
+
+  //the worker that has waited the longest past the fairness timeout wins,
+  //otherwise the worker that holds the most of the content, where ties
+  //go to the worker that is first in line
+  It chosen = this->Pool.end();
+  It longestWaiting = this->Pool.end();
+  std::size_t bestScore = 0;
+  for(It i=this->Pool.begin(); i != this->Pool.end(); ++i)
     {
-    found = (i->Reqs == reqs) && (i->isWaitingForWork());
+    if( !(i->Reqs == reqs) || !i->isWaitingForWork() )
+      {
+      continue;
+      }
+
+    if(longestWaiting == this->Pool.end() ||
+       i->WaitingSince < longestWaiting->WaitingSince)
+      {
+      longestWaiting = i;
+      }
+
+    std::size_t score = 0;
+    for(std::size_t d=0; d < digests.size(); ++d)
+      {
+      score += i->Content.mayContain(digests[d]) ? 1 : 0;
+      }
+    if(chosen == this->Pool.end() || score > bestScore)
+      {
+      chosen = i;
+      bestScore = score;
+      }
+    }
+
+  SocketHandle workerIdentity = 0;
+  if(chosen == this->Pool.end())
+    {
+    return workerIdentity;
     }
 
-  zmq::SocketIdentity workerIdentity;
+  if(longestWaiting->WaitingSince <= overdue)
+    {
+    chosen = longestWaiting;
+    }
 
-  if(found)
+  //take the worker id as it matches the reqs
+  workerIdentity = chosen->Address;
+  chosen->takesJob();
+  chosen->WaitingSince = now;
+  if(!chosen->isWaitingForWork())
     {
-    --i; //we have to decrement the iterator, as the forloop increments it one
-    //past the found position.
+    this->waitingChanged(chosen->Reqs, false);
+    }
+
+  //now that the worker has taken the job, we move him to the back of
+  //the vector so he is the last worker to take a job of that type again,
+  //this allows us to handle multiple workers taking jobs
+  std::rotate(chosen, chosen + 1, this->Pool.end());
 
-    //take the worker id as it matches the reqs
-    workerIdentity = zmq::SocketIdentity(i->Address);
-    i->takesJob();
+  return workerIdentity;
+}
+
+//------------------------------------------------------------------------------
+SocketHandle WorkerPool::takeOtherWorker(
+                             const remus::proto::JobRequirements& reqs,
+                             SocketHandle excluded)
+{
+  It chosen = this->Pool.end();
+  for(It i=this->Pool.begin(); i != this->Pool.end(); ++i)
+    {
+    if( i->Reqs == reqs && i->isWaitingForWork() && !(i->Address == excluded) &&
+        (chosen == this->Pool.end() || i->WaitingSince < chosen->WaitingSince) )
+      {
+      chosen = i;
+      }
+    }
 
-    //now that the worker has taken the job, we move him to the back of
-    //the vector so he is the last worker to take a job of that type again,
-    //this allows us to handle multiple workers taking jobs
-    std::rotate(this->Pool.begin(), this->Pool.begin() + 1,this->Pool.end());
+  SocketHandle workerIdentity = 0;
+  if(chosen == this->Pool.end())
+    {
+    return workerIdentity;
     }
 
+  workerIdentity = chosen->Address;
+  chosen->takesJob();
+  chosen->WaitingSince = boost::posix_time::microsec_clock::local_time();
+  if(!chosen->isWaitingForWork())
+    {
+    this->waitingChanged(chosen->Reqs, false);
+    }
+  std::rotate(chosen, chosen + 1, this->Pool.end());
   return workerIdentity;
 }
 
 //------------------------------------------------------------------------------
-void WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor)
+bool WorkerPool::takeAnotherJob(SocketHandle address,
+                                const remus::proto::JobRequirements& reqs)
+{
+  for(It i=this->Pool.begin(); i != this->Pool.end(); ++i)
+    {
+    if( i->Address == address && i->Reqs == reqs && i->isWaitingForWork() )
+      {
+      i->takesJob();
+      if(!i->isWaitingForWork())
+        {
+        this->waitingChanged(i->Reqs, false);
+        }
+      return true;
+      }
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::fairnessTimeout(boost::int64_t milliseconds)
+{
+  this->FairnessTimeout = milliseconds < 0 ? 0 : milliseconds;
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::holdsContent(SocketHandle address,
+                              const std::string& digest) const
+{
+  std::map<SocketHandle, std::set<std::string> >::const_iterator held =
+                                              this->HeldContent.find(address);
+  return held != this->HeldContent.end() && held->second.count(digest) != 0;
+}
+
+//------------------------------------------------------------------------------
+std::set<SocketHandle>
+WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor)
 {
   //Remove all workers that we know are really dead
   WorkerPool::DeadWorkers dead(monitor);
 
+  //remember the dead workers first, remove_if leaves the items past the
+  //new end in an unspecified state
+  std::set<SocketHandle> purged;
+  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+    {
+    if(dead(*i))
+      {
+      purged.insert(i->Address);
+      if(i->isWaitingForWork())
+        {
+        this->waitingChanged(i->Reqs, false);
+        }
+      }
+    }
+
   //remove if moves all bad items to end of the vector and returns
   //an iterator to the new end. Remove if is easiest way to remove from middle
   It newEnd = std::remove_if(this->Pool.begin(),this->Pool.end(),dead);
 
   for(It i=this->Pool.begin(); i != newEnd; ++i)
     {
+    const bool wasResponsive = i->IsResponsive;
+    const bool wasWaiting = i->isWaitingForWork();
     i->IsResponsive = !monitor.isUnresponsive(i->Address);
+    this->Generation += (wasResponsive != i->IsResponsive) ? 1 : 0;
+    if(wasWaiting != i->isWaitingForWork())
+      {
+      this->waitingChanged(i->Reqs, i->isWaitingForWork());
+      }
     }
 
   //erase all the dead workers to free up space
+  this->Generation += (newEnd != this->Pool.end()) ? 1 : 0;
   this->Pool.erase(newEnd,this->Pool.end());
+
+  typedef std::map<SocketHandle, std::set<std::string> >::iterator
+                                                                      HeldIt;
+  HeldIt held = this->HeldContent.begin();
+  while(held != this->HeldContent.end())
+    {
+    if(monitor.isDead(held->first))
+      {
+      purged.insert(held->first);
+      this->HeldContent.erase(held++);
+      }
+    else
+      {
+      ++held;
+      }
+    }
+  return purged;
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::waitingChanged(const remus::proto::JobRequirements& reqs,
+                                bool waiting)
+{
+  if(waiting)
+    {
+    std::size_t& count = this->Waiting[reqs];
+    this->Generation += (count == 0) ? 1 : 0;
+    ++count;
+    return;
+    }
+
+  std::map<remus::proto::JobRequirements, std::size_t>::iterator i =
+                                                      this->Waiting.find(reqs);
+  if(i != this->Waiting.end() && --i->second == 0)
+    {
+    this->Waiting.erase(i);
+    ++this->Generation;
+    }
 }
 
 //------------------------------------------------------------------------------
-std::set<zmq::SocketIdentity> WorkerPool::allWorkers() const
+std::set<SocketHandle> WorkerPool::allWorkers() const
 {
-  std::set<zmq::SocketIdentity> workerAddresses;
+  std::set<SocketHandle> workerAddresses;
   for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
     {
     workerAddresses.insert(i->Address);
@@ -183,9 +448,9 @@ std::set<zmq::SocketIdentity> WorkerPool::allWorkers() const
 }
 
 //------------------------------------------------------------------------------
-std::set<zmq::SocketIdentity> WorkerPool::allWorkersWantingWork() const
+std::set<SocketHandle> WorkerPool::allWorkersWantingWork() const
 {
-  std::set<zmq::SocketIdentity> workerAddresses;
+  std::set<SocketHandle> workerAddresses;
   for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
     {
     if(i->isWaitingForWork())
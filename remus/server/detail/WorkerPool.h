@@ -13,12 +13,18 @@
 #ifndef remus_server_detail_WorkerPool_h
 #define remus_server_detail_WorkerPool_h
 
+#include <remus/proto/ContentSummary.h>
 #include <remus/proto/JobRequirements.h>
-#include <remus/proto/zmqSocketIdentity.h>
 
+#include <remus/server/detail/SocketIdentities.h>
 #include <remus/server/detail/SocketMonitor.h>
 
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 namespace remus{
@@ -30,7 +36,7 @@ class WorkerPool
 public:
   WorkerPool();
 
-  bool addWorker(zmq::SocketIdentity workerIdentity,
+  bool addWorker(SocketHandle workerIdentity,
                  const remus::proto::JobRequirements& reqs);
 
   //return all the MeshIOTypes that workers have registered to support.
@@ -47,43 +53,106 @@ public:
   //do we have any worker waiting to take this type of job
   bool haveWaitingWorker(const remus::proto::JobRequirements& reqs) const;
 
-  //do we have a worker with this address?
-  bool haveWorker(const zmq::SocketIdentity& address,
+  //do we have a worker with this address, for any requirements
+  bool haveWorker(SocketHandle address) const;
+
+  //do we have a worker with this address for these requirements
+  bool haveWorker(SocketHandle address,
                   const remus::proto::JobRequirements& reqs) const;
 
-  //mark a worker with the given address ready to take a job.
-  //returns false if a worker with that address wasn't found
-  bool readyForWork(const zmq::SocketIdentity& address,
-                    const remus::proto::JobRequirements& reqs);
+  //mark a worker with the given address ready to take the given number
+  //of jobs. returns false if a worker with that address wasn't found
+  bool readyForWork(SocketHandle address,
+                    const remus::proto::JobRequirements& reqs,
+                    std::size_t numberOfJobs = 1);
+
+  //mark a worker ready to take jobs, and record the summary of the
+  //content the worker holds, and the content it acknowledged starting or
+  //stopping to hold, that came with the request
+  bool readyForWork(SocketHandle address,
+                    const remus::proto::JobRequirements& reqs,
+                    const remus::proto::ContentSummary& content,
+                    const remus::proto::ContentChanges& changes,
+                    std::size_t numberOfJobs = 1);
+
+  //return the number of waiting workers that can take this type of job
+  std::size_t numberOfWaitingWorkers(
+                          const remus::proto::JobRequirements& reqs) const;
+
+  //return the number of jobs of this type the worker is still waiting for
+  std::size_t numberOfJobsWanted(SocketHandle address,
+                          const remus::proto::JobRequirements& reqs) const;
 
   //returns the worker address and marks that the worker has taken a job.
   //this doesn't remove the worker from the worker pool, it just decrements
   //the number of jobs the worker is allowed to take, and puts in at the worker
   //queue
-  zmq::SocketIdentity takeWorker(const remus::proto::JobRequirements& reqs);
-
-  //remove all workers that haven't responded based on the passed in monitor
-  void purgeDeadWorkers(remus::server::detail::SocketMonitor monitor);
+  SocketHandle takeWorker(const remus::proto::JobRequirements& reqs);
+
+  //returns the address of a worker to run a job that uses content with the
+  //given digests, preferring the waiting worker that holds the most of that
+  //content. A worker that has been waiting longer than the fairness timeout
+  //is taken before any other, so that workers holding popular content can't
+  //starve the rest of the pool
+  SocketHandle takeWorker(const remus::proto::JobRequirements& reqs,
+                          const std::vector<std::string>& digests);
+
+  //returns the address of the waiting worker that has waited the longest,
+  //and isn't the excluded worker, and marks that it has taken a job.
+  //Returns handle zero if there is no such worker
+  SocketHandle takeOtherWorker(const remus::proto::JobRequirements& reqs,
+                               SocketHandle excluded);
+
+  //marks that the worker we just took has taken another job of the same
+  //type, so that several jobs can be sent to it in a single batch.
+  //returns false if the worker isn't waiting for another job
+  bool takeAnotherJob(SocketHandle address,
+                      const remus::proto::JobRequirements& reqs);
+
+  //set how long in milliseconds a waiting worker can be passed over for a
+  //worker that holds the content of a job. Defaults to one second
+  void fairnessTimeout(boost::int64_t milliseconds);
+  boost::int64_t fairnessTimeout() const { return FairnessTimeout; }
+
+  //returns true if the worker has acknowledged holding the content with
+  //the given digest, and hasn't told us it dropped it since
+  bool holdsContent(SocketHandle address,
+                    const std::string& digest) const;
+
+  //remove all workers that haven't responded based on the passed in monitor.
+  //Returns the workers that were removed, so their handles can be released
+  std::set<SocketHandle> purgeDeadWorkers(
+                              remus::server::detail::SocketMonitor monitor);
 
   //return the socket identity of all workers
-  std::set<zmq::SocketIdentity> allWorkers() const;
+  std::set<SocketHandle> allWorkers() const;
 
   //return the socket identity of all workers that want to work on a job
-  std::set<zmq::SocketIdentity> allWorkersWantingWork() const;
+  std::set<SocketHandle> allWorkersWantingWork() const;
+
+  //returns a counter that changes whenever the answers of supportedIOTypes,
+  //waitingWorkerRequirements or haveWaitingWorker might change. That is
+  //when a worker registers, stops or starts responding or dies, or when
+  //the first worker of some requirements starts waiting for work or the
+  //last one stops. Workers moving between waiting and busy while others
+  //of their requirements are still waiting don't change it
+  boost::uint64_t generation() const { return Generation; }
 
 private:
   struct WorkerInfo
   {
     int NumberOfDesiredJobs;
     remus::proto::JobRequirements Reqs;
-    zmq::SocketIdentity Address;
+    SocketHandle Address;
     bool IsResponsive; //as in we are getting heartbeating from the worker
+    remus::proto::ContentSummary Content;
+    boost::posix_time::ptime WaitingSince;
 
-    WorkerInfo(const zmq::SocketIdentity& address,
+    WorkerInfo(SocketHandle address,
                const remus::proto::JobRequirements& type);
 
     bool isWaitingForWork() const { return NumberOfDesiredJobs > 0 && IsResponsive; }
-    void addJob() { ++NumberOfDesiredJobs; }
+    void addJobs(int numberOfJobs);
     void takesJob() { --NumberOfDesiredJobs; }
   };
 
@@ -97,9 +166,25 @@ private:
   };
 
 
+  //record that a worker of the requirements started or stopped waiting
+  //for work, bumping the generation when that changes which requirements
+  //have a waiting worker
+  void waitingChanged(const remus::proto::JobRequirements& reqs,
+                      bool waiting);
+
   typedef std::vector<WorkerInfo>::const_iterator ConstIt;
   typedef std::vector<WorkerInfo>::iterator It;
   std::vector<WorkerInfo> Pool;
+  boost::int64_t FairnessTimeout;
+  boost::uint64_t Generation;
+
+  //the number of workers waiting for work, for every requirements that
+  //has at least one
+  std::map<remus::proto::JobRequirements, std::size_t> Waiting;
+
+  //the digests of the content each worker acknowledged holding. A worker
+  //process caches content for all the requirements it registered
+  std::map<SocketHandle, std::set<std::string> > HeldContent;
 };
 
 }
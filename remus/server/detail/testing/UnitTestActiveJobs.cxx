@@ -11,6 +11,7 @@
 //=============================================================================
 #include <remus/server/detail/ActiveJobs.h>
 
+#include <remus/common/MD5Hash.h>
 #include <remus/common/SleepFor.h>
 #include <remus/testing/Testing.h>
 
@@ -26,12 +27,16 @@ remus::server::detail::SocketMonitor make_Monitor( )
   return sm;
 }
 
-//makes a random socket identity
-zmq::SocketIdentity make_socketId()
+typedef remus::server::detail::SocketHandle SocketHandle;
+
+//makes a random socket identity, and interns it like the server does
+SocketHandle make_socketId()
 {
+  static remus::server::detail::SocketIdentities identities;
   boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
   const std::string str_id = boost::lexical_cast<std::string>(new_uid);
-  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+  return identities.intern(remus::server::detail::SocketIdentities::WORKER,
+                           zmq::SocketIdentity(str_id.c_str(),str_id.size()));
 }
 
 
@@ -74,15 +79,15 @@ void verify_add_remove_jobs()
     }
 
   //verify the contents of the set returned by activeWorkers is correct
-  std::set< zmq::SocketIdentity > valid_workers = jobs.activeWorkers();
+  std::set< SocketHandle > valid_workers = jobs.activeWorkers();
   REMUS_ASSERT( (valid_workers.size() == 4) );
   for(int i=1; i < 5; ++i)
     {
-    zmq::SocketIdentity workerAddress = jobs.workerAddress(uuids_used[i]);
+    SocketHandle workerAddress = jobs.workerAddress(uuids_used[i]);
     REMUS_ASSERT( (valid_workers.count(workerAddress) == 1) );
     }
   //verify that we don't have the removed jobs
-  zmq::SocketIdentity workerAddress = jobs.workerAddress(uuids_used[0]);
+  SocketHandle workerAddress = jobs.workerAddress(uuids_used[0]);
   REMUS_ASSERT( (valid_workers.count(workerAddress) == 0) );
   REMUS_ASSERT( (jobs.haveUUID(uuids_used[0]) == false) );
 }
@@ -255,13 +260,13 @@ void verify_refresh_jobs()
   MonitorType monitor = make_Monitor( );
 
   std::vector< boost::uuids::uuid > uuids_used;
-  std::vector< zmq::SocketIdentity > socketIds_used;
+  std::vector< SocketHandle > socketIds_used;
 
   for(int i=0; i < 5; ++i)
     {
     uuids_used.push_back( remus::testing::UUIDGenerator() );
 
-    const zmq::SocketIdentity sId =  make_socketId();
+    const SocketHandle sId =  make_socketId();
     monitor.refresh(sId);
     socketIds_used.push_back( sId );
     }
@@ -300,7 +305,7 @@ void verify_refresh_jobs()
   boost::uuids::uuid finished_job_uuid = remus::testing::UUIDGenerator();
   remus::proto::JobResult result_with_data =
                         remus::proto::make_JobResult(finished_job_uuid,"data");
-  const zmq::SocketIdentity finishedJobSocketId =  make_socketId();
+  const SocketHandle finishedJobSocketId =  make_socketId();
   jobs.add(finishedJobSocketId, finished_job_uuid);
   jobs.updateResult(result_with_data);
 
@@ -317,13 +322,13 @@ void verify_expire_jobs()
   MonitorType monitor = make_Monitor( );
 
   std::vector< boost::uuids::uuid > uuids_used;
-  std::vector< zmq::SocketIdentity > socketIds_used;
+  std::vector< SocketHandle > socketIds_used;
 
   for(int i=0; i < 5; ++i)
     {
     uuids_used.push_back( remus::testing::UUIDGenerator() );
 
-    const zmq::SocketIdentity sId =  make_socketId();
+    const SocketHandle sId =  make_socketId();
     monitor.refresh(sId);
     socketIds_used.push_back( sId );
     }
@@ -346,12 +351,150 @@ void verify_expire_jobs()
       { monitor.refresh(socketIds_used[j]); }
     }
 
-  jobs.markExpiredJobs( monitor );
+  std::set< boost::uuids::uuid > expired = jobs.markExpiredJobs( monitor );
+  REMUS_ASSERT( (expired.size() == 2) );
   for(int i=0; i < 3; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::QUEUED) ); }
   for(int i=3; i < 5; ++i)
-    { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::EXPIRED) ); }
+    {
+    REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::EXPIRED) );
+    REMUS_ASSERT( (expired.count(uuids_used[i]) == 1) );
+    }
+
+  //jobs that have already expired aren't reported a second time
+  expired = jobs.markExpiredJobs( monitor );
+  REMUS_ASSERT( (expired.size() == 0) );
+}
+
+void verify_requeue_unstarted_jobs()
+{
+  typedef remus::server::detail::SocketMonitor MonitorType;
+  MonitorType monitor = make_Monitor( );
+
+  using namespace remus::meshtypes;
+  remus::proto::JobSubmission sub( remus::proto::make_JobRequirements(
+      remus::common::make_MeshIOType(Mesh2D(),Mesh3D()), "", "") );
+
+  //jobs 0 and 1 are prefetched, job 2 is started, job 3 has reported
+  //progress and job 4 was added without the job so it can't be requeued
+  std::vector< remus::worker::Job > jobs_used;
+  for(int i=0; i < 5; ++i)
+    { jobs_used.push_back( remus::worker::Job(remus::testing::UUIDGenerator(),
+                                              sub) ); }
+
+  const SocketHandle sId = make_socketId();
+  monitor.refresh(sId);
+
+  remus::server::detail::ActiveJobs jobs;
+  for(int i=0; i < 4; ++i)
+    { REMUS_ASSERT( (jobs.add(sId, jobs_used[i]) == true) ); }
+  REMUS_ASSERT( (jobs.add(sId, jobs_used[4].id()) == true) );
+  REMUS_ASSERT( (jobs.add(sId, jobs_used[0]) == false) );
+
+  jobs.markStarted(jobs_used[2].id());
+  jobs.updateStatus( remus::proto::JobStatus(jobs_used[3].id(),
+                                             remus::proto::JobProgress(5)) );
+
+  //prefetched jobs still are queued, not in progress
+  REMUS_ASSERT( (jobs.status(jobs_used[0].id()).queued() == true) );
+  REMUS_ASSERT( (jobs.status(jobs_used[2].id()).queued() == true) );
+
+  //nothing is taken while the worker is alive
+  REMUS_ASSERT( (jobs.takeUnstartedJobs(monitor).size() == 0) );
+
+  //let the worker die
+  remus::common::SleepForMillisec(300);
+
+  std::vector< remus::worker::Job > unstarted =
+                                              jobs.takeUnstartedJobs(monitor);
+  REMUS_ASSERT( (unstarted.size() == 2) );
+  for(std::size_t i=0; i < unstarted.size(); ++i)
+    {
+    REMUS_ASSERT( (unstarted[i].id() == jobs_used[0].id() ||
+                   unstarted[i].id() == jobs_used[1].id()) );
+    REMUS_ASSERT( (unstarted[i].submission() == sub) );
+    REMUS_ASSERT( (jobs.haveUUID(unstarted[i].id()) == false) );
+    }
 
+  //everything else expires as before
+  std::set< boost::uuids::uuid > expired = jobs.markExpiredJobs( monitor );
+  REMUS_ASSERT( (expired.size() == 3) );
+  for(int i=2; i < 5; ++i)
+    { REMUS_ASSERT( (expired.count(jobs_used[i].id()) == 1) ); }
+}
+
+void verify_retried_jobs()
+{
+  const SocketHandle sId = make_socketId();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  remus::server::detail::ActiveJobs jobs;
+  jobs.add(sId, id);
+  REMUS_ASSERT( (jobs.status(id).retries() == 0) );
+
+  //the retry count survives every status change the worker sends
+  jobs.markRetried(id, 2);
+  REMUS_ASSERT( (jobs.status(id).retries() == 2) );
+  jobs.updateStatus( remus::proto::JobStatus(id,remus::proto::JobProgress(5)) );
+  REMUS_ASSERT( (jobs.status(id).inProgress() == true) );
+  REMUS_ASSERT( (jobs.status(id).retries() == 2) );
+
+  jobs.updateResult( remus::proto::JobResult(id) );
+  REMUS_ASSERT( (jobs.status(id).finished() == true) );
+  REMUS_ASSERT( (jobs.status(id).retries() == 2) );
+}
+
+void verify_reassign_jobs()
+{
+  typedef remus::server::detail::SocketMonitor MonitorType;
+  MonitorType monitor = make_Monitor( );
+
+  const SocketHandle dies = make_socketId();
+  const SocketHandle lives = make_socketId();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  remus::server::detail::ActiveJobs jobs;
+  jobs.add(dies, id);
+  jobs.reassign(id, lives);
+  REMUS_ASSERT( (jobs.workerAddress(id) == lives) );
+
+  //only the worker the job was moved to decides if it expires
+  remus::common::SleepForMillisec(300);
+  monitor.refresh(lives);
+  REMUS_ASSERT( (jobs.markExpiredJobs( monitor ).size() == 0) );
+  REMUS_ASSERT( (jobs.status(id).queued() == true) );
+}
+
+void verify_hash_result()
+{
+  const SocketHandle sId = make_socketId();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(1000);
+
+  remus::server::detail::ActiveJobs jobs;
+  jobs.add(sId, id);
+  REMUS_ASSERT( (jobs.hashResult(id, 0, 400).empty() == true) );
+  jobs.updateResult( remus::proto::make_JobResult(id, data) );
+
+  //the checksum is only known once all of the result has been fed, and
+  //a chunk that is asked for again isn't fed twice
+  REMUS_ASSERT( (jobs.hashResult(id, 0, 400).empty() == true) );
+  REMUS_ASSERT( (jobs.hashResult(id, 0, 400).empty() == true) );
+  REMUS_ASSERT( (jobs.hashResult(id, 400, 400).empty() == true) );
+  REMUS_ASSERT( (jobs.hashResult(id, 800, 200) ==
+                 remus::common::MD5Hash(data)) );
+  REMUS_ASSERT( (jobs.hashResult(id, 800, 200) ==
+                 remus::common::MD5Hash(data)) );
+
+  //a part that was skipped is fed before the chunk
+  jobs.updateResult( remus::proto::make_JobResult(id, data) );
+  REMUS_ASSERT( (jobs.hashResult(id, 800, 200) ==
+                 remus::common::MD5Hash(data)) );
+
+  //an empty result has the checksum of nothing
+  jobs.updateResult( remus::proto::make_JobResult(id, std::string()) );
+  REMUS_ASSERT( (jobs.hashResult(id, 0, 0) ==
+                 remus::common::MD5Hash(std::string())) );
 }
 
 } //namespace
@@ -368,5 +511,13 @@ int UnitTestActiveJobs(int, char *[])
 
   verify_expire_jobs();
 
+  verify_requeue_unstarted_jobs();
+
+  verify_retried_jobs();
+
+  verify_reassign_jobs();
+
+  verify_hash_result();
+
   return 0;
 }
@@ -0,0 +1,136 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/ContentStore.h>
+
+#include <remus/testing/Testing.h>
+
+#include <sstream>
+
+namespace {
+
+using remus::common::ContentFormat;
+using remus::proto::JobContent;
+
+void verify_references()
+{
+  remus::server::detail::ContentStore store;
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+
+  const JobContent geometry = remus::proto::make_JobContent(
+                          remus::testing::BinaryDataGenerator(1024 * 64),
+                          ContentFormat::BSON);
+  const JobContent params = remus::proto::make_JobContent(
+                          remus::testing::AsciiStringGenerator(128));
+
+  REMUS_ASSERT( (store.have(geometry.hash()) == false) );
+  store.add(first, geometry);
+  store.add(first, params);
+  REMUS_ASSERT( (store.size() == 2) );
+  REMUS_ASSERT( (store.have(geometry.hash()) == true) );
+
+  //a second job referencing the content shares the data
+  JobContent shared;
+  REMUS_ASSERT( (store.retain(second, geometry.hash(),
+                              ContentFormat::BSON, shared) == true) );
+  REMUS_ASSERT( (shared.data() == geometry.data()) );
+  REMUS_ASSERT( (shared == geometry) );
+
+  //content with the same digest but a different format doesn't match
+  JobContent other;
+  REMUS_ASSERT( (store.retain(second, geometry.hash(),
+                              ContentFormat::XML, other) == false) );
+
+  //finding content doesn't add a reference to it
+  JobContent found;
+  REMUS_ASSERT( (store.find(geometry.hash(), found) == true) );
+  REMUS_ASSERT( (found.data() == geometry.data()) );
+  REMUS_ASSERT( (store.find("not a digest", found) == false) );
+
+  //adding content we already hold only adds a reference
+  store.add(second, params);
+  REMUS_ASSERT( (store.size() == 2) );
+
+  //the content stays until every job referencing it is released
+  store.release(first);
+  REMUS_ASSERT( (store.size() == 2) );
+  REMUS_ASSERT( (store.have(geometry.hash()) == true) );
+
+  store.release(second);
+  REMUS_ASSERT( (store.size() == 0) );
+  REMUS_ASSERT( (store.have(geometry.hash()) == false) );
+  REMUS_ASSERT( (store.retain(second, geometry.hash(),
+                              ContentFormat::BSON, shared) == false) );
+
+  //releasing a job without references does nothing
+  store.release(remus::testing::UUIDGenerator());
+}
+
+void verify_missing()
+{
+  remus::server::detail::ContentStore store;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  const JobContent held = remus::proto::make_JobContent(
+                          remus::testing::BinaryDataGenerator(2048));
+  const JobContent notHeld = remus::proto::make_JobContent(
+                          remus::testing::BinaryDataGenerator(4096));
+  store.add(id, held);
+
+  remus::proto::ContentDigests digests;
+  digests["held"] = held.hash();
+  digests["not held"] = notHeld.hash();
+
+  remus::proto::ContentDigests missing = store.missing(digests);
+  REMUS_ASSERT( (missing.size() == 1) );
+  REMUS_ASSERT( (missing.count("not held") == 1) );
+  REMUS_ASSERT( (missing["not held"] == notHeld.hash()) );
+
+  //the digests survive a trip over the wire
+  std::stringstream buffer;
+  remus::proto::writeContentDigests(buffer, digests);
+  REMUS_ASSERT( (remus::proto::readContentDigests(buffer) == digests) );
+}
+
+
+void verify_sent_digest()
+{
+  remus::server::detail::ContentStore store;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  const JobContent content = remus::proto::make_JobContent(
+                          remus::testing::BinaryDataGenerator(1024 * 64));
+  const std::string digest = content.hash();
+
+  //corrupt the digest that is sent along with the content
+  std::string wire = remus::proto::to_string(content);
+  wire.replace(wire.size() - 33, 32, std::string(32,'0'));
+  const JobContent received = remus::proto::to_JobContent(wire);
+  REMUS_ASSERT( (received.hash() != digest) );
+
+  //the content is stored under the digest of its data
+  store.add(id, received);
+  REMUS_ASSERT( (store.have(digest) == true) );
+  REMUS_ASSERT( (store.have(std::string(32,'0')) == false) );
+}
+
+}
+
+int UnitTestContentStore(int, char *[])
+{
+  verify_references();
+  verify_missing();
+  verify_sent_digest();
+  return 0;
+}
@@ -0,0 +1,121 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/JobDeadlines.h>
+
+#include <remus/testing/Testing.h>
+
+namespace {
+
+typedef remus::server::detail::JobDeadlines JobDeadlines;
+
+boost::posix_time::ptime start()
+{
+  return boost::posix_time::microsec_clock::local_time();
+}
+
+boost::posix_time::ptime after(const boost::posix_time::ptime& t,
+                               boost::int64_t milliseconds)
+{
+  return t + boost::posix_time::milliseconds(milliseconds);
+}
+
+void verify_queue_deadlines()
+{
+  JobDeadlines deadlines;
+  const boost::posix_time::ptime t = start();
+
+  const boost::uuids::uuid forever = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+
+  //jobs without a timeout aren't tracked
+  deadlines.add(forever, 0, 0, t);
+  REMUS_ASSERT( (deadlines.empty() == true) );
+  REMUS_ASSERT( (deadlines.millisecondsToNextDeadline(t, 500) == 500) );
+
+  deadlines.add(second, 200, 0, t);
+  deadlines.add(first, 100, 0, t);
+  REMUS_ASSERT( (deadlines.size() == 2) );
+  REMUS_ASSERT( (deadlines.millisecondsToNextDeadline(t, 500) == 100) );
+  REMUS_ASSERT( (deadlines.millisecondsToNextDeadline(after(t,60), 500) == 40) );
+  REMUS_ASSERT( (deadlines.millisecondsToNextDeadline(after(t,900), 500) == 0) );
+
+  //nothing has expired yet
+  REMUS_ASSERT( (deadlines.takeExpired(after(t,99)).empty() == true) );
+
+  //deadlines expire in the order they pass, and only once
+  std::vector<JobDeadlines::Expired> expired = deadlines.takeExpired(after(t,200));
+  REMUS_ASSERT( (expired.size() == 2) );
+  REMUS_ASSERT( (expired[0].Id == first) );
+  REMUS_ASSERT( (expired[0].Type == JobDeadlines::QUEUE) );
+  REMUS_ASSERT( (expired[1].Id == second) );
+  REMUS_ASSERT( (deadlines.empty() == true) );
+  REMUS_ASSERT( (deadlines.takeExpired(after(t,1000)).empty() == true) );
+
+  //removed jobs never expire
+  deadlines.add(first, 100, 0, t);
+  deadlines.remove(first);
+  REMUS_ASSERT( (deadlines.empty() == true) );
+  REMUS_ASSERT( (deadlines.takeExpired(after(t,1000)).empty() == true) );
+}
+
+void verify_run_deadlines()
+{
+  JobDeadlines deadlines;
+  const boost::posix_time::ptime t = start();
+
+  const boost::uuids::uuid queueOnly = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid runOnly = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid both = remus::testing::UUIDGenerator();
+
+  deadlines.add(queueOnly, 100, 0, t);
+  deadlines.add(runOnly, 0, 100, t);
+  deadlines.add(both, 100, 300, t);
+  REMUS_ASSERT( (deadlines.size() == 3) );
+
+  //the run deadline doesn't start until the job is dispatched
+  REMUS_ASSERT( (deadlines.millisecondsToNextDeadline(t, 500) == 100) );
+
+  //dispatching drops the queue deadline, and starts the run deadline
+  deadlines.dispatched(queueOnly, after(t,50));
+  deadlines.dispatched(runOnly, after(t,50));
+  deadlines.dispatched(both, after(t,50));
+  REMUS_ASSERT( (deadlines.size() == 2) );
+  REMUS_ASSERT( (deadlines.takeExpired(after(t,100)).empty() == true) );
+
+  std::vector<JobDeadlines::Expired> expired = deadlines.takeExpired(after(t,150));
+  REMUS_ASSERT( (expired.size() == 1) );
+  REMUS_ASSERT( (expired[0].Id == runOnly) );
+  REMUS_ASSERT( (expired[0].Type == JobDeadlines::RUN) );
+
+  //dispatching again restarts the run deadline
+  deadlines.dispatched(both, after(t,200));
+  REMUS_ASSERT( (deadlines.takeExpired(after(t,400)).empty() == true) );
+  expired = deadlines.takeExpired(after(t,500));
+  REMUS_ASSERT( (expired.size() == 1) );
+  REMUS_ASSERT( (expired[0].Id == both) );
+  REMUS_ASSERT( (expired[0].Type == JobDeadlines::RUN) );
+  REMUS_ASSERT( (deadlines.empty() == true) );
+
+  //dispatching a job we don't track does nothing
+  deadlines.dispatched(queueOnly, t);
+  REMUS_ASSERT( (deadlines.empty() == true) );
+}
+
+} //namespace
+
+int UnitTestJobDeadlines(int, char *[])
+{
+  verify_queue_deadlines();
+  verify_run_deadlines();
+  return 0;
+}
@@ -0,0 +1,137 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/JobRetries.h>
+
+#include <remus/testing/Testing.h>
+
+namespace {
+
+typedef remus::server::detail::JobRetries JobRetries;
+
+boost::posix_time::ptime start()
+{
+  return boost::posix_time::microsec_clock::local_time();
+}
+
+boost::posix_time::ptime after(const boost::posix_time::ptime& t,
+                               boost::int64_t milliseconds)
+{
+  return t + boost::posix_time::milliseconds(milliseconds);
+}
+
+remus::proto::JobSubmission make_Submission(int retryLimit,
+                                            boost::int64_t retryBackoff)
+{
+  using namespace remus::meshtypes;
+  remus::proto::JobSubmission sub( remus::proto::make_JobRequirements(
+      remus::common::make_MeshIOType(Mesh2D(),Mesh3D()), "", "") );
+  sub["a"] = remus::proto::make_JobContent("contents");
+  sub.retryLimit(retryLimit);
+  sub.retryBackoff(retryBackoff);
+  return sub;
+}
+
+void verify_retry_budget()
+{
+  JobRetries retries;
+  const boost::posix_time::ptime t = start();
+
+  const boost::uuids::uuid never = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid twice = remus::testing::UUIDGenerator();
+
+  //jobs without a retry limit aren't tracked, and are never retried
+  retries.add(never, make_Submission(0, 0), remus::proto::StreamedKeys());
+  REMUS_ASSERT( (retries.empty() == true) );
+  REMUS_ASSERT( (retries.have(never) == false) );
+  REMUS_ASSERT( (retries.retry(never, t) == false) );
+
+  const remus::proto::JobSubmission sub = make_Submission(2, 100);
+  retries.add(twice, sub, remus::proto::StreamedKeys());
+  REMUS_ASSERT( (retries.size() == 1) );
+  REMUS_ASSERT( (retries.have(twice) == true) );
+  REMUS_ASSERT( (retries.retries(twice) == 0) );
+  REMUS_ASSERT( (retries.millisecondsToNextRetry(t, 500) == 500) );
+
+  //the first retry waits out the backoff
+  REMUS_ASSERT( (retries.retry(twice, t) == true) );
+  REMUS_ASSERT( (retries.waiting(twice) == true) );
+  REMUS_ASSERT( (retries.retries(twice) == 1) );
+  REMUS_ASSERT( (retries.millisecondsToNextRetry(t, 500) == 100) );
+  REMUS_ASSERT( (retries.takeReady(after(t,99)).empty() == true) );
+
+  //once ready we get back the original submission with the same id
+  std::vector<remus::worker::Job> ready = retries.takeReady(after(t,100));
+  REMUS_ASSERT( (ready.size() == 1) );
+  REMUS_ASSERT( (ready[0].id() == twice) );
+  REMUS_ASSERT( (ready[0].submission() == sub) );
+  REMUS_ASSERT( (retries.waiting(twice) == false) );
+  REMUS_ASSERT( (retries.takeReady(after(t,1000)).empty() == true) );
+
+  //the backoff doubles with every retry
+  REMUS_ASSERT( (retries.retry(twice, t) == true) );
+  REMUS_ASSERT( (retries.retries(twice) == 2) );
+  REMUS_ASSERT( (retries.takeReady(after(t,199)).empty() == true) );
+  REMUS_ASSERT( (retries.takeReady(after(t,200)).size() == 1) );
+
+  //once the budget is spent the job is no longer tracked
+  REMUS_ASSERT( (retries.retry(twice, t) == false) );
+  REMUS_ASSERT( (retries.empty() == true) );
+  REMUS_ASSERT( (retries.have(twice) == false) );
+  REMUS_ASSERT( (retries.retries(twice) == 0) );
+
+  //removed jobs waiting out their backoff are never ready
+  retries.add(twice, sub, remus::proto::StreamedKeys());
+  REMUS_ASSERT( (retries.retry(twice, t) == true) );
+  retries.remove(twice);
+  REMUS_ASSERT( (retries.empty() == true) );
+  REMUS_ASSERT( (retries.takeReady(after(t,1000)).empty() == true) );
+}
+
+void verify_streamed_content()
+{
+  JobRetries retries;
+  const boost::posix_time::ptime t = start();
+
+  remus::proto::StreamedKeys keys;
+  keys.insert("a");
+  keys.insert("b");
+
+  const boost::uuids::uuid partial = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid complete = remus::testing::UUIDGenerator();
+  retries.add(partial, make_Submission(1, 0), keys);
+  retries.add(complete, make_Submission(1, 0), keys);
+
+  const remus::proto::JobContent a = remus::proto::make_JobContent("streamed a");
+  const remus::proto::JobContent b = remus::proto::make_JobContent("streamed b");
+  retries.content(partial, "a", a);
+  retries.content(complete, "a", a);
+  retries.content(complete, "b", b);
+
+  //a job whose content never fully arrived can't be retried
+  REMUS_ASSERT( (retries.retry(partial, t) == false) );
+  REMUS_ASSERT( (retries.retry(complete, t) == true) );
+
+  std::vector<remus::worker::Job> ready = retries.takeReady(t);
+  REMUS_ASSERT( (ready.size() == 1) );
+  REMUS_ASSERT( (ready[0].id() == complete) );
+  REMUS_ASSERT( (ready[0].submission().find("a")->second.hash() == a.hash()) );
+  REMUS_ASSERT( (ready[0].submission().find("b")->second.hash() == b.hash()) );
+}
+
+} //namespace
+
+int UnitTestJobRetries(int, char *[])
+{
+  verify_retry_budget();
+  verify_streamed_content();
+  return 0;
+}
@@ -174,8 +174,22 @@ void verify_dispatch_jobs()
 
   REMUS_ASSERT( (queue.takeJob(worker_type1D).valid() == false) );
 
+  //the number of jobs of a type counts both queues
+  REMUS_ASSERT( (queue.numJobs(worker_type1D) == 0) );
+  REMUS_ASSERT( (queue.numJobs(worker_type2D) == 3) );
+  REMUS_ASSERT( (queue.numJobs(worker_type3D) == 4) );
+
+  //peeking returns the job that will be taken next, without taking it
+  REMUS_ASSERT( (queue.peekJob(worker_type1D).valid() == false) );
+  remus::worker::Job peeked = queue.peekJob(worker_type2D);
+  REMUS_ASSERT( (peeked.valid() == true) );
+  REMUS_ASSERT( (queue.haveUUID(peeked.id()) == true) );
+  REMUS_ASSERT( (queue.numJobs(worker_type2D) == 3) );
+
   remus::worker::Job job_2d_1 = queue.takeJob(worker_type2D);
   REMUS_ASSERT( (job_2d_1.valid() == true) );
+  REMUS_ASSERT( (job_2d_1.id() == peeked.id()) );
+  REMUS_ASSERT( (queue.numJobs(worker_type2D) == 2) );
   REMUS_ASSERT( (queue.haveUUID(job_2d_1.id()) == false) );
 
   remus::worker::Job job_2d_2 = queue.takeJob(worker_type2D);
@@ -0,0 +1,183 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/SocketIdentities.h>
+
+#include <remus/testing/Testing.h>
+
+#include <string>
+
+namespace {
+
+typedef remus::server::detail::SocketIdentities SocketIdentities;
+typedef remus::server::detail::SocketHandle SocketHandle;
+
+zmq::SocketIdentity make_identity(const std::string& name)
+{
+  return zmq::SocketIdentity(name.c_str(), name.size());
+}
+
+void verify_empty_identity()
+{
+  SocketIdentities identities;
+  REMUS_ASSERT( (identities.size() == 1) );
+
+  //the empty identity is always handle zero
+  REMUS_ASSERT( (identities.intern(SocketIdentities::WORKER,
+                                   zmq::SocketIdentity()) == 0) );
+  REMUS_ASSERT( (identities.resolve(0).size() == 0) );
+  REMUS_ASSERT( (identities.size() == 1) );
+
+  //handles we never gave out resolve to the empty identity
+  REMUS_ASSERT( (identities.resolve(42).size() == 0) );
+}
+
+void verify_intern()
+{
+  SocketIdentities identities;
+  const zmq::SocketIdentity worker1 = make_identity("worker1");
+  const zmq::SocketIdentity worker2 = make_identity("worker2");
+
+  const SocketHandle handle1 = identities.intern(SocketIdentities::WORKER,
+                                                 worker1);
+  const SocketHandle handle2 = identities.intern(SocketIdentities::WORKER,
+                                                 worker2);
+  REMUS_ASSERT( (handle1 != 0) );
+  REMUS_ASSERT( (handle2 != 0) );
+  REMUS_ASSERT( (handle1 != handle2) );
+  REMUS_ASSERT( (identities.size() == 3) );
+
+  //interning the same bytes again gives back the same handle
+  REMUS_ASSERT( (identities.intern(SocketIdentities::WORKER,
+                                   make_identity("worker1")) == handle1) );
+  REMUS_ASSERT( (identities.intern(SocketIdentities::WORKER,
+                                   worker2) == handle2) );
+  REMUS_ASSERT( (identities.size() == 3) );
+
+  //handles resolve back to the identity they were interned from
+  REMUS_ASSERT( (identities.resolve(handle1) == worker1) );
+  REMUS_ASSERT( (identities.resolve(handle2) == worker2) );
+
+  //resolved identities stay valid as we intern more identities
+  const zmq::SocketIdentity& resolved = identities.resolve(handle1);
+  for(int i=0; i < 100; ++i)
+    {
+    identities.intern(SocketIdentities::WORKER,
+                      make_identity("worker" + std::string(1, char('a'+i%26)) +
+                                    std::string(1, char('a'+i/26))));
+    }
+  REMUS_ASSERT( (resolved == worker1) );
+  REMUS_ASSERT( (identities.size() == 103) );
+}
+
+void verify_release()
+{
+  SocketIdentities identities;
+  const zmq::SocketIdentity worker = make_identity("worker");
+  const zmq::SocketIdentity client = make_identity("client");
+
+  const SocketHandle workerHandle = identities.intern(SocketIdentities::WORKER,
+                                                      worker);
+  REMUS_ASSERT( (identities.size() == 2) );
+
+  //a released handle resolves to the empty identity
+  identities.release(workerHandle);
+  REMUS_ASSERT( (identities.size() == 1) );
+  REMUS_ASSERT( (identities.resolve(workerHandle).size() == 0) );
+
+  //the next identity reuses the slot, but gets a handle of its own, so the
+  //released handle doesn't refer to it
+  const SocketHandle clientHandle = identities.intern(SocketIdentities::CLIENT,
+                                                      client);
+  REMUS_ASSERT( (identities.size() == 2) );
+  REMUS_ASSERT( (clientHandle != workerHandle) );
+  REMUS_ASSERT( ((clientHandle & 0xFFFFFFFFu) == (workerHandle & 0xFFFFFFFFu)) );
+  REMUS_ASSERT( (identities.resolve(clientHandle) == client) );
+  REMUS_ASSERT( (identities.resolve(workerHandle).size() == 0) );
+
+  //releasing a stale handle doesn't release the socket now in its slot
+  identities.release(workerHandle);
+  REMUS_ASSERT( (identities.resolve(clientHandle) == client) );
+  REMUS_ASSERT( (identities.size() == 2) );
+
+  //a released identity that comes back is interned with a new handle
+  const SocketHandle workerAgain = identities.intern(SocketIdentities::WORKER,
+                                                     worker);
+  REMUS_ASSERT( (workerAgain != workerHandle) );
+  REMUS_ASSERT( (identities.resolve(workerAgain) == worker) );
+  REMUS_ASSERT( (identities.intern(SocketIdentities::WORKER,
+                                   worker) == workerAgain) );
+
+  //the empty identity is never released
+  identities.release(0);
+  REMUS_ASSERT( (identities.intern(SocketIdentities::WORKER,
+                                   zmq::SocketIdentity()) == 0) );
+  REMUS_ASSERT( (identities.size() == 3) );
+}
+
+void verify_channels()
+{
+  SocketIdentities identities;
+  const zmq::SocketIdentity same = make_identity("same-bytes");
+
+  //the client and worker channels pick identities on their own, so the
+  //same bytes on each channel are different sockets
+  const SocketHandle client = identities.intern(SocketIdentities::CLIENT, same);
+  const SocketHandle worker = identities.intern(SocketIdentities::WORKER, same);
+  REMUS_ASSERT( (client != worker) );
+  REMUS_ASSERT( (identities.size() == 3) );
+
+  //releasing the client leaves the worker alone
+  identities.release(client);
+  REMUS_ASSERT( (identities.resolve(client).size() == 0) );
+  REMUS_ASSERT( (identities.resolve(worker) == same) );
+  REMUS_ASSERT( (identities.intern(SocketIdentities::WORKER, same) == worker) );
+}
+
+void verify_references()
+{
+  SocketIdentities identities;
+  const zmq::SocketIdentity client = make_identity("client");
+
+  //a client that is parked while it sends another request is held by
+  //the waiting list and the request, and lives until both let go
+  const SocketHandle parked = identities.intern(SocketIdentities::CLIENT,
+                                                client);
+  identities.retain(parked);
+  identities.release(parked);
+  const SocketHandle request = identities.intern(SocketIdentities::CLIENT,
+                                                 client);
+  REMUS_ASSERT( (request == parked) );
+
+  identities.release(request);
+  REMUS_ASSERT( (identities.resolve(parked) == client) );
+
+  identities.release(parked);
+  REMUS_ASSERT( (identities.resolve(parked).size() == 0) );
+  REMUS_ASSERT( (identities.size() == 1) );
+
+  //retaining a released handle doesn't bring it back
+  identities.retain(parked);
+  REMUS_ASSERT( (identities.resolve(parked).size() == 0) );
+  REMUS_ASSERT( (identities.size() == 1) );
+}
+
+} //namespace
+
+int UnitTestSocketIdentities(int, char *[])
+{
+  verify_empty_identity();
+  verify_intern();
+  verify_release();
+  verify_channels();
+  verify_references();
+  return 0;
+}
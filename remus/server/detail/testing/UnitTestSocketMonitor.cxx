@@ -13,21 +13,32 @@
 #include <remus/server/detail/SocketMonitor.h>
 
 #include <remus/common/SleepFor.h>
-#include <remus/proto/zmqSocketIdentity.h>
 #include <remus/testing/Testing.h>
 
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/date_time/posix_time/posix_time.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
 #include <boost/lexical_cast.hpp>
 
 namespace
 {
 typedef remus::server::detail::SocketMonitor SocketMonitor;
 
-//makes a random socket identity
-zmq::SocketIdentity make_socketId()
+typedef remus::server::detail::SocketHandle SocketHandle;
+
+//makes a random socket identity, and interns it like the server does
+SocketHandle make_socketId()
 {
+  static remus::server::detail::SocketIdentities identities;
   boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
   const std::string str_id = boost::lexical_cast<std::string>(new_uid);
-  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+  return identities.intern(remus::server::detail::SocketIdentities::WORKER,
+                           zmq::SocketIdentity(str_id.c_str(),str_id.size()));
 }
 
 //helper function that makes it clear what the numbers in this test
@@ -40,7 +51,7 @@ boost::int64_t make_heartbeat( boost::int64_t dur_in_milli )
 
 void verify_constructors()
 {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
 
   //create a socket monitor, add an Id to it and use that id to verify
   //that socket monitors shared pointer is working properly
@@ -67,7 +78,7 @@ void verify_constructors()
 
 void verify_bad_id()
 {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   REMUS_ASSERT( (monitor.isDead(sid) == true) );
   REMUS_ASSERT( (monitor.isUnresponsive(sid) == true) );
@@ -75,13 +86,13 @@ void verify_bad_id()
 
 void verify_existence()
 {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.refresh(sid);
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
   REMUS_ASSERT( (monitor.isUnresponsive(sid) == false) );
 
-  zmq::SocketIdentity sid2 = make_socketId();
+  SocketHandle sid2 = make_socketId();
   monitor.heartbeat( sid2, make_heartbeat(250) );
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
   REMUS_ASSERT( (monitor.isUnresponsive(sid) == false) );
@@ -90,7 +101,7 @@ void verify_existence()
 void verify_markAsDead()
 {
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.refresh(sid);
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
@@ -102,7 +113,7 @@ void verify_markAsDead()
 
   //do the same with heartbeating instead of refresh
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.heartbeat( sid, make_heartbeat(250) );
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
@@ -117,7 +128,7 @@ void verify_markAsDead()
 void verify_resurrection()
 {
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.refresh(sid);
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
@@ -132,7 +143,7 @@ void verify_resurrection()
 
   //do the same with heartbeating instead of refresh
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.heartbeat( sid, make_heartbeat(250) );
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
@@ -151,13 +162,13 @@ void verify_heartbeat_interval()
   //verify that the interval for unkown sockets is zero
   {
   SocketMonitor monitor;
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   REMUS_ASSERT( (monitor.heartbeatInterval(sid) == 0) );
   }
 
   //check is to verify that negative heartbeats are properly ignored
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.heartbeat(sid, make_heartbeat(-5) ); //make a heartbeat of -5msec
   REMUS_ASSERT( (monitor.isDead(sid) == false) );
@@ -169,7 +180,7 @@ void verify_heartbeat_interval()
   //verify that a positive value heartbeat duration is stored correctly
   //in milliseconds
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
 
   //change the timeout ranges to be smaller than the heartbeat value
@@ -199,7 +210,7 @@ void verify_responiveness()
 {
   //check is to verify that negative heartbeats are properly ignored
   {
-  zmq::SocketIdentity sid = make_socketId();
+  SocketHandle sid = make_socketId();
   SocketMonitor monitor;
   monitor.pollingMonitor().changeTimeOutRates(25,125);
 
@@ -235,6 +246,39 @@ void verify_responiveness()
   }
 }
 
+void verify_next_expiry()
+{
+  SocketMonitor monitor;
+  monitor.pollingMonitor().changeTimeOutRates(1,5);
+  const boost::posix_time::ptime start =
+                            boost::posix_time::microsec_clock::local_time();
+
+  //with no sockets there is nothing to wake up for
+  REMUS_ASSERT( (monitor.millisecondsToNextExpiry(start, 5000) == 5000) );
+
+  //sockets expire after twice their heartbeat interval
+  SocketHandle slow = make_socketId();
+  SocketHandle fast = make_socketId();
+  monitor.heartbeat(slow, make_heartbeat(2000) );
+  monitor.heartbeat(fast, make_heartbeat(500) );
+  const boost::int64_t next = monitor.millisecondsToNextExpiry(start, 5000);
+  REMUS_ASSERT( (next > 900 && next <= 1001) );
+  REMUS_ASSERT( (monitor.millisecondsToNextExpiry(start, 100) == 100) );
+
+  //sockets that have already expired aren't waited on
+  const boost::posix_time::ptime later =
+                            start + boost::posix_time::milliseconds(1500);
+  const boost::int64_t nextSlow = monitor.millisecondsToNextExpiry(later, 5000);
+  REMUS_ASSERT( (nextSlow > 2400 && nextSlow <= 2501) );
+
+  //a heartbeat moves the expiry, and dead sockets never expire
+  monitor.heartbeat(fast, make_heartbeat(3000) );
+  monitor.markAsDead(slow);
+  const boost::int64_t nextFast = monitor.millisecondsToNextExpiry(start, 9000);
+  REMUS_ASSERT( (nextFast > 5900 && nextFast <= 6001) );
+  monitor.markAsDead(fast);
+  REMUS_ASSERT( (monitor.millisecondsToNextExpiry(start, 9000) == 9000) );
+}
 
 }
 int UnitTestSocketMonitor(int, char *[])
@@ -248,6 +292,7 @@ int UnitTestSocketMonitor(int, char *[])
   verify_resurrection();
   verify_heartbeat_interval();
   verify_responiveness();
+  verify_next_expiry();
 
   return 0;
 }
@@ -0,0 +1,224 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/SpeculativeJobs.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace {
+
+typedef remus::server::detail::SpeculativeJobs SpeculativeJobs;
+
+boost::posix_time::ptime start()
+{
+  return boost::posix_time::microsec_clock::local_time();
+}
+
+boost::posix_time::ptime after(const boost::posix_time::ptime& t,
+                               boost::int64_t milliseconds)
+{
+  return t + boost::posix_time::milliseconds(milliseconds);
+}
+
+typedef remus::server::detail::SocketHandle SocketHandle;
+
+//makes a random socket identity, and interns it like the server does
+SocketHandle make_socketId()
+{
+  static remus::server::detail::SocketIdentities identities;
+  boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
+  const std::string str_id = boost::lexical_cast<std::string>(new_uid);
+  return identities.intern(remus::server::detail::SocketIdentities::WORKER,
+                           zmq::SocketIdentity(str_id.c_str(),str_id.size()));
+}
+
+remus::proto::JobRequirements make_Reqs()
+{
+  using namespace remus::meshtypes;
+  return remus::proto::make_JobRequirements(
+      remus::common::make_MeshIOType(Mesh2D(),Mesh3D()), "", "");
+}
+
+remus::worker::Job make_Job()
+{
+  return remus::worker::Job(remus::testing::UUIDGenerator(),
+                            remus::proto::JobSubmission(make_Reqs()));
+}
+
+//finish jobs that took 10, 20, ... 100 milliseconds
+void finish_jobs(SpeculativeJobs& jobs, const boost::posix_time::ptime& t)
+{
+  const SocketHandle worker = make_socketId();
+  for(int i=1; i <= 10; ++i)
+    {
+    const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+    jobs.dispatched(id, make_Reqs(), worker, t);
+    jobs.finished(id, worker, after(t, i*10));
+    }
+}
+
+void verify_runtimes()
+{
+  SpeculativeJobs jobs(10, 5);
+  const boost::posix_time::ptime t = start();
+
+  //without enough finished jobs there is no percentile
+  REMUS_ASSERT( (jobs.percentileRuntime(make_Reqs(), 0.9) == -1) );
+
+  finish_jobs(jobs, t);
+  REMUS_ASSERT( (jobs.empty() == true) );
+  REMUS_ASSERT( (jobs.percentileRuntime(make_Reqs(), 0.9) == 90) );
+  REMUS_ASSERT( (jobs.percentileRuntime(make_Reqs(), 0.5) == 50) );
+  REMUS_ASSERT( (jobs.percentileRuntime(make_Reqs(), 1.0) == 100) );
+
+  //only the last window of runtimes are kept
+  finish_jobs(jobs, after(t,0));
+  const SocketHandle worker = make_socketId();
+  for(int i=0; i < 10; ++i)
+    {
+    const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+    jobs.dispatched(id, make_Reqs(), worker, t);
+    jobs.finished(id, worker, after(t, 1000));
+    }
+  REMUS_ASSERT( (jobs.percentileRuntime(make_Reqs(), 0.1) == 1000) );
+
+  //jobs that stop without a result don't count
+  const boost::uuids::uuid failed = remus::testing::UUIDGenerator();
+  jobs.dispatched(failed, make_Reqs(), worker, t);
+  jobs.stop(failed);
+  REMUS_ASSERT( (jobs.empty() == true) );
+  REMUS_ASSERT( (jobs.percentileRuntime(make_Reqs(), 0.1) == 1000) );
+}
+
+void verify_stragglers()
+{
+  SpeculativeJobs jobs(10, 5);
+  const boost::posix_time::ptime t = start();
+  finish_jobs(jobs, t);
+
+  const SocketHandle worker = make_socketId();
+  const remus::worker::Job slow = make_Job();
+  const remus::worker::Job slower = make_Job();
+  const remus::worker::Job unheld = make_Job();
+  jobs.dispatched(slow.id(), make_Reqs(), worker, after(t,20));
+  jobs.dispatched(slower.id(), make_Reqs(), worker, t);
+  jobs.dispatched(unheld.id(), make_Reqs(), worker, t);
+  jobs.holdForCopies(slow);
+  jobs.holdForCopies(slower);
+
+  //nothing has run past the 90th percentile yet
+  REMUS_ASSERT( (jobs.stragglers(0.9, after(t,90)).empty() == true) );
+
+  //we know when the next held job becomes a straggler
+  REMUS_ASSERT( (jobs.millisecondsToNextStraggler(0.9, t, 500) == 91) );
+  REMUS_ASSERT( (jobs.millisecondsToNextStraggler(0.9, after(t,95), 500) == 16) );
+  REMUS_ASSERT( (jobs.millisecondsToNextStraggler(0.9, after(t,200), 500) == 500) );
+
+  //only held jobs are stragglers, and the longest running comes first
+  std::vector<remus::worker::Job> stragglers = jobs.stragglers(0.9, after(t,200));
+  REMUS_ASSERT( (stragglers.size() == 2) );
+  REMUS_ASSERT( (stragglers[0].id() == slower.id()) );
+  REMUS_ASSERT( (stragglers[1].id() == slow.id()) );
+
+  //jobs that have a copy, or are sending their result aren't stragglers
+  const SocketHandle copy = make_socketId();
+  jobs.copied(slower.id(), copy);
+  REMUS_ASSERT( (jobs.numberOfCopies() == 1) );
+  REMUS_ASSERT( (jobs.claimResult(slow.id(), worker) == true) );
+  REMUS_ASSERT( (jobs.stragglers(0.9, after(t,200)).empty() == true) );
+  REMUS_ASSERT( (jobs.millisecondsToNextStraggler(0.9, t, 500) == 500) );
+}
+
+void verify_first_result_wins()
+{
+  SpeculativeJobs jobs;
+  const boost::posix_time::ptime t = start();
+  const SocketHandle worker = make_socketId();
+  const SocketHandle copy = make_socketId();
+
+  const remus::worker::Job job = make_Job();
+  jobs.dispatched(job.id(), make_Reqs(), worker, t);
+  jobs.holdForCopies(job);
+  jobs.copied(job.id(), copy);
+
+  //the copy sends its result first, so the original worker loses
+  REMUS_ASSERT( (jobs.claimResult(job.id(), copy) == true) );
+  REMUS_ASSERT( (jobs.claimResult(job.id(), worker) == false) );
+  REMUS_ASSERT( (jobs.claimResult(job.id(), copy) == true) );
+  jobs.finished(job.id(), copy, after(t,10));
+  REMUS_ASSERT( (jobs.numberOfCopies() == 0) );
+  REMUS_ASSERT( (jobs.empty() == true) );
+
+  std::vector<SpeculativeJobs::JobWorker> losers = jobs.takeLosers();
+  REMUS_ASSERT( (losers.size() == 1) );
+  REMUS_ASSERT( (losers[0].first == job.id()) );
+  REMUS_ASSERT( (losers[0].second == worker) );
+  REMUS_ASSERT( (jobs.takeLosers().empty() == true) );
+
+  //a job that stops without a result terminates its copy
+  jobs.dispatched(job.id(), make_Reqs(), worker, t);
+  jobs.holdForCopies(job);
+  jobs.copied(job.id(), copy);
+  jobs.stop(job.id());
+  losers = jobs.takeLosers();
+  REMUS_ASSERT( (losers.size() == 1) );
+  REMUS_ASSERT( (losers[0].second == copy) );
+}
+
+void verify_promote_copies()
+{
+  remus::common::PollingMonitor poller(100,100);
+  remus::server::detail::SocketMonitor monitor(poller);
+
+  SpeculativeJobs jobs;
+  const boost::posix_time::ptime t = start();
+  const SocketHandle dies = make_socketId();
+  const SocketHandle lives = make_socketId();
+
+  const remus::worker::Job first = make_Job();
+  const remus::worker::Job second = make_Job();
+  jobs.dispatched(first.id(), make_Reqs(), dies, t);
+  jobs.dispatched(second.id(), make_Reqs(), lives, t);
+  jobs.copied(first.id(), lives);
+  jobs.copied(second.id(), dies);
+  REMUS_ASSERT( (jobs.claimResult(first.id(), dies) == true) );
+
+  remus::common::SleepForMillisec(300);
+  monitor.refresh(lives);
+
+  std::vector<SpeculativeJobs::JobWorker> promoted;
+  std::vector<boost::uuids::uuid> lostResults;
+  jobs.promoteCopies(monitor, promoted, lostResults);
+  REMUS_ASSERT( (jobs.numberOfCopies() == 0) );
+
+  //the first job moves to its copy, and loses the result the dead worker
+  //was sending. The second job just loses its copy
+  REMUS_ASSERT( (promoted.size() == 1) );
+  REMUS_ASSERT( (promoted[0].first == first.id()) );
+  REMUS_ASSERT( (promoted[0].second == lives) );
+  REMUS_ASSERT( (lostResults.size() == 1) );
+  REMUS_ASSERT( (lostResults[0] == first.id()) );
+  REMUS_ASSERT( (jobs.claimResult(first.id(), lives) == true) );
+}
+
+} //namespace
+
+int UnitTestSpeculativeJobs(int, char *[])
+{
+  verify_runtimes();
+  verify_stragglers();
+  verify_first_result_wins();
+  verify_promote_copies();
+  return 0;
+}
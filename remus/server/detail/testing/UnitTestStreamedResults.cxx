@@ -0,0 +1,185 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/StreamedResults.h>
+
+#include <remus/common/MD5Hash.h>
+
+#include <remus/testing/Testing.h>
+
+#include <algorithm>
+
+namespace {
+
+using remus::proto::DataChunk;
+
+//breaks the data into chunks of the given size, marking the last one final
+std::vector<DataChunk> make_chunks(const boost::uuids::uuid& id,
+                                   const std::string& data,
+                                   std::size_t chunkSize)
+{
+  std::vector<DataChunk> chunks;
+  for(std::size_t pos=0; pos < data.size(); pos+=chunkSize)
+    {
+    const std::size_t len = std::min(chunkSize, data.size() - pos);
+    chunks.push_back( DataChunk(id, remus::common::ContentFormat::BSON,
+                                pos, data.data() + pos, len) );
+    }
+  if(chunks.empty())
+    {
+    chunks.push_back( DataChunk(id) );
+    }
+  chunks.back().markAsFinal(data.size(), remus::common::MD5Hash(data));
+  return chunks;
+}
+
+void verify_assembly()
+{
+  remus::server::detail::StreamedResults results;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(10240 * 3 + 17);
+  std::vector<DataChunk> chunks = make_chunks(id, data, 10240);
+  REMUS_ASSERT( (chunks.size() == 4) );
+
+  for(std::size_t i=0; i < chunks.size(); ++i)
+    {
+    REMUS_ASSERT( (results.isComplete(id) == false) );
+    REMUS_ASSERT( (results.add(chunks[i]) == true) );
+    REMUS_ASSERT( (results.have(id) == true) );
+    }
+  REMUS_ASSERT( (results.isComplete(id) == true) );
+
+  //once complete no more chunks can be added
+  REMUS_ASSERT( (results.add(chunks[0]) == false) );
+
+  remus::server::detail::ChunkedResult chunked;
+  REMUS_ASSERT( (results.take(id, chunked) == true) );
+  REMUS_ASSERT( (results.have(id) == false) );
+  REMUS_ASSERT( (results.size() == 0) );
+  REMUS_ASSERT( (chunked.size() == data.size()) );
+  REMUS_ASSERT( (chunked.checksum() == remus::common::MD5Hash(data)) );
+
+  const remus::proto::JobResult result = chunked.join();
+  REMUS_ASSERT( (result.id() == id) );
+  REMUS_ASSERT( (result.formatType() == remus::common::ContentFormat::BSON) );
+  REMUS_ASSERT( (std::string(result.data(), result.dataSize()) == data) );
+}
+
+void verify_chunk_at()
+{
+  remus::server::detail::StreamedResults results;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(10240 * 3 + 17);
+  std::vector<DataChunk> chunks = make_chunks(id, data, 10240);
+  for(std::size_t i=0; i < chunks.size(); ++i)
+    {
+    REMUS_ASSERT( (results.add(chunks[i]) == true) );
+    }
+  remus::server::detail::ChunkedResult chunked;
+  REMUS_ASSERT( (results.take(id, chunked) == true) );
+
+  //walking the result from any offset gives back the data, and only
+  //the piece that ends the result is final
+  const boost::uint64_t starts[] = { 0, 100, 10240, 20479 };
+  for(std::size_t s=0; s < 4; ++s)
+    {
+    std::string received;
+    boost::uint64_t offset = starts[s];
+    while(true)
+      {
+      const DataChunk piece = chunked.chunkAt(offset);
+      REMUS_ASSERT( (piece.offset() == offset) );
+      REMUS_ASSERT( (piece.dataSize() > 0) );
+      received.append(piece.data(), piece.dataSize());
+      offset += piece.dataSize();
+      if(piece.isFinal())
+        {
+        REMUS_ASSERT( (piece.totalSize() == data.size()) );
+        REMUS_ASSERT( (piece.checksum() == chunked.checksum()) );
+        break;
+        }
+      }
+    REMUS_ASSERT( (received == data.substr(starts[s])) );
+    }
+
+  //the end of the result is an empty final piece, past it there is nothing
+  REMUS_ASSERT( (chunked.chunkAt(data.size()).isFinal() == true) );
+  REMUS_ASSERT( (chunked.chunkAt(data.size()).dataSize() == 0) );
+  REMUS_ASSERT( (chunked.chunkAt(data.size() + 1).isFinal() == false) );
+}
+
+void verify_out_of_order()
+{
+  remus::server::detail::StreamedResults results;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::AsciiStringGenerator(4096);
+  std::vector<DataChunk> chunks = make_chunks(id, data, 1024);
+
+  //a stream has to start with the first chunk
+  REMUS_ASSERT( (results.add(chunks[1]) == false) );
+  REMUS_ASSERT( (results.have(id) == false) );
+
+  //skipping or repeating a chunk is rejected
+  REMUS_ASSERT( (results.add(chunks[0]) == true) );
+  REMUS_ASSERT( (results.add(chunks[2]) == false) );
+  REMUS_ASSERT( (results.add(chunks[0]) == false) );
+
+  //an incomplete stream can't be taken
+  remus::server::detail::ChunkedResult result;
+  REMUS_ASSERT( (results.take(id, result) == false) );
+  REMUS_ASSERT( (results.have(id) == true) );
+
+  results.remove(id);
+  REMUS_ASSERT( (results.have(id) == false) );
+}
+
+void verify_checksum()
+{
+  remus::server::detail::StreamedResults results;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::AsciiStringGenerator(2048);
+  std::vector<DataChunk> chunks = make_chunks(id, data, 1024);
+
+  //replace the final chunk with one that has the wrong checksum
+  DataChunk bad(id, remus::common::ContentFormat::BSON,
+                chunks[1].offset(), chunks[1].data(), chunks[1].dataSize());
+  bad.markAsFinal(data.size(), remus::common::MD5Hash(std::string("junk")));
+
+  REMUS_ASSERT( (results.add(chunks[0]) == true) );
+  REMUS_ASSERT( (results.add(bad) == true) );
+  REMUS_ASSERT( (results.isComplete(id) == true) );
+
+  //the stream is removed even though it was invalid
+  remus::server::detail::ChunkedResult result;
+  REMUS_ASSERT( (results.take(id, result) == false) );
+  REMUS_ASSERT( (results.have(id) == false) );
+
+  //an empty result is a single final chunk with no data
+  std::vector<DataChunk> empty = make_chunks(id, std::string(), 1024);
+  REMUS_ASSERT( (results.add(empty[0]) == true) );
+  REMUS_ASSERT( (results.take(id, result) == true) );
+  REMUS_ASSERT( (result.size() == 0) );
+  REMUS_ASSERT( (result.join().dataSize() == 0) );
+  REMUS_ASSERT( (result.chunkAt(0).isFinal() == true) );
+}
+
+}
+
+int UnitTestStreamedResults(int, char *[])
+{
+  verify_assembly();
+  verify_chunk_at();
+  verify_out_of_order();
+  verify_checksum();
+  return 0;
+}
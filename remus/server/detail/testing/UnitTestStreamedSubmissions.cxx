@@ -0,0 +1,232 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/StreamedSubmissions.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/common/remusGlobals.h>
+
+#include <remus/testing/Testing.h>
+
+#include <algorithm>
+
+namespace {
+
+using remus::proto::DataChunk;
+
+//breaks the data into chunks of the given size, marking the last one final
+std::vector<DataChunk> make_chunks(const boost::uuids::uuid& id,
+                                   const std::string& key,
+                                   const std::string& data,
+                                   std::size_t chunkSize)
+{
+  std::vector<DataChunk> chunks;
+  for(std::size_t pos=0; pos < data.size(); pos+=chunkSize)
+    {
+    const std::size_t len = std::min(chunkSize, data.size() - pos);
+    chunks.push_back( DataChunk(id, remus::common::ContentFormat::XML,
+                                pos, data.data() + pos, len) );
+    chunks.back().key(key);
+    }
+  chunks.back().markAsFinal(data.size(), remus::common::MD5Hash(data));
+  return chunks;
+}
+
+//forward every chunk that we have credits for, and return the data
+//of each forwarded chunk
+std::string forward_chunks(remus::server::detail::StreamedSubmissions& subs,
+                           const boost::uuids::uuid& id,
+                           std::size_t& numForwarded)
+{
+  std::string data;
+  DataChunk chunk(id);
+  numForwarded = 0;
+  while(subs.nextChunkToForward(id, chunk))
+    {
+    data += std::string(chunk.data(), chunk.dataSize());
+    ++numForwarded;
+    }
+  return data;
+}
+
+void verify_spool_and_forward()
+{
+  remus::server::detail::StreamedSubmissions subs;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  remus::proto::StreamedKeys keys;
+  keys.insert("mesh");
+  keys.insert("model");
+  REMUS_ASSERT( (subs.add(id, keys) == true) );
+  REMUS_ASSERT( (subs.add(id, keys) == false) );
+  REMUS_ASSERT( (subs.have(id) == true) );
+  REMUS_ASSERT( (subs.keys(id) == keys) );
+
+  const std::string mesh = remus::testing::BinaryDataGenerator(1024 * 10);
+  const std::string model = remus::testing::AsciiStringGenerator(100);
+  std::vector<DataChunk> meshChunks = make_chunks(id, "mesh", mesh, 1024);
+  std::vector<DataChunk> modelChunks = make_chunks(id, "model", model, 1024);
+
+  //chunks for unknown keys or jobs are rejected
+  std::vector<DataChunk> badKey = make_chunks(id, "junk", model, 1024);
+  REMUS_ASSERT( (subs.append(badKey[0]) == false) );
+  std::vector<DataChunk> badJob =
+    make_chunks(remus::testing::UUIDGenerator(), "mesh", model, 1024);
+  REMUS_ASSERT( (subs.append(badJob[0]) == false) );
+
+  //out of order chunks are rejected
+  REMUS_ASSERT( (subs.append(meshChunks[1]) == false) );
+
+  //spool half of the mesh, we can only forward as many chunks as
+  //we have credits for
+  for(std::size_t i=0; i < 5; ++i)
+    {
+    REMUS_ASSERT( (subs.append(meshChunks[i]) == true) );
+    }
+  std::size_t numForwarded = 0;
+  std::string forwarded = forward_chunks(subs, id, numForwarded);
+  REMUS_ASSERT( (numForwarded == remus::STREAM_CHUNK_CREDITS) );
+
+  //acknowledging chunks allows more to be forwarded
+  for(std::size_t i=0; i < numForwarded; ++i)
+    {
+    subs.acknowledged(id);
+    }
+  forwarded += forward_chunks(subs, id, numForwarded);
+  REMUS_ASSERT( (numForwarded == 1) );
+  REMUS_ASSERT( (forwarded == mesh.substr(0, 5 * 1024)) );
+  REMUS_ASSERT( (subs.isUploaded(id) == false) );
+
+  //spool the rest of the content
+  REMUS_ASSERT( (subs.append(modelChunks[0]) == true) );
+  for(std::size_t i=5; i < meshChunks.size(); ++i)
+    {
+    REMUS_ASSERT( (subs.append(meshChunks[i]) == true) );
+    }
+  REMUS_ASSERT( (subs.isUploaded(id) == true) );
+  REMUS_ASSERT( (subs.isValid(id) == true) );
+
+  //forward everything else, acknowledging as we go
+  std::string rest;
+  while(!subs.isForwarded(id))
+    {
+    subs.acknowledged(id);
+    rest += forward_chunks(subs, id, numForwarded);
+    for(std::size_t i=0; i < numForwarded; ++i)
+      {
+      subs.acknowledged(id);
+      }
+    }
+  REMUS_ASSERT( (rest == model + mesh.substr(5 * 1024)) );
+
+  //a rewound spool is forwarded again from the start, in the
+  //order the chunks arrived
+  subs.rewind(id);
+  REMUS_ASSERT( (subs.isForwarded(id) == false) );
+  std::string again;
+  while(!subs.isForwarded(id))
+    {
+    again += forward_chunks(subs, id, numForwarded);
+    for(std::size_t i=0; i < numForwarded; ++i)
+      {
+      subs.acknowledged(id);
+      }
+    }
+  REMUS_ASSERT( (again == mesh.substr(0, 5 * 1024) + model +
+                         mesh.substr(5 * 1024)) );
+
+  subs.remove(id);
+  REMUS_ASSERT( (subs.have(id) == false) );
+  REMUS_ASSERT( (subs.size() == 0) );
+}
+
+void verify_checksum()
+{
+  remus::server::detail::StreamedSubmissions subs;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  remus::proto::StreamedKeys keys;
+  keys.insert("data");
+  REMUS_ASSERT( (subs.add(id, keys) == true) );
+
+  //an empty set of keys can't be streamed
+  REMUS_ASSERT( (subs.add(remus::testing::UUIDGenerator(),
+                          remus::proto::StreamedKeys()) == false) );
+
+  const std::string data = remus::testing::AsciiStringGenerator(2048);
+  DataChunk chunk(id, remus::common::ContentFormat::User,
+                  0, data.data(), data.size());
+  chunk.key("data");
+  chunk.markAsFinal(data.size(), remus::common::MD5Hash(std::string("junk")));
+  REMUS_ASSERT( (subs.append(chunk) == true) );
+  REMUS_ASSERT( (subs.isUploaded(id) == true) );
+  REMUS_ASSERT( (subs.isValid(id) == false) );
+
+  //content that failed verification can't be read back
+  remus::proto::JobContent content;
+  REMUS_ASSERT( (subs.content(id, "data", content) == false) );
+}
+
+void verify_read_back_content()
+{
+  remus::server::detail::StreamedSubmissions subs;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  remus::proto::StreamedKeys keys;
+  keys.insert("mesh");
+  keys.insert("model");
+  REMUS_ASSERT( (subs.add(id, keys) == true) );
+
+  const std::string mesh = remus::testing::BinaryDataGenerator(1024 * 10 + 7);
+  const std::string model = remus::testing::AsciiStringGenerator(3000);
+  std::vector<DataChunk> meshChunks = make_chunks(id, "mesh", mesh, 1024);
+  std::vector<DataChunk> modelChunks = make_chunks(id, "model", model, 1024);
+
+  //interleave the chunks of the keys in the spool
+  for(std::size_t i=0; i < meshChunks.size(); ++i)
+    {
+    REMUS_ASSERT( (subs.append(meshChunks[i]) == true) );
+    if(i < modelChunks.size())
+      {
+      REMUS_ASSERT( (subs.append(modelChunks[i]) == true) );
+      }
+    }
+
+  remus::proto::JobContent content;
+  REMUS_ASSERT( (subs.content(id, "mesh", content) == true) );
+  REMUS_ASSERT( (content.formatType() == remus::common::ContentFormat::XML) );
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == mesh) );
+
+  REMUS_ASSERT( (subs.content(id, "model", content) == true) );
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == model) );
+
+  //the content is the mapped spool, which outlives the upload
+  subs.remove(id);
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == model) );
+  REMUS_ASSERT( (content.hash() == remus::proto::make_JobContent(model).hash()) );
+
+  //unknown keys and jobs have no content
+  REMUS_ASSERT( (subs.content(id, "junk", content) == false) );
+  REMUS_ASSERT( (subs.content(remus::testing::UUIDGenerator(),
+                              "mesh", content) == false) );
+}
+
+}
+
+int UnitTestStreamedSubmissions(int, char *[])
+{
+  verify_spool_and_forward();
+  verify_checksum();
+  verify_read_back_content();
+  return 0;
+}
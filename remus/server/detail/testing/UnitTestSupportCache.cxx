@@ -0,0 +1,120 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/SupportCache.h>
+
+#include <remus/common/MeshTypes.h>
+
+#include <remus/testing/Testing.h>
+
+namespace {
+
+typedef remus::server::detail::SupportCache SupportCache;
+
+using namespace remus::meshtypes;
+
+void verify_lookup()
+{
+  SupportCache cache;
+  const remus::common::MeshIOType edges2D =
+                          remus::common::MeshIOType(Edges(),Mesh2D());
+  const remus::common::MeshIOType edges3D =
+                          remus::common::MeshIOType(Edges(),Mesh3D());
+
+  std::string answer;
+  REMUS_ASSERT( (cache.find(remus::CAN_MESH_IO_TYPE, edges2D, answer) == false) );
+
+  cache.store(remus::CAN_MESH_IO_TYPE, edges2D, "1");
+  cache.store(remus::MESH_REQUIREMENTS_FOR_IO_TYPE, edges2D, "reqs");
+  cache.store(remus::SUPPORTED_IO_TYPES, remus::common::MeshIOType(), "types");
+  REMUS_ASSERT( (cache.size() == 3) );
+
+  //answers are held per query and type
+  REMUS_ASSERT( (cache.find(remus::CAN_MESH_IO_TYPE, edges2D, answer) == true) );
+  REMUS_ASSERT( (answer == "1") );
+  REMUS_ASSERT( (cache.find(remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
+                            edges2D, answer) == true) );
+  REMUS_ASSERT( (answer == "reqs") );
+  REMUS_ASSERT( (cache.find(remus::SUPPORTED_IO_TYPES,
+                            remus::common::MeshIOType(), answer) == true) );
+  REMUS_ASSERT( (answer == "types") );
+  REMUS_ASSERT( (cache.find(remus::CAN_MESH_IO_TYPE, edges3D, answer) == false) );
+}
+
+void verify_generations()
+{
+  SupportCache cache;
+  const remus::common::MeshIOType edges2D =
+                          remus::common::MeshIOType(Edges(),Mesh2D());
+  std::string answer;
+
+  cache.validate(1, 1);
+  const boost::uint64_t generation = cache.generation();
+  cache.store(remus::CAN_MESH_IO_TYPE, edges2D, "1");
+
+  //the same generations keep the answers
+  cache.validate(1, 1);
+  REMUS_ASSERT( (cache.generation() == generation) );
+  REMUS_ASSERT( (cache.find(remus::CAN_MESH_IO_TYPE, edges2D, answer) == true) );
+
+  //a change to the pool drops the answers
+  cache.validate(1, 2);
+  REMUS_ASSERT( (cache.generation() != generation) );
+  REMUS_ASSERT( (cache.size() == 0) );
+  REMUS_ASSERT( (cache.find(remus::CAN_MESH_IO_TYPE, edges2D, answer) == false) );
+
+  //as does a change to the factory
+  cache.store(remus::CAN_MESH_IO_TYPE, edges2D, "0");
+  cache.validate(2, 2);
+  REMUS_ASSERT( (cache.size() == 0) );
+}
+
+void verify_requirements()
+{
+  SupportCache cache;
+  const remus::common::MeshIOType edges2D =
+                          remus::common::MeshIOType(Edges(),Mesh2D());
+
+  cache.validate(1, 1);
+  const std::string tag = cache.tag();
+  REMUS_ASSERT( (cache.findRequirements(edges2D) == NULL) );
+
+  SupportCache::DigestedRequirements reqs;
+  reqs["digest"] = "serialized";
+  cache.storeRequirements(edges2D, reqs);
+  REMUS_ASSERT( (cache.findRequirements(edges2D) != NULL) );
+  REMUS_ASSERT( (*cache.findRequirements(edges2D) == reqs) );
+
+  //the tag only changes with the generation
+  cache.validate(1, 1);
+  REMUS_ASSERT( (cache.tag() == tag) );
+  cache.validate(2, 1);
+  REMUS_ASSERT( (cache.tag() != tag) );
+  REMUS_ASSERT( (cache.findRequirements(edges2D) == NULL) );
+
+  //caches of different servers never share a tag
+  SupportCache other;
+  other.validate(1, 1);
+  SupportCache same;
+  same.validate(1, 1);
+  REMUS_ASSERT( (other.generation() == same.generation()) );
+  REMUS_ASSERT( (other.tag() != same.tag()) );
+}
+
+} //namespace
+
+int UnitTestSupportCache(int, char *[])
+{
+  verify_lookup();
+  verify_generations();
+  verify_requirements();
+  return 0;
+}
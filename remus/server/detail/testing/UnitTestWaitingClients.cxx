@@ -0,0 +1,123 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/WaitingClients.h>
+
+#include <remus/testing/Testing.h>
+
+namespace {
+
+typedef remus::server::detail::WaitingClients::Waiter Waiter;
+
+typedef remus::server::detail::SocketHandle SocketHandle;
+
+//makes a random socket identity, and interns it like the server does
+SocketHandle make_socketId()
+{
+  static remus::server::detail::SocketIdentities identities;
+  const std::string str_id = remus::testing::UniqueString();
+  return identities.intern(remus::server::detail::SocketIdentities::CLIENT,
+                           zmq::SocketIdentity(str_id.c_str(),str_id.size()));
+}
+
+boost::posix_time::ptime now()
+{
+  return boost::posix_time::microsec_clock::local_time();
+}
+
+void verify_job_changes()
+{
+  remus::server::detail::WaitingClients clients;
+  REMUS_ASSERT( (clients.empty() == true) );
+
+  //changes that happen while nobody is waiting should not be remembered
+  std::vector< boost::uuids::uuid > jobs;
+  for(int i=0; i < 4; ++i)
+    { jobs.push_back(remus::testing::UUIDGenerator()); }
+  clients.jobChanged(jobs[0]);
+
+  const boost::posix_time::ptime later = now() + boost::posix_time::hours(1);
+
+  std::vector< boost::uuids::uuid > firstJobs(jobs.begin(), jobs.begin()+2);
+  std::vector< boost::uuids::uuid > secondJobs(jobs.begin()+2, jobs.end());
+  const SocketHandle first = make_socketId();
+  const SocketHandle second = make_socketId();
+  clients.add(first, firstJobs, later);
+  clients.add(second, secondJobs, later);
+  REMUS_ASSERT( (clients.size() == 2) );
+
+  //nothing has changed and no deadline has passed
+  REMUS_ASSERT( (clients.takeReady(now()).size() == 0) );
+
+  //a job nobody is watching doesn't wake anybody
+  clients.jobChanged(remus::testing::UUIDGenerator());
+  REMUS_ASSERT( (clients.takeReady(now()).size() == 0) );
+
+  //changing the second job of the first client only wakes the first client
+  clients.jobChanged(jobs[1]);
+  std::vector<Waiter> ready = clients.takeReady(now());
+  REMUS_ASSERT( (ready.size() == 1) );
+  REMUS_ASSERT( (ready[0].Address == first) );
+  REMUS_ASSERT( (ready[0].Jobs == firstJobs) );
+  REMUS_ASSERT( (clients.size() == 1) );
+
+  //the change was consumed, so it doesn't leak into the next query
+  REMUS_ASSERT( (clients.takeReady(now()).size() == 0) );
+
+  clients.jobChanged(jobs[3]);
+  ready = clients.takeReady(now());
+  REMUS_ASSERT( (ready.size() == 1) );
+  REMUS_ASSERT( (ready[0].Address == second) );
+  REMUS_ASSERT( (clients.empty() == true) );
+}
+
+void verify_deadlines()
+{
+  remus::server::detail::WaitingClients clients;
+  const boost::posix_time::ptime start = now();
+
+  //with nobody waiting we should get back the max value
+  REMUS_ASSERT( (clients.millisecondsToNextDeadline(start,250) == 250) );
+
+  std::vector< boost::uuids::uuid > jobs(1,remus::testing::UUIDGenerator());
+  clients.add(make_socketId(), jobs,
+              start + boost::posix_time::milliseconds(100));
+  clients.add(make_socketId(), jobs,
+              start + boost::posix_time::milliseconds(5000));
+
+  REMUS_ASSERT( (clients.millisecondsToNextDeadline(start,250) == 100) );
+  REMUS_ASSERT( (clients.millisecondsToNextDeadline(start,50) == 50) );
+
+  //once a deadline has passed we clamp to zero
+  const boost::posix_time::ptime past_first =
+                                start + boost::posix_time::milliseconds(200);
+  REMUS_ASSERT( (clients.millisecondsToNextDeadline(past_first,250) == 0) );
+
+  std::vector<Waiter> ready = clients.takeReady(past_first);
+  REMUS_ASSERT( (ready.size() == 1) );
+  REMUS_ASSERT( (clients.size() == 1) );
+
+  //takeAll releases everybody
+  ready = clients.takeAll();
+  REMUS_ASSERT( (ready.size() == 1) );
+  REMUS_ASSERT( (clients.empty() == true) );
+}
+
+} //namespace
+
+int UnitTestWaitingClients(int, char *[])
+{
+  verify_job_changes();
+
+  verify_deadlines();
+
+  return 0;
+}
@@ -12,7 +12,6 @@
 #include <remus/server/detail/WorkerPool.h>
 
 #include <remus/common/SleepFor.h>
-#include <remus/proto/zmqSocketIdentity.h>
 #include <remus/server/detail/uuidHelper.h>
 
 #include <remus/testing/Testing.h>
@@ -41,12 +40,16 @@ remus::server::detail::SocketMonitor make_Monitor( )
 }
 
 
-//makes a random socket identity
-zmq::SocketIdentity make_socketId()
+typedef remus::server::detail::SocketHandle SocketHandle;
+
+//makes a random socket identity, and interns it like the server does
+SocketHandle make_socketId()
 {
+  static remus::server::detail::SocketIdentities identities;
   boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
   const std::string str_id = boost::lexical_cast<std::string>(new_uid);
-  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+  return identities.intern(remus::server::detail::SocketIdentities::WORKER,
+                           zmq::SocketIdentity(str_id.c_str(),str_id.size()));
 }
 
 
@@ -58,9 +61,11 @@ void verify_has_workers()
 
   //verify that if we add a worker we only have 1 worker,
   //and we have no workers ready for work
-  zmq::SocketIdentity worker1_id = make_socketId();
+  SocketHandle worker1_id = make_socketId();
+  REMUS_ASSERT( (pool.haveWorker(worker1_id) == false) );
   pool.addWorker(worker1_id, worker_type2D);
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
+  REMUS_ASSERT( (pool.haveWorker(worker1_id) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type2D) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type3D) == false) );
   REMUS_ASSERT( (pool.allWorkers().count(worker1_id) == 1) );
@@ -94,7 +99,7 @@ void verify_has_worker_type()
   //verify that we only have workers for the given types
   //that we have added, and no false positives
   remus::server::detail::WorkerPool pool;
-  zmq::SocketIdentity worker1_id = make_socketId();
+  SocketHandle worker1_id = make_socketId();
   pool.addWorker(worker1_id, worker_type2D);
 
   //now verify that a worker added to the pool, but not marked as ready
@@ -132,7 +137,7 @@ void verify_purge_workers()
 {
   //verify that we properly purge workers given a time
   remus::server::detail::WorkerPool pool;
-  zmq::SocketIdentity worker1_id = make_socketId();
+  SocketHandle worker1_id = make_socketId();
 
   typedef remus::server::detail::SocketMonitor MonitorType;
   MonitorType monitor = make_Monitor( );
@@ -148,7 +153,7 @@ void verify_purge_workers()
   monitor.refresh(worker1_id);
 
   //fail to purge by using the time stamp the worker was added with
-  pool.purgeDeadWorkers(monitor);
+  REMUS_ASSERT( (pool.purgeDeadWorkers(monitor).empty() == true) );
   REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type2D) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type3D) == true) );
@@ -173,23 +178,32 @@ void verify_purge_workers()
 
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
   REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 1) );
+
+  //a worker that is dead is purged, and returned so that its
+  //handle can be released
+  monitor.markAsDead(worker1_id);
+  std::set<SocketHandle> purged = pool.purgeDeadWorkers(monitor);
+  REMUS_ASSERT( (purged.size() == 1) );
+  REMUS_ASSERT( (purged.count(worker1_id) == 1) );
+  REMUS_ASSERT( (pool.allWorkers().empty() == true) );
+  REMUS_ASSERT( (pool.purgeDeadWorkers(monitor).empty() == true) );
 }
 
 void verify_taking_works()
 {
   remus::server::detail::WorkerPool pool;
-  zmq::SocketIdentity worker1_id = make_socketId();
+  SocketHandle worker1_id = make_socketId();
 
   //try to take a worker before it has been marked as ready for work
   pool.addWorker(worker1_id, worker_type2D);
-  zmq::SocketIdentity bad_id = pool.takeWorker(worker_type2D);
-  REMUS_ASSERT( (bad_id == zmq::SocketIdentity()) );
+  SocketHandle bad_id = pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( (bad_id == SocketHandle()) );
   REMUS_ASSERT( !(bad_id == worker1_id) );
 
   //verify that we can take workers for a given job type
   pool.readyForWork(worker1_id, worker_type2D);
-  zmq::SocketIdentity good_id = pool.takeWorker(worker_type2D);
-  REMUS_ASSERT( !(good_id == zmq::SocketIdentity()) );
+  SocketHandle good_id = pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( !(good_id == SocketHandle()) );
   REMUS_ASSERT( (good_id == worker1_id) );
   REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 0) );
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
@@ -205,17 +219,17 @@ void verify_taking_works()
 
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
 
-  zmq::SocketIdentity good_2d_id = pool.takeWorker(worker_type2D);
-  REMUS_ASSERT( !(good_2d_id == zmq::SocketIdentity()) );
+  SocketHandle good_2d_id = pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( !(good_2d_id == SocketHandle()) );
   REMUS_ASSERT( (good_2d_id == worker1_id) );
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
 
-  zmq::SocketIdentity bad_2d_id = pool.takeWorker(worker_type2D);
-  zmq::SocketIdentity good_3d_id = pool.takeWorker(worker_type3D);
+  SocketHandle bad_2d_id = pool.takeWorker(worker_type2D);
+  SocketHandle good_3d_id = pool.takeWorker(worker_type3D);
 
-  REMUS_ASSERT( (bad_2d_id == zmq::SocketIdentity()) );
+  REMUS_ASSERT( (bad_2d_id == SocketHandle()) );
   REMUS_ASSERT( !(bad_2d_id == worker1_id) );
-  REMUS_ASSERT( !(good_3d_id == zmq::SocketIdentity()) );
+  REMUS_ASSERT( !(good_3d_id == SocketHandle()) );
   REMUS_ASSERT( (good_3d_id == worker1_id) );
   REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 0) );
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
@@ -236,17 +250,17 @@ void verify_taking_works()
 
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
 
-  zmq::SocketIdentity good_2d_id = pool.takeWorker(worker_type2D);
-  REMUS_ASSERT( !(good_2d_id == zmq::SocketIdentity()) );
+  SocketHandle good_2d_id = pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( !(good_2d_id == SocketHandle()) );
   REMUS_ASSERT( (good_2d_id == worker1_id) );
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
 
-  zmq::SocketIdentity bad_2d_id = pool.takeWorker(worker_type2D);
-  zmq::SocketIdentity bad_3d_id = pool.takeWorker(worker_type3D);
+  SocketHandle bad_2d_id = pool.takeWorker(worker_type2D);
+  SocketHandle bad_3d_id = pool.takeWorker(worker_type3D);
 
-  REMUS_ASSERT( (bad_2d_id == zmq::SocketIdentity()) );
+  REMUS_ASSERT( (bad_2d_id == SocketHandle()) );
   REMUS_ASSERT( !(bad_2d_id == worker1_id) );
-  REMUS_ASSERT( (bad_3d_id == zmq::SocketIdentity()) );
+  REMUS_ASSERT( (bad_3d_id == SocketHandle()) );
   REMUS_ASSERT( !(bad_3d_id == worker1_id) );
 
   //still have the 3d worker item kicking around
@@ -258,6 +272,178 @@ void verify_taking_works()
   }
 }
 
+void verify_content_locality()
+{
+  remus::server::detail::WorkerPool pool;
+  SocketHandle worker1_id = make_socketId();
+  SocketHandle worker2_id = make_socketId();
+
+  const std::string digest("held by worker two");
+  remus::proto::ContentSummary holds(4);
+  holds.add(digest);
+  remus::proto::ContentChanges acknowledged;
+  acknowledged.Added.insert(digest);
+
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D, holds, acknowledged);
+  REMUS_ASSERT( (pool.holdsContent(worker2_id, digest)) )
+  REMUS_ASSERT( (!pool.holdsContent(worker1_id, digest)) )
+
+  //the worker holding the content is taken, even though the other
+  //worker has been waiting longer
+  std::vector<std::string> digests(1, digest);
+  SocketHandle taken = pool.takeWorker(worker_type2D, digests);
+  REMUS_ASSERT( (taken == worker2_id) )
+
+  //without content in common the worker first in line is taken
+  pool.readyForWork(worker2_id, worker_type2D, holds,
+                    remus::proto::ContentChanges());
+  taken = pool.takeWorker(worker_type2D, std::vector<std::string>());
+  REMUS_ASSERT( (taken == worker1_id) )
+
+  //a worker that has waited past the fairness timeout is taken before
+  //the worker that holds the content
+  pool.fairnessTimeout(0);
+  REMUS_ASSERT( (pool.fairnessTimeout() == 0) )
+  pool.readyForWork(worker1_id, worker_type2D);
+  remus::common::SleepForMillisec(5);
+  taken = pool.takeWorker(worker_type2D, digests);
+  REMUS_ASSERT( (taken == worker2_id) )
+  remus::common::SleepForMillisec(5);
+  pool.readyForWork(worker2_id, worker_type2D, holds,
+                    remus::proto::ContentChanges());
+  taken = pool.takeWorker(worker_type2D, digests);
+  REMUS_ASSERT( (taken == worker1_id) )
+  REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 1) )
+
+  //the acknowledged content stays until the worker drops it
+  REMUS_ASSERT( (pool.holdsContent(worker2_id, digest)) )
+  remus::proto::ContentChanges dropped;
+  dropped.Dropped.insert(digest);
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D,
+                    remus::proto::ContentSummary(), dropped);
+  REMUS_ASSERT( (!pool.holdsContent(worker2_id, digest)) )
+}
+
+void verify_batching()
+{
+  remus::server::detail::WorkerPool pool;
+  SocketHandle worker1_id = make_socketId();
+  SocketHandle worker2_id = make_socketId();
+
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type2D);
+  REMUS_ASSERT( (pool.numberOfWaitingWorkers(worker_type2D) == 0) )
+
+  //a single request can ask for several jobs
+  pool.readyForWork(worker1_id, worker_type2D, 3);
+  pool.readyForWork(worker2_id, worker_type2D, remus::proto::ContentSummary(),
+                    remus::proto::ContentChanges(), 2);
+  REMUS_ASSERT( (pool.numberOfWaitingWorkers(worker_type2D) == 2) )
+  REMUS_ASSERT( (pool.numberOfWaitingWorkers(worker_type3D) == 0) )
+  REMUS_ASSERT( (pool.numberOfJobsWanted(worker1_id, worker_type2D) == 3) )
+  REMUS_ASSERT( (pool.numberOfJobsWanted(worker2_id, worker_type2D) == 2) )
+  REMUS_ASSERT( (pool.numberOfJobsWanted(worker1_id, worker_type3D) == 0) )
+
+  //the worker we take can take more jobs for a batch, until it has all
+  //the jobs it asked for
+  SocketHandle taken = pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( (taken == worker1_id) )
+  REMUS_ASSERT( (pool.takeAnotherJob(taken, worker_type2D)) )
+  REMUS_ASSERT( (pool.takeAnotherJob(taken, worker_type2D)) )
+  REMUS_ASSERT( (!pool.takeAnotherJob(taken, worker_type2D)) )
+  REMUS_ASSERT( (!pool.takeAnotherJob(worker1_id, worker_type3D)) )
+  REMUS_ASSERT( (pool.numberOfJobsWanted(worker1_id, worker_type2D) == 0) )
+  REMUS_ASSERT( (pool.numberOfWaitingWorkers(worker_type2D) == 1) )
+
+  taken = pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( (taken == worker2_id) )
+  REMUS_ASSERT( (pool.numberOfJobsWanted(worker2_id, worker_type2D) == 1) )
+}
+
+void verify_taking_other_workers()
+{
+  remus::server::detail::WorkerPool pool;
+  SocketHandle worker1_id = make_socketId();
+  SocketHandle worker2_id = make_socketId();
+
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+
+  //the only waiting worker is the one we exclude
+  REMUS_ASSERT( (pool.takeOtherWorker(worker_type2D, worker1_id) == 0) )
+  REMUS_ASSERT( (pool.takeOtherWorker(worker_type3D, worker2_id) == 0) )
+
+  pool.readyForWork(worker2_id, worker_type2D);
+  SocketHandle taken = pool.takeOtherWorker(worker_type2D, worker1_id);
+  REMUS_ASSERT( (taken == worker2_id) )
+  REMUS_ASSERT( (pool.numberOfWaitingWorkers(worker_type2D) == 1) )
+
+  taken = pool.takeOtherWorker(worker_type2D, worker2_id);
+  REMUS_ASSERT( (taken == worker1_id) )
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) )
+}
+
+void verify_generation()
+{
+  remus::server::detail::WorkerPool pool;
+  SocketHandle worker1_id = make_socketId();
+  SocketHandle worker2_id = make_socketId();
+
+  //registering a worker changes what we support
+  boost::uint64_t generation = pool.generation();
+  pool.addWorker(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.generation() != generation) )
+
+  //registering the same worker again doesn't
+  generation = pool.generation();
+  pool.addWorker(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.generation() == generation) )
+
+  //starting to wait for work changes the waiting requirements, asking for
+  //more jobs while already waiting doesn't
+  pool.readyForWork(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.generation() != generation) )
+  generation = pool.generation();
+  pool.readyForWork(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.generation() == generation) )
+
+  //taking a job only changes the generation once the worker stops waiting
+  pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( (pool.generation() == generation) )
+  pool.takeWorker(worker_type2D);
+  REMUS_ASSERT( (pool.generation() != generation) )
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) )
+
+  //failing to find a worker changes nothing
+  generation = pool.generation();
+  REMUS_ASSERT( (pool.takeOtherWorker(worker_type2D, worker2_id) == 0) )
+  REMUS_ASSERT( (pool.readyForWork(worker2_id, worker_type2D) == false) )
+  REMUS_ASSERT( (pool.generation() == generation) )
+
+  //while another worker of the requirements is waiting, workers moving
+  //between waiting and busy don't change what is waiting
+  pool.addWorker(worker2_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  generation = pool.generation();
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) != 0) )
+  REMUS_ASSERT( (pool.generation() == generation) )
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  REMUS_ASSERT( (pool.generation() == generation) )
+
+  //a worker of other requirements starting to wait does change it
+  pool.addWorker(worker2_id, worker_type3D);
+  generation = pool.generation();
+  pool.readyForWork(worker2_id, worker_type3D);
+  REMUS_ASSERT( (pool.generation() != generation) )
+}
+
 } //namespace
 
 int UnitTestWorkerPool(int, char *[])
@@ -270,5 +456,13 @@ int UnitTestWorkerPool(int, char *[])
 
   verify_taking_works();
 
+  verify_content_locality();
+
+  verify_batching();
+
+  verify_taking_other_workers();
+
+  verify_generation();
+
   return 0;
 }
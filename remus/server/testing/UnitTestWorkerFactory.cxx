@@ -174,6 +174,11 @@ void test_factory_worker_args_env_tag()
   REMUS_ASSERT( (w.sourceType() == ContentSource::Memory) );
   REMUS_ASSERT( (w.hasRequirements() == false) );
 
+  //the worker file holds the default timeouts of its jobs
+  REMUS_ASSERT( (f_def.queueTimeout(reqIOTypes) == 60000) );
+  REMUS_ASSERT( (f_def.runTimeout(reqIOTypes) == 120000) );
+  REMUS_ASSERT( (f_def.queueTimeout(make_Reqs("Edges", "Mesh2D")) == 0) );
+
   const remus::server::WorkerFactoryBase::FactoryDeletionBehavior live =
     remus::server::WorkerFactoryBase::KillOnFactoryDeletion;
 
@@ -0,0 +1,215 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "AsyncWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//records the results that have been uploaded
+class RecordUploads : public remus::worker::ResultCallback
+{
+public:
+  void operator()(const remus::proto::JobResult& result)
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    this->Uploaded.push_back(result.id());
+  }
+
+  std::size_t count()
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    return this->Uploaded.size();
+  }
+
+private:
+  boost::mutex Mutex;
+  std::vector<boost::uuids::uuid> Uploaded;
+};
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job> submit_jobs(boost::shared_ptr<remus::Client> client,
+                                           boost::shared_ptr<remus::Worker> worker,
+                                           std::size_t numberOfJobs)
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  //let the server know about the worker, so that we can submit jobs
+  worker->askForJobs(1);
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  while(!client->canMesh(io_type))
+    {
+    remus::common::SleepForMillisec(50);
+    }
+
+  JobRequirementsSet reqsFromServer = client->retrieveRequirements(io_type);
+  REMUS_ASSERT( (reqsFromServer.size()==1) )
+
+  std::vector<Job> jobs;
+  for(std::size_t i=0; i < numberOfJobs; ++i)
+    {
+    JobSubmission sub((*reqsFromServer.begin()));
+    jobs.push_back( client->submitJob(sub) );
+    REMUS_ASSERT( jobs.back().valid() )
+    }
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+void verify_job_result(const remus::proto::Job& job,
+                       boost::shared_ptr<remus::Client> client,
+                       const std::string& expected)
+{
+  REMUS_ASSERT( (client->jobStatus(job).finished()) )
+
+  remus::proto::JobResult result = client->retrieveResults(job);
+  REMUS_ASSERT( (result.valid()) )
+  REMUS_ASSERT( (std::string(result.data(), result.dataSize()) == expected) )
+}
+
+//------------------------------------------------------------------------------
+void verify_async_results(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker)
+{
+  const std::size_t numberOfJobs = 4;
+  std::vector<remus::proto::Job> jobs = submit_jobs(client, worker,
+                                                    numberOfJobs);
+
+  //limit the uploads to a single result, so that returning the
+  //results has to wait on earlier uploads
+  worker->limitOutstandingResults(1);
+  REMUS_ASSERT( (worker->outstandingResultLimit() == 1) )
+
+  const std::string ascii_data = remus::testing::AsciiStringGenerator(2097152);
+  boost::shared_ptr<RecordUploads> uploads(new RecordUploads());
+  for(std::size_t i=0; i < numberOfJobs; ++i)
+    {
+    remus::worker::Job job = worker->getJob();
+    REMUS_ASSERT( (job.valid()) )
+
+    worker->returnResultAsync( remus::proto::make_JobResult(job.id(),
+                                                            ascii_data),
+                               uploads );
+    REMUS_ASSERT( (worker->outstandingResultCount() <= 1) )
+    }
+
+  worker->waitForResults();
+  REMUS_ASSERT( (worker->outstandingResultCount() == 0) )
+  REMUS_ASSERT( (uploads->count() == numberOfJobs) )
+
+  for(std::size_t i=0; i < numberOfJobs; ++i)
+    {
+    verify_job_result(jobs[i], client, ascii_data);
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_results_uploaded_on_destruction(
+                                    boost::shared_ptr<remus::Client> client,
+                                    const remus::server::ServerPorts& ports)
+{
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  std::vector<remus::proto::Job> jobs = submit_jobs(client, worker, 1);
+
+  const std::string ascii_data = remus::testing::AsciiStringGenerator(2097152);
+  remus::worker::Job job = worker->getJob();
+  REMUS_ASSERT( (job.valid()) )
+  worker->returnResultAsync( remus::proto::make_JobResult(job.id(),
+                                                          ascii_data) );
+
+  //destroying the worker has to wait for the result to be uploaded
+  worker.reset();
+  verify_job_result(jobs[0], client, ascii_data);
+}
+
+}
+
+//Verifies that results returned asynchronously all reach the server, even
+//when the worker is destroyed while they are being uploaded
+int AsyncResultJobFlow(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  {
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  verify_async_results(client,worker);
+  }
+
+  verify_results_uploaded_on_destruction(client,ports);
+  return 0;
+}
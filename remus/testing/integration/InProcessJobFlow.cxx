@@ -0,0 +1,194 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/InProcessWorkerFactory.h>
+#include <remus/server/Server.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements make_Requirements(const std::string& name)
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  return remus::proto::make_JobRequirements(io_type, name, "");
+}
+
+//returns the content of the submission as the result
+class EchoJob : public remus::server::InProcessJobFunction
+{
+public:
+  void operator()(remus::server::InProcessJob& handle)
+  {
+    const remus::worker::Job& job = handle.job();
+    handle.updateStatus( remus::proto::make_JobStatus(job.id(), 50) );
+
+    remus::proto::JobSubmission::const_iterator content =
+                                          job.submission().find("data");
+    REMUS_ASSERT( (content != job.submission().end()) )
+    handle.returnResult( remus::proto::make_JobResult(job.id(),
+                std::string(content->second.data(), content->second.dataSize())) );
+  }
+};
+
+//runs until the job is terminated, or the server shuts down
+class EndlessJob : public remus::server::InProcessJobFunction
+{
+public:
+  void operator()(remus::server::InProcessJob& handle)
+  {
+    handle.updateStatus( remus::proto::make_JobStatus(handle.job().id(), 1) );
+    while(!handle.jobShouldBeTerminated() && !handle.workerShouldTerminate())
+      {
+      remus::common::SleepForMillisec(10);
+      }
+  }
+};
+
+//returns without a result, which fails the job
+class ForgetfulJob : public remus::server::InProcessJobFunction
+{
+public:
+  void operator()(remus::server::InProcessJob&)
+  {
+  }
+};
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  boost::shared_ptr<remus::server::InProcessWorkerFactory> factory(
+                            new remus::server::InProcessWorkerFactory(2));
+  factory->registerJobFunction(make_Requirements("Echo"),
+      boost::shared_ptr<remus::server::InProcessJobFunction>(new EchoJob()));
+  factory->registerJobFunction(make_Requirements("Endless"),
+      boost::shared_ptr<remus::server::InProcessJobFunction>(new EndlessJob()));
+  factory->registerJobFunction(make_Requirements("Forgetful"),
+      boost::shared_ptr<remus::server::InProcessJobFunction>(new ForgetfulJob()));
+  REMUS_ASSERT( (factory->maxWorkerCount() == 2) )
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus wait_for_job(boost::shared_ptr<remus::Client> client,
+                                     const remus::proto::Job& job)
+{
+  std::vector<remus::proto::Job> jobs(1, job);
+  std::vector<remus::proto::JobStatus> statuses = client->waitForJobs(jobs, 10000);
+  REMUS_ASSERT( (statuses.size() == 1) )
+  return statuses[0];
+}
+
+//------------------------------------------------------------------------------
+void verify_echo_jobs(boost::shared_ptr<remus::Client> client)
+{
+  REMUS_ASSERT( (client->canMesh(make_Requirements("Echo"))) )
+
+  //submit more jobs than we have threads, so that jobs have to wait in
+  //the queue for a thread to be free
+  std::vector<remus::proto::Job> jobs;
+  for(int i=0; i < 6; ++i)
+    {
+    remus::proto::JobSubmission sub(make_Requirements("Echo"));
+    sub["data"] = remus::proto::make_JobContent(
+                        "content " + boost::lexical_cast<std::string>(i));
+    jobs.push_back( client->submitJob(sub) );
+    REMUS_ASSERT( (jobs.back().valid()) )
+    }
+
+  for(int i=0; i < 6; ++i)
+    {
+    REMUS_ASSERT( (wait_for_job(client, jobs[i]).finished()) )
+    remus::proto::JobResult result = client->retrieveResults(jobs[i]);
+    REMUS_ASSERT( (result.valid()) )
+    REMUS_ASSERT( (std::string(result.data(), result.dataSize()) ==
+                   "content " + boost::lexical_cast<std::string>(i)) )
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_failed_job(boost::shared_ptr<remus::Client> client)
+{
+  remus::proto::JobSubmission sub(make_Requirements("Forgetful"));
+  remus::proto::Job job = client->submitJob(sub);
+  REMUS_ASSERT( (wait_for_job(client, job).failed()) )
+}
+
+//------------------------------------------------------------------------------
+void verify_terminate_job(boost::shared_ptr<remus::Client> client)
+{
+  remus::proto::JobSubmission sub(make_Requirements("Endless"));
+  remus::proto::Job job = client->submitJob(sub);
+
+  //wait for the job to start before terminating it
+  while(!client->jobStatus(job).inProgress())
+    {
+    remus::common::SleepForMillisec(10);
+    }
+  REMUS_ASSERT( (client->terminate(job).failed()) )
+  REMUS_ASSERT( (client->jobStatus(job).invalid()) )
+
+  //once the job has stopped its thread runs other jobs again
+  remus::proto::JobSubmission echo(make_Requirements("Echo"));
+  echo["data"] = remus::proto::make_JobContent("after terminate");
+  remus::proto::Job next = client->submitJob(echo);
+  REMUS_ASSERT( (wait_for_job(client, next).finished()) )
+}
+
+}
+
+//Verifies that jobs run inside the server by an InProcessWorkerFactory
+//report their status and results like jobs given to a worker
+int InProcessJobFlow(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+
+  verify_echo_jobs(client);
+  verify_failed_job(client);
+  verify_terminate_job(client);
+
+  //leave a job running, stopping the server has to tell it to stop
+  remus::proto::JobSubmission sub(make_Requirements("Endless"));
+  remus::proto::Job job = client->submitJob(sub);
+  while(!client->jobStatus(job).inProgress())
+    {
+    remus::common::SleepForMillisec(10);
+    }
+  server->stopBrokering();
+  return 0;
+}
@@ -124,6 +124,11 @@ remus::proto::Job verify_job_submission(boost::shared_ptr<remus::Client> client,
   JobRequirementsSet reqsFromServer = client->retrieveRequirements(io_type);
   REMUS_ASSERT( (reqsFromServer.size()==1) )
 
+  //asking again is answered from the requirements the client holds
+  JobRequirementsSet cachedReqs = client->retrieveRequirements(io_type);
+  REMUS_ASSERT( (cachedReqs.size()==1) )
+  REMUS_ASSERT( (*cachedReqs.begin() == *reqsFromServer.begin()) )
+
   //craft a submission using the first workers reqs
   JobSubmission sub((*reqsFromServer.begin()));
   sub["extra_stuff"] = make_JobContent("random data");
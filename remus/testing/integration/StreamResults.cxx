@@ -0,0 +1,190 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/remusGlobals.h>
+#include <remus/testing/Testing.h>
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <sstream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "SimpleWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client)
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements reqs = make_JobRequirements(io_type, "SimpleWorker", "");
+
+  JobSubmission sub(reqs);
+  sub["data"] = make_JobContent("random data");
+
+  remus::proto::Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+void return_result(boost::shared_ptr<remus::Worker> worker,
+                   const std::string& data)
+{
+  remus::worker::Job job = worker->getJob();
+  worker->returnResult( remus::proto::make_JobResult(job.id(),data) );
+}
+
+//------------------------------------------------------------------------------
+void return_streamed_result(boost::shared_ptr<remus::Worker> worker,
+                            const std::string& data)
+{
+  remus::worker::Job job = worker->getJob();
+  std::istringstream input(data);
+  worker->returnResult( job, input, remus::common::ContentFormat::BSON );
+}
+
+//------------------------------------------------------------------------------
+void wait_for_finish(boost::shared_ptr<remus::Client> client,
+                     const remus::proto::Job& job)
+{
+  std::vector<remus::proto::Job> jobs(1,job);
+  std::vector<remus::proto::JobStatus> statuses = client->waitForJobs(jobs,60000);
+  REMUS_ASSERT( (statuses.size() == 1) );
+  REMUS_ASSERT( (statuses[0].finished() == true) );
+}
+
+//------------------------------------------------------------------------------
+void verify_large_result(boost::shared_ptr<remus::Client> client,
+                         boost::shared_ptr<remus::Worker> worker)
+{
+  //a result that spans multiple chunks and more chunks than the worker
+  //has credits for, with a partial last chunk. The server is on the same
+  //machine, so the worker hands it the result through shared memory
+  const std::size_t size = remus::STREAM_CHUNK_SIZE *
+                           (remus::STREAM_CHUNK_CREDITS + 2) + 1234;
+  const std::string data = remus::testing::BinaryDataGenerator(size);
+
+  remus::proto::Job job = submit_Job(client);
+  boost::thread returner(&return_result, worker, data);
+  wait_for_finish(client, job);
+  returner.join();
+
+  //the regular retrieval returns the joined result
+  remus::proto::JobResult result = client->retrieveResults(job);
+  REMUS_ASSERT( (result.dataSize() == data.size()) );
+  REMUS_ASSERT( (std::string(result.data(),result.dataSize()) == data) );
+
+  //the result has been removed from the server
+  std::ostringstream output;
+  REMUS_ASSERT( (client->retrieveResults(job, output) == false) );
+}
+
+//------------------------------------------------------------------------------
+void verify_streamed_result(boost::shared_ptr<remus::Client> client,
+                            boost::shared_ptr<remus::Worker> worker,
+                            std::size_t size)
+{
+  const std::string data = remus::testing::BinaryDataGenerator(size);
+
+  remus::proto::Job job = submit_Job(client);
+  boost::thread returner(&return_streamed_result, worker, data);
+  wait_for_finish(client, job);
+  returner.join();
+
+  //retrieve the result a chunk at a time
+  std::ostringstream output;
+  REMUS_ASSERT( (client->retrieveResults(job, output) == true) );
+  REMUS_ASSERT( (output.str() == data) );
+
+  //the result has been removed from the server
+  REMUS_ASSERT( (client->retrieveResults(job).valid() == false) );
+}
+
+}
+
+//Verifies that large results are streamed between the worker, server and
+//client in chunks
+int StreamResults(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+
+  verify_large_result(client, worker);
+
+  //stream from an input with a partial last chunk, and from one that
+  //is an exact multiple of the chunk size
+  verify_streamed_result(client, worker, remus::STREAM_CHUNK_SIZE * 3 + 11);
+  verify_streamed_result(client, worker, remus::STREAM_CHUNK_SIZE * 2);
+
+  //small results still work when retrieved by chunk
+  verify_streamed_result(client, worker, 64);
+
+  return 0;
+}
@@ -0,0 +1,234 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/remusGlobals.h>
+#include <remus/testing/Testing.h>
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <sstream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "SimpleWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission()
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements reqs = make_JobRequirements(io_type, "SimpleWorker", "");
+  return JobSubmission(reqs);
+}
+
+//------------------------------------------------------------------------------
+//take a job and verify that its content for each key matches what was
+//submitted, including the format and tag
+void verify_job(boost::shared_ptr<remus::Worker> worker,
+                remus::proto::JobSubmission expected)
+{
+  remus::worker::Job job = worker->getJob();
+  REMUS_ASSERT( job.valid() );
+  REMUS_ASSERT( (job.submission().size() == expected.size()) );
+
+  typedef remus::proto::JobSubmission::const_iterator it;
+  for(it i = expected.begin(); i != expected.end(); ++i)
+    {
+    remus::proto::JobContent content;
+    REMUS_ASSERT( (job.details(i->first, content) == true) );
+    REMUS_ASSERT( (content.formatType() == i->second.formatType()) );
+    REMUS_ASSERT( (content.tag() == i->second.tag()) );
+    REMUS_ASSERT( (content.dataSize() == i->second.dataSize()) );
+    REMUS_ASSERT( (std::string(content.data(),content.dataSize()) ==
+                   std::string(i->second.data(),i->second.dataSize())) );
+    }
+
+  worker->returnResult( remus::proto::make_JobResult(job.id(),"done") );
+}
+
+//------------------------------------------------------------------------------
+void wait_for_finish(boost::shared_ptr<remus::Client> client,
+                     const remus::proto::Job& job)
+{
+  std::vector<remus::proto::Job> jobs(1,job);
+  std::vector<remus::proto::JobStatus> statuses = client->waitForJobs(jobs,60000);
+  REMUS_ASSERT( (statuses.size() == 1) );
+  REMUS_ASSERT( (statuses[0].finished() == true) );
+
+  remus::proto::JobResult result = client->retrieveResults(job);
+  REMUS_ASSERT( (std::string(result.data(),result.dataSize()) == "done") );
+}
+
+//------------------------------------------------------------------------------
+void verify_shared_submission(boost::shared_ptr<remus::Client> client,
+                              boost::shared_ptr<remus::Worker> worker)
+{
+  //content larger than a chunk, mixed with content small enough to be
+  //sent with the submission. The server is on the same machine, so the
+  //large content is handed to it through shared memory
+  const std::size_t size = remus::STREAM_CHUNK_SIZE *
+                           (remus::STREAM_CHUNK_CREDITS + 2) + 1234;
+  const std::string large = remus::testing::BinaryDataGenerator(size);
+  const std::string medium =
+              remus::testing::BinaryDataGenerator(remus::STREAM_CHUNK_SIZE * 2);
+
+  remus::proto::JobSubmission sub = make_Submission();
+  sub["small"] = remus::proto::make_JobContent("random data");
+  sub["large"] = remus::proto::make_JobContent(large,
+                                         remus::common::ContentFormat::BSON);
+  sub["large"].tag("large tag");
+  sub["medium"] = remus::proto::make_JobContent(medium);
+
+  remus::proto::Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() );
+
+  verify_job(worker, sub);
+  wait_for_finish(client, job);
+}
+
+//------------------------------------------------------------------------------
+void verify_deduplicated_submission(boost::shared_ptr<remus::Client> client,
+                                    boost::shared_ptr<remus::Worker> worker)
+{
+  //jobs that share large content, and differ only in small content. The
+  //first job is still queued when the second is submitted, so the server
+  //holds the large content and the second job only references it
+  const std::string geometry =
+        remus::testing::BinaryDataGenerator(remus::STREAM_CHUNK_SIZE * 3);
+
+  remus::proto::JobSubmission first = make_Submission();
+  first["geometry"] = remus::proto::make_JobContent(geometry,
+                                           remus::common::ContentFormat::BSON);
+  first["params"] = remus::proto::make_JobContent("first");
+
+  remus::proto::JobSubmission second = first;
+  second["geometry"].tag("second tag");
+  second["params"] = remus::proto::make_JobContent("second");
+
+  remus::proto::Job firstJob = client->submitJob(first);
+  remus::proto::Job secondJob = client->submitJob(second);
+  REMUS_ASSERT( firstJob.valid() );
+  REMUS_ASSERT( secondJob.valid() );
+
+  verify_job(worker, first);
+  wait_for_finish(client, firstJob);
+  verify_job(worker, second);
+  wait_for_finish(client, secondJob);
+}
+
+//------------------------------------------------------------------------------
+void verify_forwarded_submission(boost::shared_ptr<remus::Client> client,
+                                 boost::shared_ptr<remus::Worker> worker,
+                                 std::size_t size)
+{
+  //the worker is already waiting for a job, so the server forwards
+  //each chunk to the worker as it arrives
+  const std::string data = remus::testing::BinaryDataGenerator(size);
+
+  remus::proto::JobSubmission sub = make_Submission();
+  sub["small"] = remus::proto::make_JobContent("random data");
+  sub["data"] = remus::proto::make_JobContent(std::string(),
+                                              remus::common::ContentFormat::XML);
+  sub["data"].tag("streamed tag");
+
+  remus::proto::JobSubmission expected = sub;
+  expected["data"] = remus::proto::make_JobContent(data,
+                                             remus::common::ContentFormat::XML);
+  expected["data"].tag("streamed tag");
+
+  boost::thread taker(&verify_job, worker, expected);
+
+  std::istringstream input(data);
+  remus::proto::Job job = client->submitJob(sub, "data", input);
+  REMUS_ASSERT( job.valid() );
+
+  wait_for_finish(client, job);
+  taker.join();
+}
+
+}
+
+//Verifies that large job submissions are streamed between the client,
+//server and worker in chunks
+int StreamSubmissions(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+
+  verify_shared_submission(client, worker);
+  verify_deduplicated_submission(client, worker);
+
+  //stream from an input with a partial last chunk, from one that
+  //is an exact multiple of the chunk size, and from an empty one
+  verify_forwarded_submission(client, worker, remus::STREAM_CHUNK_SIZE * 3 + 11);
+  verify_forwarded_submission(client, worker, remus::STREAM_CHUNK_SIZE * 2);
+  verify_forwarded_submission(client, worker, 0);
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //use a slow polling cycle, so that we verify waiting clients are
+  //answered without waiting for the poll to timeout
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "SimpleWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client)
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements reqs = make_JobRequirements(io_type, "SimpleWorker", "");
+
+  JobSubmission sub(reqs);
+  sub["data"] = make_JobContent("random data");
+
+  remus::proto::Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+boost::posix_time::time_duration elapsed(const boost::posix_time::ptime& start)
+{
+  return boost::posix_time::microsec_clock::local_time() - start;
+}
+
+//------------------------------------------------------------------------------
+void finish_job_later(boost::shared_ptr<remus::Worker> worker,
+                      boost::int64_t delayInMilliseconds)
+{
+  remus::worker::Job job = worker->getJob();
+  remus::common::SleepForMillisec(delayInMilliseconds);
+  worker->returnResult( remus::proto::make_JobResult(job.id(),"result") );
+}
+
+//------------------------------------------------------------------------------
+void verify_wait_times_out(boost::shared_ptr<remus::Client> client,
+                           const std::vector<remus::proto::Job>& jobs)
+{
+  //no worker is connected, so the jobs will stay queued and we should
+  //only return once the timeout has expired
+  const boost::posix_time::ptime start =
+                              boost::posix_time::microsec_clock::local_time();
+  std::vector<remus::proto::JobStatus> statuses = client->waitForJobs(jobs,250);
+
+  REMUS_ASSERT( (elapsed(start).total_milliseconds() >= 250) );
+  //the server polls at 1500ms, so a much later answer means we
+  //were not woken up by the deadline
+  REMUS_ASSERT( (elapsed(start).total_milliseconds() < 1500) );
+  REMUS_ASSERT( (statuses.size() == jobs.size()) );
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].id() == jobs[i].id()) );
+    REMUS_ASSERT( (statuses[i].queued() == true) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_wait_returns_on_finish(boost::shared_ptr<remus::Client> client,
+                                   boost::shared_ptr<remus::Worker> worker,
+                                   const std::vector<remus::proto::Job>& jobs)
+{
+  worker->askForJobs(1);
+  boost::thread finisher(&finish_job_later, worker, 250);
+
+  //we should be woken up when the worker returns the result and not when
+  //the very long timeout expires
+  const boost::posix_time::ptime start =
+                              boost::posix_time::microsec_clock::local_time();
+  std::vector<remus::proto::JobStatus> statuses = client->waitForJobs(jobs,60000);
+  finisher.join();
+
+  REMUS_ASSERT( (elapsed(start).total_milliseconds() < 30000) );
+  REMUS_ASSERT( (statuses.size() == jobs.size()) );
+
+  std::size_t numFinished = 0;
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    if(statuses[i].finished())
+      { ++numFinished; }
+    }
+  REMUS_ASSERT( (numFinished == 1) );
+
+  //waiting on jobs where one has already finished returns right away
+  statuses = client->waitForJobs(jobs,60000);
+  REMUS_ASSERT( (elapsed(start).total_milliseconds() < 30000) );
+}
+
+//------------------------------------------------------------------------------
+void verify_wait_returns_on_terminate(boost::shared_ptr<remus::Client> client,
+                                      const remus::proto::Job& job)
+{
+  //a job that has been terminated doesn't exist on the server anymore,
+  //and waiting on it should return right away
+  client->terminate(job);
+  std::vector<remus::proto::Job> jobs(1,job);
+
+  const boost::posix_time::ptime start =
+                              boost::posix_time::microsec_clock::local_time();
+  std::vector<remus::proto::JobStatus> statuses = client->waitForJobs(jobs,60000);
+  REMUS_ASSERT( (elapsed(start).total_milliseconds() < 30000) );
+  REMUS_ASSERT( (statuses.size() == 1) );
+  REMUS_ASSERT( (statuses[0].invalid() == true) );
+}
+
+}
+
+//Verifies that a client can block on the server until jobs finish
+int WaitForJobs(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+
+  std::vector<remus::proto::Job> jobs;
+  jobs.push_back( submit_Job(client) );
+  jobs.push_back( submit_Job(client) );
+
+  //waiting on nothing returns nothing
+  REMUS_ASSERT( (client->waitForJobs(std::vector<remus::proto::Job>(),1000).size() == 0) );
+
+  verify_wait_times_out(client, jobs);
+
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  verify_wait_returns_on_finish(client, worker, jobs);
+
+  verify_wait_returns_on_terminate(client, jobs[1]);
+
+  return 0;
+}
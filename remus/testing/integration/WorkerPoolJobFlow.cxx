@@ -0,0 +1,268 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/WorkerPool.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+//holds every job until a second job is running at the same time, or a
+//timeout passes, and records the most jobs that ran at the same time
+class CountingJobFunction : public remus::worker::JobFunction
+{
+public:
+  CountingJobFunction():
+    Running(0),
+    MaxRunning(0),
+    Throw(false)
+  {
+  }
+
+  void operator()(remus::worker::Worker& worker,
+                  const remus::worker::Job& job)
+  {
+    {
+    boost::unique_lock<boost::mutex> lock(this->Mutex);
+    if(this->Throw)
+      {
+      throw std::runtime_error("meshing failed");
+      }
+    }
+
+    {
+    boost::unique_lock<boost::mutex> lock(this->Mutex);
+    ++this->Running;
+    this->MaxRunning = std::max(this->MaxRunning, this->Running);
+    this->Changed.notify_all();
+
+    const boost::system_time until = boost::get_system_time() +
+                                     boost::posix_time::milliseconds(2000);
+    while(this->Running < 2)
+      {
+      if(!this->Changed.timed_wait(lock, until))
+        {
+        break;
+        }
+      }
+    }
+
+    remus::proto::JobProgress progress(50);
+    worker.updateStatus( remus::proto::JobStatus(job.id(),progress) );
+    worker.returnResult( remus::proto::make_JobResult(job.id(),"done") );
+
+    boost::unique_lock<boost::mutex> lock(this->Mutex);
+    --this->Running;
+  }
+
+  std::size_t maxRunning()
+  {
+    boost::unique_lock<boost::mutex> lock(this->Mutex);
+    return this->MaxRunning;
+  }
+
+  //make every job that is started from now on throw
+  void throwOnJobs(bool t)
+  {
+    boost::unique_lock<boost::mutex> lock(this->Mutex);
+    this->Throw = t;
+  }
+
+private:
+  boost::mutex Mutex;
+  boost::condition_variable Changed;
+  std::size_t Running;
+  std::size_t MaxRunning;
+  bool Throw;
+};
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements make_Requirements()
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  return remus::proto::make_JobRequirements(io_type, "PoolWorker", "");
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::worker::WorkerPool>
+make_WorkerPool( const remus::server::ServerPorts& ports,
+                 boost::shared_ptr<remus::worker::JobFunction> function,
+                 std::size_t numberOfSlots )
+{
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  boost::shared_ptr<remus::worker::WorkerPool> pool(
+        new remus::worker::WorkerPool(make_Requirements(), conn,
+                                      function, numberOfSlots) );
+  return pool;
+}
+
+//------------------------------------------------------------------------------
+void verify_concurrent_jobs(boost::shared_ptr<remus::Client> client,
+                            boost::shared_ptr<remus::worker::WorkerPool> pool,
+                            boost::shared_ptr<CountingJobFunction> function)
+{
+  REMUS_ASSERT( (pool->numberOfSlots() == 4) );
+
+  std::vector<remus::proto::Job> jobs;
+  for(int i=0; i < 8; ++i)
+    {
+    remus::proto::JobSubmission sub(make_Requirements());
+    jobs.push_back( client->submitJob(sub) );
+    REMUS_ASSERT( jobs.back().valid() );
+    }
+
+  //wait for every job to finish
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    remus::proto::JobStatus status = client->jobStatus(jobs[i]);
+    for(int tries=0; !status.finished() && tries < 600; ++tries)
+      {
+      remus::common::SleepForMillisec(50);
+      status = client->jobStatus(jobs[i]);
+      }
+    REMUS_ASSERT( (status.finished() == true) );
+
+    remus::proto::JobResult result = client->retrieveResults(jobs[i]);
+    REMUS_ASSERT( (std::string(result.data(),result.dataSize()) == "done") );
+    }
+
+  //the server dispatched jobs to multiple slots of the single worker
+  REMUS_ASSERT( (function->maxRunning() >= 2) );
+  REMUS_ASSERT( (function->maxRunning() <= pool->numberOfSlots()) );
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus wait_for_job(boost::shared_ptr<remus::Client> client,
+                                     const remus::proto::Job& job)
+{
+  remus::proto::JobStatus status = client->jobStatus(job);
+  for(int tries=0; !status.finished() && !status.failed() && tries < 600;
+      ++tries)
+    {
+    remus::common::SleepForMillisec(50);
+    status = client->jobStatus(job);
+    }
+  return status;
+}
+
+//------------------------------------------------------------------------------
+void verify_throwing_jobs(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::worker::WorkerPool> pool,
+                          boost::shared_ptr<CountingJobFunction> function)
+{
+  //a job function that throws fails the job, and every slot keeps going
+  function->throwOnJobs(true);
+  std::vector<remus::proto::Job> jobs;
+  for(std::size_t i=0; i < pool->numberOfSlots(); ++i)
+    {
+    remus::proto::JobSubmission sub(make_Requirements());
+    jobs.push_back( client->submitJob(sub) );
+    }
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( (wait_for_job(client, jobs[i]).failed() == true) );
+    }
+
+  function->throwOnJobs(false);
+  jobs.clear();
+  for(std::size_t i=0; i < pool->numberOfSlots(); ++i)
+    {
+    remus::proto::JobSubmission sub(make_Requirements());
+    jobs.push_back( client->submitJob(sub) );
+    }
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( (wait_for_job(client, jobs[i]).finished() == true) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_server_shutdown(boost::shared_ptr<remus::Server> server,
+                            boost::shared_ptr<remus::worker::WorkerPool> pool)
+{
+  //when the server goes away every slot has to be told to stop
+  server->stopBrokering();
+  if(server->isBrokering())
+    {
+    server->waitForBrokeringToFinish();
+    }
+  pool->wait();
+  REMUS_ASSERT( (pool->worker().workerShouldTerminate() == true) );
+}
+
+}
+
+int WorkerPoolJobFlow(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+
+  boost::shared_ptr<CountingJobFunction> function(new CountingJobFunction());
+  boost::shared_ptr<remus::worker::WorkerPool> pool =
+                                        make_WorkerPool( ports, function, 4 );
+
+  verify_concurrent_jobs(client, pool, function);
+  verify_throwing_jobs(client, pool, function);
+  verify_server_shutdown(server, pool);
+
+  return 0;
+}
@@ -13,8 +13,11 @@
 #ifndef remus_worker_Job_h
 #define remus_worker_Job_h
 
+#include <cstring>
 #include <string>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <remus/common/MeshIOType.h>
 #include <remus/proto/JobSubmission.h>
@@ -127,11 +130,10 @@ inline std::string to_string(const remus::worker::Job& job)
 
 
 //------------------------------------------------------------------------------
-inline remus::worker::Job to_Job(const std::string& msg)
+//read a job from a stream, leaving anything that follows the job
+//in the stream
+inline remus::worker::Job to_Job(std::istream& buffer)
 {
-  //convert a job detail from a string, used as a hack to serialize
-  std::istringstream buffer(msg);
-
   boost::uuids::uuid id;
   remus::proto::JobSubmission submission;
 
@@ -140,6 +142,14 @@ inline remus::worker::Job to_Job(const std::string& msg)
   return remus::worker::Job(id,submission);
 }
 
+//------------------------------------------------------------------------------
+inline remus::worker::Job to_Job(const std::string& msg)
+{
+  //convert a job detail from a string, used as a hack to serialize
+  std::istringstream buffer(msg);
+  return to_Job(buffer);
+}
+
 
 //------------------------------------------------------------------------------
 inline remus::worker::Job to_Job(const char* data, int size)
@@ -149,6 +159,88 @@ inline remus::worker::Job to_Job(const char* data, int size)
   return to_Job( temp );
 }
 
+//------------------------------------------------------------------------------
+//returns the id of a serialized job without decoding the submission
+inline boost::uuids::uuid to_JobId(const char* data, std::size_t size)
+{
+  //the id is the first line of a serialized job
+  const char* end = static_cast<const char*>(std::memchr(data, '\n', size));
+  const std::size_t idSize = (end != NULL) ? static_cast<std::size_t>(end - data)
+                                           : size;
+
+  std::istringstream buffer(std::string(data, idSize));
+  boost::uuids::uuid id = boost::uuids::uuid();
+  buffer >> id;
+  return id;
+}
+
+//------------------------------------------------------------------------------
+//serializes the messages of several jobs for the same requirements into
+//the data of a single JOB_BATCH message, so that small jobs don't each
+//pay for a message of their own
+inline std::string to_JobBatch(const std::vector<std::string>& jobMessages)
+{
+  std::ostringstream buffer;
+  buffer << jobMessages.size() << std::endl;
+  typedef std::vector<std::string>::const_iterator It;
+  for(It i = jobMessages.begin(); i != jobMessages.end(); ++i)
+    {
+    buffer << i->size() << std::endl;
+    buffer.write(i->data(), static_cast<std::streamsize>(i->size()));
+    }
+  return buffer.str();
+}
+
+namespace detail
+{
+//------------------------------------------------------------------------------
+//reads a newline terminated number, moving data past the newline
+inline bool readBatchNumber(const char*& data, const char* end,
+                            std::size_t& value)
+{
+  const char* eol = static_cast<const char*>(
+                    std::memchr(data, '\n', static_cast<std::size_t>(end - data)));
+  if(eol == NULL)
+    {
+    return false;
+    }
+  std::istringstream buffer(std::string(data, eol));
+  buffer >> value;
+  data = eol + 1;
+  return !buffer.fail();
+}
+}
+
+//------------------------------------------------------------------------------
+//returns where the message of each job is in the data of a JOB_BATCH
+//message, so that each job can be parsed without copying the batch.
+//A damaged batch returns the jobs before the damage
+typedef std::pair<const char*, std::size_t> JobBatchEntry;
+inline std::vector<JobBatchEntry> to_JobBatchEntries(const char* data,
+                                                     std::size_t size)
+{
+  std::vector<JobBatchEntry> entries;
+  const char* end = data + size;
+  std::size_t count = 0;
+  if(!detail::readBatchNumber(data, end, count))
+    {
+    return entries;
+    }
+
+  for(std::size_t i=0; i < count; ++i)
+    {
+    std::size_t jobSize = 0;
+    if(!detail::readBatchNumber(data, end, jobSize) ||
+       jobSize > static_cast<std::size_t>(end - data))
+      {
+      break;
+      }
+    entries.push_back(JobBatchEntry(data, jobSize));
+    data += jobSize;
+    }
+  return entries;
+}
+
 }
 }
 
@@ -12,19 +12,33 @@
 
 #include <remus/worker/Worker.h>
 
+#include <remus/common/MappedFile.h>
+#include <remus/common/MD5Hash.h>
+#include <remus/common/SharedMemory.h>
+#include <remus/proto/DataChunk.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 #include <remus/proto/zmqHelper.h>
+#include <remus/worker/detail/ContentCache.h>
 #include <remus/worker/detail/JobQueue.h>
 #include <remus/worker/detail/MessageRouter.h>
+#include <remus/worker/detail/StatusCoalescer.h>
 
+#include <algorithm>
+#include <deque>
 #include <string>
+#include <utility>
+#include <vector>
 
 //suppress warnings inside boost headers for gcc and clang
 #ifndef _MSC_VER
   #pragma GCC diagnostic push
   #pragma GCC diagnostic ignored "-Wshadow"
 #endif
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -44,20 +58,28 @@ struct ZmqManagement
   //the same context.
   boost::shared_ptr<zmq::context_t> InterWorkerContext;
   zmq::socket_t Server;
+  //zmq sockets can't be shared between threads, so every use of the Server
+  //socket holds this lock. Calls that wait on a response from the server
+  //hold it until the response arrives, so responses go to the right caller
+  boost::mutex ServerMutex;
+  //the number of MAKE_MESH requests we have sent, and the number of jobs
+  //we want to keep prefetched. Both are guarded by the ServerMutex
+  std::size_t JobsRequested;
+  unsigned int PrefetchCount;
   std::string WorkerChannelUUID;
-  std::string JobChannelUUID;
   ZmqManagement( remus::worker::ServerConnection const& conn ):
     InterWorkerContext( conn.context() ),
     Server( *InterWorkerContext, ZMQ_PAIR),
-    WorkerChannelUUID(),
-    JobChannelUUID()
+    ServerMutex(),
+    JobsRequested(0),
+    PrefetchCount(0),
+    WorkerChannelUUID()
   {
   boost::uuids::random_generator generator;
 
   //the goal here is to produce unique socket names. The current solution
   //is to use uuids for the channel names
   WorkerChannelUUID = boost::uuids::to_string(generator());
-  JobChannelUUID = boost::uuids::to_string(generator());
 
   //We have to bind to the inproc socket before the MessageRouter class does
   zmq::socketInfo<zmq::proto::inproc> sInfo( this->WorkerChannelUUID );
@@ -65,6 +87,104 @@ struct ZmqManagement
   }
 };
 
+//The results passed to returnResultAsync that are waiting to be uploaded,
+//and the thread that uploads them. The thread is only started the first
+//time a result is returned asynchronously.
+struct AsyncResults
+{
+  typedef std::pair< remus::proto::JobResult,
+                     boost::shared_ptr<remus::worker::ResultCallback> > Upload;
+
+  boost::mutex Mutex;
+  boost::condition_variable Changed;
+  std::deque<Upload> Pending;
+  //the number of results taken from Pending that are being uploaded
+  std::size_t Uploading;
+  std::size_t Limit;
+  bool Stopping;
+  boost::scoped_ptr<boost::thread> Thread;
+
+  AsyncResults():
+    Mutex(),
+    Changed(),
+    Pending(),
+    Uploading(0),
+    Limit(2),
+    Stopping(false),
+    Thread()
+  {
+  }
+
+  //requires the lock to be held
+  std::size_t outstanding() const
+  {
+    return this->Pending.size() + this->Uploading;
+  }
+};
+
+//Sends the chunks of a streamed result to the server. Each chunk uses up
+//one credit until the server acknowledges it, and once all
+//remus::STREAM_CHUNK_CREDITS credits are used we block waiting for an
+//acknowledgement. This keeps a fast worker from queuing an unbounded
+//amount of data in the messaging layers.
+class ResultStreamer
+{
+public:
+  ResultStreamer(const remus::common::MeshIOType& mtype,
+                 zmq::socket_t& socket):
+    MeshTypes(mtype),
+    Socket(socket),
+    ChunksInFlight(0),
+    Accepted(true)
+  {
+  }
+
+  //send the next chunk, returns false if the server has rejected the
+  //stream, in which case no more chunks should be sent
+  bool send(const remus::proto::DataChunk& chunk)
+  {
+    if(this->ChunksInFlight >= remus::STREAM_CHUNK_CREDITS)
+      {
+      this->waitForAcknowledgement();
+      }
+    if(this->Accepted)
+      {
+      remus::proto::send_Message(this->MeshTypes,
+                                 remus::RESULT_CHUNK,
+                                 remus::proto::to_string(chunk),
+                                 &this->Socket);
+      ++this->ChunksInFlight;
+      }
+    return this->Accepted;
+  }
+
+  //block until the server has acknowledged every chunk we have sent.
+  //Like the RETRIEVE_RESULT response, if the server terminates the worker
+  //before this is over the MessageRouter spoofs the acknowledgements.
+  bool finish()
+  {
+    while(this->ChunksInFlight > 0)
+      {
+      this->waitForAcknowledgement();
+      }
+    return this->Accepted;
+  }
+
+private:
+  void waitForAcknowledgement()
+  {
+    remus::proto::Response response =
+        remus::proto::receive_Response(&this->Socket);
+    const std::string ack(response.data(), response.dataSize());
+    this->Accepted = this->Accepted && (ack != remus::INVALID_MSG);
+    --this->ChunksInFlight;
+  }
+
+  remus::common::MeshIOType MeshTypes;
+  zmq::socket_t& Socket;
+  std::size_t ChunksInFlight;
+  bool Accepted;
+};
 
 }
 
@@ -75,11 +195,13 @@ Worker::Worker(remus::common::MeshIOType mtype,
   MeshRequirements( remus::proto::make_JobRequirements(mtype,"","") ),
   ConnectionInfo(conn),
   Zmq( new detail::ZmqManagement( conn ) ),
+  Cache( new remus::worker::detail::ContentCache() ),
+  JobQueue( new remus::worker::detail::JobQueue(*Cache) ),
+  Statuses( new remus::worker::detail::StatusCoalescer() ),
   MessageRouter( new remus::worker::detail::MessageRouter(
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->WorkerChannelUUID),
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID))),
-  JobQueue( new remus::worker::detail::JobQueue( *Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)))
+                    *JobQueue, *Statuses) ),
+  Uploads( new detail::AsyncResults() )
 {
   this->MessageRouter->start(conn, *Zmq->InterWorkerContext);
 
@@ -95,13 +217,15 @@ Worker::Worker(remus::common::MeshIOType mtype,
 Worker::Worker(const remus::proto::JobRequirements& requirements,
                remus::worker::ServerConnection const& conn):
   MeshRequirements(requirements),
-  ConnectionInfo(),
+  ConnectionInfo(conn),
   Zmq( new detail::ZmqManagement( conn ) ),
+  Cache( new remus::worker::detail::ContentCache() ),
+  JobQueue( new remus::worker::detail::JobQueue(*Cache) ),
+  Statuses( new remus::worker::detail::StatusCoalescer() ),
   MessageRouter( new remus::worker::detail::MessageRouter(
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->WorkerChannelUUID),
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) ),
-  JobQueue( new remus::worker::detail::JobQueue( *Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) )
+                    *JobQueue, *Statuses) ),
+  Uploads( new detail::AsyncResults() )
 {
   this->MessageRouter->start(conn, *Zmq->InterWorkerContext);
 
@@ -117,10 +241,14 @@ Worker::Worker(const remus::proto::JobRequirements& requirements,
 //-----------------------------------------------------------------------------
 Worker::~Worker()
 {
+  //the results must be on the server before we stop talking to it
+  this->stopUploadingResults();
+
   if(this->MessageRouter->valid())
     {
     //send message that we are shutting down communication, and we can stop
     //polling the server
+    boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
     remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                                remus::TERMINATE_WORKER,
                                &this->Zmq->Server);
@@ -136,29 +264,105 @@ const remus::worker::ServerConnection& Worker::connection() const
 //-----------------------------------------------------------------------------
 void Worker::askForJobs( unsigned int numberOfJobs )
 {
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+  this->requestJobs(numberOfJobs);
+}
+
+//-----------------------------------------------------------------------------
+void Worker::prefetchJobs( unsigned int numberOfJobs )
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+  this->Zmq->PrefetchCount = numberOfJobs;
+  }
+  this->replenishJobs(numberOfJobs);
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Worker::prefetchCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+  return this->Zmq->PrefetchCount;
+}
+
+//-----------------------------------------------------------------------------
+void Worker::requestJobs( unsigned int numberOfJobs )
+{
+  if(numberOfJobs == 0)
+    { //nothing to ask the server for
+    return;
+    }
 
   //next we send the MAKE_MESH call with the shorter version of the reqs,
   //which have none of the heavy data.
-  proto::JobRequirements lightReqs(this->MeshRequirements.formatType(),
-                                   this->MeshRequirements.meshTypes(),
-                                   this->MeshRequirements.workerName(),
-                                   "");
-  //override the source type
-  lightReqs.SourceType = this->MeshRequirements.sourceType();
-  lightReqs.Tag = this->MeshRequirements.tag();
+  const proto::JobRequirements lightReqs =
+                              this->MeshRequirements.withoutRequirements();
 
   std::ostringstream input_buffer;
   input_buffer << lightReqs;
 
-  for(unsigned int i=0; i < numberOfJobs; ++i)
+  //tell the server what content we hold, so it can prefer giving us jobs
+  //that use it, and acknowledge the content we started or stopped holding,
+  //which decides what the server sends us as a reference. The server
+  //socket lock keeps the changes in order
+  remus::proto::writeContentSummary(input_buffer, this->Cache->summary());
+  remus::proto::writeContentChanges(input_buffer, this->Cache->takeChanges());
+
+  //a single request asks for up to numberOfJobs jobs, which the server
+  //can send one at a time or bundled into batches
+  input_buffer << numberOfJobs << std::endl;
+
+  proto::send_Message(this->MeshRequirements.meshTypes(),
+                      remus::MAKE_MESH,
+                      input_buffer.str(),
+                      &this->Zmq->Server);
+  this->Zmq->JobsRequested += numberOfJobs;
+}
+
+//-----------------------------------------------------------------------------
+void Worker::replenishJobs( unsigned int numberOfJobs )
+{
+  if(numberOfJobs == 0 || this->workerShouldTerminate())
+    {
+    return;
+    }
+
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+
+  //the jobs we have asked for that the server hasn't sent yet, plus the
+  //jobs we hold, are the credit we already have with the server
+  const std::size_t received = this->JobQueue->numberOfJobsReceived();
+  const std::size_t outstanding = this->Zmq->JobsRequested > received ?
+                                  this->Zmq->JobsRequested - received : 0;
+  const std::size_t credit = outstanding + this->JobQueue->numberOfJobsHeld();
+  if(credit < numberOfJobs)
     {
-    proto::send_Message(this->MeshRequirements.meshTypes(),
-                        remus::MAKE_MESH,
-                        input_buffer.str(),
-                        &this->Zmq->Server);
+    this->requestJobs( static_cast<unsigned int>(numberOfJobs - credit) );
     }
 }
 
+//-----------------------------------------------------------------------------
+remus::worker::Job Worker::startJob( const remus::worker::Job& job )
+{
+  if(job.valid())
+    {
+    //tell the server we have started the job, so that it knows the job
+    //is no longer just prefetched. This doesn't change the status of the
+    //job, that only happens when we send a status update
+    {
+    boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+    remus::proto::send_Message(this->MeshRequirements.meshTypes(),
+                               remus::JOB_STARTED,
+                               boost::uuids::to_string(job.id()),
+                               &this->Zmq->Server);
+    }
+
+    //taking the job used up one of our prefetch credits
+    this->replenishJobs(this->prefetchCount());
+    }
+  return job;
+}
+
 //-----------------------------------------------------------------------------
 std::size_t Worker::pendingJobCount() const
 {
@@ -168,38 +372,170 @@ std::size_t Worker::pendingJobCount() const
 //-----------------------------------------------------------------------------
 remus::worker::Job Worker::takePendingJob()
 {
-  return this->JobQueue->take();
+  return this->startJob( this->JobQueue->take() );
+}
+
+//-----------------------------------------------------------------------------
+remus::worker::Job Worker::takePendingJob(int timeoutInMillisec)
+{
+  return this->startJob( this->JobQueue->waitAndTakeJob(timeoutInMillisec) );
 }
 
 //-----------------------------------------------------------------------------
 remus::worker::Job Worker::getJob()
 {
-  if(this->pendingJobCount() == 0)
+  const unsigned int prefetch = this->prefetchCount();
+  if(prefetch > 0)
+    { //only ask for more jobs if we don't have enough credit already
+    this->replenishJobs(prefetch);
+    }
+  else if(this->pendingJobCount() == 0)
     {
     this->askForJobs(1);
     }
-  return this->JobQueue->waitAndTakeJob();
+  return this->startJob( this->JobQueue->waitAndTakeJob() );
 }
 
 //-----------------------------------------------------------------------------
 void Worker::updateStatus(const remus::proto::JobStatus& info)
 {
+  if(info.failed())
+    { //we are done with the job, so drop any content we spooled for it
+    this->JobQueue->removeSpooledContent(info.id());
+    }
+
+  if(!this->Statuses->add(info,
+                          boost::posix_time::microsec_clock::local_time()))
+    { //the status is held back until the MessageRouter flushes it
+    return;
+    }
+
   //send a message that contains, the status
   std::string msg = remus::proto::to_string(info);
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
   remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                              remus::MESH_STATUS,
                              msg,
                              &this->Zmq->Server);
 }
 
+//-----------------------------------------------------------------------------
+void Worker::limitStatusUpdates( boost::int64_t intervalInMillisec )
+{
+  this->Statuses->minimumInterval(intervalInMillisec);
+}
+
+//-----------------------------------------------------------------------------
+boost::int64_t Worker::statusUpdateInterval() const
+{
+  return this->Statuses->minimumInterval();
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::coalescedStatusCount() const
+{
+  return this->Statuses->coalescedCount();
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::droppedStatusCount() const
+{
+  return this->Statuses->droppedCount();
+}
+
 //-----------------------------------------------------------------------------
 void Worker::returnResult(const remus::proto::JobResult& result)
 {
+  //the result replaces any progress we have held back for the job
+  this->Statuses->remove(result.id());
+
+  bool sent = false;
+  if(result.sourceType() == remus::common::ContentSource::File &&
+     !this->ConnectionInfo.isLocalEndpoint())
+    {
+    //the server can't read our files, so send the contents of the file
+    //straight from a mapping of it instead
+    const remus::common::FileHandle handle(
+                          std::string(result.data(), result.dataSize()));
+    remus::common::MappedFile file(handle);
+    if(file.valid())
+      {
+      this->sendResult( remus::proto::JobResult(result.id(),
+                                                result.formatType(),
+                                                file.data(),
+                                                file.size()) );
+      sent = true;
+      }
+    }
+
+  if(!sent)
+    {
+    this->sendResult(result);
+    }
+
+  //we are done with the job, so drop any content we spooled for it
+  this->JobQueue->removeSpooledContent(result.id());
+}
+
+//-----------------------------------------------------------------------------
+void Worker::sendResult(const remus::proto::JobResult& result)
+{
+  remus::common::SharedMemoryHandle handle;
+  if(this->ConnectionInfo.isLocalEndpoint() &&
+     result.dataSize() > remus::STREAM_CHUNK_SIZE)
+    {
+    //the server is on the same machine, so we hand it large results
+    //through shared memory instead of sending them over the socket
+    handle = remus::common::make_SharedMemory(result.data(),
+                                              result.dataSize());
+    }
+
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+
+  if(!handle.valid() && result.dataSize() > remus::STREAM_CHUNK_SIZE)
+    {
+    //large results are streamed in chunks that point into the result,
+    //so the only copy made is when each chunk is serialized
+    detail::ResultStreamer streamer(this->MeshRequirements.meshTypes(),
+                                    this->Zmq->Server);
+    const std::size_t resultSize = result.dataSize();
+    remus::common::MD5Hasher hasher;
+    bool streaming = true;
+    for(std::size_t pos=0; pos < resultSize && streaming;
+        pos += remus::STREAM_CHUNK_SIZE)
+      {
+      const std::size_t length = std::min(remus::STREAM_CHUNK_SIZE,
+                                          resultSize - pos);
+      remus::proto::DataChunk chunk(result.id(), result.formatType(), pos,
+                                    result.data() + pos, length);
+      //the checksum is built as the chunks are sent, so the result
+      //is only read once
+      hasher.append(result.data() + pos, length);
+      if(pos + length == resultSize)
+        {
+        chunk.markAsFinal(resultSize, hasher.hash());
+        }
+      streaming = streamer.send(chunk);
+      }
+    streamer.finish();
+    return;
+    }
+
   //send a message that contains, the path to the resulting file
-  std::string msg = remus::proto::to_string(result);
+  std::ostringstream buffer;
+  if(handle.valid())
+    {
+    buffer << remus::proto::JobResult(result.id(), result.formatType(),
+                                      std::string());
+    buffer << handle;
+    }
+  else
+    {
+    buffer << result;
+    }
   remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                              remus::RETRIEVE_RESULT,
-                             msg,
+                             buffer.str(),
                              &this->Zmq->Server);
 
   //we need to block on waiting for the server to notify it has our result.
@@ -209,6 +545,179 @@ void Worker::returnResult(const remus::proto::JobResult& result)
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
   (void) response;
+
+  //the server has mapped the segment by now, or never will
+  remus::common::remove_SharedMemory(handle);
+}
+
+//-----------------------------------------------------------------------------
+void Worker::returnResult(const remus::worker::Job& job,
+                          std::istream& data,
+                          remus::common::ContentFormat::Type format)
+{
+  //the result replaces any progress we have held back for the job
+  this->Statuses->remove(job.id());
+
+  boost::lock_guard<boost::mutex> lock(this->Zmq->ServerMutex);
+  detail::ResultStreamer streamer(this->MeshRequirements.meshTypes(),
+                                  this->Zmq->Server);
+  remus::common::MD5Hasher hasher;
+  std::vector<char> buffer(remus::STREAM_CHUNK_SIZE);
+  boost::uint64_t offset = 0;
+
+  bool streaming = true;
+  while(streaming)
+    {
+    data.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    const std::size_t length = static_cast<std::size_t>(data.gcount());
+    hasher.append(&buffer[0], length);
+
+    remus::proto::DataChunk chunk(job.id(), format, offset,
+                                  &buffer[0], length);
+    offset += length;
+
+    //a short read means we have reached the end of the input. When the
+    //input is a multiple of the chunk size this sends an empty final chunk
+    const bool lastChunk = length < buffer.size();
+    if(lastChunk)
+      {
+      chunk.markAsFinal(offset, hasher.hash());
+      }
+    streaming = streamer.send(chunk) && !lastChunk;
+    }
+  streamer.finish();
+
+  //we are done with the job, so drop any content we spooled for it
+  this->JobQueue->removeSpooledContent(job.id());
+}
+
+//-----------------------------------------------------------------------------
+void Worker::returnResultAsync(const remus::proto::JobResult& result)
+{
+  this->returnResultAsync(result,
+                          boost::shared_ptr<remus::worker::ResultCallback>());
+}
+
+//-----------------------------------------------------------------------------
+void Worker::returnResultAsync(const remus::proto::JobResult& result,
+                       boost::shared_ptr<remus::worker::ResultCallback> callback)
+{
+  boost::unique_lock<boost::mutex> lock(this->Uploads->Mutex);
+  while(this->Uploads->outstanding() >= this->Uploads->Limit)
+    { //bound the memory held by results waiting to be uploaded
+    this->Uploads->Changed.wait(lock);
+    }
+
+  this->Uploads->Pending.push_back(
+                            detail::AsyncResults::Upload(result, callback));
+  if(!this->Uploads->Thread)
+    {
+    this->Uploads->Thread.reset(
+                          new boost::thread(&Worker::uploadResults, this));
+    }
+  this->Uploads->Changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void Worker::limitOutstandingResults( std::size_t numberOfResults )
+{
+  boost::lock_guard<boost::mutex> lock(this->Uploads->Mutex);
+  //we need to be able to hold at least the result being uploaded
+  this->Uploads->Limit = std::max(std::size_t(1), numberOfResults);
+  this->Uploads->Changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::outstandingResultLimit() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Uploads->Mutex);
+  return this->Uploads->Limit;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::outstandingResultCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Uploads->Mutex);
+  return this->Uploads->outstanding();
+}
+
+//-----------------------------------------------------------------------------
+void Worker::waitForResults()
+{
+  boost::unique_lock<boost::mutex> lock(this->Uploads->Mutex);
+  while(this->Uploads->outstanding() > 0)
+    {
+    this->Uploads->Changed.wait(lock);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void Worker::limitCachedContent( boost::uint64_t numberOfBytes )
+{
+  this->Cache->maximumBytes(numberOfBytes);
+}
+
+//-----------------------------------------------------------------------------
+boost::uint64_t Worker::cachedContentLimit() const
+{
+  return this->Cache->maximumBytes();
+}
+
+//-----------------------------------------------------------------------------
+void Worker::cacheContentOnDisk( const std::string& directory,
+                                 boost::uint64_t numberOfBytes )
+{
+  this->Cache->diskBacking(directory, numberOfBytes);
+}
+
+//-----------------------------------------------------------------------------
+void Worker::uploadResults()
+{
+  boost::unique_lock<boost::mutex> lock(this->Uploads->Mutex);
+  while(true)
+    {
+    while(this->Uploads->Pending.empty() && !this->Uploads->Stopping)
+      {
+      this->Uploads->Changed.wait(lock);
+      }
+    if(this->Uploads->Pending.empty())
+      { //we have been told to stop, and every result has been uploaded
+      return;
+      }
+
+    detail::AsyncResults::Upload upload = this->Uploads->Pending.front();
+    this->Uploads->Pending.pop_front();
+    ++this->Uploads->Uploading;
+
+    //upload without holding the lock, so that more results can be
+    //queued while we wait on the server
+    lock.unlock();
+    this->returnResult(upload.first);
+    if(upload.second)
+      {
+      (*upload.second)(upload.first);
+      }
+    lock.lock();
+
+    --this->Uploads->Uploading;
+    this->Uploads->Changed.notify_all();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void Worker::stopUploadingResults()
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->Uploads->Mutex);
+  this->Uploads->Stopping = true;
+  this->Uploads->Changed.notify_all();
+  }
+
+  //the thread uploads every outstanding result before it exits
+  if(this->Uploads->Thread)
+    {
+    this->Uploads->Thread->join();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -24,7 +24,11 @@
 #include <remus/worker/Job.h>
 #include <remus/worker/ServerConnection.h>
 
+#include <boost/cstdint.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <istream>
 
 //included for export symbols
 #include <remus/worker/WorkerExports.h>
@@ -35,14 +39,33 @@ namespace worker{
   {
   //forward declaration of classes only the implementation needs
   class MessageRouter;
+  class ContentCache;
   class JobQueue;
+  class StatusCoalescer;
+  struct AsyncResults;
   struct ZmqManagement;
   }
 
+//Called once a result returned with Worker::returnResultAsync is on the
+//server. It is also called if the server terminates the worker before the
+//result could be sent. The callback is run by the thread that uploads the
+//results, so it should be quick and must be thread safe.
+class REMUSWORKER_EXPORT ResultCallback
+{
+public:
+  virtual ~ResultCallback() {}
+
+  virtual void operator()(const remus::proto::JobResult& result) = 0;
+};
+
 //The worker class is the interface for accepting jobs to process from a
 // remus server. Once you get a job from the server you process the given
 // job reporting back the status of the job, and than once finished the
 // results of the job.
+//
+// Status updates and results can be sent from multiple threads, which
+// allows a single worker to process multiple jobs at the same time. See
+// remus::worker::WorkerPool.
 class REMUSWORKER_EXPORT Worker
 {
 public:
@@ -66,26 +89,119 @@ public:
   const remus::worker::ServerConnection& connection() const;
 
   //send a message to the server stating how many jobs
-  //that we want to be sent to process
+  //that we want to be sent to process. The server can send small jobs
+  //bundled together in a single message
   void askForJobs( unsigned int numberOfJobs = 1 );
 
+  //keep the given number of jobs prefetched from the server, so that the
+  //next job has already arrived when the current one is finished. Each
+  //time a job is taken the worker asks the server for another, keeping
+  //numberOfJobs requested or waiting to be taken. Prefetched jobs that
+  //haven't been taken are given to another worker if this worker dies.
+  //Defaults to zero, where getJob only asks for a job when none are pending
+  void prefetchJobs( unsigned int numberOfJobs );
+
+  //return the number of jobs we keep prefetched
+  unsigned int prefetchCount() const;
+
   //query to see how many pending jobs we need to process
   std::size_t pendingJobCount( ) const;
 
   //fetch a pending job, if no jobs are pending will return
   //an invalid job, this method will never block waiting for a job
-  //from the server
+  //from the server. Taking a job tells the server the job has started
   remus::worker::Job takePendingJob();
 
+  //fetch a pending job, waiting at most the given time for one to arrive
+  //from the server. If no job arrives will return an invalid job. Like
+  //takePendingJob this never asks the server for jobs
+  remus::worker::Job takePendingJob(int timeoutInMillisec);
+
   //Blocking fetch a pending job and return it
   remus::worker::Job getJob();
 
-  //update the status of the worker
+  //update the status of the worker. When status updates are limited,
+  //progress for a job that arrives too soon after the last status we sent
+  //for it is held back, with only the newest progress being sent once the
+  //interval has passed. A status that changes the state of the job, such
+  //as a failure, is always sent right away.
   void updateStatus(const remus::proto::JobStatus& info);
 
-  //send to the server the mesh results.
+  //limit the status updates we send to the server to one for each job in
+  //the given number of milliseconds. Workers that report progress for
+  //every line of output from a mesher should use this, as most of those
+  //updates would be overwritten on the server before any client reads them.
+  //Defaults to zero, which sends every status update
+  void limitStatusUpdates( boost::int64_t intervalInMillisec );
+
+  //return the minimum number of milliseconds between status
+  //updates sent for a job
+  boost::int64_t statusUpdateInterval() const;
+
+  //return the number of status updates that were held back and then
+  //replaced by newer progress for the same job
+  std::size_t coalescedStatusCount() const;
+
+  //return the number of status updates that were held back and then
+  //thrown away, since the job failed or finished before they were sent
+  std::size_t droppedStatusCount() const;
+
+  //send to the server the mesh results. Results larger than
+  //remus::STREAM_CHUNK_SIZE are streamed to the server in chunks, so
+  //that no single message has to hold the entire result. When the server
+  //isn't local, results that are a file are sent as the contents of the file.
   void returnResult(const remus::proto::JobResult& result);
 
+  //stream to the server the mesh results for a job, reading the results
+  //from the input stream until it ends. This allows results that are
+  //larger than available memory to be sent directly from a file.
+  void returnResult(const remus::worker::Job& job,
+                    std::istream& data,
+                    remus::common::ContentFormat::Type format =
+                                            remus::common::ContentFormat::User);
+
+  //send to the server the mesh results without waiting for the server to
+  //receive them, so that the next job can be started while the result is
+  //uploaded. Results are uploaded in order by a thread the worker starts
+  //the first time this is called, and the callback, if given, is called
+  //once the result is on the server. Each outstanding result holds onto its
+  //data, so when the limit of outstanding results is reached this blocks
+  //until the oldest result has been uploaded. The worker destructor waits
+  //for every outstanding result to be uploaded.
+  void returnResultAsync(const remus::proto::JobResult& result);
+  void returnResultAsync(const remus::proto::JobResult& result,
+                  boost::shared_ptr<remus::worker::ResultCallback> callback);
+
+  //set the number of results passed to returnResultAsync that can be waiting
+  //to be uploaded, including the one being uploaded. Defaults to two
+  void limitOutstandingResults( std::size_t numberOfResults );
+
+  //return the number of results that can be waiting to be uploaded
+  std::size_t outstandingResultLimit() const;
+
+  //return the number of results passed to returnResultAsync that haven't
+  //been uploaded yet
+  std::size_t outstandingResultCount() const;
+
+  //block until every result passed to returnResultAsync has been uploaded
+  void waitForResults();
+
+  //set the number of bytes of large job content the worker holds onto in
+  //memory after a job is done. The server prefers giving us jobs that use
+  //content we hold, and sends that content as a reference instead of
+  //sending it again. Defaults to 256MB, zero disables caching in memory
+  void limitCachedContent( boost::uint64_t numberOfBytes );
+
+  //return the number of bytes of large job content the worker holds onto
+  //in memory
+  boost::uint64_t cachedContentLimit() const;
+
+  //hold onto large job content that no longer fits in memory in files in
+  //the given directory, using at most the given number of bytes. By default
+  //no content is held on disk, and an empty directory stops using the disk
+  void cacheContentOnDisk( const std::string& directory,
+                           boost::uint64_t numberOfBytes );
+
   //ask the worker API if the server has told us we should shutdown.
   //This means that the server has shutdown and all jobs the worker
   //has are invalid and can be terminated.
@@ -97,14 +213,41 @@ public:
   bool jobShouldBeTerminated( const remus::worker::Job& job ) const;
 
 private:
+  //send MAKE_MESH requests, requires the server socket lock to be held
+  void requestJobs(unsigned int numberOfJobs);
+
+  //ask the server for enough jobs that we have numberOfJobs
+  //requested or waiting to be taken
+  void replenishJobs(unsigned int numberOfJobs);
+
+  //tell the server that we have taken a job, and replenish the jobs we
+  //keep prefetched. Does nothing for invalid jobs
+  remus::worker::Job startJob(const remus::worker::Job& job);
+
+  //send the result as is to the server
+  void sendResult(const remus::proto::JobResult& result);
+
+  //the loop of the thread that uploads results passed to returnResultAsync
+  void uploadResults();
+
+  //wait for the outstanding results to be uploaded, and stop the
+  //thread that uploads them
+  void stopUploadingResults();
+
   //holds the type of mesh we support
   const remus::proto::JobRequirements MeshRequirements;
 
   remus::worker::ServerConnection ConnectionInfo;
 
   boost::scoped_ptr<detail::ZmqManagement> Zmq;
-  boost::scoped_ptr<remus::worker::detail::MessageRouter> MessageRouter;
+  //the message router adds jobs to the queue and flushes held statuses,
+  //so both must be constructed before it and destroyed after it. The
+  //queue fills the cache, so the cache must outlive the queue
+  boost::scoped_ptr<remus::worker::detail::ContentCache> Cache;
   boost::scoped_ptr<remus::worker::detail::JobQueue> JobQueue;
+  boost::scoped_ptr<remus::worker::detail::StatusCoalescer> Statuses;
+  boost::scoped_ptr<remus::worker::detail::MessageRouter> MessageRouter;
+  boost::scoped_ptr<remus::worker::detail::AsyncResults> Uploads;
 
   //explicitly state the worker doesn't support copy or move semantics
   Worker(const Worker&);
@@ -0,0 +1,171 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/WorkerPool.h>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+  #pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+//how long a slot waits for a job before checking if it should stop
+static const int SlotPollTimeout = 250;
+}
+
+namespace remus{
+namespace worker{
+
+//-----------------------------------------------------------------------------
+class WorkerPool::SlotThreads
+{
+public:
+  SlotThreads(std::size_t numberOfSlots):
+    NumberOfSlots(numberOfSlots),
+    Threads(),
+    ContinueMutex(),
+    ContinueProcessing(true)
+  {
+  }
+
+  //every slot reads the flag while stop sets it, so it is guarded
+  bool continueProcessing()
+  {
+    boost::lock_guard<boost::mutex> lock(this->ContinueMutex);
+    return this->ContinueProcessing;
+  }
+
+  void stopProcessing()
+  {
+    boost::lock_guard<boost::mutex> lock(this->ContinueMutex);
+    this->ContinueProcessing = false;
+  }
+
+  std::size_t NumberOfSlots;
+  boost::thread_group Threads;
+
+private:
+  boost::mutex ContinueMutex;
+  bool ContinueProcessing;
+};
+
+//-----------------------------------------------------------------------------
+WorkerPool::WorkerPool(const remus::proto::JobRequirements& requirements,
+                       const remus::worker::ServerConnection& conn,
+                       boost::shared_ptr<remus::worker::JobFunction> function,
+                       std::size_t numberOfSlots):
+  Worker( new remus::worker::Worker(requirements, conn) ),
+  Function(function),
+  Slots( new SlotThreads( std::max<std::size_t>(1, numberOfSlots) ) )
+{
+  //ask for a job for every slot, so the server sees the capacity of the
+  //whole pool. Each slot asks for a new job once it finishes one
+  this->Worker->askForJobs(
+                  static_cast<unsigned int>(this->Slots->NumberOfSlots) );
+
+  for(std::size_t i=0; i < this->Slots->NumberOfSlots; ++i)
+    {
+    this->Slots->Threads.add_thread(
+                          new boost::thread(&WorkerPool::processJobs, this) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+WorkerPool::~WorkerPool()
+{
+  this->stop();
+}
+
+//-----------------------------------------------------------------------------
+std::size_t WorkerPool::numberOfSlots() const
+{
+  return this->Slots->NumberOfSlots;
+}
+
+//-----------------------------------------------------------------------------
+remus::worker::Worker& WorkerPool::worker()
+{
+  return *this->Worker;
+}
+
+//-----------------------------------------------------------------------------
+void WorkerPool::wait()
+{
+  this->Slots->Threads.join_all();
+}
+
+//-----------------------------------------------------------------------------
+void WorkerPool::stop()
+{
+  this->Slots->stopProcessing();
+  this->Slots->Threads.join_all();
+}
+
+//-----------------------------------------------------------------------------
+void WorkerPool::processJobs()
+{
+  while(this->Slots->continueProcessing())
+    {
+    //wait with a timeout so that we notice when the pool is stopped
+    remus::worker::Job job = this->Worker->takePendingJob(SlotPollTimeout);
+    if(job.validityReason() == remus::worker::Job::TERMINATE_WORKER)
+      { //the job that terminates the worker stays on the queue, so every
+        //slot will see it
+      break;
+      }
+    if(!job.valid())
+      {
+      continue;
+      }
+
+    //a job that throws fails, but must not take the slot down with it
+    std::string failure;
+    try
+      {
+      (*this->Function)(*this->Worker, job);
+      }
+    catch(const std::exception& e)
+      {
+      failure = std::string("job function threw: ") + e.what();
+      }
+    catch(...)
+      {
+      failure = "job function threw an unknown exception";
+      }
+    if(!failure.empty())
+      {
+      this->Worker->updateStatus(
+                    remus::proto::make_FailedJobStatus(job.id(), failure) );
+      }
+
+    //replace the job we finished, so the server keeps seeing the
+    //capacity of this slot
+    if(this->Slots->continueProcessing())
+      {
+      this->Worker->askForJobs(1);
+      }
+    }
+}
+
+}
+}
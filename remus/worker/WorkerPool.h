@@ -0,0 +1,92 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_worker_WorkerPool_h
+#define remus_worker_WorkerPool_h
+
+#include <remus/worker/Worker.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+//included for export symbols
+#include <remus/worker/WorkerExports.h>
+
+namespace remus{
+namespace worker{
+
+//The function a WorkerPool runs for each job it is given. The function is
+//called from every slot of the pool at the same time, so it must be safe to
+//call from multiple threads. The worker it is handed is shared by every
+//slot, and should be used to report the status and result of the job.
+//If the function throws, the pool reports the job as FAILED, and the slot
+//goes on to the next job.
+class REMUSWORKER_EXPORT JobFunction
+{
+public:
+  virtual ~JobFunction() {}
+
+  virtual void operator()(remus::worker::Worker& worker,
+                          const remus::worker::Job& job) = 0;
+};
+
+//The WorkerPool processes multiple jobs at the same time inside a single
+//worker. It runs the job function on a fixed number of slots, each of which
+//is its own thread. All the slots share a single connection to the server,
+//so fetching jobs, status updates and results for every slot go through
+//one worker. The server sees a single worker that wants as many jobs as
+//there are slots, instead of one worker per slot.
+class REMUSWORKER_EXPORT WorkerPool
+{
+public:
+  //construct a pool of numberOfSlots slots that can mesh an exact set of
+  //requirements. The slots start asking the server for jobs right away
+  WorkerPool(const remus::proto::JobRequirements& requirements,
+             const remus::worker::ServerConnection& conn,
+             boost::shared_ptr<remus::worker::JobFunction> function,
+             std::size_t numberOfSlots);
+
+  //stops the pool, waiting for the jobs being processed to finish
+  ~WorkerPool();
+
+  //return the number of jobs that can be processed at the same time
+  std::size_t numberOfSlots() const;
+
+  //return the worker that is shared by all the slots
+  remus::worker::Worker& worker();
+
+  //block until every slot has stopped, which happens when the server
+  //tells the worker to shutdown, or stop is called
+  void wait();
+
+  //stop taking new jobs, and block until the jobs being processed
+  //have finished
+  void stop();
+
+private:
+  //the loop that each slot runs
+  void processJobs();
+
+  boost::scoped_ptr<remus::worker::Worker> Worker;
+  boost::shared_ptr<remus::worker::JobFunction> Function;
+
+  class SlotThreads;
+  boost::scoped_ptr<SlotThreads> Slots;
+
+  //explicitly state the pool doesn't support copy or move semantics
+  WorkerPool(const WorkerPool&);
+  void operator=(const WorkerPool&);
+};
+
+}
+}
+#endif
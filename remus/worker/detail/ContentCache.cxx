@@ -0,0 +1,345 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/detail/ContentCache.h>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread/locks.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+
+#include <boost/shared_array.hpp>
+
+#include <fstream>
+
+namespace remus{
+namespace worker{
+namespace detail{
+
+//------------------------------------------------------------------------------
+ContentCache::ContentCache(boost::uint64_t bytes):
+  Mutex(),
+  MaximumBytes(bytes),
+  MemoryBytes(0),
+  DiskDirectory(),
+  MaximumDiskBytes(0),
+  DiskBytes(0),
+  MemoryRecent(),
+  DiskRecent(),
+  Entries(),
+  Changes()
+{
+}
+
+//------------------------------------------------------------------------------
+ContentCache::~ContentCache()
+{
+  boost::system::error_code ec;
+  typedef std::list<std::string>::const_iterator DigestIt;
+  for(DigestIt i = this->DiskRecent.begin(); i != this->DiskRecent.end(); ++i)
+    {
+    boost::filesystem::remove(this->diskPath(*i), ec);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ContentCache::maximumBytes(boost::uint64_t bytes)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->MaximumBytes = bytes;
+  this->shrink();
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t ContentCache::maximumBytes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->MaximumBytes;
+}
+
+//------------------------------------------------------------------------------
+void ContentCache::diskBacking(const std::string& directory,
+                               boost::uint64_t bytes)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+
+  //the content we hold on disk can't move to the new directory
+  while(!this->DiskRecent.empty())
+    {
+    this->drop(this->Entries.find(this->DiskRecent.back()));
+    }
+
+  this->DiskDirectory = (bytes > 0) ? directory : std::string();
+  this->MaximumDiskBytes = this->DiskDirectory.empty() ? 0 : bytes;
+  if(!this->DiskDirectory.empty())
+    {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(this->DiskDirectory, ec);
+    }
+  this->shrink();
+}
+
+//------------------------------------------------------------------------------
+std::string ContentCache::diskDirectory() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->DiskDirectory;
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t ContentCache::maximumDiskBytes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->MaximumDiskBytes;
+}
+
+//------------------------------------------------------------------------------
+void ContentCache::add(const remus::proto::JobContent& content)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  const std::string& digest = content.hash();
+  It item = this->Entries.find(digest);
+  if(item != this->Entries.end())
+    { //we already hold it, so we use the copy we were given
+      //and it becomes the most recently used
+    this->drop(item);
+    }
+
+  this->MemoryRecent.push_front(digest);
+  Entry& entry = this->Entries[digest];
+  entry.Content = content;
+  entry.Format = content.formatType();
+  entry.Size = content.dataSize();
+  entry.OnDisk = false;
+  entry.Position = this->MemoryRecent.begin();
+  this->MemoryBytes += entry.Size;
+
+  this->Changes.Added.insert(digest);
+  this->Changes.Dropped.erase(digest);
+  this->shrink();
+}
+
+//------------------------------------------------------------------------------
+bool ContentCache::find(const std::string& digest,
+                        remus::proto::JobContent& content)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  It item = this->Entries.find(digest);
+  if(item == this->Entries.end())
+    {
+    return false;
+    }
+
+  Entry& entry = item->second;
+  if(entry.OnDisk)
+    {
+    //the content becomes the most recently used content in memory,
+    //unless it was damaged on disk
+    if(!this->readFromDisk(digest, entry))
+      {
+      this->drop(item);
+      return false;
+      }
+    this->MemoryRecent.push_front(digest);
+    entry.Position = this->MemoryRecent.begin();
+    this->MemoryBytes += entry.Size;
+    content = entry.Content;
+    this->shrink();
+    return true;
+    }
+
+  this->MemoryRecent.splice(this->MemoryRecent.begin(), this->MemoryRecent,
+                            entry.Position);
+  content = entry.Content;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ContentSummary ContentCache::summary() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  if(this->Entries.empty())
+    {
+    return remus::proto::ContentSummary();
+    }
+
+  //round the size of the summary up to a power of two, so that it
+  //only changes size when the cache grows a lot
+  std::size_t expected = 16;
+  while(expected < this->Entries.size())
+    {
+    expected *= 2;
+    }
+
+  remus::proto::ContentSummary result(expected);
+  for(ConstIt i = this->Entries.begin(); i != this->Entries.end(); ++i)
+    {
+    result.add(i->first);
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ContentChanges ContentCache::takeChanges()
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  remus::proto::ContentChanges result;
+  std::swap(result, this->Changes);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+std::size_t ContentCache::size() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Entries.size();
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t ContentCache::memoryBytes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->MemoryBytes;
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t ContentCache::diskBytes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->DiskBytes;
+}
+
+//------------------------------------------------------------------------------
+void ContentCache::shrink()
+{
+  while(this->MemoryBytes > this->MaximumBytes)
+    {
+    It item = this->Entries.find(this->MemoryRecent.back());
+    Entry& entry = item->second;
+    if(entry.Size > this->MaximumDiskBytes ||
+       !this->writeToDisk(item->first, entry))
+      {
+      this->drop(item);
+      continue;
+      }
+
+    this->MemoryRecent.pop_back();
+    this->MemoryBytes -= entry.Size;
+    this->DiskRecent.push_front(item->first);
+    entry.Position = this->DiskRecent.begin();
+    entry.Content = remus::proto::JobContent();
+    entry.OnDisk = true;
+    this->DiskBytes += entry.Size;
+    }
+
+  while(this->DiskBytes > this->MaximumDiskBytes)
+    {
+    this->drop(this->Entries.find(this->DiskRecent.back()));
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ContentCache::writeToDisk(const std::string& digest, Entry& entry)
+{
+  if(this->DiskDirectory.empty())
+    {
+    return false;
+    }
+
+  const std::string path = this->diskPath(digest);
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+  file.write(entry.Content.data(),
+             static_cast<std::streamsize>(entry.Content.dataSize()));
+  file.close();
+  if(!file)
+    {
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ContentCache::readFromDisk(const std::string& digest, Entry& entry)
+{
+  const std::string path = this->diskPath(digest);
+  const std::size_t size = static_cast<std::size_t>(entry.Size);
+  boost::shared_array<char> data(new char[size > 0 ? size : 1]);
+
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  file.read(data.get(), static_cast<std::streamsize>(size));
+  const bool readAll = file.good() &&
+                       file.gcount() == static_cast<std::streamsize>(size);
+  file.close();
+
+  //the content is back in memory, so we no longer need the file
+  boost::system::error_code ec;
+  boost::filesystem::remove(path, ec);
+  this->DiskRecent.erase(entry.Position);
+  this->DiskBytes -= entry.Size;
+  entry.OnDisk = false;
+
+  remus::proto::JobContent content(entry.Format, data, size);
+  if(!readAll || content.hash() != digest)
+    {
+    //put the entry in memory so that it can be dropped like any other
+    this->MemoryRecent.push_front(digest);
+    entry.Position = this->MemoryRecent.begin();
+    this->MemoryBytes += entry.Size;
+    return false;
+    }
+  entry.Content = content;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ContentCache::drop(It item)
+{
+  Entry& entry = item->second;
+  if(entry.OnDisk)
+    {
+    boost::system::error_code ec;
+    boost::filesystem::remove(this->diskPath(item->first), ec);
+    this->DiskRecent.erase(entry.Position);
+    this->DiskBytes -= entry.Size;
+    }
+  else
+    {
+    this->MemoryRecent.erase(entry.Position);
+    this->MemoryBytes -= entry.Size;
+    }
+
+  this->Changes.Added.erase(item->first);
+  this->Changes.Dropped.insert(item->first);
+  this->Entries.erase(item);
+}
+
+//------------------------------------------------------------------------------
+std::string ContentCache::diskPath(const std::string& digest) const
+{
+  return (boost::filesystem::path(this->DiskDirectory) /
+          (digest + ".remus-content")).string();
+}
+
+}
+}
+}
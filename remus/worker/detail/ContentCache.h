@@ -0,0 +1,140 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_worker_detail_ContentCache_h
+#define remus_worker_detail_ContentCache_h
+
+#include <remus/proto/ContentSummary.h>
+#include <remus/proto/JobContent.h>
+
+#include <boost/cstdint.hpp>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread/mutex.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace remus{
+namespace worker{
+namespace detail{
+
+//Holds the large JobContent of the jobs a worker has received, keyed by the
+//digest of the content. The worker reports what it holds with every request
+//for a job, so the server can prefer giving it jobs that use the same
+//content, and send that content as a digest reference instead of sending
+//the bytes again.
+//
+//The cache holds a limited number of bytes of content in memory, dropping
+//the least recently used content once it is full. When given a directory,
+//content that no longer fits in memory is written there instead, and is
+//read back the next time it is used. Content in memory is shared with the
+//jobs that use it, so no copy of the data is made.
+//
+//The MessageRouter fills the cache while the worker asks for its summary,
+//so every method is thread safe.
+class ContentCache
+{
+public:
+  //construct a cache that holds the given number of bytes of content
+  //in memory, and none on disk
+  explicit ContentCache(boost::uint64_t maximumBytes = 256 * 1024 * 1024);
+
+  //remove the files of the content held on disk
+  ~ContentCache();
+
+  //set the number of bytes of content we hold in memory, moving the least
+  //recently used content that no longer fits to disk, or dropping it
+  void maximumBytes(boost::uint64_t bytes);
+  boost::uint64_t maximumBytes() const;
+
+  //hold at most the given number of bytes of content in files in the
+  //directory, once it no longer fits in memory. An empty directory or zero
+  //bytes drops the content we hold on disk, and stops using the disk
+  void diskBacking(const std::string& directory, boost::uint64_t maximumBytes);
+  std::string diskDirectory() const;
+  boost::uint64_t maximumDiskBytes() const;
+
+  //hold the content under its digest
+  void add(const remus::proto::JobContent& content);
+
+  //find the content with the given digest, marking it as recently used.
+  //Content held on disk is read back into memory. Returns false if we
+  //don't hold it
+  bool find(const std::string& digest, remus::proto::JobContent& content);
+
+  //returns a summary of the digests of the content we hold
+  remus::proto::ContentSummary summary() const;
+
+  //returns the digests of the content we started and stopped holding
+  //since the last call, and forgets them
+  remus::proto::ContentChanges takeChanges();
+
+  //returns the number of pieces of content we hold in memory and on disk
+  std::size_t size() const;
+
+  //returns the number of bytes of content we hold in memory, and on disk
+  boost::uint64_t memoryBytes() const;
+  boost::uint64_t diskBytes() const;
+
+private:
+  //explicitly state the class doesn't support copy or move semantics
+  ContentCache(const ContentCache&);
+  void operator=(const ContentCache&);
+
+  struct Entry
+  {
+    remus::proto::JobContent Content; //invalid while the entry is on disk
+    remus::common::ContentFormat::Type Format;
+    boost::uint64_t Size;
+    bool OnDisk;
+    std::list<std::string>::iterator Position;
+  };
+  typedef std::map<std::string, Entry>::iterator It;
+  typedef std::map<std::string, Entry>::const_iterator ConstIt;
+
+  //move the least recently used content to disk or drop it until we fit,
+  //all of these require the Mutex to be held
+  void shrink();
+  bool writeToDisk(const std::string& digest, Entry& entry);
+  bool readFromDisk(const std::string& digest, Entry& entry);
+  void drop(It item);
+  std::string diskPath(const std::string& digest) const;
+
+  mutable boost::mutex Mutex;
+  boost::uint64_t MaximumBytes;
+  boost::uint64_t MemoryBytes;
+  std::string DiskDirectory;
+  boost::uint64_t MaximumDiskBytes;
+  boost::uint64_t DiskBytes;
+
+  //the digests in the order they were used, most recent first
+  std::list<std::string> MemoryRecent;
+  std::list<std::string> DiskRecent;
+  std::map<std::string, Entry> Entries;
+
+  remus::proto::ContentChanges Changes;
+};
+
+}
+}
+}
+
+#endif
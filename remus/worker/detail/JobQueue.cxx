@@ -12,8 +12,12 @@
 
 #include <remus/worker/detail/JobQueue.h>
 
-#include <remus/proto/Response.h>
+#include <remus/common/MD5Hash.h>
+#include <remus/common/MappedFile.h>
+#include <remus/common/remusGlobals.h>
+#include <remus/proto/DataChunk.h>
 #include <remus/proto/JobSubmission.h>
+#include <remus/worker/detail/ContentCache.h>
 
 //suppress warnings inside boost headers for gcc and clang
 #ifndef _MSC_VER
@@ -26,10 +30,19 @@
   #pragma GCC diagnostic pop
 #endif
 
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+
 #include <boost/thread/locks.hpp>
+#include <boost/make_shared.hpp>
 
+#include <algorithm>
 #include <deque>
+#include <fstream>
+#include <map>
 #include <set>
+#include <vector>
 
 namespace
 {
@@ -43,6 +56,108 @@ struct JobIdMatches
 
     boost::uuids::uuid UUID;
   };
+
+//The content of a single key of a job submission that is being streamed
+//to us as DataChunks. The chunks are written to a spool file as they
+//arrive, so we hold at most a single chunk of the content in memory
+struct StreamedContent
+{
+  StreamedContent():
+    Spool(),
+    SpoolPath(),
+    FromFile(false),
+    BytesReceived(0),
+    Hasher( boost::make_shared<remus::common::MD5Hasher>() )
+  {
+  }
+
+  boost::shared_ptr<std::ofstream> Spool;
+  std::string SpoolPath;
+  bool FromFile;
+  boost::uint64_t BytesReceived;
+  boost::shared_ptr<remus::common::MD5Hasher> Hasher;
+};
+
+//create a spool file for content that came from the given file. We keep
+//the extension of the original file, as workers commonly rely on it
+std::string make_SpoolPath(const std::string& originalPath)
+{
+  namespace fs = boost::filesystem;
+  const std::string name = fs::unique_path("remus-%%%%-%%%%-%%%%").string() +
+                          fs::path(originalPath).extension().string();
+  return (fs::temp_directory_path() / name).string();
+}
+
+//Releases the mapping of a spool file, and removes the file, once the
+//last JobContent that shares the mapped data is gone. Content can outlive
+//its job when it is cached, so the file isn't removed with the job.
+struct ReleaseSpool
+{
+  ReleaseSpool(const boost::shared_ptr<remus::common::MappedFile>& mapped,
+               const std::string& path):
+    Mapped(mapped),
+    Path(path)
+  {
+  }
+
+  void operator()(char*)
+  {
+    this->Mapped.reset();
+    boost::system::error_code ec;
+    boost::filesystem::remove(this->Path, ec);
+  }
+
+  boost::shared_ptr<remus::common::MappedFile> Mapped;
+  std::string Path;
+};
+
+//hand memory content that was spooled to a file to the worker as the
+//mapped file, so the content is paged in from the file instead of being
+//joined into a single allocation. Returns false if the file couldn't be
+//mapped
+bool map_SpooledContent(remus::common::ContentFormat::Type format,
+                        const std::string& path,
+                        remus::proto::JobContent& content)
+{
+  boost::shared_ptr<remus::common::MappedFile> mapped =
+      boost::make_shared<remus::common::MappedFile>(
+                                      remus::common::FileHandle(path));
+  if(!mapped->valid())
+    {
+    return false;
+    }
+  if(mapped->size() == 0)
+    {
+    content = remus::proto::JobContent(format, std::string());
+    ReleaseSpool(mapped, path)(NULL);
+    return true;
+    }
+
+  const std::size_t size = mapped->size();
+  boost::shared_array<char> data(const_cast<char*>(mapped->data()),
+                                 ReleaseSpool(mapped, path));
+  content = remus::proto::JobContent(format, data, size);
+  return true;
+}
+
+//A job that can't be taken until all its streamed content has arrived
+struct PendingJob
+{
+  remus::worker::Job Job;
+  std::map<std::string, StreamedContent> Content;
+};
+
+//Reads directly from the data of a message, so that parsing a job
+//doesn't first copy the message into a string
+class MessageBuffer : public std::streambuf
+{
+public:
+  MessageBuffer(const char* data, std::size_t size)
+  {
+    char* begin = const_cast<char*>(data);
+    this->setg(begin, begin, begin + size);
+  }
+};
 }
 
 namespace remus{
@@ -52,9 +167,6 @@ namespace detail{
 //-----------------------------------------------------------------------------
 class JobQueue::JobQueueImplementation
 {
-  //thread our polling method
-  boost::scoped_ptr<boost::thread> PollingThread;
-
   //used to keep the queue from breaking with threads
   boost::mutex QueueMutex;
   boost::condition_variable QueueChanged;
@@ -63,128 +175,114 @@ class JobQueue::JobQueueImplementation
   //a set of jobs that the JobQueue has been told should be terminated
   std::set< boost::uuids::uuid > TerminatedJobs;
 
-  //need to store our endpoint so we can pass it to the worker
-  std::string EndPoint;
+  //jobs whose submission content is still being streamed to us
+  std::map< boost::uuids::uuid, PendingJob > PendingJobs;
 
-  //state to tell when we should stop polling
-  bool ContinuePolling;
+  //the files that streamed content of each job was spooled to
+  std::map< boost::uuids::uuid, std::vector<std::string> > SpooledFiles;
 
-  //states that we have finished setting up and are ready to accept messages
-  bool PollingStarted;
+  //the number of jobs the server has sent us
+  std::size_t JobsReceived;
 
-  //states that we have been told to stop polling and should be ready
-  //to be destroyed. Is not the same as NOT ContinuePolling and PollingStarted.
-  //as that logic returns false while the polling thread is being constructed
-  bool PollingFinished;
+  //states that we have been told the worker is terminating, after which
+  //we don't accept anything from the server
+  bool Shutdown;
+
+  //where large content is cached, can be NULL
+  remus::worker::detail::ContentCache* Cache;
 
 public:
 //-----------------------------------------------------------------------------
-JobQueueImplementation(zmq::context_t& context,
-                       const zmq::socketInfo<zmq::proto::inproc>& queue_info):
-  PollingThread(new boost::thread()),
+JobQueueImplementation(remus::worker::detail::ContentCache* cache):
   QueueMutex(),
   QueueChanged(),
   Queue(),
   TerminatedJobs(),
-  EndPoint(),
-  ContinuePolling(true),
-  PollingStarted(false),
-  PollingFinished(false)
+  PendingJobs(),
+  SpooledFiles(),
+  JobsReceived(0),
+  Shutdown(false),
+  Cache(cache)
 {
-  //start up our thread
-  boost::scoped_ptr<boost::thread> pollingThread(
-      new boost::thread( &JobQueueImplementation::pollForJobs,
-                         this,
-                         &context,
-                         queue_info) );
-
-  //transfer ownership of the polling thread to our scoped_ptr
-  this->PollingThread.swap(pollingThread);
 }
 
 //------------------------------------------------------------------------------
 ~JobQueueImplementation()
 {
-  //stop the thread
-  this->PollingThread->join();
+  //remove the spool files of any jobs that are still around
+  typedef std::map< boost::uuids::uuid, std::vector<std::string> >::iterator It;
+  for(It i = this->SpooledFiles.begin(); i != this->SpooledFiles.end(); ++i)
+    {
+    this->removeFiles(i->second);
+    }
 }
 
 //------------------------------------------------------------------------------
-const std::string& endpoint() const
+void removeFiles(const std::vector<std::string>& paths)
 {
-  return this->EndPoint;
+  boost::system::error_code ec;
+  typedef std::vector<std::string>::const_iterator It;
+  for(It i = paths.begin(); i != paths.end(); ++i)
+    {
+    boost::filesystem::remove(*i, ec);
+    }
 }
 
 //------------------------------------------------------------------------------
-void stop()
+void removeSpooledContent(const boost::uuids::uuid& id)
 {
-  this->ContinuePolling = false;
-  this->PollingStarted = false;
-  this->PollingFinished = true;
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  this->removeSpooledContentNoLock(id);
 }
 
 //------------------------------------------------------------------------------
-void pollForJobs(zmq::context_t* context,
-                 zmq::socketInfo<zmq::proto::inproc> queue_info)
+void removeSpooledContentNoLock(const boost::uuids::uuid& id)
 {
-  //we pass the context by pointer since it can't be copied.
-  //we pass the queue_info by value since it is light weight
-
-  //since this is threaded, this we need to make sure that zmq_socket and
-  //zmq_close will execute from inside the thread address space so that
-  //when the thread is joined everything cleans up in the correct order,
-  //otherwise we can get segment-faults when trying to use multiple workers in
-  //the same process.
-  zmq::socket_t serverComm(*context,ZMQ_PAIR);
-
-  //bind to the work_jobs communication channel first
-  this->EndPoint = zmq::bindToAddress(serverComm, queue_info).endpoint();
-
-  //now that we have finished binding we are ready to accept jobs
-  this->PollingStarted = true;
+  typedef std::map< boost::uuids::uuid, std::vector<std::string> >::iterator It;
+  It i = this->SpooledFiles.find(id);
+  if(i != this->SpooledFiles.end())
+    {
+    this->removeFiles(i->second);
+    this->SpooledFiles.erase(i);
+    }
+}
 
-  zmq::pollitem_t item  = { serverComm,  0, ZMQ_POLLIN, 0 };
-  while( this->ContinuePolling )
+//------------------------------------------------------------------------------
+//drop a job that is waiting on streamed content
+void removePendingJob(const boost::uuids::uuid& id)
+{
+  typedef std::map< boost::uuids::uuid, PendingJob >::iterator PendingIt;
+  PendingIt job = this->PendingJobs.find(id);
+  if(job != this->PendingJobs.end())
     {
-    zmq::poll(&item,1,250);
-    if(item.revents & ZMQ_POLLIN)
+    //close any spool files that are being written before removing them
+    typedef std::map<std::string, StreamedContent>::iterator ContentIt;
+    for(ContentIt i = job->second.Content.begin();
+        i != job->second.Content.end(); ++i)
       {
-      remus::proto::Response response =
-          remus::proto::receive_Response(&serverComm);
-      if(!response.isValid())
-        { //ignore this response if it isn't valid
-        continue;
-        }
-
-      switch(response.serviceType())
-        {
-        case remus::TERMINATE_WORKER:
-          this->clearJobs();
-          this->stop();
-          break;
-        case remus::MAKE_MESH:
-          this->addItem(response);
-          break;
-        case remus::TERMINATE_JOB:
-          this->terminateJob(response);
-        default:
-          //ignore other service types as we shouldn't be sent those
-          break;
-        }
+      i->second.Spool->close();
       }
+    this->PendingJobs.erase(job);
     }
+  this->removeSpooledContentNoLock(id);
 }
 
 //------------------------------------------------------------------------------
-void terminateJob(remus::proto::Response& response)
+void terminateJob(const char* msg, std::size_t msgSize)
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  if(this->Shutdown)
+    {
+    return;
+    }
 
-  const std::string data(response.data(), response.dataSize());
-  remus::worker::Job tj = remus::worker::to_Job(data);
+  MessageBuffer message(msg, msgSize);
+  std::istream buffer(&message);
+  remus::worker::Job tj = remus::worker::to_Job(buffer);
 
   //first thing is we add the job id to the list of terminated job ids
   this->TerminatedJobs.insert( tj.id() );
+  this->removePendingJob( tj.id() );
 
   //next we go through the deque and remove any job with that id
 
@@ -200,10 +298,19 @@ void terminateJob(remus::proto::Response& response)
 }
 
 //------------------------------------------------------------------------------
-void clearJobs()
+void terminateWorker()
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  if(this->Shutdown)
+    {
+    return;
+    }
+  this->Shutdown = true;
   this->Queue.clear();
+  while(!this->PendingJobs.empty())
+    {
+    this->removePendingJob(this->PendingJobs.begin()->first);
+    }
 
   remus::worker::Job j;
   j.updateValidityReason(remus::worker::Job::TERMINATE_WORKER);
@@ -213,17 +320,193 @@ void clearJobs()
 }
 
 //------------------------------------------------------------------------------
-void addItem(remus::proto::Response& response )
+//cache the large content of a job, so that the server can reference it
+//by digest in later jobs. Content that was spooled to a file isn't cached
+void cacheContent(const remus::worker::Job& job)
 {
+  if(!this->Cache)
+    {
+    return;
+    }
+
+  const remus::proto::JobSubmission& submission = job.submission();
+  typedef remus::proto::JobSubmission::const_iterator ContentIt;
+  for(ContentIt i = submission.begin(); i != submission.end(); ++i)
+    {
+    if(i->second.sourceType() == remus::common::ContentSource::Memory &&
+       i->second.dataSize() > remus::STREAM_CHUNK_SIZE)
+      {
+      this->Cache->add(i->second);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ContentDigests addJob(const char* msg, std::size_t msgSize)
+{
+  remus::proto::ContentDigests missing;
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  if(this->Shutdown)
+    {
+    return missing;
+    }
+
+  //parse the job straight from the message, as the data can be binary
+  //data with lots of null terminators.
+  MessageBuffer message(msg, msgSize);
+  std::istream buffer(&message);
+  remus::worker::Job j = remus::worker::to_Job(buffer);
+  ++this->JobsReceived;
+
+  remus::proto::StreamedKeys keys = remus::proto::readStreamedKeys(buffer);
+
+  //content the server thinks we hold is only referenced by its digest.
+  //Content that isn't in our cache is streamed to us like any other
+  //streamed content, once we tell the server that we are missing it
+  const remus::proto::ContentDigests references =
+                                      remus::proto::readContentDigests(buffer);
+  if(!references.empty())
+    {
+    remus::proto::JobSubmission submission = j.submission();
+    typedef remus::proto::ContentDigests::const_iterator DigestIt;
+    for(DigestIt i = references.begin(); i != references.end(); ++i)
+      {
+      remus::proto::JobContent& placeholder = submission[i->first];
+      remus::proto::JobContent cached;
+      if(this->Cache && this->Cache->find(i->second, cached) &&
+         cached.formatType() == placeholder.formatType())
+        {
+        cached.tag(placeholder.tag());
+        placeholder = cached;
+        }
+      else
+        {
+        missing.insert(*i);
+        keys.insert(i->first);
+        }
+      }
+    j = remus::worker::Job(j.id(), submission);
+    }
 
-  //required to use the char*, len constructor as response's data can
-  //be binary data with lots of null terminators.
-  const std::string data(response.data(), response.dataSize());
-  remus::worker::Job j = remus::worker::to_Job(data);
+  //if some of the content is being streamed, hold onto the job
+  //until all of that content has arrived
+  if(!keys.empty())
+    {
+    PendingJob& pending = this->PendingJobs[j.id()];
+    pending.Job = j;
+    typedef remus::proto::StreamedKeys::const_iterator KeyIt;
+    for(KeyIt i = keys.begin(); i != keys.end(); ++i)
+      {
+      StreamedContent& sc = pending.Content[*i];
+
+      //the placeholder of content that was sent from a file holds the
+      //original path
+      remus::proto::JobContent placeholder;
+      sc.FromFile = j.details(*i, placeholder) &&
+              placeholder.sourceType() == remus::common::ContentSource::File;
+      sc.SpoolPath = make_SpoolPath( sc.FromFile ?
+                std::string(placeholder.data(), placeholder.dataSize()) :
+                std::string() );
+      sc.Spool = boost::make_shared<std::ofstream>(sc.SpoolPath.c_str(),
+                                  std::ios::out | std::ios::binary);
+      this->SpooledFiles[j.id()].push_back(sc.SpoolPath);
+      }
+    return missing;
+    }
+
+  this->cacheContent( j );
   this->Queue.push_back( j );
 
   this->QueueChanged.notify_all();
+  return missing;
+}
+
+//------------------------------------------------------------------------------
+void addChunk(const char* msg, std::size_t msgSize)
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  if(this->Shutdown)
+    {
+    return;
+    }
+
+  remus::proto::DataChunk chunk = remus::proto::to_DataChunk(msg, msgSize);
+
+  typedef std::map< boost::uuids::uuid, PendingJob >::iterator PendingIt;
+  PendingIt job = this->PendingJobs.find(chunk.id());
+  if(job == this->PendingJobs.end())
+    { //the job has been terminated, drop the chunk
+    return;
+    }
+
+  typedef std::map<std::string, StreamedContent>::iterator ContentIt;
+  ContentIt content = job->second.Content.find(chunk.key());
+  if(content == job->second.Content.end() ||
+     chunk.offset() != content->second.BytesReceived)
+    { //the server only forwards chunks it has verified the order of
+    return;
+    }
+
+  StreamedContent& sc = content->second;
+  sc.Hasher->append(chunk.data(), chunk.dataSize());
+  sc.BytesReceived += chunk.dataSize();
+  sc.Spool->write(chunk.data(),
+                  static_cast<std::streamsize>(chunk.dataSize()));
+  if(!chunk.isFinal())
+    {
+    return;
+    }
+
+  sc.Spool->close();
+  bool valid = sc.BytesReceived == chunk.totalSize() &&
+               sc.Hasher->hash() == chunk.checksum() &&
+               !sc.Spool->fail();
+
+  remus::proto::JobSubmission submission = job->second.Job.submission();
+  remus::proto::JobContent& placeholder = submission[chunk.key()];
+  remus::proto::JobContent joined;
+  if(valid && sc.FromFile)
+    {
+    //the content is handed to the worker as the spool file
+    joined = remus::proto::JobContent(placeholder.formatType(),
+                            remus::common::FileHandle(sc.SpoolPath));
+    }
+  else if(valid)
+    {
+    //memory content is handed to the worker as the mapped spool file,
+    //which from now on removes the file once nothing uses the content
+    valid = map_SpooledContent(placeholder.formatType(), sc.SpoolPath,
+                               joined);
+    if(valid)
+      {
+      std::vector<std::string>& spooled = this->SpooledFiles[chunk.id()];
+      spooled.erase(std::remove(spooled.begin(), spooled.end(),
+                                sc.SpoolPath),
+                    spooled.end());
+      }
+    }
+
+  if(!valid)
+    { //the content was corrupted, so this job can't be run
+    this->TerminatedJobs.insert( chunk.id() );
+    this->removePendingJob( chunk.id() );
+    return;
+    }
+
+  //keep the format and tag the client gave the content
+  joined.tag(placeholder.tag());
+  placeholder = joined;
+
+  job->second.Job = remus::worker::Job(chunk.id(), submission);
+  job->second.Content.erase(content);
+
+  if(job->second.Content.empty())
+    {
+    this->cacheContent( job->second.Job );
+    this->Queue.push_back( job->second.Job );
+    this->PendingJobs.erase(job);
+    this->QueueChanged.notify_all();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -235,18 +518,8 @@ bool isATerminatedJob(const remus::worker::Job& job) const
 //------------------------------------------------------------------------------
 remus::worker::Job take()
 {
-  //the only jobs on the queue should be valid jobs or kill the worker
-  remus::worker::Job job;
-  if(this->size() > 0)
-    {
-    boost::unique_lock<boost::mutex> lock(this->QueueMutex);
-    job = this->Queue[0];
-    this->Queue.pop_front();
-
-    //notify everyone that a job was taken from the queue
-    this->QueueChanged.notify_all();
-    }
-  return job;
+  boost::unique_lock<boost::mutex> lock(this->QueueMutex);
+  return this->takeLocked();
 }
 
 //------------------------------------------------------------------------------
@@ -257,8 +530,46 @@ remus::worker::Job waitAndTakeJob()
     {
     QueueChanged.wait(lock);
     }
-  lock.unlock();
-  return take();
+  return this->takeLocked();
+}
+
+//------------------------------------------------------------------------------
+remus::worker::Job waitAndTakeJob(int timeoutInMillisec)
+{
+  const boost::system_time until = boost::get_system_time() +
+                         boost::posix_time::milliseconds(timeoutInMillisec);
+
+  boost::unique_lock<boost::mutex> lock(this->QueueMutex);
+  while(this->Queue.size() == 0)
+    {
+    if(!QueueChanged.timed_wait(lock, until))
+      {
+      break;
+      }
+    }
+  return this->takeLocked();
+}
+
+//------------------------------------------------------------------------------
+//the only jobs on the queue should be valid jobs or kill the worker. The
+//job that kills the worker is left on the queue, so that every thread that
+//is taking jobs from the queue is told to stop. Requires the QueueMutex
+//to be held
+remus::worker::Job takeLocked()
+{
+  remus::worker::Job job;
+  if(this->Queue.size() > 0)
+    {
+    job = this->Queue[0];
+    if(job.validityReason() != remus::worker::Job::TERMINATE_WORKER)
+      {
+      this->Queue.pop_front();
+      }
+
+    //notify everyone that a job was taken from the queue
+    this->QueueChanged.notify_all();
+    }
+  return job;
 }
 
 //------------------------------------------------------------------------------
@@ -269,35 +580,73 @@ std::size_t size()
 }
 
 //------------------------------------------------------------------------------
-bool isReady() const
+std::size_t numberOfJobsReceived()
 {
-  return this->PollingStarted && this->ContinuePolling;
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->JobsReceived;
 }
 
 //------------------------------------------------------------------------------
-bool isShutdown() const
+std::size_t numberOfJobsHeld()
 {
-  return this->PollingFinished;
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  std::size_t held = this->Queue.size() + this->PendingJobs.size();
+  if(!this->Queue.empty() && this->Queue.front().validityReason() ==
+                             remus::worker::Job::TERMINATE_WORKER)
+    { //the job that terminates the worker isn't a job to process
+    --held;
+    }
+  return held;
+}
+
+//------------------------------------------------------------------------------
+bool isShutdown()
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->Shutdown;
 }
 
 };
 
 //------------------------------------------------------------------------------
-JobQueue::JobQueue(zmq::context_t& context,
-                   const zmq::socketInfo<zmq::proto::inproc>& queue_info):
-  Implementation( new JobQueueImplementation(context,queue_info) )
+JobQueue::JobQueue():
+  Implementation( new JobQueueImplementation(NULL) )
+{
+}
+
+//------------------------------------------------------------------------------
+JobQueue::JobQueue(remus::worker::detail::ContentCache& cache):
+  Implementation( new JobQueueImplementation(&cache) )
 {
 }
 
 JobQueue::~JobQueue()
 {
-  this->Implementation->stop();
 }
 
 //------------------------------------------------------------------------------
-std::string JobQueue::endpoint() const
+remus::proto::ContentDigests JobQueue::addJob(const char* data,
+                                              std::size_t size)
+{
+  return this->Implementation->addJob(data, size);
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::addChunk(const char* data, std::size_t size)
+{
+  this->Implementation->addChunk(data, size);
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::terminateJob(const char* data, std::size_t size)
+{
+  this->Implementation->terminateJob(data, size);
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::terminateWorker()
 {
-  return this->Implementation->endpoint();
+  this->Implementation->terminateWorker();
 }
 
 //------------------------------------------------------------------------------
@@ -306,6 +655,12 @@ bool JobQueue::isATerminatedJob(const remus::worker::Job& job) const
   return this->Implementation->isATerminatedJob(job);
 }
 
+//------------------------------------------------------------------------------
+void JobQueue::removeSpooledContent(const boost::uuids::uuid& id)
+{
+  this->Implementation->removeSpooledContent(id);
+}
+
 //------------------------------------------------------------------------------
 remus::worker::Job JobQueue::take()
 {
@@ -318,6 +673,12 @@ remus::worker::Job JobQueue::waitAndTakeJob()
   return this->Implementation->waitAndTakeJob();
 }
 
+//------------------------------------------------------------------------------
+remus::worker::Job JobQueue::waitAndTakeJob(int timeoutInMillisec)
+{
+  return this->Implementation->waitAndTakeJob(timeoutInMillisec);
+}
+
 //------------------------------------------------------------------------------
 std::size_t JobQueue::size() const
 {
@@ -325,9 +686,15 @@ std::size_t JobQueue::size() const
 }
 
 //------------------------------------------------------------------------------
-bool JobQueue::isReady() const
+std::size_t JobQueue::numberOfJobsReceived() const
+{
+  return this->Implementation->numberOfJobsReceived();
+}
+
+//------------------------------------------------------------------------------
+std::size_t JobQueue::numberOfJobsHeld() const
 {
-  return this->Implementation->isReady();
+  return this->Implementation->numberOfJobsHeld();
 }
 
 //------------------------------------------------------------------------------
@@ -13,7 +13,7 @@
 #ifndef remus_worker_detail_JobQueue_h
 #define remus_worker_detail_JobQueue_h
 
-#include <remus/proto/zmqHelper.h>
+#include <remus/proto/JobContent.h>
 #include <remus/worker/Job.h>
 
 #include <boost/scoped_ptr.hpp>
@@ -22,43 +22,80 @@ namespace remus{
 namespace worker{
 namespace detail{
 
+class ContentCache;
+
 //A Simple JobQueue that holds onto a collection of jobs from the server.
-//If the TermianteWorker job is sent to the job queue, we will clear the
-//entire queue and only have a TerminateJob on the queue.
+//The MessageRouter adds the jobs it receives from the server directly, and
+//worker threads waiting on a job are woken up as jobs arrive.
+//If the worker is terminated, we will clear the entire queue and only have
+//a TerminateJob on the queue.
+//
+//Once a JobQueue is told the worker is terminated, it will not accept any
+//new jobs
 //
-//Once a JobQueue is sent a TerminateWorker, it will not accept any new jobs
-//and will refuse to start back up looking for jobs
+//When given a ContentCache the large content of the jobs we receive is
+//cached, and content the server only references by digest is taken from
+//the cache.
 class JobQueue
 {
 public:
-  JobQueue(zmq::context_t& context,
-           const zmq::socketInfo<zmq::proto::inproc>& queue_info);
+  JobQueue();
+  explicit JobQueue(remus::worker::detail::ContentCache& cache);
   ~JobQueue();
 
-  std::string endpoint() const;
+  //add the job held in the data of a MAKE_MESH message from the server.
+  //Jobs with streamed content are held until all of that content arrives.
+  //Returns the digests of referenced content that isn't in our cache, which
+  //the server has to stream to us before the job can be taken
+  remus::proto::ContentDigests addJob(const char* data, std::size_t size);
+
+  //add a chunk of the streamed content of a job, held in the data of a
+  //SUBMISSION_CHUNK message from the server
+  void addChunk(const char* data, std::size_t size);
+
+  //mark the job held in the data of a TERMINATE_JOB message from the server
+  //as terminated, and remove it from the queue
+  void terminateJob(const char* data, std::size_t size);
+
+  //the worker is terminating, drop every job and only have a TerminateJob
+  //on the queue
+  void terminateWorker();
 
   //Returns true if the job is part of the queue and job status
   //has been marked as terminate. This is allows people to peek at the queue
   //and check jobs without taking them off the queue
   bool isATerminatedJob( const remus::worker::Job& job) const;
 
+  //Removes the files that the streamed content of the job was spooled to.
+  //Is called once the worker is done with the job
+  void removeSpooledContent( const boost::uuids::uuid& id );
+
   //Removes the first job from the queue, If no job
-  //in the queue will return an invalid job
+  //in the queue will return an invalid job. The TerminateWorker job is
+  //never removed, so that every caller sees it.
   remus::worker::Job take();
 
   //Removes the first job from the queue, If no
   //job is present, it waits for a job to enter the queue
   remus::worker::Job waitAndTakeJob();
 
+  //Removes the first job from the queue, If no job is present, it waits
+  //at most the given time for a job to enter the queue, returning an
+  //invalid job if none did
+  remus::worker::Job waitAndTakeJob(int timeoutInMillisec);
+
   //return the number of jobs waiting for work
   std::size_t size() const;
 
-  //has finished setting up and is ready for jobs
-  bool isReady() const;
+  //return the number of jobs the server has sent us, including jobs that
+  //have since been taken or terminated
+  std::size_t numberOfJobsReceived() const;
+
+  //return the number of jobs we hold that haven't been taken, including
+  //jobs whose content is still being streamed to us
+  std::size_t numberOfJobsHeld() const;
 
-  //has job queue been told to shutdown and terminate this is only true
-  //if the job queue has been started and than has been stopped. If the
-  //job queue is still launching this will return false
+  //has job queue been told the worker is terminating
   bool isShutdown() const;
 
 private:
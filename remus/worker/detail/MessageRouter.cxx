@@ -12,12 +12,15 @@
 
 #include <remus/worker/detail/MessageRouter.h>
 
+#include <remus/proto/DataChunk.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 #include <remus/proto/zmqHelper.h>
 
-#include <remus/common/PollingMonitor.h>
+#include <remus/common/TimerQueue.h>
 #include <remus/worker/Job.h>
+#include <remus/worker/detail/JobQueue.h>
+#include <remus/worker/detail/StatusCoalescer.h>
 
 #ifndef _MSC_VER
 #  pragma GCC diagnostic push
@@ -32,6 +35,10 @@
 #include <boost/thread/locks.hpp>
 #include <boost/uuid/uuid.hpp>
 
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
 namespace remus{
 namespace worker{
 namespace detail{
@@ -40,8 +47,14 @@ namespace detail{
 class MessageRouter::MessageRouterImplementation
 {
   std::string WorkerEndpoint;
-  std::string QueueEndpoint;
+  //we sleep until we have traffic or timed work, so we are woken up over
+  //this endpoint when we need to stop polling
+  zmq::socketInfo<zmq::proto::inproc> WakeInfo;
+  zmq::context_t* WakeContext;
+  remus::worker::detail::JobQueue& Queue;
+  remus::worker::detail::StatusCoalescer& Statuses;
   std::size_t OutstandingResults;
+  std::size_t OutstandingChunks;
 
   //thread our polling method
   mutable boost::mutex ThreadMutex;
@@ -62,10 +75,15 @@ public:
 //-----------------------------------------------------------------------------
 MessageRouterImplementation(
                       const zmq::socketInfo<zmq::proto::inproc>& worker_info,
-                      const zmq::socketInfo<zmq::proto::inproc>& queue_info):
+                      remus::worker::detail::JobQueue& queue,
+                      remus::worker::detail::StatusCoalescer& statuses):
   WorkerEndpoint(worker_info.endpoint()),
-  QueueEndpoint(queue_info.endpoint()),
+  WakeInfo(worker_info.host() + "_wake"),
+  WakeContext(NULL),
+  Queue(queue),
+  Statuses(statuses),
   OutstandingResults(0),
+  OutstandingChunks(0),
   ThreadMutex(),
   ThreadStatusChanged(),
   PollingThread(new boost::thread()),
@@ -82,6 +100,7 @@ MessageRouterImplementation(
   if(this->PollingThread)
     {
     this->setIsTalking(false);
+    this->wakeUp();
     this->PollingThread->join();
     }
 }
@@ -146,6 +165,25 @@ void setIsTalking(bool t)
   this->ThreadStatusChanged.notify_all();
 }
 
+//----------------------------------------------------------------------------
+void wakeUp()
+{
+  zmq::context_t* context = NULL;
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    context = this->WakeContext;
+    }
+  if(context)
+    {
+    //the message is empty, it only wakes up the polling thread. If the
+    //thread has already stopped nobody is listening, so we don't block
+    zmq::socket_t wakeup(*context, ZMQ_PUSH);
+    zmq::connectToAddress(wakeup, this->WakeInfo);
+    zmq::message_t message(0);
+    wakeup.send(message, ZMQ_DONTWAIT);
+    }
+}
+
 //----------------------------------------------------------------------------
 void waitForThreadToStart()
 {
@@ -166,32 +204,65 @@ void poll(remus::worker::ServerConnection server_info,
   zmq::socket_t serverComm(*(server_info.context()),ZMQ_DEALER);
   zmq::connectToAddress(serverComm, server_info.endpoint());
 
-  zmq::socket_t queueComm(*internal_inproc_context,ZMQ_PAIR);
-  zmq::connectToAddress(queueComm,  this->QueueEndpoint);
-
   zmq::socket_t workerComm(*internal_inproc_context,ZMQ_PAIR);
   zmq::connectToAddress(workerComm, this->WorkerEndpoint);
 
-  zmq::pollitem_t items[2]  = {
+  //we only wake up for traffic or timed work, so stopping the router wakes
+  //us up over this socket
+  zmq::socket_t wakeComm(*internal_inproc_context,ZMQ_PULL);
+  zmq::bindToAddress(wakeComm, this->WakeInfo);
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    this->WakeContext = internal_inproc_context;
+    }
+
+  zmq::pollitem_t items[3]  = {
                                 { workerComm,  0, ZMQ_POLLIN, 0 },
-                                { serverComm,  0, ZMQ_POLLIN, 0 }
+                                { serverComm,  0, ZMQ_POLLIN, 0 },
+                                { wakeComm,  0, ZMQ_POLLIN, 0 }
                               };
 
-  //we specify a new polling rate so that the polling monitor is more responsive
-  //plus allows testing of the monitor to be quicker. In the future we could
-  //expose this option in the MessageRouter class.
-  remus::common::PollingMonitor monitor(boost::int64_t(250),
-                                        boost::int64_t(60000) );
+  //we tell the server how long it can go without hearing from us, and
+  //only send a heartbeat once we have been quiet for that long. In the
+  //future we could expose this option in the MessageRouter class.
+  const boost::int64_t heartbeatInterval(60000);
+
+  //the timed work of the router, so that we sleep until exactly the
+  //earliest of it is due. The first heartbeat goes out right away, so the
+  //server learns our interval before we go quiet
+  enum RouterTimer { HeartbeatTimer, StatusFlushTimer };
+  remus::common::TimerQueue timers;
+  timers.schedule(HeartbeatTimer,
+                  boost::posix_time::microsec_clock::local_time());
 
   //We need to notify the Thread management that polling is about to start.
   //This allows the calling thread to resume, as it has been waiting for this
   //notification, and will also allow threads that have been holding on
   //waitForThreadToStart to resume
   this->setIsTalking(true);
+  boost::int64_t nextStatusFlush = -1;
   while( this->isTalking() )
     {
-    zmq::poll(&items[0],2,monitor.current());
-    monitor.pollOccurred();
+    //wake up in time to flush any progress the worker has held back
+    boost::posix_time::ptime now =
+                              boost::posix_time::microsec_clock::local_time();
+    if(nextStatusFlush < 0)
+      {
+      timers.cancel(StatusFlushTimer);
+      }
+    else
+      {
+      timers.scheduleIn(StatusFlushTimer, now, nextStatusFlush);
+      }
+    zmq::poll(&items[0],3,timers.millisecondsToNext(now, heartbeatInterval));
+    if(items[2].revents & ZMQ_POLLIN)
+      {
+      //we are being told to stop, the loop condition will see that
+      zmq::message_t wakeup;
+      while(wakeComm.recv(&wakeup, ZMQ_DONTWAIT))
+        {
+        }
+      }
 
     //handle taking
     bool notSentToServer = true;
@@ -201,14 +272,14 @@ void poll(remus::worker::ServerConnection server_info,
         //them to the server. Handle server messages before worker
         //messages so that we don't send messages to a server
         //that is now telling us to shut down
-        this->handleServerMessage(workerComm, serverComm, queueComm);
+        this->handleServerMessage(workerComm, serverComm);
         }
     if(items[0].revents & ZMQ_POLLIN)
         {
         notSentToServer = false;
         //handle accepting messages from the worker and forwarding
         //them to the server
-        this->handleWorkerMessage(workerComm, serverComm, queueComm);
+        this->handleWorkerMessage(workerComm, serverComm);
         if(!ContinueForwardingToWorker)
           {
           //we are shutting down so we mark that we will not accept any
@@ -217,11 +288,22 @@ void poll(remus::worker::ServerConnection server_info,
           }
         }
 
-     if(notSentToServer)
+     if(this->flushStatuses(serverComm, nextStatusFlush))
+        {
+        notSentToServer = false;
+        }
+
+     now = boost::posix_time::microsec_clock::local_time();
+     if(notSentToServer && timers.isDue(HeartbeatTimer, now))
         {
         //we are going to send a heartbeat now since we have gone long enough
         //without sending a message to the server
-        this->sendHeartBeat(serverComm, monitor);
+        this->sendHeartBeat(serverComm, heartbeatInterval);
+        notSentToServer = false;
+        }
+     if(!notSentToServer)
+        {
+        timers.scheduleIn(HeartbeatTimer, now, heartbeatInterval);
         }
     }
 }
@@ -229,13 +311,17 @@ void poll(remus::worker::ServerConnection server_info,
 //------------------------------------------------------------------------------
 //handles taking messages from the worker
 void handleWorkerMessage(zmq::socket_t& workerComm,
-                         zmq::socket_t& serverComm,
-                         zmq::socket_t& queueComm)
+                         zmq::socket_t& serverComm)
 {
   //first we take the message from the worker socket so it
   //doesn't hang around, and makes the worker think it
   //always is connected to a server
   remus::proto::Message message = remus::proto::receive_Message(&workerComm);
+  if(message.serviceType()==remus::MESH_STATUS)
+    { //held progress can be flushed once every status the worker sent
+      //has been forwarded
+    this->Statuses.forwarded();
+    }
 
   //next we check if we are forwarding messages to the server,
   //if we aren't doing that there is no point to send the message
@@ -251,14 +337,9 @@ void handleWorkerMessage(zmq::socket_t& workerComm,
     //so we need to prepare for that
     if(message.serviceType()==remus::TERMINATE_WORKER)
       {
-      //send the terminate worker message to the job queue so it
-      //shuts down. This has to be blocking so we know that it has
-      //received the message.
-      remus::worker::Job terminateJob;
-      remus::proto::send_Response(remus::TERMINATE_WORKER,
-                                  remus::worker::to_string(terminateJob),
-                                  &queueComm,
-                                  (zmq::SocketIdentity()) );
+      //tell the job queue to shut down, which wakes up anybody
+      //waiting on a job
+      this->Queue.terminateWorker();
 
       //we are in the process of cleaning up we need to stop everything.
       //we first check if we have any outstanding job results that
@@ -274,14 +355,46 @@ void handleWorkerMessage(zmq::socket_t& workerComm,
       //to the server.
       ++this->OutstandingResults;
       }
+    else if(message.serviceType()==remus::RESULT_CHUNK)
+      {
+      //each chunk of a streamed result is acknowledged by the server, and
+      //the worker blocks on those acknowledgements once it is out of credits
+      ++this->OutstandingChunks;
+      }
+    }
+  else if(message.serviceType()==remus::RESULT_CHUNK)
+    {
+    //the server has told us to shut down, so reject the chunk right away
+    //otherwise the worker would block forever waiting for an acknowledgement
+    remus::proto::send_NonBlockingResponse(remus::RESULT_CHUNK,
+                                           remus::INVALID_MSG,
+                                           &workerComm,
+                                           (zmq::SocketIdentity()));
+    }
+}
+
+//------------------------------------------------------------------------------
+//adds a job the server sent us to the job queue
+void queueJob(const char* data, std::size_t size, zmq::socket_t& serverComm)
+{
+  const remus::proto::ContentDigests missing = this->Queue.addJob(data, size);
+  if(!missing.empty() && this->ContinueForwardingToServer)
+    { //the job references content that we no longer hold, so ask
+      //the server to stream it to us
+    std::ostringstream buffer;
+    buffer << remus::worker::to_JobId(data, size) << std::endl;
+    remus::proto::writeContentDigests(buffer, missing);
+    remus::proto::send_Message(remus::common::MeshIOType(),
+                               remus::MISSING_CONTENT,
+                               buffer.str(),
+                               &serverComm);
     }
 }
 
 //------------------------------------------------------------------------------
 //handles taking messages from the server
 void handleServerMessage( zmq::socket_t& workerComm,
-                          zmq::socket_t& serverComm,
-                          zmq::socket_t& queueComm)
+                          zmq::socket_t& serverComm)
 {
   remus::proto::Response response = remus::proto::receive_Response(&serverComm);
   const bool goodToForward = response.isValid();
@@ -305,21 +418,59 @@ void handleServerMessage( zmq::socket_t& workerComm,
                                                (zmq::SocketIdentity()));
         --this->OutstandingResults;
         }
-      remus::proto::forward_Response(response,
-                                     &queueComm,
-                                     zmq::SocketIdentity());
+      //the same goes for any chunks of a streamed result, which are
+      //rejected so the worker stops streaming
+      while(this->OutstandingChunks > 0)
+        {
+        remus::proto::send_NonBlockingResponse(remus::RESULT_CHUNK,
+                                               remus::INVALID_MSG,
+                                               &workerComm,
+                                               (zmq::SocketIdentity()));
+        --this->OutstandingChunks;
+        }
+      this->Queue.terminateWorker();
 
       //the server has told us to terminate, which means that the server
       //might not exist so don't continue trying to send it messages
       this->ContinueForwardingToServer = false;
       }
     else if(goodToForwardToQueue &&
-            ( response.serviceType() == remus::TERMINATE_JOB ||
-              response.serviceType() == remus::MAKE_MESH ) )
+            response.serviceType() == remus::TERMINATE_JOB)
       {
-      remus::proto::forward_Response(response,
-                                     &queueComm,
-                                     zmq::SocketIdentity());
+      this->Queue.terminateJob(response.data(), response.dataSize());
+      }
+    else if(goodToForwardToQueue &&
+            response.serviceType() == remus::MAKE_MESH)
+      { //jobs are parsed straight from the message into the job queue
+      this->queueJob(response.data(), response.dataSize(), serverComm);
+      }
+    else if(goodToForwardToQueue &&
+            response.serviceType() == remus::JOB_BATCH)
+      { //a batch holds several jobs, each is queued like a single job
+      const std::vector<remus::worker::JobBatchEntry> jobs =
+        remus::worker::to_JobBatchEntries(response.data(),
+                                          response.dataSize());
+      typedef std::vector<remus::worker::JobBatchEntry>::const_iterator It;
+      for(It i = jobs.begin(); i != jobs.end(); ++i)
+        {
+        this->queueJob(i->first, i->second, serverComm);
+        }
+      }
+    else if(goodToForwardToQueue &&
+            response.serviceType() == remus::SUBMISSION_CHUNK)
+      { //streamed content of a job we have been given goes to the job
+        //queue, and we acknowledge it so the server can send more
+      this->Queue.addChunk(response.data(), response.dataSize());
+      if(this->ContinueForwardingToServer)
+        {
+        const boost::uuids::uuid id =
+              remus::proto::to_DataChunkId(response.data(),
+                                           response.dataSize());
+        remus::proto::send_Message(remus::common::MeshIOType(),
+                                   remus::SUBMISSION_CHUNK,
+                                   boost::uuids::to_string(id),
+                                   &serverComm);
+        }
       }
     else if ( response.serviceType() == remus::RETRIEVE_RESULT)
       { //the worker is notifying us that it recieved our results, so decrement
@@ -330,30 +481,60 @@ void handleServerMessage( zmq::socket_t& workerComm,
                                      zmq::SocketIdentity());
         --this->OutstandingResults;
       }
+    else if ( response.serviceType() == remus::RESULT_CHUNK)
+      { //the server has acknowledged a chunk of a streamed result, forward
+        //it to the worker so it can send more
+      remus::proto::forward_Response(response,
+                                     &workerComm,
+                                     zmq::SocketIdentity());
+      --this->OutstandingChunks;
+      }
       // do nothing if it isn't terminate_job, terminate_worker,
-      // make_mesh or retrieve result
+      // make_mesh, submission chunk, retrieve result or result chunk
+    }
+}
+
+//------------------------------------------------------------------------------
+//sends the progress the worker held back that is now due, and stores when
+//we need to check again. Returns true if anything was sent to the server
+bool flushStatuses(zmq::socket_t& serverComm, boost::int64_t& nextFlush)
+{
+  std::vector<remus::proto::JobStatus> due;
+  nextFlush = this->Statuses.takeDue(
+                  boost::posix_time::microsec_clock::local_time(), due);
+  if(!this->ContinueForwardingToServer)
+    {
+    return false;
+    }
+
+  typedef std::vector<remus::proto::JobStatus>::const_iterator StatusIt;
+  for(StatusIt i = due.begin(); i != due.end(); ++i)
+    {
+    remus::proto::send_Message(remus::common::MeshIOType(),
+                               remus::MESH_STATUS,
+                               remus::proto::to_string(*i),
+                               &serverComm);
     }
+  return !due.empty();
 }
 
 //------------------------------------------------------------------------------
 //handles sending heartbeat to the server
 void sendHeartBeat(zmq::socket_t& serverComm,
-                   const remus::common::PollingMonitor& monitor)
+                   boost::int64_t heartbeatInterval)
 {
   //First we check if we should be talking to the server, if we aren't forwarding
   //messages to the server than sending heartbeats is pointless
   if( this->ContinueForwardingToServer)
     {
-    //send the server how soon in seconds we will send our next heartbeat
-    //message. This way we are telling the server itself when it should
-    //expect a message, rather than it guessing. We always send the max
-    //time out since we don't know how long till we poll again. If a
-    //super large job comes in we could be blocking for a very long time
-    const boost::int64_t polldur = monitor.maxTimeOut();
-    //send the heartbeat to the server
+    //send the server how soon in milliseconds we will send our next
+    //heartbeat message. This way we are telling the server itself when it
+    //should expect a message, rather than it guessing. If a super large
+    //job comes in we could be blocking for a very long time, so we can't
+    //promise anything sooner than the interval
     remus::proto::send_Message(remus::common::MeshIOType(),
                                remus::HEARTBEAT,
-                               boost::lexical_cast<std::string>(polldur),
+                               boost::lexical_cast<std::string>(heartbeatInterval),
                                &serverComm);
     }
 }
@@ -364,8 +545,10 @@ void sendHeartBeat(zmq::socket_t& serverComm,
 //-----------------------------------------------------------------------------
 MessageRouter::MessageRouter(
                 const zmq::socketInfo<zmq::proto::inproc>& worker_info,
-                const zmq::socketInfo<zmq::proto::inproc>& queue_info):
-Implementation( new MessageRouterImplementation(worker_info, queue_info) )
+                remus::worker::detail::JobQueue& queue,
+                remus::worker::detail::StatusCoalescer& statuses):
+Implementation( new MessageRouterImplementation(worker_info, queue,
+                                                statuses) )
 {
 
 }
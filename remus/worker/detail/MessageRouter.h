@@ -23,9 +23,15 @@ namespace remus{
 namespace worker{
 namespace detail{
 
+class JobQueue;
+class StatusCoalescer;
+
 //Routes messages from the server to the worker class or the job queue,
 //based on the message type. The message router also handles send heartbeat
-//message back to the server
+//message back to the server. Jobs are added to the job queue directly
+//from the thread of the message router, so the only thread that talks to
+//the server is the message router's. Progress held back by the status
+//coalescer is flushed to the server from the same thread.
 
 //Once a MessageRouter is sent a TerminateWorker message,it will not accept any
 //new messages from the Server and trying to start back up the server. Also
@@ -34,7 +40,8 @@ class MessageRouter
 {
 public:
   MessageRouter(const zmq::socketInfo<zmq::proto::inproc>& worker_info,
-                const zmq::socketInfo<zmq::proto::inproc>& queue_info);
+                remus::worker::detail::JobQueue& queue,
+                remus::worker::detail::StatusCoalescer& statuses);
 
   ~MessageRouter();
 
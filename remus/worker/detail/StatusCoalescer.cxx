@@ -0,0 +1,195 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/detail/StatusCoalescer.h>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread/locks.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+
+namespace remus{
+namespace worker{
+namespace detail{
+
+//------------------------------------------------------------------------------
+StatusCoalescer::StatusCoalescer():
+  Mutex(),
+  Interval(boost::posix_time::milliseconds(0)),
+  Jobs(),
+  InFlight(0),
+  Coalesced(0),
+  Dropped(0)
+{
+}
+
+//------------------------------------------------------------------------------
+void StatusCoalescer::minimumInterval(boost::int64_t intervalInMillisec)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->Interval = boost::posix_time::milliseconds(
+                              std::max(boost::int64_t(0), intervalInMillisec));
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t StatusCoalescer::minimumInterval() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Interval.total_milliseconds();
+}
+
+//------------------------------------------------------------------------------
+bool StatusCoalescer::add(const remus::proto::JobStatus& status,
+                          const boost::posix_time::ptime& now)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  JobEntry& entry = this->Jobs[status.id()];
+
+  const bool stateChanged = entry.State != status.status();
+  const bool intervalPassed = entry.LastSent.is_not_a_date_time() ||
+                              (now - entry.LastSent) >= this->Interval;
+  if(!stateChanged && !intervalPassed)
+    {
+    //hold onto the newest progress until the MessageRouter flushes it
+    if(entry.Pending.empty())
+      {
+      entry.Pending.push_back(status);
+      }
+    else
+      {
+      entry.Pending[0] = status;
+      ++this->Coalesced;
+      }
+    return false;
+    }
+
+  if(!entry.Pending.empty())
+    {
+    //the held progress is older than this status, so it will never be sent.
+    //A change of state drops it, newer progress of the same state replaces it
+    if(stateChanged)
+      {
+      ++this->Dropped;
+      }
+    else
+      {
+      ++this->Coalesced;
+      }
+    entry.Pending.clear();
+    }
+
+  this->markSent(entry, status, now);
+  ++this->InFlight;
+  if(status.failed())
+    { //we won't hear about this job again
+    this->Jobs.erase(status.id());
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void StatusCoalescer::forwarded()
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  if(this->InFlight > 0)
+    {
+    --this->InFlight;
+    }
+}
+
+//------------------------------------------------------------------------------
+void StatusCoalescer::remove(const boost::uuids::uuid& id)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  It item = this->Jobs.find(id);
+  if(item == this->Jobs.end())
+    {
+    return;
+    }
+
+  if(!item->second.Pending.empty())
+    {
+    ++this->Dropped;
+    }
+  this->Jobs.erase(item);
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t StatusCoalescer::takeDue(const boost::posix_time::ptime& now,
+                                std::vector<remus::proto::JobStatus>& due)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  if(this->InFlight > 0)
+    {
+    //the worker has statuses waiting to be forwarded, which could be older
+    //than what we hold. Forwarding them wakes up the MessageRouter, which
+    //checks again afterwards
+    return -1;
+    }
+
+  //progress can be held for any job whose interval hasn't passed, even if
+  //we aren't holding any yet, so we need to check again once it has passed
+  boost::int64_t nextDue = -1;
+  for(It i = this->Jobs.begin(); i != this->Jobs.end(); ++i)
+    {
+    JobEntry& entry = i->second;
+    const boost::int64_t remaining =
+          (this->Interval - (now - entry.LastSent)).total_milliseconds();
+    if(remaining > 0)
+      {
+      nextDue = (nextDue < 0) ? remaining : std::min(nextDue, remaining);
+      }
+    else if(!entry.Pending.empty())
+      {
+      due.push_back(entry.Pending[0]);
+      this->markSent(entry, entry.Pending[0], now);
+      entry.Pending.clear();
+      nextDue = (nextDue < 0) ? this->Interval.total_milliseconds() :
+                std::min(nextDue, this->Interval.total_milliseconds());
+      }
+    }
+  return nextDue;
+}
+
+//------------------------------------------------------------------------------
+std::size_t StatusCoalescer::coalescedCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Coalesced;
+}
+
+//------------------------------------------------------------------------------
+std::size_t StatusCoalescer::droppedCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Dropped;
+}
+
+//------------------------------------------------------------------------------
+void StatusCoalescer::markSent(JobEntry& entry,
+                               const remus::proto::JobStatus& status,
+                               const boost::posix_time::ptime& now)
+{
+  entry.LastSent = now;
+  entry.State = status.status();
+}
+
+}
+}
+}
@@ -0,0 +1,131 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_worker_detail_StatusCoalescer_h
+#define remus_worker_detail_StatusCoalescer_h
+
+#include <remus/proto/JobStatus.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/uuid/uuid.hpp>
+
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread/mutex.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <map>
+#include <vector>
+
+namespace remus{
+namespace worker{
+namespace detail{
+
+//Limits how often the progress of each job is sent to the server. Progress
+//that arrives sooner than the minimum interval after the last status we sent
+//for the job is held, and replaced by any newer progress, until the
+//MessageRouter flushes it once the interval has passed. A status that
+//changes the state of the job is always sent right away, and replaces any
+//progress we were holding for the job.
+//
+//Statuses that are sent right away travel through the worker's socket, while
+//held statuses are flushed by the MessageRouter on its own socket. So that
+//the server sees the statuses of a job in order, held statuses are only
+//flushed once the MessageRouter has forwarded every status sent through the
+//worker's socket.
+//
+//The worker and the MessageRouter use this class from different threads,
+//so every method is thread safe.
+class StatusCoalescer
+{
+public:
+  //construct a coalescer that sends every status right away
+  StatusCoalescer();
+
+  //set the minimum number of milliseconds between the statuses we send
+  //for a single job. A value of zero sends every status right away
+  void minimumInterval(boost::int64_t intervalInMillisec);
+
+  //returns the minimum number of milliseconds between statuses for a job
+  boost::int64_t minimumInterval() const;
+
+  //returns true if the status should be sent to the server now, otherwise
+  //the status is held until the MessageRouter flushes it
+  bool add(const remus::proto::JobStatus& status,
+           const boost::posix_time::ptime& now);
+
+  //state that the MessageRouter has forwarded a status that add told
+  //the worker to send
+  void forwarded();
+
+  //forget about the given job, dropping any progress we hold for it.
+  //Called once the results of the job have been sent
+  void remove(const boost::uuids::uuid& id);
+
+  //move every held status whose interval has passed into due, marking
+  //them as sent. Returns the number of milliseconds until the interval of
+  //a job passes, which is when held progress could next be due, or -1 if
+  //there is no need to check again until the worker sends a status
+  boost::int64_t takeDue(const boost::posix_time::ptime& now,
+                         std::vector<remus::proto::JobStatus>& due);
+
+  //returns the number of held statuses that were replaced by newer progress
+  std::size_t coalescedCount() const;
+
+  //returns the number of held statuses that were thrown away since the
+  //job changed state or finished before they could be sent
+  std::size_t droppedCount() const;
+
+private:
+  //explicitly state the class doesn't support copy or move semantics
+  StatusCoalescer(const StatusCoalescer&);
+  void operator=(const StatusCoalescer&);
+
+  struct JobEntry
+  {
+    JobEntry(): LastSent(), State(remus::INVALID_STATUS), Pending() {}
+
+    boost::posix_time::ptime LastSent;
+    remus::STATUS_TYPE State;
+    //holds at most one status, the newest progress we haven't sent
+    std::vector<remus::proto::JobStatus> Pending;
+  };
+
+  typedef std::map<boost::uuids::uuid, JobEntry>::iterator It;
+
+  //mark the entry as sent at the given time, requires the lock to be held
+  void markSent(JobEntry& entry,
+                const remus::proto::JobStatus& status,
+                const boost::posix_time::ptime& now);
+
+  mutable boost::mutex Mutex;
+  boost::posix_time::time_duration Interval;
+  std::map<boost::uuids::uuid, JobEntry> Jobs;
+
+  //statuses sent through the worker's socket that the MessageRouter
+  //hasn't forwarded yet
+  std::size_t InFlight;
+  std::size_t Coalesced;
+  std::size_t Dropped;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,188 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/detail/ContentCache.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+using namespace remus::worker::detail;
+
+namespace {
+
+//------------------------------------------------------------------------------
+//every piece of content is 100 bytes
+remus::proto::JobContent make_Content(int i)
+{
+  std::string data = "content " + boost::lexical_cast<std::string>(i);
+  data.resize(100, 'x');
+  return remus::proto::JobContent(remus::common::ContentFormat::User, data);
+}
+
+//------------------------------------------------------------------------------
+void verify_find()
+{
+  ContentCache cache;
+  REMUS_ASSERT( (cache.size() == 0) )
+  REMUS_ASSERT( (cache.summary().empty()) )
+
+  const remus::proto::JobContent content = make_Content(0);
+  cache.add(content);
+  cache.add(content);
+  REMUS_ASSERT( (cache.size() == 1) )
+  REMUS_ASSERT( (cache.memoryBytes() == 100) )
+
+  remus::proto::JobContent found;
+  REMUS_ASSERT( (cache.find(content.hash(), found)) )
+  REMUS_ASSERT( (found.hash() == content.hash()) )
+  REMUS_ASSERT( (found.dataSize() == content.dataSize()) )
+  REMUS_ASSERT( (!cache.find(make_Content(1).hash(), found)) )
+
+  //the summary holds what is in the cache
+  remus::proto::ContentSummary summary = cache.summary();
+  REMUS_ASSERT( (!summary.empty()) )
+  REMUS_ASSERT( (summary.mayContain(content.hash())) )
+}
+
+//------------------------------------------------------------------------------
+void verify_eviction()
+{
+  ContentCache cache(200);
+  REMUS_ASSERT( (cache.maximumBytes() == 200) )
+
+  cache.add(make_Content(0));
+  cache.add(make_Content(1));
+
+  //using the first content makes the second the least recently used
+  remus::proto::JobContent found;
+  REMUS_ASSERT( (cache.find(make_Content(0).hash(), found)) )
+
+  cache.add(make_Content(2));
+  REMUS_ASSERT( (cache.size() == 2) )
+  REMUS_ASSERT( (cache.memoryBytes() == 200) )
+  REMUS_ASSERT( (cache.find(make_Content(0).hash(), found)) )
+  REMUS_ASSERT( (!cache.find(make_Content(1).hash(), found)) )
+  REMUS_ASSERT( (cache.find(make_Content(2).hash(), found)) )
+
+  //shrinking drops the least recently used content
+  cache.maximumBytes(150);
+  REMUS_ASSERT( (cache.size() == 1) )
+  REMUS_ASSERT( (cache.find(make_Content(2).hash(), found)) )
+
+  //a cache of zero bytes holds nothing
+  cache.maximumBytes(0);
+  cache.add(make_Content(3));
+  REMUS_ASSERT( (cache.size() == 0) )
+  REMUS_ASSERT( (cache.summary().empty()) )
+}
+
+//------------------------------------------------------------------------------
+void verify_changes()
+{
+  ContentCache cache(200);
+  cache.add(make_Content(0));
+  cache.add(make_Content(1));
+
+  remus::proto::ContentChanges changes = cache.takeChanges();
+  REMUS_ASSERT( (changes.Added.size() == 2) )
+  REMUS_ASSERT( (changes.Added.count(make_Content(0).hash()) == 1) )
+  REMUS_ASSERT( (changes.Dropped.empty()) )
+
+  //changes are only reported once
+  REMUS_ASSERT( (cache.takeChanges().empty()) )
+
+  //content that is pushed out is reported as dropped
+  cache.add(make_Content(2));
+  changes = cache.takeChanges();
+  REMUS_ASSERT( (changes.Added.size() == 1) )
+  REMUS_ASSERT( (changes.Added.count(make_Content(2).hash()) == 1) )
+  REMUS_ASSERT( (changes.Dropped.size() == 1) )
+  REMUS_ASSERT( (changes.Dropped.count(make_Content(0).hash()) == 1) )
+}
+
+//------------------------------------------------------------------------------
+void verify_disk_backing()
+{
+  namespace fs = boost::filesystem;
+  const fs::path directory = fs::temp_directory_path() /
+                             fs::unique_path("remus-cache-%%%%-%%%%");
+  {
+  ContentCache cache(100);
+  cache.diskBacking(directory.string(), 200);
+  REMUS_ASSERT( (cache.diskDirectory() == directory.string()) )
+  REMUS_ASSERT( (cache.maximumDiskBytes() == 200) )
+
+  //content that doesn't fit in memory is moved to disk
+  cache.add(make_Content(0));
+  cache.add(make_Content(1));
+  REMUS_ASSERT( (cache.size() == 2) )
+  REMUS_ASSERT( (cache.memoryBytes() == 100) )
+  REMUS_ASSERT( (cache.diskBytes() == 100) )
+
+  //moving to disk isn't dropping the content
+  remus::proto::ContentChanges changes = cache.takeChanges();
+  REMUS_ASSERT( (changes.Added.size() == 2) )
+  REMUS_ASSERT( (changes.Dropped.empty()) )
+
+  //content on disk is read back, and swaps with the content in memory
+  remus::proto::JobContent found;
+  REMUS_ASSERT( (cache.find(make_Content(0).hash(), found)) )
+  REMUS_ASSERT( (found.dataSize() == 100) )
+  REMUS_ASSERT( (found.hash() == make_Content(0).hash()) )
+  REMUS_ASSERT( (std::string(found.data(), found.dataSize()) ==
+                 std::string(make_Content(0).data(), 100)) )
+  REMUS_ASSERT( (cache.memoryBytes() == 100) )
+  REMUS_ASSERT( (cache.diskBytes() == 100) )
+
+  //once the disk is full the least recently used content is dropped
+  cache.add(make_Content(2));
+  cache.add(make_Content(3));
+  REMUS_ASSERT( (cache.size() == 3) )
+  REMUS_ASSERT( (cache.diskBytes() == 200) )
+  REMUS_ASSERT( (!cache.find(make_Content(1).hash(), found)) )
+  changes = cache.takeChanges();
+  REMUS_ASSERT( (changes.Dropped.count(make_Content(1).hash()) == 1) )
+
+  //damaged content on disk is dropped instead of being used
+  {
+  std::ofstream damage( (directory /
+                   (make_Content(0).hash() + ".remus-content")).string().c_str(),
+                   std::ios::out | std::ios::binary);
+  damage << "damaged";
+  }
+  REMUS_ASSERT( (!cache.find(make_Content(0).hash(), found)) )
+  REMUS_ASSERT( (cache.size() == 2) )
+  }
+
+  //the files of the cache are removed with it
+  REMUS_ASSERT( (fs::is_empty(directory)) )
+  boost::system::error_code ec;
+  fs::remove_all(directory, ec);
+}
+
+}
+
+int UnitTestContentCache(int, char *[])
+{
+  verify_find();
+  verify_eviction();
+  verify_changes();
+  verify_disk_backing();
+  return 0;
+}
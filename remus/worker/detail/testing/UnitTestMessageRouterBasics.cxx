@@ -16,6 +16,7 @@
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 #include <remus/worker/detail/JobQueue.h>
+#include <remus/worker/detail/StatusCoalescer.h>
 
 #include <remus/proto/zmqHelper.h>
 
@@ -93,11 +94,16 @@ void test_job_routing(MessageRouter& mr,
   REMUS_ASSERT( (r.isValid()) );
   }
 
+  //small jobs can arrive bundled in a single batch
   remus::worker::Job fakeJob3(remus::testing::UUIDGenerator(), sub);
+  remus::worker::Job fakeJob4(remus::testing::UUIDGenerator(), sub);
   {
+  std::vector<std::string> batch;
+  batch.push_back(remus::worker::to_string(fakeJob3));
+  batch.push_back(remus::worker::to_string(fakeJob4));
   remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                             remus::worker::to_string(fakeJob3),
+      remus::proto::send_NonBlockingResponse(remus::JOB_BATCH,
+                                             remus::worker::to_JobBatch(batch),
                                              &serverSocket,sid);
   REMUS_ASSERT( (r.isValid()) );
   }
@@ -120,6 +126,8 @@ void test_job_routing(MessageRouter& mr,
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob ) ==true ))
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob2 ) ==false ))
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob3) ==false ))
+  REMUS_ASSERT( (jq.isATerminatedJob( fakeJob4) ==false ))
+  REMUS_ASSERT( (jq.size()==3) );
 
   while(jq.size()>0)
     {
@@ -133,7 +141,6 @@ void test_job_routing(MessageRouter& mr,
 int UnitTestMessageRouterBasics(int, char *[])
 {
   zmq::socketInfo<zmq::proto::inproc> worker_channel(remus::testing::UniqueString());
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(remus::testing::UniqueString());
 
   //bind the serverSocket
   boost::shared_ptr<zmq::context_t> context = remus::worker::make_ServerContext();
@@ -148,12 +155,13 @@ int UnitTestMessageRouterBasics(int, char *[])
   zmq::socket_t worker_socket(*context, ZMQ_PAIR);
   zmq::bindToAddress(worker_socket, worker_channel);
 
-  JobQueue jq(*context,queue_channel); //bind the jobqueue to the worker channel
+  JobQueue jq;
+  StatusCoalescer sc;
 
   //now we can construct the message router, and verify that it can
   //be destroyed before starting
   {
-  MessageRouter mr(worker_channel, queue_channel);
+  MessageRouter mr(worker_channel, jq, sc);
   REMUS_ASSERT( (!mr.valid()) )
   }
 
@@ -161,7 +169,7 @@ int UnitTestMessageRouterBasics(int, char *[])
   //noted that since MessageRouter uses ZMQ_PAIR connections we can't have
   //multiple MessageRouters connecting to the same socket, you have to bind
   //and unbind those socket classes.
-  MessageRouter mr(worker_channel, queue_channel);
+  MessageRouter mr(worker_channel, jq, sc);
   {
   REMUS_ASSERT( (!mr.valid()) )
   mr.start( serverConn, *(serverConn.context()) );
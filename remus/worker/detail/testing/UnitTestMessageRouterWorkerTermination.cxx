@@ -16,6 +16,7 @@
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 #include <remus/worker/detail/JobQueue.h>
+#include <remus/worker/detail/StatusCoalescer.h>
 
 #include <remus/proto/zmqHelper.h>
 
@@ -75,7 +76,6 @@ void test_worker_terminate_routing_call(MessageRouter& mr,
 int UnitTestMessageRouterWorkerTermination(int, char *[])
 {
   zmq::socketInfo<zmq::proto::inproc> worker_channel(remus::testing::UniqueString());
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(remus::testing::UniqueString());
 
   //bind the serverSocket
   boost::shared_ptr<zmq::context_t> context = remus::worker::make_ServerContext();
@@ -90,11 +90,12 @@ int UnitTestMessageRouterWorkerTermination(int, char *[])
   zmq::socket_t worker_socket(*context, ZMQ_PAIR);
   zmq::bindToAddress(worker_socket, worker_channel);
 
-  JobQueue jq(*context,queue_channel); //bind the jobqueue to the worker channel
+  JobQueue jq;
+  StatusCoalescer sc;
 
   //It should be noted that once you send a terminate call to a JobQueue
   //or MessageRouter it can't be started again
-  MessageRouter mr(worker_channel, queue_channel);
+  MessageRouter mr(worker_channel, jq, sc);
   test_worker_terminate_routing_call(mr,serverConn,worker_socket,jq);
   return 0;
 }
@@ -0,0 +1,185 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/detail/StatusCoalescer.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/uuid/uuid.hpp>
+
+using namespace remus::worker::detail;
+
+namespace {
+
+typedef boost::posix_time::ptime ptime;
+typedef boost::posix_time::milliseconds milliseconds;
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus make_Progress(const boost::uuids::uuid& id, int value)
+{
+  return remus::proto::make_JobStatus(id, value);
+}
+
+//------------------------------------------------------------------------------
+void verify_no_limit()
+{
+  StatusCoalescer sc;
+  REMUS_ASSERT( (sc.minimumInterval() == 0) )
+
+  //without a limit every status is sent right away
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const ptime now = boost::posix_time::microsec_clock::local_time();
+  for(int i=1; i <= 10; ++i)
+    {
+    REMUS_ASSERT( (sc.add(make_Progress(id,i), now)) )
+    sc.forwarded();
+    }
+
+  std::vector<remus::proto::JobStatus> due;
+  REMUS_ASSERT( (sc.takeDue(now, due) == -1) )
+  REMUS_ASSERT( (due.empty()) )
+  REMUS_ASSERT( (sc.coalescedCount() == 0) )
+  REMUS_ASSERT( (sc.droppedCount() == 0) )
+
+  //negative intervals are treated as no limit
+  sc.minimumInterval(-10);
+  REMUS_ASSERT( (sc.minimumInterval() == 0) )
+}
+
+//------------------------------------------------------------------------------
+void verify_coalescing()
+{
+  StatusCoalescer sc;
+  sc.minimumInterval(100);
+  REMUS_ASSERT( (sc.minimumInterval() == 100) )
+
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const ptime start = boost::posix_time::microsec_clock::local_time();
+
+  //the first status for a job is sent right away
+  REMUS_ASSERT( (sc.add(make_Progress(id,1), start)) )
+  sc.forwarded();
+
+  //progress inside the interval is held, with only the newest kept
+  for(int i=2; i <= 10; ++i)
+    {
+    REMUS_ASSERT( (!sc.add(make_Progress(id,i), start + milliseconds(i))) )
+    }
+  REMUS_ASSERT( (sc.coalescedCount() == 8) )
+
+  //nothing is due until the interval has passed
+  std::vector<remus::proto::JobStatus> due;
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(40), due) == 60) )
+  REMUS_ASSERT( (due.empty()) )
+
+  //once it has passed we get only the newest progress
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(100), due) == 100) )
+  REMUS_ASSERT( (due.size() == 1) )
+  REMUS_ASSERT( (due[0] == make_Progress(id,10)) )
+
+  //the flushed status starts a new interval
+  REMUS_ASSERT( (!sc.add(make_Progress(id,11), start + milliseconds(150))) )
+  due.clear();
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(150), due) == 50) )
+  REMUS_ASSERT( (due.empty()) )
+
+  //progress sent after the interval passed replaces what we held
+  REMUS_ASSERT( (sc.add(make_Progress(id,12), start + milliseconds(200))) )
+  REMUS_ASSERT( (sc.coalescedCount() == 9) )
+  REMUS_ASSERT( (sc.droppedCount() == 0) )
+
+  //while a sent status hasn't been forwarded nothing is flushed, as it
+  //could arrive at the server after the held one
+  REMUS_ASSERT( (!sc.add(make_Progress(id,13), start + milliseconds(210))) )
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(400), due) == -1) )
+  REMUS_ASSERT( (due.empty()) )
+  sc.forwarded();
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(400), due) == 100) )
+  REMUS_ASSERT( (due.size() == 1) )
+  REMUS_ASSERT( (due[0] == make_Progress(id,13)) )
+}
+
+//------------------------------------------------------------------------------
+void verify_state_changes()
+{
+  StatusCoalescer sc;
+  sc.minimumInterval(100);
+
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const ptime start = boost::posix_time::microsec_clock::local_time();
+
+  REMUS_ASSERT( (sc.add(make_Progress(id,1), start)) )
+  sc.forwarded();
+  REMUS_ASSERT( (!sc.add(make_Progress(id,2), start + milliseconds(1))) )
+
+  //a failure is sent right away and drops the held progress
+  const remus::proto::JobStatus failed =
+            remus::proto::make_FailedJobStatus(id, "mesher crashed");
+  REMUS_ASSERT( (sc.add(failed, start + milliseconds(2))) )
+  sc.forwarded();
+  REMUS_ASSERT( (sc.droppedCount() == 1) )
+  REMUS_ASSERT( (sc.coalescedCount() == 0) )
+
+  std::vector<remus::proto::JobStatus> due;
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(500), due) == -1) )
+  REMUS_ASSERT( (due.empty()) )
+
+  //sending the result of a job drops the progress held for it
+  const boost::uuids::uuid other = remus::testing::UUIDGenerator();
+  REMUS_ASSERT( (sc.add(make_Progress(other,1), start)) )
+  sc.forwarded();
+  REMUS_ASSERT( (!sc.add(make_Progress(other,2), start + milliseconds(1))) )
+  sc.remove(other);
+  REMUS_ASSERT( (sc.droppedCount() == 2) )
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(500), due) == -1) )
+  REMUS_ASSERT( (due.empty()) )
+}
+
+//------------------------------------------------------------------------------
+void verify_multiple_jobs()
+{
+  StatusCoalescer sc;
+  sc.minimumInterval(100);
+
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+  const ptime start = boost::posix_time::microsec_clock::local_time();
+
+  //each job has its own interval
+  REMUS_ASSERT( (sc.add(make_Progress(first,1), start)) )
+  REMUS_ASSERT( (sc.add(make_Progress(second,1), start + milliseconds(50))) )
+  sc.forwarded();
+  sc.forwarded();
+  REMUS_ASSERT( (!sc.add(make_Progress(first,2), start + milliseconds(60))) )
+  REMUS_ASSERT( (!sc.add(make_Progress(second,2), start + milliseconds(60))) )
+
+  std::vector<remus::proto::JobStatus> due;
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(100), due) == 50) )
+  REMUS_ASSERT( (due.size() == 1) )
+  REMUS_ASSERT( (due[0] == make_Progress(first,2)) )
+
+  due.clear();
+  REMUS_ASSERT( (sc.takeDue(start + milliseconds(150), due) == 50) )
+  REMUS_ASSERT( (due.size() == 1) )
+  REMUS_ASSERT( (due[0] == make_Progress(second,2)) )
+}
+
+}
+
+int UnitTestStatusCoalescer(int, char *[])
+{
+  verify_no_limit();
+  verify_coalescing();
+  verify_state_changes();
+  verify_multiple_jobs();
+  return 0;
+}
@@ -10,89 +10,76 @@
 //
 //=============================================================================
 
-#include <remus/worker/detail/MessageRouter.h>
+#include <remus/worker/detail/JobQueue.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/common/remusGlobals.h>
+#include <remus/proto/DataChunk.h>
+#include <remus/worker/detail/ContentCache.h>
 
 #include <remus/common/SleepFor.h>
-#include <remus/proto/Message.h>
-#include <remus/proto/Response.h>
-#include <remus/worker/detail/JobQueue.h>
 
-#include <remus/proto/zmq.hpp>
+#ifndef _MSC_VER
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wshadow"
+#  pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+#  pragma GCC diagnostic pop
+#endif
 
 #include <remus/testing/Testing.h>
 
 #include <boost/uuid/uuid.hpp>
 
+#include <algorithm>
+#include <sstream>
+
 using namespace remus::worker::detail;
 
 namespace {
 
 //------------------------------------------------------------------------------
-void verify_basic_comms(zmq::context_t& context)
+void add_job(JobQueue& jq, const remus::worker::Job& job)
 {
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(
-                                                remus::testing::UniqueString());
-  JobQueue jq(context,queue_channel); //bind the jobqueue to the worker channel
-
-  //we need to pause for some time to all the JobQueue
-  //to properly bind to the socket before we connect
-  while(!jq.isReady())
-    { remus::common::SleepForMillisec(10); }
-
-  //create the socket to send info to the job queue
-  zmq::socket_t jobSocket(context,ZMQ_PAIR);
-  jobSocket.connect(queue_channel.endpoint().c_str());
+  const std::string msg = remus::worker::to_string(job);
+  jq.addJob(msg.data(), msg.size());
+}
 
-  zmq::SocketIdentity sid;
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission()
+{
+  remus::proto::JobRequirements reqs(
+          remus::common::ContentFormat::User,
+          remus::common::MeshIOType( (remus::meshtypes::Mesh2D()),
+                                     (remus::meshtypes::Mesh2D()) ),
+          std::string(),
+          std::string()
+          );
+  return remus::proto::JobSubmission(reqs);
+}
 
+//------------------------------------------------------------------------------
+void verify_basic_comms()
+{
+  JobQueue jq;
 
   boost::uuids::uuid jobId = remus::testing::UUIDGenerator();
   remus::worker::Job fakeJob(jobId,
                              remus::proto::JobSubmission());
+  add_job(jq, fakeJob);
 
-  {
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                             remus::worker::to_string(fakeJob),
-                                             &jobSocket,
-                                             sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
-
-  while(jq.size()<1){}
-  REMUS_ASSERT( (jq.size()>0) );
+  //jobs are on the queue as soon as they are added
   REMUS_ASSERT( (jq.size()==1) );
+  REMUS_ASSERT( (jq.numberOfJobsReceived()==1) );
 
   //now add multiple more jobs to the queue
-  remus::proto::JobRequirements reqs(
-          remus::common::ContentFormat::User,
-          remus::common::MeshIOType( (remus::meshtypes::Mesh2D()),
-                                     (remus::meshtypes::Mesh2D()) ),
-          std::string(),
-          std::string()
-          );
-  remus::proto::JobSubmission sub(reqs);
-
+  remus::proto::JobSubmission sub = make_Submission();
   remus::worker::Job fakeJob2(remus::testing::UUIDGenerator(), sub);
   remus::worker::Job fakeJob3(remus::testing::UUIDGenerator(), sub);
-
-  {
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                             remus::worker::to_string(fakeJob2),
-                                             &jobSocket,
-                                             sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
-
-  {
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                            remus::worker::to_string(fakeJob3),
-                                            &jobSocket,
-                                            sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
+  add_job(jq, fakeJob2);
+  add_job(jq, fakeJob3);
 
   //now send a terminate job command for the first job
   //and verify that the correct job was terminated by pulling
@@ -100,20 +87,15 @@ void verify_basic_comms(zmq::context_t& context)
   {
   remus::worker::Job terminateJob(jobId,
                                   remus::proto::JobSubmission());
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::TERMINATE_JOB,
-                                             remus::worker::to_string(terminateJob),
-                                             &jobSocket,
-                                             sid);
-  REMUS_ASSERT( (r.isValid()) );
+  const std::string msg = remus::worker::to_string(terminateJob);
+  jq.terminateJob(msg.data(), msg.size());
   }
 
-  //gotta wait for all three messages to come in
-  remus::common::SleepForMillisec(2000);
-
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob ) ==true ))
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob2 ) ==false ))
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob3) ==false ))
+  REMUS_ASSERT( (jq.numberOfJobsReceived()==3) );
+  REMUS_ASSERT( (jq.numberOfJobsHeld()==2) );
 
   while(jq.size()>0)
     {
@@ -123,34 +105,44 @@ void verify_basic_comms(zmq::context_t& context)
 }
 
 //------------------------------------------------------------------------------
-void verify_term(zmq::context_t& context)
+void add_job_later(JobQueue* jq, remus::worker::Job job)
 {
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(
-                                                remus::testing::UniqueString());
-  JobQueue jq(context,queue_channel); //bind the jobqueue to the worker channel
-
-  //we need to pause for some time to all the JobQueue
-  //to properly bind to the socket before we connect
-  while(!jq.isReady())
-    { remus::common::SleepForMillisec(10); }
+  remus::common::SleepForMillisec(100);
+  add_job(*jq, job);
+}
 
-  //create the socket to send info to the job queue
-  zmq::socket_t jobSocket(context,ZMQ_PAIR);
-  jobSocket.connect(queue_channel.endpoint().c_str());
+//------------------------------------------------------------------------------
+void verify_wakeup()
+{
+  JobQueue jq;
+
+  //nothing arrives, so we get an invalid job once the wait is over
+  remus::worker::Job none = jq.waitAndTakeJob(10);
+  REMUS_ASSERT( (!none.valid()) )
+  REMUS_ASSERT( (none.validityReason() == remus::worker::Job::INVALID) )
+
+  //a thread waiting on a job is woken up when a job is added
+  remus::worker::Job job(remus::testing::UUIDGenerator(), make_Submission());
+  boost::thread adder(&add_job_later, &jq, job);
+  remus::worker::Job taken = jq.waitAndTakeJob();
+  adder.join();
+  REMUS_ASSERT( (taken.valid()) )
+  REMUS_ASSERT( (taken.id() == job.id()) )
+}
 
+//------------------------------------------------------------------------------
+void verify_term()
+{
+  JobQueue jq;
   REMUS_ASSERT( (jq.size() == 0) );
+  REMUS_ASSERT( (jq.isShutdown() == false) );
 
-  //now send it a terminate message over the worker channel
-  remus::worker::Job terminateJob;
-  remus::proto::Response r=
-      remus::proto::send_NonBlockingResponse(remus::TERMINATE_WORKER,
-                                             remus::worker::to_string(terminateJob),
-                                             &jobSocket,
-                                             (zmq::SocketIdentity()));
-  REMUS_ASSERT( (r.isValid()) );
+  add_job(jq, remus::worker::Job(remus::testing::UUIDGenerator(),
+                                 make_Submission()) );
 
-  //cheap block while we wait for the router thread to get the message
-  while(jq.size()<1){}
+  //terminating the worker drops every job
+  jq.terminateWorker();
+  REMUS_ASSERT( (jq.isShutdown() == true) );
 
   REMUS_ASSERT( (jq.size() == 1) )
   remus::worker::Job invalid_job = jq.take();
@@ -158,16 +150,153 @@ void verify_term(zmq::context_t& context)
   REMUS_ASSERT( (invalid_job.validityReason() ==
                  remus::worker::Job::TERMINATE_WORKER) )
 
+  //the job that terminates the worker stays on the queue, so everybody
+  //taking jobs is told to terminate
+  REMUS_ASSERT( (jq.size() == 1) )
+  REMUS_ASSERT( (jq.waitAndTakeJob().validityReason() ==
+                 remus::worker::Job::TERMINATE_WORKER) )
+
+  //and no new jobs are accepted
+  add_job(jq, remus::worker::Job(remus::testing::UUIDGenerator(),
+                                 make_Submission()) );
+  REMUS_ASSERT( (jq.size() == 1) )
+  REMUS_ASSERT( (jq.numberOfJobsHeld() == 0) )
+}
+
+
+//------------------------------------------------------------------------------
+void verify_cached_references()
+{
+  ContentCache cache;
+  JobQueue jq(cache);
+
+  //large content of the jobs we receive is cached
+  const std::string data(remus::STREAM_CHUNK_SIZE + 1, 'x');
+  remus::proto::JobContent content(remus::common::ContentFormat::User, data);
+  remus::proto::JobSubmission sub = make_Submission();
+  sub["data"] = content;
+  add_job(jq, remus::worker::Job(remus::testing::UUIDGenerator(), sub));
+  REMUS_ASSERT( (cache.size() == 1) )
+  jq.take();
+
+  //content the server references by digest is taken from the cache
+  remus::proto::JobContent placeholder(remus::common::ContentFormat::User,
+                                       std::string());
+  placeholder.tag("tagged");
+  remus::proto::JobSubmission refSub = make_Submission();
+  refSub["data"] = placeholder;
+  refSub["other"] = placeholder;
+
+  remus::proto::ContentDigests refs;
+  refs["data"] = content.hash();
+  refs["other"] = "not a cached digest";
+
+  const boost::uuids::uuid refId = remus::testing::UUIDGenerator();
+  std::ostringstream buffer;
+  buffer << remus::worker::to_string(remus::worker::Job(refId, refSub));
+  remus::proto::writeStreamedKeys(buffer, remus::proto::StreamedKeys());
+  remus::proto::writeContentDigests(buffer, refs);
+  const std::string msg = buffer.str();
+
+  REMUS_ASSERT( (remus::worker::to_JobId(msg.data(), msg.size()) == refId) )
+
+  //content we don't hold is reported as missing, and the job is
+  //held until that content is streamed to us
+  remus::proto::ContentDigests missing = jq.addJob(msg.data(), msg.size());
+  REMUS_ASSERT( (missing.size() == 1) )
+  REMUS_ASSERT( (missing["other"] == "not a cached digest") )
+  REMUS_ASSERT( (jq.size() == 0) )
+  REMUS_ASSERT( (jq.numberOfJobsHeld() == 1) )
+
+  //once every reference is cached, the job is queued with the cached data
+  refs.erase("other");
+  remus::proto::JobSubmission cachedSub = make_Submission();
+  cachedSub["data"] = placeholder;
+  std::ostringstream buffer2;
+  buffer2 << remus::worker::to_string(
+            remus::worker::Job(remus::testing::UUIDGenerator(), cachedSub));
+  remus::proto::writeStreamedKeys(buffer2, remus::proto::StreamedKeys());
+  remus::proto::writeContentDigests(buffer2, refs);
+  const std::string msg2 = buffer2.str();
+
+  missing = jq.addJob(msg2.data(), msg2.size());
+  REMUS_ASSERT( (missing.empty()) )
+  REMUS_ASSERT( (jq.size() == 1) )
+
+  remus::worker::Job job = jq.take();
+  remus::proto::JobContent resolved;
+  REMUS_ASSERT( (job.details("data", resolved)) )
+  REMUS_ASSERT( (resolved.dataSize() == data.size()) )
+  REMUS_ASSERT( (resolved.tag() == "tagged") )
+}
+
+
+//------------------------------------------------------------------------------
+void verify_streamed_content()
+{
+  JobQueue jq;
+
+  //a job whose content is streamed is held until all of it has arrived
+  remus::proto::JobContent placeholder(remus::common::ContentFormat::XML,
+                                       std::string());
+  placeholder.tag("tagged");
+  remus::proto::JobSubmission sub = make_Submission();
+  sub["data"] = placeholder;
+
+  remus::proto::StreamedKeys keys;
+  keys.insert("data");
+
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  std::ostringstream buffer;
+  buffer << remus::worker::to_string(remus::worker::Job(id, sub));
+  remus::proto::writeStreamedKeys(buffer, keys);
+  remus::proto::writeContentDigests(buffer, remus::proto::ContentDigests());
+  const std::string msg = buffer.str();
+  jq.addJob(msg.data(), msg.size());
+  REMUS_ASSERT( (jq.size() == 0) )
+  REMUS_ASSERT( (jq.numberOfJobsHeld() == 1) )
+
+  const std::string data = remus::testing::BinaryDataGenerator(
+                                      remus::STREAM_CHUNK_SIZE * 2 + 7);
+  for(std::size_t pos=0; pos < data.size(); pos += remus::STREAM_CHUNK_SIZE)
+    {
+    const std::size_t len = std::min(remus::STREAM_CHUNK_SIZE,
+                                     data.size() - pos);
+    remus::proto::DataChunk chunk(id, remus::common::ContentFormat::XML,
+                                  pos, data.data() + pos, len);
+    chunk.key("data");
+    if(pos + len == data.size())
+      {
+      chunk.markAsFinal(data.size(), remus::common::MD5Hash(data));
+      }
+    const std::string chunkMsg = remus::proto::to_string(chunk);
+    jq.addChunk(chunkMsg.data(), chunkMsg.size());
+    }
+  REMUS_ASSERT( (jq.size() == 1) )
+
+  //the content is handed over as memory content, keeping its format and tag
+  remus::worker::Job job = jq.take();
+  remus::proto::JobContent content;
+  REMUS_ASSERT( (job.details("data", content)) )
+  REMUS_ASSERT( (content.sourceType() == remus::common::ContentSource::Memory) )
+  REMUS_ASSERT( (content.formatType() == remus::common::ContentFormat::XML) )
+  REMUS_ASSERT( (content.tag() == "tagged") )
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == data) )
+
+  //the content outlives the spool files of its job
+  jq.removeSpooledContent(id);
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == data) )
 }
 
 }
 
 int UnitTestWorkerJobQueue(int, char *[])
 {
-  zmq::context_t context(1);
-
-  verify_basic_comms(context);
-  verify_term(context);
+  verify_basic_comms();
+  verify_wakeup();
+  verify_term();
+  verify_cached_references();
+  verify_streamed_content();
 
   return 0;
 }
@@ -113,6 +113,28 @@ void verify_server_connection_tcpip()
   REMUS_ASSERT( (sc.isLocalEndpoint()==true) );
 }
 
+void verify_server_connection_requirements()
+{
+  using namespace remus::meshtypes;
+  const remus::proto::JobRequirements reqs =
+    remus::proto::make_JobRequirements(
+          remus::common::make_MeshIOType(Model(),Model()), "worker", "");
+
+  //only the loopback address is known to be local, so a worker made from
+  //requirements that talks to any other address must treat the server
+  //as remote
+  zmq::socketInfo<zmq::proto::tcp> remote_socket("0.0.0.0",
+                                        remus::SERVER_WORKER_PORT+102);
+  remus::worker::ServerConnection remote_conn(remote_socket);
+
+  fake_server remote_server(remote_socket, remote_conn.context());
+  remus::worker::Worker remote_worker(reqs,remote_conn);
+
+  REMUS_ASSERT( (remote_worker.connection().endpoint() ==
+                 remote_socket.endpoint()) );
+  REMUS_ASSERT( (remote_worker.connection().isLocalEndpoint()==false) );
+}
+
 void verify_server_connection_inproc()
 {
   using namespace remus::meshtypes;
@@ -182,6 +204,7 @@ void verify_server_connection_ipc()
 int UnitTestWorker(int, char *[])
 {
   verify_server_connection_tcpip();
+  verify_server_connection_requirements();
   verify_server_connection_inproc();
 #ifndef _WIN32
   verify_server_connection_ipc();
@@ -14,6 +14,7 @@
 #include <remus/testing/Testing.h>
 
 #include <string>
+#include <vector>
 
 namespace {
 
@@ -181,6 +182,34 @@ void verify_submission()
 
 }
 
+void verify_batch()
+{
+  Job first(make_id(),make_empty_sub());
+  Job second(make_id(),make_empty_sub());
+
+  std::vector<std::string> messages;
+  messages.push_back(to_string(first));
+  messages.push_back(to_string(second));
+  const std::string batch = to_JobBatch(messages);
+
+  //every job in the batch is found where it was written
+  std::vector<JobBatchEntry> entries = to_JobBatchEntries(batch.data(),
+                                                          batch.size());
+  REMUS_ASSERT( (entries.size() == 2) )
+  Job from_batch = to_Job(entries[0].first, entries[0].second);
+  REMUS_ASSERT( (from_batch.valid() == true) )
+  REMUS_ASSERT( (from_batch.id() == first.id()) )
+  from_batch = to_Job(entries[1].first, entries[1].second);
+  REMUS_ASSERT( (from_batch.valid() == true) )
+  REMUS_ASSERT( (from_batch.id() == second.id()) )
+
+  //a damaged batch only returns the jobs before the damage
+  entries = to_JobBatchEntries(batch.data(), batch.size() - 1);
+  REMUS_ASSERT( (entries.size() == 1) )
+  entries = to_JobBatchEntries(batch.data(), 0);
+  REMUS_ASSERT( (entries.size() == 0) )
+}
+
 } //namespace
 
 
@@ -190,5 +219,6 @@ int UnitTestWorkerJob(int, char *[])
   verify_validity();
   verify_meshTypes();
   verify_submission();
+  verify_batch();
   return 0;
 }